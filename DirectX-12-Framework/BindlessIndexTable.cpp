@@ -0,0 +1,70 @@
+#include "BindlessIndexTable.h"
+
+BindlessIndexTable::BindlessIndexTable(uint32_t capacity, uint32_t reservedIndices)
+    : m_lru()
+    , m_residents()
+    , m_freeIndices()
+    , m_frame(1)
+    , m_completedFrame(0)
+    , m_frames()
+    , m_evictions(0)
+{
+    // Stacked in reverse so the lowest indices are handed out first
+    for (uint32_t index = capacity; index > reservedIndices; index--)
+    {
+        m_freeIndices.push_back(index - 1);
+    }
+}
+
+uint32_t BindlessIndexTable::Acquire(uint32_t key, bool& inserted)
+{
+    auto resident = m_residents.find(key);
+    if (resident != m_residents.end())
+    {
+        // Already resident, just mark it as used by this frame
+        inserted = false;
+        resident->second->lastUsedFrame = m_frame;
+        m_lru.splice(m_lru.begin(), m_lru, resident->second);
+        return resident->second->index;
+    }
+
+    uint32_t index;
+    if (!m_freeIndices.empty())
+    {
+        index = m_freeIndices.back();
+        m_freeIndices.pop_back();
+    }
+    else
+    {
+        // Evict the least recently used descriptor, but only if no frame in flight can still be reading it
+        if (m_lru.empty() || m_lru.back().lastUsedFrame > m_completedFrame)
+        {
+            return InvalidIndex;
+        }
+        index = m_lru.back().index;
+        m_residents.erase(m_lru.back().key);
+        m_lru.pop_back();
+        m_evictions++;
+    }
+
+    inserted = true;
+    m_lru.push_front(Resident{ key, index, m_frame });
+    m_residents.emplace(key, m_lru.begin());
+    return index;
+}
+
+void BindlessIndexTable::EndFrame(uint64_t fenceValue)
+{
+    m_frames.push(FrameEntry{ m_frame, fenceValue });
+    m_frame++;
+}
+
+void BindlessIndexTable::Retire(uint64_t completedFenceValue)
+{
+    // Frames complete in order, so stop at the first one still in flight
+    while (!m_frames.empty() && m_frames.front().fenceValue <= completedFenceValue)
+    {
+        m_completedFrame = m_frames.front().frame;
+        m_frames.pop();
+    }
+}
@@ -0,0 +1,79 @@
+#pragma once
+#include <cstdint>
+#include <list>
+#include <queue>
+#include <unordered_map>
+#include <vector>
+
+/**
+* CPU side table of which descriptors are resident in the bindless region of the shader visible heap, and at which index.
+* Shaders index the region directly, so a resident descriptor keeps its index across frames and is only copied in once.
+* When the region is full the least recently used descriptor is evicted, but only once every frame that used it has completed on the GPU.
+* Owns no D3D12 objects, fence progression can be simulated by feeding it plain values.
+*/
+class BindlessIndexTable
+{
+public:
+	static const uint32_t InvalidIndex = UINT32_MAX;
+
+	/**
+	* @param capacity The number of descriptors in the bindless region
+	* @param reservedIndices The number of indices at the start of the region kept out of the table, i.e. for a null descriptor
+	*/
+	BindlessIndexTable(uint32_t capacity, uint32_t reservedIndices = 0);
+
+	/**
+	* Find, or make, the index of a descriptor for the frame being recorded.
+	* @param key Identifies the descriptor, i.e. its DescriptorHandle's value
+	* @param inserted Out, true if the descriptor wasn't resident and must be copied into the returned index
+	* @returns The descriptor's index in the region, or InvalidIndex if every index is in use by frames in flight
+	*/
+	uint32_t Acquire(uint32_t key, bool& inserted);
+
+	/**
+	* Close the frame being recorded.
+	* @param fenceValue The fence value signalled after the frame's command lists
+	*/
+	void EndFrame(uint64_t fenceValue);
+	/**
+	* Allow eviction of descriptors last used by frames the GPU has finished.
+	* @param completedFenceValue The value the fence has currently reached
+	*/
+	void Retire(uint64_t completedFenceValue);
+
+	uint32_t GetResidentCount() const
+	{
+		return static_cast<uint32_t>(m_residents.size());
+	}
+	uint64_t GetEvictionCount() const
+	{
+		return m_evictions;
+	}
+
+private:
+	struct Resident
+	{
+		uint32_t key;
+		uint32_t index;
+		/** The frame that most recently used the descriptor */
+		uint64_t lastUsedFrame;
+	};
+
+	/** Most recently used at the front */
+	std::list<Resident> m_lru;
+	std::unordered_map<uint32_t, std::list<Resident>::iterator> m_residents;
+	std::vector<uint32_t> m_freeIndices;
+
+	/** Frames are numbered as they're recorded, and mapped to fence values once submitted */
+	uint64_t m_frame;
+	/** Every frame up to and including this one has completed on the GPU */
+	uint64_t m_completedFrame;
+	struct FrameEntry
+	{
+		uint64_t frame;
+		uint64_t fenceValue;
+	};
+	std::queue<FrameEntry> m_frames;
+
+	uint64_t m_evictions;
+};
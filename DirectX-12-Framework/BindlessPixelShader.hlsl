@@ -0,0 +1,21 @@
+struct PSInput
+{
+    float4 position : SV_POSITION;
+    float2 uv : TEXCOORD;
+};
+
+// Indices into the bindless arrays, set by each object's bundle
+cbuffer DrawConstants : register(b1)
+{
+    uint textureIndex;
+    uint objectIndex;
+};
+
+SamplerState g_sampler : register(s0);
+// Every resident texture, indexed rather than bound. Index 0 is a null texture
+Texture2D g_textures[] : register(t0, space1);
+
+float4 main(PSInput input) : SV_TARGET
+{
+    return g_textures[textureIndex].Sample(g_sampler, input.uv);
+}
\ No newline at end of file
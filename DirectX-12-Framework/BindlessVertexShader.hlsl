@@ -0,0 +1,38 @@
+// The pass's view, written once per pass
+cbuffer ViewConstants : register(b0)
+{
+    float4x4 viewProjection;
+};
+
+// Indices into the bindless arrays, set by each object's bundle
+cbuffer DrawConstants : register(b1)
+{
+    uint textureIndex;
+    uint objectIndex;
+};
+
+// Every object's world matrix, written once per frame and shared by every pass
+StructuredBuffer<float4x4> g_worlds : register(t0, space2);
+
+struct VSInput
+{
+    float3 position : POSITION;
+    float2 uv : TEXCOORD;
+};
+
+struct PSInput
+{
+    float4 position : SV_POSITION;
+    float2 uv : TEXCOORD;
+};
+
+PSInput main(VSInput input)
+{
+    PSInput result;
+
+    float4 worldPosition = mul(float4(input.position, 1.0f), g_worlds[objectIndex]);
+    result.position = mul(worldPosition, viewProjection);
+    result.uv = input.uv;
+    
+    return result;
+}
\ No newline at end of file
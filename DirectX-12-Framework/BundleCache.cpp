@@ -0,0 +1,129 @@
+#include "BundleCache.h"
+#include "DescriptorHeap.h"
+#include "Primitive.h"
+
+size_t BundleCache::KeyHash::operator()(const Key& key) const
+{
+    size_t hash = std::hash<const void*>()(key.pipelineState);
+    auto combine = [&hash](size_t value)
+    {
+        hash ^= value + 0x9e3779b97f4a7c15ull + (hash << 6) + (hash >> 2);
+    };
+    combine(std::hash<const void*>()(key.rootSignature));
+    combine(std::hash<const void*>()(key.model));
+    combine((size_t(key.textureIndex) << 32) | key.objectIndex);
+    return hash;
+}
+
+BundleCache::BundleCache(ID3D12Device* device, uint32_t maxIdleFrames)
+    : m_device(device)
+    , m_maxIdleFrames(maxIdleFrames)
+    , m_bundles()
+    , m_spares()
+    , m_frame(1)
+    , m_completedFrame(0)
+    , m_nextSweepFrame(1)
+    , m_frames()
+    , m_stats()
+{
+}
+
+ID3D12GraphicsCommandList* BundleCache::GetBundle(ThreadBundles& thread, const std::shared_ptr<Primitive>& model, UINT textureIndex, UINT objectIndex)
+{
+    Key key{ model->GetBindlessPipelineState(), model->GetRootSignature(), model.get(), textureIndex, objectIndex };
+    auto found = m_bundles.find(key);
+    if (found != m_bundles.end())
+    {
+        thread.m_stats.hits++;
+        // Only written once a frame, so threads drawing the object again just read it
+        if (found->second.lastUsedFrame.load(std::memory_order_relaxed) != m_frame)
+        {
+            found->second.lastUsedFrame.store(m_frame, std::memory_order_relaxed);
+        }
+        return found->second.bundle.Get();
+    }
+    found = thread.m_recorded.find(key);
+    if (found != thread.m_recorded.end())
+    {
+        thread.m_stats.hits++;
+        return found->second.bundle.Get();
+    }
+
+    // Each bundle has an allocator of its own, so it can be released on its own once it goes unused
+    Microsoft::WRL::ComPtr<ID3D12CommandAllocator> allocator;
+    Microsoft::WRL::ComPtr<ID3D12GraphicsCommandList> bundle;
+    ThrowIfFailed(m_device->CreateCommandAllocator(D3D12_COMMAND_LIST_TYPE_BUNDLE, IID_PPV_ARGS(&allocator)), "Couldn't create bundle allocator.\n");
+    ThrowIfFailed(m_device->CreateCommandList(0, D3D12_COMMAND_LIST_TYPE_BUNDLE, allocator.Get(), key.pipelineState, IID_PPV_ARGS(&bundle)), "Couldn't create bundle.\n");
+
+    // Setting the calling list's root signature again keeps the bindings it inherits, i.e. the bindless table and the pass's constants
+    bundle->SetGraphicsRootSignature(key.rootSignature);
+    UINT indices[] = { textureIndex, objectIndex };
+    bundle->SetGraphicsRoot32BitConstants(DescriptorHeap::RootParameterIndices::DrawConstants, _countof(indices), indices, 0);
+    model->RecordDraw(bundle.Get());
+    ThrowIfFailed(bundle->Close());
+    thread.m_stats.recorded++;
+
+    // Entries are built in place, as their atomic can't be moved
+    Entry& entry = thread.m_recorded[key];
+    entry.allocator = allocator;
+    entry.bundle = bundle;
+    entry.model = model;
+    entry.lastUsedFrame = m_frame;
+    return bundle.Get();
+}
+
+void BundleCache::Merge(ThreadBundles& thread)
+{
+    // Moving the map's nodes moves the bundles without copying or rehashing their entries
+    while (!thread.m_recorded.empty())
+    {
+        auto inserted = m_bundles.insert(thread.m_recorded.extract(thread.m_recorded.begin()));
+        if (!inserted.inserted)
+        {
+            m_spares.push_back(Spare{ m_frame, std::move(inserted.node) });
+        }
+    }
+
+    m_stats.hits += thread.m_stats.hits;
+    m_stats.recorded += thread.m_stats.recorded;
+    thread.m_stats = Stats();
+}
+
+void BundleCache::EndFrame(uint64_t fenceValue)
+{
+    m_frames.push(FrameEntry{ m_frame, fenceValue });
+    m_frame++;
+}
+
+void BundleCache::Retire(uint64_t completedFenceValue)
+{
+    // Frames complete in order, so stop at the first one still in flight
+    while (!m_frames.empty() && m_frames.front().fenceValue <= completedFenceValue)
+    {
+        m_completedFrame = m_frames.front().frame;
+        m_frames.pop();
+    }
+    while (!m_spares.empty() && m_spares.front().frame <= m_completedFrame)
+    {
+        m_spares.pop_front();
+    }
+
+    // Objects rarely change model or texture, so only look for idle bundles once in a while rather than every frame
+    if (m_frame < m_nextSweepFrame)
+    {
+        return;
+    }
+    m_nextSweepFrame = m_frame + m_maxIdleFrames;
+    for (auto entry = m_bundles.begin(); entry != m_bundles.end();)
+    {
+        if (entry->second.lastUsedFrame <= m_completedFrame && m_frame - entry->second.lastUsedFrame > m_maxIdleFrames)
+        {
+            entry = m_bundles.erase(entry);
+            m_stats.evicted++;
+        }
+        else
+        {
+            ++entry;
+        }
+    }
+}
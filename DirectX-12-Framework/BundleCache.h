@@ -0,0 +1,141 @@
+#pragma once
+#include "stdafx.h"
+#include <atomic>
+#include <deque>
+#include <memory>
+#include <queue>
+#include <unordered_map>
+
+class Primitive;
+
+/**
+* Bundles recording an object's whole draw: pipeline state, root signature, its bindless indices, vertex and index buffers, and the draw itself.
+* Everything in a bundle is fixed by its key, so a bundle is recorded once and replayed every frame, until a changed model or texture gives the object a new key.
+* The pass's view and object constants the object index picks from are root descriptors set by the calling list, which bundles inherit.
+* Bundles not used for a while are released once the frames that executed them have completed.
+* Several recording threads can look up bundles at once, each recording any it misses into ThreadBundles of its own, which Merge() adds to the cache once recording has finished.
+* The cache itself is only changed between recordings, so looking a bundle up takes no lock.
+*/
+class BundleCache
+{
+public:
+	struct Key
+	{
+		ID3D12PipelineState* pipelineState;
+		ID3D12RootSignature* rootSignature;
+		const Primitive* model;
+		UINT textureIndex;
+		UINT objectIndex;
+
+		bool operator==(const Key& other) const = default;
+	};
+
+	/**
+	* Counts since the cache was created.
+	*/
+	struct Stats
+	{
+		/** Draws whose bundle was already recorded */
+		uint64_t hits = 0;
+		/** Bundles recorded because none matched */
+		uint64_t recorded = 0;
+		/** Bundles released after going unused */
+		uint64_t evicted = 0;
+	};
+
+	/**
+	* @param device The device to create bundles with
+	* @param maxIdleFrames How many frames a bundle can go unused before it's released
+	*/
+	BundleCache(ID3D12Device* device, uint32_t maxIdleFrames);
+
+	class ThreadBundles;
+
+	/**
+	* Find or record the bundle drawing a model with a bindless texture and an object's constants.
+	* Safe to call from several threads at once, each with its own ThreadBundles, but not alongside Merge(), EndFrame() or Retire().
+	* @param thread The calling thread's bundles, which a bundle it has to record is added to
+	* @param model The model to draw, kept alive as long as the bundle that draws it
+	* @param textureIndex The texture's bindless index, as it's only fixed while the texture stays resident
+	* @param objectIndex The object's index into the object constants
+	* @returns The bundle to execute
+	*/
+	ID3D12GraphicsCommandList* GetBundle(ThreadBundles& thread, const std::shared_ptr<Primitive>& model, UINT textureIndex, UINT objectIndex);
+	/**
+	* Add the bundles a thread recorded to the cache, and its counts to the cache's.
+	* If two threads recorded the same bundle, both were executed, so the spare is kept until the frame completes.
+	*/
+	void Merge(ThreadBundles& thread);
+
+	/**
+	* Close the frame being recorded.
+	* @param fenceValue The fence value signalled after the frame's command lists, after which its bundles are no longer executing
+	*/
+	void EndFrame(uint64_t fenceValue);
+	/**
+	* Release bundles left unused too long, once every frame that executed them has completed.
+	* @param completedFenceValue The value the fence has currently reached
+	*/
+	void Retire(uint64_t completedFenceValue);
+
+	uint32_t GetLiveCount() const
+	{
+		return static_cast<uint32_t>(m_bundles.size());
+	}
+	const Stats& GetStats() const
+	{
+		return m_stats;
+	}
+
+private:
+	struct KeyHash
+	{
+		size_t operator()(const Key& key) const;
+	};
+	struct Entry
+	{
+		Microsoft::WRL::ComPtr<ID3D12CommandAllocator> allocator;
+		Microsoft::WRL::ComPtr<ID3D12GraphicsCommandList> bundle;
+		std::shared_ptr<Primitive> model;
+		/** Atomic, as threads drawing the same object from different passes mark it used at once */
+		std::atomic<uint64_t> lastUsedFrame;
+	};
+	typedef std::unordered_map<Key, Entry, KeyHash> Bundles;
+	struct Spare
+	{
+		uint64_t frame;
+		Bundles::node_type node;
+	};
+	struct FrameEntry
+	{
+		uint64_t frame;
+		uint64_t fenceValue;
+	};
+
+	Microsoft::WRL::ComPtr<ID3D12Device> m_device;
+	const uint32_t m_maxIdleFrames;
+
+	Bundles m_bundles;
+	/** Bundles recorded twice in one frame, in the order of the frames that recorded them */
+	std::deque<Spare> m_spares;
+	/** Frames are numbered as they're recorded, and mapped to fence values once submitted */
+	uint64_t m_frame;
+	/** Every frame up to and including this one has completed on the GPU */
+	uint64_t m_completedFrame;
+	/** Idle bundles are looked for every maxIdleFrames frames, from this one on */
+	uint64_t m_nextSweepFrame;
+	std::queue<FrameEntry> m_frames;
+
+	Stats m_stats;
+};
+
+/**
+* The bundles one recording thread has recorded since they were last merged, which only that thread looks up until then.
+*/
+class BundleCache::ThreadBundles
+{
+private:
+	friend class BundleCache;
+	Bundles m_recorded;
+	Stats m_stats;
+};
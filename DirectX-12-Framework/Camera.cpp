@@ -1,5 +1,6 @@
 #include "Camera.h"
 #include "Controls.h"
+#include "TransformStats.h"
 
 using namespace DirectX;
 
@@ -19,7 +20,10 @@ Camera::Camera(DirectX::XMFLOAT3 position, DirectX::XMFLOAT3 direction, DirectX:
 	m_moveUp(false),
 	m_moveDown(false),
 	m_moveForward(false),
-	m_moveBackward(false)
+	m_moveBackward(false),
+	m_viewDirty(true),
+	m_projDirty(true),
+	m_viewProjDirty(true)
 {
 	
 
@@ -27,12 +31,47 @@ Camera::Camera(DirectX::XMFLOAT3 position, DirectX::XMFLOAT3 direction, DirectX:
 
 const DirectX::XMMATRIX Camera::GetView()
 {
-	return XMMatrixLookToLH(XMLoadFloat3(&m_position), XMLoadFloat3(&m_direction), XMLoadFloat3(&m_up));
+	std::lock_guard<std::mutex> lock(m_matricesMutex);
+	UpdateMatrices();
+	return XMLoadFloat4x4(&m_view);
 }
 
 const DirectX::XMMATRIX Camera::GetProj()
 {
-	return XMMatrixPerspectiveFovLH(0.8f, m_aspectRatio, m_nearZ, m_farZ);
+	std::lock_guard<std::mutex> lock(m_matricesMutex);
+	UpdateMatrices();
+	return XMLoadFloat4x4(&m_proj);
+}
+
+const DirectX::XMMATRIX Camera::GetViewProjection()
+{
+	std::lock_guard<std::mutex> lock(m_matricesMutex);
+	UpdateMatrices();
+	return XMLoadFloat4x4(&m_viewProj);
+}
+
+void Camera::UpdateMatrices()
+{
+	if (m_viewDirty)
+	{
+		XMStoreFloat4x4(&m_view, XMMatrixLookToLH(XMLoadFloat3(&m_position), XMLoadFloat3(&m_direction), XMLoadFloat3(&m_up)));
+		TransformStats::CountRebuild(TransformStats::View);
+		m_viewDirty = false;
+		m_viewProjDirty = true;
+	}
+	if (m_projDirty)
+	{
+		XMStoreFloat4x4(&m_proj, XMMatrixPerspectiveFovLH(0.8f, m_aspectRatio, m_nearZ, m_farZ));
+		TransformStats::CountRebuild(TransformStats::Projection);
+		m_projDirty = false;
+		m_viewProjDirty = true;
+	}
+	if (m_viewProjDirty)
+	{
+		XMStoreFloat4x4(&m_viewProj, XMLoadFloat4x4(&m_view) * XMLoadFloat4x4(&m_proj));
+		TransformStats::CountRebuild(TransformStats::ViewProjection);
+		m_viewProjDirty = false;
+	}
 }
 
 const DirectX::XMMATRIX Camera::GetWorld()
@@ -182,6 +221,7 @@ void Camera::Update(const double deltaTime)
 
 			// Store the updated vectors back to the class members
 			XMStoreFloat3(&m_direction, lookDirVec);
+			m_viewDirty = true;
 			//XMStoreFloat3(&m_up, upVec);
 		}
 	}
@@ -200,6 +240,7 @@ void Camera::MoveForward(float distance)
 
 	// Move in the direction the camera is facing
 	XMStoreFloat3(&m_position, XMVectorMultiplyAdd(XMVectorReplicate(distance), forwardVec, posVec));
+	m_viewDirty = true;
 }
 
 void Camera::MoveRight(float distance)
@@ -214,6 +255,7 @@ void Camera::MoveRight(float distance)
 
 	// Move left by moving opposite to the right vector
 	XMStoreFloat3(&m_position, XMVectorMultiplyAdd(XMVectorReplicate(distance), rightVec, posVec));
+	m_viewDirty = true;
 }
 
 void Camera::MoveUp(float distance)
@@ -224,4 +266,5 @@ void Camera::MoveUp(float distance)
 
 	// Move in the direction the camera is facing
 	XMStoreFloat3(&m_position, XMVectorMultiplyAdd(XMVectorReplicate(distance), upVec, posVec));
+	m_viewDirty = true;
 }
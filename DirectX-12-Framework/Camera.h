@@ -1,5 +1,6 @@
 #pragma once
 #include "stdafx.h"
+#include <mutex>
 
 class Camera
 {
@@ -23,11 +24,28 @@ private:
 
     int m_dX;
     int m_dY;
+
+    /**
+    * The matrices as last computed, each rebuilt only when read after something it's computed from has changed,
+    * so a camera that hasn't moved costs every pass reading it nothing.
+    */
+    DirectX::XMFLOAT4X4 m_view;
+    DirectX::XMFLOAT4X4 m_proj;
+    DirectX::XMFLOAT4X4 m_viewProj;
+    bool m_viewDirty;
+    bool m_projDirty;
+    bool m_viewProjDirty;
+    /** Passes are recorded on several threads and read the same cameras, so whichever reads a stale matrix first rebuilds it under this */
+    std::mutex m_matricesMutex;
 public:
     Camera(DirectX::XMFLOAT3 position, DirectX::XMFLOAT3 direction, DirectX::XMFLOAT3 up, float aspectRatio = 1280 / 720);
 
     const DirectX::XMMATRIX GetView();
     const DirectX::XMMATRIX GetProj();
+    /** 
+    * @returns GetView() * GetProj(), for passes that only need the product
+    */
+    const DirectX::XMMATRIX GetViewProjection();
     const DirectX::XMMATRIX GetWorld();
 
     /** 
@@ -36,22 +54,27 @@ public:
     */
     void SetAspectRatio(float aspectRatio)
     {
-        m_aspectRatio = aspectRatio;
+        if (m_aspectRatio != aspectRatio)
+        {
+            m_aspectRatio = aspectRatio;
+            m_projDirty = true;
+        }
     }
 
+    // Setting what's already there, as portals do with their cameras every frame, keeps the cached view
     void SetPosition(const DirectX::XMFLOAT3 position)
     {
-        m_position = position;
+        SetViewVector(m_position, position);
     }
     
     void SetDirection(const DirectX::XMFLOAT3 direction)
     {
-        m_direction = direction;
+        SetViewVector(m_direction, direction);
     }
 
     void SetUp(const DirectX::XMFLOAT3 up)
     {
-        m_up = up;
+        SetViewVector(m_up, up);
     }
 
     DirectX::XMFLOAT3 GetPosition()
@@ -72,6 +95,19 @@ public:
 
     void Update(const double deltaTime);
 private:
+    void SetViewVector(DirectX::XMFLOAT3& member, const DirectX::XMFLOAT3& value)
+    {
+        if (member.x != value.x || member.y != value.y || member.z != value.z)
+        {
+            member = value;
+            m_viewDirty = true;
+        }
+    }
+    /** 
+    * Rebuild whichever matrices are stale. Call with m_matricesMutex held.
+    */
+    void UpdateMatrices();
+
     void MoveForward(float distance);
     void MoveBackward(float distance)
     {
@@ -2,115 +2,326 @@
 #include "ShaderResourceView.h"
 #include "ConstantBufferView.h"
 #include "Primitive.h"
+#include "Resource.h"
+#include "CommandQueue.h"
 
 
-const std::shared_ptr<ShaderResourceView> CbvSrvUavHeap::CreateShaderResourceView(ID3D12Device* device, ID3D12PipelineState* pipelineState, const wchar_t* path, std::string name)
+const std::shared_ptr<ShaderResourceView> CbvSrvUavHeap::CreateShaderResourceView(ID3D12Device* device, const wchar_t* path, std::string name)
 {
-    if (m_resetRequired)
-    {
-        m_commandAllocator->Reset();
-        m_commandList->Reset(m_commandAllocator.Get(), pipelineState);
-        m_resetRequired = false;
-    }
-
-    D3D12_CPU_DESCRIPTOR_HANDLE cpuDescriptorHandle;
-    D3D12_GPU_DESCRIPTOR_HANDLE gpuDescriptorHandle;
-    GetFreeHandle(cpuDescriptorHandle, gpuDescriptorHandle);
+    // The SRV is created into the staging heap, and only copied to this heap in frames it's drawn
+    DescriptorHandle descriptorHandle = m_stagingHeap->Allocate();
     UINT rootParameterIndex = RootParameterIndices::SRV;
 
-    auto srv = std::make_shared<ShaderResourceView>(cpuDescriptorHandle, gpuDescriptorHandle, rootParameterIndex);
+    auto srv = std::make_shared<ShaderResourceView>(descriptorHandle, rootParameterIndex, this);
     srv->name = name;
 
     // Ensure the load went correctly - if it didnt, return nullptr!
-    if (!srv->Load(device, m_commandList.Get(), path))
+    if (!srv->Load(device, GetUploadCommandList(), path))
     {
+        // Nothing is handed the SRV, so nothing else will free its descriptor. It was never copied from, so can be reused straight away
+        m_stagingHeap->Free(descriptorHandle, 0);
         return nullptr;
     }
-    m_load = true;
+    // The upload is submitted by the next Load(), which signals the copy queue's next fence value
+    srv->uploadFenceValue = m_copyQueue->GetNextFenceValue();
+    ReleaseWhenUploaded(std::move(srv->uploadResource));
 
     return srv;
 }
 
 const std::shared_ptr<ShaderResourceView> CbvSrvUavHeap::ReserveShaderResourceView(std::string name)
 {
-    D3D12_CPU_DESCRIPTOR_HANDLE cpuDescriptorHandle;
-    D3D12_GPU_DESCRIPTOR_HANDLE gpuDescriptorHandle;
-    GetFreeHandle(cpuDescriptorHandle, gpuDescriptorHandle);
+    // The descriptor belongs to whatever the caller creates into it, e.g. a render texture, which frees it when it's unloaded
+    DescriptorHandle descriptorHandle = m_stagingHeap->Allocate();
     UINT rootParameterIndex = RootParameterIndices::SRV;
 
-    auto srv = std::make_shared<ShaderResourceView>(cpuDescriptorHandle, gpuDescriptorHandle, rootParameterIndex);
+    auto srv = std::make_shared<ShaderResourceView>(descriptorHandle, rootParameterIndex, this);
     srv->name = name;
 
     return srv;
 }
 
-const std::shared_ptr<ConstantBufferView> CbvSrvUavHeap::CreateConstantBufferView(ID3D12Device* device)
+const std::shared_ptr<ConstantBufferView> CbvSrvUavHeap::CreateConstantBufferView(ConstantBufferArena* arena)
 {
-    D3D12_CPU_DESCRIPTOR_HANDLE cpuDescriptorHandle;
-    D3D12_GPU_DESCRIPTOR_HANDLE gpuDescriptorHandle;
-    GetFreeHandle(cpuDescriptorHandle, gpuDescriptorHandle);
+    // Unlike SRVs, CBVs have no staging descriptor, every object's constants are bound at once by address and each draw indexes its own
     UINT rootParameterIndex = RootParameterIndices::CBV;
 
-    auto cbv = std::make_shared<ConstantBufferView>(cpuDescriptorHandle, gpuDescriptorHandle, rootParameterIndex);
-    
-    cbv->Initialize(device);
-
-    return cbv;
+    return std::make_shared<ConstantBufferView>(rootParameterIndex, this, arena);
 }
 
-const std::shared_ptr<Primitive> CbvSrvUavHeap::CreateModel(ID3D12Device* device, ID3D12PipelineState* pipelineState, ID3D12RootSignature* rootSignature, const wchar_t* path, std::string name)
+const std::shared_ptr<Primitive> CbvSrvUavHeap::CreateModel(ID3D12Device* device, ID3D12PipelineState* pipelineState, ID3D12PipelineState* bindlessPipelineState, ID3D12RootSignature* rootSignature, const wchar_t* path, std::string name)
 {
-    if (m_resetRequired)
-    {
-        m_commandAllocator->Reset();
-        m_commandList->Reset(m_commandAllocator.Get(), pipelineState);
-        m_resetRequired = false;
-    }
-
     // Create the model
     auto model = std::make_shared<Primitive>(name);
 
     // If the model is loaded incorrectly, return nothing.
-    if (!model->Initialize(device, m_commandList.Get(), pipelineState, rootSignature, path))
+    if (!model->Initialize(device, GetUploadCommandList(), pipelineState, bindlessPipelineState, rootSignature, path))
     {
         return nullptr;
     }
-    m_load = true;
+    model->SetUploadFenceValue(m_copyQueue->GetNextFenceValue());
+    for (auto& uploadHeap : model->TakeUploadHeaps())
+    {
+        ReleaseWhenUploaded(std::move(uploadHeap));
+    }
 
     return model;
 }
 
-CbvSrvUavHeap::CbvSrvUavHeap(ID3D12Device* device, const D3D12_DESCRIPTOR_HEAP_DESC desc, ID3D12PipelineState* pipelineState) :
-    DescriptorHeap(device, desc)
+CbvSrvUavHeap::CbvSrvUavHeap(ID3D12Device* device, const D3D12_DESCRIPTOR_HEAP_DESC desc, UINT transientDescriptors, UINT tableDescriptors, UINT stagingDescriptors, UINT bindlessDescriptors, CommandQueue* copyQueue, CommandQueue* directQueue) :
+    DescriptorHeap(device, desc, transientDescriptors, tableDescriptors),
+    m_device(device),
+    m_copyQueue(copyQueue),
+    m_uploadCommandList(),
+    m_waitedUploadFenceValue(0),
+    // Blocks are small, as each recording thread holds the unused end of its last block until the frame retires
+    m_transientDescriptors(desc.NumDescriptors - transientDescriptors, transientDescriptors, 16, [directQueue](uint64_t fenceValue)
+        {
+            directQueue->WaitForFenceValue(fenceValue);
+        }),
+    m_descriptorsCopied(0),
+    m_lastFrameDescriptorsCopied(0),
+    m_bindless(true),
+    m_bindlessCpuStart(),
+    m_bindlessGpuStart(),
+    m_bindlessStart(0),
+    // Index 0 is kept for the null SRV
+    m_bindlessIndices(bindlessDescriptors, 1),
+    // Bundles are small, so one is kept for a couple of seconds after an object last drew with it
+    m_bundleCache(std::make_unique<BundleCache>(device, 120))
 {
-    CreateCommandList(device, pipelineState);
+    // The staging heap can't be bound, only copied from, which is what lets it grow
+    m_stagingHeap = std::make_unique<GrowableDescriptorHeap>(device, D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV, stagingDescriptors);
+
+    // The bindless region is one long-lived table, so the unbounded arrays in the shaders start at its first descriptor
+    GetFreeRange(bindlessDescriptors, m_bindlessCpuStart, m_bindlessGpuStart);
+    m_bindlessStart = static_cast<UINT>((m_bindlessCpuStart.ptr - m_cpuHeapStart.ptr) / m_descriptorSize);
+    // Draws without a texture sample a null SRV, which reads as zero, rather than whatever was bound before
+    D3D12_SHADER_RESOURCE_VIEW_DESC nullSrvDesc = {};
+    nullSrvDesc.Format = DXGI_FORMAT_R8G8B8A8_UNORM;
+    nullSrvDesc.ViewDimension = D3D12_SRV_DIMENSION_TEXTURE2D;
+    nullSrvDesc.Shader4ComponentMapping = D3D12_DEFAULT_SHADER_4_COMPONENT_MAPPING;
+    nullSrvDesc.Texture2D.MipLevels = 1;
+    device->CreateShaderResourceView(nullptr, &nullSrvDesc, m_bindlessCpuStart);
 }
 
-void CbvSrvUavHeap::CreateCommandList(ID3D12Device* device, ID3D12PipelineState* pipelineState)
+D3D12_GPU_DESCRIPTOR_HANDLE CbvSrvUavHeap::StageDescriptor(const DescriptorHandle stagingDescriptorHandle)
 {
-    ThrowIfFailed(device->CreateCommandAllocator(D3D12_COMMAND_LIST_TYPE_DIRECT, IID_PPV_ARGS(&m_commandAllocator)), "Couldn't create command allocator.\n");
+    UINT index = m_transientDescriptors.Stage(stagingDescriptorHandle.value);
+    ThrowIfFalse(index != TransientStager::InvalidIndex, "Transient descriptor region is full of the frame being recorded.\n");
+    return CD3DX12_GPU_DESCRIPTOR_HANDLE(m_gpuHeapStart, index, m_descriptorSize);
+}
 
-    // Create command list, and set it to closed state
-    ThrowIfFailed(device->CreateCommandList(
-        0,  // 0 for single GPU, for multi-adapter
-        D3D12_COMMAND_LIST_TYPE_DIRECT, // Create a direct command list that the GPU can execute
-        m_commandAllocator.Get(),   // Command allocator associated with this list
-        pipelineState,  // Pipeline state
-        IID_PPV_ARGS(&m_commandList)
-    ), "Failed to create command list.\n");
+void CbvSrvUavHeap::SetDrawResources(ID3D12GraphicsCommandList* commandList, Resource* texture, UINT objectIndex)
+{
+    BindingStats& bindingStats = m_threadRecordings.Get().bindingStats;
+    bindingStats.draws++;
+    if (texture)
+    {
+        RequireUpload(texture->uploadFenceValue);
+    }
+    if (m_bindless)
+    {
+        // Bindless draws with constants set their indices inside their bundle by DrawBundled(), and there's nothing to bind for those without
+        return;
+    }
+    else
+    {
+        if (texture)
+        {
+            texture->Set(commandList);
+            bindingStats.descriptorTables++;
+        }
+        if (objectIndex != InvalidObjectIndex)
+        {
+            // The pass binds every object's constants at once, so a draw only says which are its own and takes no descriptor
+            commandList->SetGraphicsRoot32BitConstant(RootParameterIndices::DrawConstants, objectIndex, 1);
+            bindingStats.rootConstants++;
+        }
+    }
 }
 
-bool CbvSrvUavHeap::Load(ID3D12CommandQueue* commandQueue)
+void CbvSrvUavHeap::DrawBundled(ID3D12GraphicsCommandList* commandList, const std::shared_ptr<Primitive>& model, Resource* texture, UINT objectIndex)
 {
-    bool load = m_load;
-    if (load)
+    ThreadRecording& recording = m_threadRecordings.Get();
+    recording.bindingStats.draws++;
+    if (texture)
     {
-        m_load = false;
-        m_commandList->Close();
+        RequireUpload(texture->uploadFenceValue);
+    }
+    RequireUpload(model->GetUploadFenceValue());
+
+    UINT textureIndex = texture ? GetBindlessIndex(texture->descriptorHandle) : 0;
+    // Found among the bundles merged in earlier frames, or recorded into the thread's own, so nothing is locked while recording or executing it
+    commandList->ExecuteBundle(m_bundleCache->GetBundle(recording.bundles, model, textureIndex, objectIndex));
+    recording.bindingStats.bundles++;
+}
+
+UINT CbvSrvUavHeap::GetBindlessIndex(const DescriptorHandle stagingDescriptorHandle)
+{
+    bool inserted;
+    UINT index;
+    {
+        std::lock_guard<std::mutex> lock(m_bindlessMutex);
+        index = m_bindlessIndices.Acquire(stagingDescriptorHandle.value, inserted);
+    }
+    ThrowIfFalse(index != BindlessIndexTable::InvalidIndex, "Bindless descriptor region is full.\n");
+
+    if (inserted)
+    {
+        // Copied alongside the transient descriptors, before the command list executes.
+        // Another thread may draw with the index before this one's copies are merged, which is fine as nothing executes until they have been
+        m_transientDescriptors.AddCopy(stagingDescriptorHandle.value, m_bindlessStart + index);
+    }
+    return index;
+}
+
+void CbvSrvUavHeap::CopyStagedDescriptors()
+{
+    m_threadRecordings.ForEach([this](ThreadRecording& recording)
+        {
+            m_bundleCache->Merge(recording.bundles);
+        });
+
+    m_transientDescriptors.TakeCopies(m_pendingCopies);
+    if (m_pendingCopies.empty())
+    {
+        return;
+    }
+
+    UINT destinationEnd = 0;
+    for (auto& copy : m_pendingCopies)
+    {
+        m_pendingSources.push_back(DescriptorHandle{ copy.source });
+        // Each thread's slots follow on from each other within a block, so extend the last destination range where possible
+        if (!m_pendingDestinationSizes.empty() && copy.destination == destinationEnd)
+        {
+            m_pendingDestinationSizes.back()++;
+        }
+        else
+        {
+            m_pendingDestinations.push_back(CD3DX12_CPU_DESCRIPTOR_HANDLE(m_cpuHeapStart, copy.destination, m_descriptorSize));
+            m_pendingDestinationSizes.push_back(1);
+        }
+        destinationEnd = copy.destination + 1;
+    }
 
-        ID3D12CommandList* loadCommandLists[] = { m_commandList.Get() };
-        commandQueue->ExecuteCommandLists(_countof(loadCommandLists), loadCommandLists);
-        m_resetRequired = true;
+    // Sources are only resolved now, as the staging heap may have grown since they were staged
+    UINT count = static_cast<UINT>(m_pendingSources.size());
+    m_stagingHeap->CopyDescriptors(
+        static_cast<UINT>(m_pendingDestinations.size()), m_pendingDestinations.data(), m_pendingDestinationSizes.data(),
+        m_pendingSources.data(), count
+    );
+    m_descriptorsCopied += count;
+
+    m_pendingCopies.clear();
+    m_pendingSources.clear();
+    m_pendingDestinations.clear();
+    m_pendingDestinationSizes.clear();
+}
+
+void CbvSrvUavHeap::FreeStaged(const DescriptorHandle stagingDescriptorHandle, uint64_t fenceValue)
+{
+    m_stagingHeap->Free(stagingDescriptorHandle, fenceValue);
+}
+
+void CbvSrvUavHeap::EndFrame(uint64_t fenceValue)
+{
+    DescriptorHeap::EndFrame(fenceValue);
+    // Slots are only shared within a frame, the next frame copies its descriptors afresh
+    m_transientDescriptors.EndFrame(fenceValue);
+    m_stagingHeap->EndFrame(fenceValue);
+    m_bindlessIndices.EndFrame(fenceValue);
+    m_bundleCache->EndFrame(fenceValue);
+
+    m_lastFrameBindingStats = BindingStats();
+    m_threadRecordings.ForEach([this](ThreadRecording& recording)
+        {
+            m_lastFrameBindingStats.draws += recording.bindingStats.draws;
+            m_lastFrameBindingStats.descriptorTables += recording.bindingStats.descriptorTables;
+            m_lastFrameBindingStats.rootConstants += recording.bindingStats.rootConstants;
+            m_lastFrameBindingStats.bundles += recording.bindingStats.bundles;
+            recording.bindingStats = BindingStats();
+        });
+
+    m_lastFrameDescriptorsCopied = m_descriptorsCopied;
+    m_descriptorsCopied = 0;
+}
+
+void CbvSrvUavHeap::Retire(uint64_t completedFenceValue)
+{
+    DescriptorHeap::Retire(completedFenceValue);
+    m_stagingHeap->Retire(completedFenceValue);
+    m_transientDescriptors.Retire(completedFenceValue);
+    m_bindlessIndices.Retire(completedFenceValue);
+    m_bundleCache->Retire(completedFenceValue);
+}
+
+void CbvSrvUavHeap::GetSnapshots(std::vector<DescriptorHeapSnapshot>& snapshots)
+{
+    DescriptorHeap::GetSnapshots(snapshots);
+
+    DescriptorHeapSnapshot transient;
+    transient.name = m_name + " transient";
+    m_transientDescriptors.GetStats().Fill(transient);
+    auto& ring = m_transientDescriptors.GetRing();
+    transient.capacity = ring.GetCapacity();
+    transient.occupied = ring.GetUsed();
+    transient.freeListLength = transient.capacity - transient.occupied;
+    // Slots held by frames already submitted, waiting on their fence
+    transient.pendingFrees = ring.GetUsed() - ring.GetFrameUsed();
+    snapshots.push_back(transient);
+
+    snapshots.push_back(m_stagingHeap->GetSnapshot(m_name + " staging"));
+}
+
+ID3D12GraphicsCommandList* CbvSrvUavHeap::GetUploadCommandList()
+{
+    // The copy queue pools its allocators, so the list's allocator is reused once the copy queue has finished with it
+    if (!m_uploadCommandList)
+    {
+        m_uploadCommandList = m_copyQueue->GetCommandList(nullptr);
+        m_uploadCommandList->SetName(L"Upload Command List");
+    }
+    return m_uploadCommandList.Get();
+}
+
+void CbvSrvUavHeap::ReleaseWhenUploaded(Microsoft::WRL::ComPtr<ID3D12Resource> uploadResource)
+{
+    // Only the copy reads the buffer, so it's done with once the copy queue passes the fence value the upload is tagged with
+    m_copyQueue->OnFenceComplete(m_copyQueue->GetNextFenceValue(), [uploadResource = std::move(uploadResource)]() mutable
+    {
+        uploadResource.Reset();
+    });
+}
+
+bool CbvSrvUavHeap::Load()
+{
+    if (!m_uploadCommandList)
+    {
+        return false;
+    }
+
+    // Signals the fence value every resource recorded to the list was tagged with
+    m_copyQueue->ExecuteCommandList(m_uploadCommandList.Get());
+    m_uploadCommandList.Reset();
+    return true;
+}
+
+uint64_t CbvSrvUavHeap::TakeUploadWait()
+{
+    uint64_t uploadFenceValue = 0;
+    m_threadRecordings.ForEach([&uploadFenceValue](ThreadRecording& recording)
+        {
+            if (recording.requiredUploadFenceValue > uploadFenceValue)
+                uploadFenceValue = recording.requiredUploadFenceValue;
+            recording.requiredUploadFenceValue = 0;
+        });
+    // The direct queue executes in order, so once it has waited for an upload every later frame is covered too
+    if (uploadFenceValue <= m_waitedUploadFenceValue)
+    {
+        return 0;
     }
-    return load;
+    m_waitedUploadFenceValue = uploadFenceValue;
+    return uploadFenceValue;
 }
\ No newline at end of file
@@ -1,7 +1,19 @@
 #pragma once
 #include "DescriptorHeap.h"
+#include "TransientStager.h"
+#include "GrowableDescriptorHeap.h"
+#include "BindlessIndexTable.h"
+#include "BundleCache.h"
+#include "DescriptorAllocator.h"
+#include "PerThread.h"
+#include <mutex>
 #include <unordered_set>
+#include <unordered_map>
+#include <vector>
 
+struct Resource;
+class CommandQueue;
+class ConstantBufferArena;
 struct ShaderResourceView;
 struct ConstantBufferView;
 class Primitive;
@@ -9,25 +21,228 @@ class Primitive;
 class CbvSrvUavHeap : public DescriptorHeap
 {
 public:
-    CbvSrvUavHeap(ID3D12Device* device, const D3D12_DESCRIPTOR_HEAP_DESC desc, ID3D12PipelineState* pipelineState);
-    bool Load(ID3D12CommandQueue* commandQueue);
+    /**
+    * @param device The ID3D12Device
+    * @param desc Description of the whole shader visible heap
+    * @param transientDescriptors Number of descriptors at the end of the heap set aside for per-draw descriptors, which live for a single frame
+    * @param tableDescriptors Number of descriptors before the transient region set aside for contiguous descriptor tables
+    * @param stagingDescriptors Initial size of the CPU only heap holding every SRV and CBV, which grows as needed
+    * @param bindlessDescriptors Size of the bindless region, claimed as one table from the table region
+    * @param copyQueue COPY queue textures and models are uploaded on, so uploads run alongside rendering rather than in front of it
+    * @param directQueue Queue frames execute on, waited on when the transient region is full of frames in flight
+    */
+    CbvSrvUavHeap(ID3D12Device* device, const D3D12_DESCRIPTOR_HEAP_DESC desc, UINT transientDescriptors, UINT tableDescriptors, UINT stagingDescriptors, UINT bindlessDescriptors, CommandQueue* copyQueue, CommandQueue* directQueue);
+    /**
+    * Submit every upload recorded since the last call to the copy queue.
+    * Nothing waits for them here, a frame only waits GPU-side once it draws one of the uploaded resources, see TakeUploadWait().
+    * @returns true if there were uploads to submit
+    */
+    bool Load();
+    /**
+    * Note a draw of something uploaded on the copy queue, so the frame drawing it waits for the upload. Safe to call from several recording threads at once.
+    * @param uploadFenceValue The copy queue fence value the upload completes at, 0 if it never needed uploading
+    */
+    void RequireUpload(uint64_t uploadFenceValue)
+    {
+        uint64_t& required = m_threadRecordings.Get().requiredUploadFenceValue;
+        if (uploadFenceValue > required)
+            required = uploadFenceValue;
+    }
+    /**
+    * Must only be called once recording has finished, as it merges what every recording thread required.
+    * @returns The copy queue fence value the frame being recorded must wait for before it executes, or 0 if everything it draws was already waited for
+    */
+    uint64_t TakeUploadWait();
 
-    const std::shared_ptr<ShaderResourceView> CreateShaderResourceView(ID3D12Device* device, ID3D12PipelineState* pipelineState, const wchar_t* path, std::string name);
+    const std::shared_ptr<ShaderResourceView> CreateShaderResourceView(ID3D12Device* device, const wchar_t* path, std::string name);
     const std::shared_ptr<ShaderResourceView> ReserveShaderResourceView(std::string name);
-    const std::shared_ptr<ConstantBufferView> CreateConstantBufferView(ID3D12Device* device);
-    const std::shared_ptr<Primitive> CreateModel(ID3D12Device* device, ID3D12PipelineState* pipelineState, ID3D12RootSignature* rootSignature, const wchar_t* path, std::string name);
+    /**
+    * @param arena Where the constant buffer's slot is, which passes write its constants to
+    */
+    const std::shared_ptr<ConstantBufferView> CreateConstantBufferView(ConstantBufferArena* arena);
+    const std::shared_ptr<Primitive> CreateModel(ID3D12Device* device, ID3D12PipelineState* pipelineState, ID3D12PipelineState* bindlessPipelineState, ID3D12RootSignature* rootSignature, const wchar_t* path, std::string name);
+
+    /**
+    * Counts of root parameter changes made binding draws, to compare bindless against descriptor tables.
+    */
+    struct BindingStats
+    {
+        UINT draws = 0;
+        UINT descriptorTables = 0;
+        UINT rootConstants = 0;
+        /** Draws made by executing a cached bundle, with no other per-draw call */
+        UINT bundles = 0;
+    };
+
+    bool IsBindless() const
+    {
+        return m_bindless;
+    }
+    /**
+    * Switch between binding each draw's texture and constants as descriptor tables, and passing their bindless indices as root constants.
+    */
+    void SetBindless(bool bindless)
+    {
+        m_bindless = bindless;
+    }
+    /**
+    * Bind a draw's texture and constants, by whichever method is current.
+    * Like the other methods that stage descriptors while recording, it can be called from several recording threads at once.
+    * Each thread stages into state of its own, so no lock is held while the command list is written.
+    * @param commandList The command list to bind to
+    * @param texture The texture to sample, or nullptr to leave it as is, or sample a null texture if bindless
+    * @param objectIndex Where the draw's world matrix is in the pass's object constants, or InvalidObjectIndex to skip binding it
+    */
+    void SetDrawResources(ID3D12GraphicsCommandList* commandList, Resource* texture, UINT objectIndex);
+
+    static const UINT InvalidObjectIndex = UINT32_MAX;
+    /**
+    * Draw a model bindlessly with a single ExecuteBundle, from a bundle which sets the pipeline state, the texture and object indices, and draws.
+    * The bundle inherits the pass's view and object constants, so the same bundle draws the object from every view.
+    * Can be called from several recording threads at once.
+    * @param commandList The direct command list to draw with, with the pass's constants set
+    * @param model The model to draw
+    * @param texture The texture to sample, or nullptr to sample a null texture
+    * @param objectIndex Where the object's world matrix is in the pass's object constants, its constant buffer's slot
+    */
+    void DrawBundled(ID3D12GraphicsCommandList* commandList, const std::shared_ptr<Primitive>& model, Resource* texture, UINT objectIndex);
+    const BundleCache& GetBundleCache() const
+    {
+        return *m_bundleCache;
+    }
+    /**
+    * Make a staging descriptor resident in the bindless region, copying it in if it isn't already. Safe to call from several recording threads at once.
+    * @param stagingDescriptorHandle The authoritative descriptor, in the staging heap
+    * @returns The descriptor's index in the bindless arrays
+    */
+    UINT GetBindlessIndex(const DescriptorHandle stagingDescriptorHandle);
+    /**
+    * @returns GPU handle to the start of the bindless region, to set as the bindless tables
+    */
+    D3D12_GPU_DESCRIPTOR_HANDLE GetBindlessTable() const
+    {
+        return m_bindlessGpuStart;
+    }
+    /**
+    * @returns The binding counts of the last completed frame
+    */
+    const BindingStats& GetBindingStats() const
+    {
+        return m_lastFrameBindingStats;
+    }
+
+    /**
+    * Give a staging descriptor a slot in the transient region for the frame being recorded. Safe to call from several recording threads at once.
+    * The copy itself is deferred until CopyStagedDescriptors(), and a descriptor staged twice by one thread in a frame shares one slot.
+    * If the region is full of frames in flight, waits for the oldest to complete. Throws only if the frame being recorded fills it on its own.
+    * @param stagingDescriptorHandle The authoritative descriptor, in the staging heap
+    * @returns GPU handle to bind the descriptor with, valid until the frame being recorded is retired
+    */
+    D3D12_GPU_DESCRIPTOR_HANDLE StageDescriptor(const DescriptorHandle stagingDescriptorHandle);
+    /**
+    * Copy every descriptor staged since the last call into the shader visible heap with a single CopyDescriptors, merging what every recording thread staged,
+    * along with the bundles they recorded. Must be called once recording has finished, before executing a command list that binds staged descriptors.
+    */
+    void CopyStagedDescriptors();
+    /**
+    * Return a staging descriptor to the staging heap, once the GPU has finished with it.
+    * @param stagingDescriptorHandle The descriptor to free
+    * @param fenceValue The fence value signalled after the last command list that could reference the descriptor
+    */
+    void FreeStaged(const DescriptorHandle stagingDescriptorHandle, uint64_t fenceValue);
+    /**
+    * Create a view into a descriptor in the staging heap, which can't grow while the view is written.
+    * @param stagingDescriptorHandle A descriptor in the staging heap
+    * @param writeView Creates the view at the CPU handle it's passed, which is only valid during the call
+    */
+    void WriteStagingView(const DescriptorHandle stagingDescriptorHandle, const std::function<void(D3D12_CPU_DESCRIPTOR_HANDLE)>& writeView)
+    {
+        m_stagingHeap->WriteView(stagingDescriptorHandle, writeView);
+    }
+    /**
+    * @returns The number of descriptors copied into the shader visible heap during the last completed frame
+    */
+    UINT GetDescriptorsCopied() const
+    {
+        return m_lastFrameDescriptorsCopied;
+    }
+    /**
+    * Close the frame being recorded, its transient descriptors are released once fenceValue completes.
+    * @param fenceValue The fence value signalled after the frame's final command list
+    */
+    void EndFrame(uint64_t fenceValue) override;
+    /**
+    * Release the transient descriptors of every frame the GPU has finished with, along with any deferred frees.
+    * @param completedFenceValue The value the frame fence has currently reached
+    */
+    void Retire(uint64_t completedFenceValue) override;
+    /**
+    * Append snapshots of the persistent heap, its transient region, and the staging heap.
+    */
+    void GetSnapshots(std::vector<DescriptorHeapSnapshot>& snapshots) override;
 
 
 protected:
     
     friend class Renderer;
-    void CreateCommandList(ID3D12Device* device, ID3D12PipelineState* pipelineState);
+    ID3D12Device* m_device;
+    /**
+    * @returns The copy command list uploads are being recorded to, taken from the copy queue when the first upload since the last Load() is recorded
+    */
+    ID3D12GraphicsCommandList* GetUploadCommandList();
+    /**
+    * Release an intermediate upload buffer once the upload recorded from it completes, rather than holding it for the life of the resource.
+    * Released on the copy queue's callback thread, so the frame thread never waits for it
+    */
+    void ReleaseWhenUploaded(Microsoft::WRL::ComPtr<ID3D12Resource> uploadResource);
 
-    // Shader resource view heap for accessing data in a resource (texture)
-    Microsoft::WRL::ComPtr<ID3D12GraphicsCommandList> m_commandList;
-    Microsoft::WRL::ComPtr<ID3D12CommandAllocator> m_commandAllocator;
+    CommandQueue* m_copyQueue;
+    /** Uploads recorded since the last Load(), null if there are none */
+    Microsoft::WRL::ComPtr<ID3D12GraphicsCommandList> m_uploadCommandList;
+    /** Highest upload fence value the direct queue has already been told to wait for */
+    uint64_t m_waitedUploadFenceValue;
 
-    bool m_load = false;
-    bool m_resetRequired = false;
-};
+    /** Per-draw descriptors, bump allocated each frame by each recording thread from blocks of its own, and retired by the frame fence */
+    TransientStager m_transientDescriptors;
 
+    /**
+    * Non shader visible heap owning the authoritative SRVs and CBVs.
+    * It's ordinary CPU memory, so it's cheap to write and read from, unlike the write-combined shader visible heap.
+    */
+    std::unique_ptr<GrowableDescriptorHeap> m_stagingHeap;
+    /** Copies merged from every recording thread by CopyStagedDescriptors(), each staging descriptor, and the runs of slots they're copied to in order */
+    std::vector<TransientStager::Copy> m_pendingCopies;
+    std::vector<DescriptorHandle> m_pendingSources;
+    std::vector<D3D12_CPU_DESCRIPTOR_HANDLE> m_pendingDestinations;
+    std::vector<UINT> m_pendingDestinationSizes;
+    UINT m_descriptorsCopied;
+    UINT m_lastFrameDescriptorsCopied;
+
+    bool m_bindless;
+    /** Region shaders index directly, with a null SRV at index 0 for draws without a texture */
+    D3D12_CPU_DESCRIPTOR_HANDLE m_bindlessCpuStart;
+    D3D12_GPU_DESCRIPTOR_HANDLE m_bindlessGpuStart;
+    /** Index of the bindless region's first descriptor in the heap */
+    UINT m_bindlessStart;
+    /** Which staging descriptors are resident in the bindless region, keyed by DescriptorHandle value */
+    BindlessIndexTable m_bindlessIndices;
+    /** Only held to look up or insert an index, copies are queued by the recording thread */
+    std::mutex m_bindlessMutex;
+
+    std::unique_ptr<BundleCache> m_bundleCache;
+
+    BindingStats m_lastFrameBindingStats;
+
+    /**
+    * What a recording thread gathers while recording passes, merged on the frame thread once recording has finished.
+    */
+    struct ThreadRecording
+    {
+        BindingStats bindingStats;
+        /** Highest upload fence value the thread drew with in the frame being recorded */
+        uint64_t requiredUploadFenceValue = 0;
+        /** Bundles the thread recorded this frame, merged into the bundle cache by CopyStagedDescriptors() */
+        BundleCache::ThreadBundles bundles;
+    };
+    PerThread<ThreadRecording> m_threadRecordings;
+};
@@ -0,0 +1,111 @@
+#include "CommandAllocatorPool.h"
+#include <cassert>
+
+CommandAllocatorPool::CommandAllocatorPool(uint32_t capacity, uint32_t maxIdleFrames)
+    : m_slots(capacity, Slot{ SlotState::Empty, 0, 0 })
+    , m_maxIdleFrames(maxIdleFrames)
+    , m_live(0)
+    , m_frame(0)
+    , m_stats()
+{
+}
+
+uint32_t CommandAllocatorPool::Acquire(uint64_t completedFenceValue, bool& create, uint64_t& waitFenceValue)
+{
+    create = false;
+    waitFenceValue = 0;
+
+    Retire(completedFenceValue);
+
+    // Reuse the most recently used free allocator, so the least used ones go idle and get trimmed
+    uint32_t index = InvalidIndex;
+    uint32_t empty = InvalidIndex;
+    uint32_t oldestInFlight = InvalidIndex;
+    for (uint32_t i = 0; i < m_slots.size(); i++)
+    {
+        const Slot& slot = m_slots[i];
+        if (slot.state == SlotState::Free && (index == InvalidIndex || slot.lastUsedFrame > m_slots[index].lastUsedFrame))
+        {
+            index = i;
+        }
+        else if (slot.state == SlotState::Empty && empty == InvalidIndex)
+        {
+            empty = i;
+        }
+        else if (slot.state == SlotState::InFlight && (oldestInFlight == InvalidIndex || slot.fenceValue < m_slots[oldestInFlight].fenceValue))
+        {
+            oldestInFlight = i;
+        }
+    }
+
+    if (index != InvalidIndex)
+    {
+        m_stats.reused++;
+    }
+    // Below the cap, a new allocator is cheaper than waiting
+    else if (empty != InvalidIndex)
+    {
+        index = empty;
+        create = true;
+        m_live++;
+        m_stats.created++;
+    }
+    // At the cap, wait for the allocator that will be finished soonest
+    else if (oldestInFlight != InvalidIndex)
+    {
+        index = oldestInFlight;
+        waitFenceValue = m_slots[index].fenceValue;
+        m_stats.waited++;
+        m_stats.reused++;
+    }
+    // Every allocator is recording, e.g. one thread claimed more passes in a frame than the cap.
+    // Waiting would never finish, as none of them has been submitted yet, so the pool grows past the cap instead
+    else
+    {
+        index = static_cast<uint32_t>(m_slots.size());
+        m_slots.push_back(Slot{ SlotState::Empty, 0, 0 });
+        create = true;
+        m_live++;
+        m_stats.created++;
+    }
+
+    m_slots[index].state = SlotState::Recording;
+    m_slots[index].lastUsedFrame = m_frame;
+    return index;
+}
+
+void CommandAllocatorPool::Release(uint32_t index, uint64_t fenceValue)
+{
+    assert(index < m_slots.size() && m_slots[index].state == SlotState::Recording && "Command allocator released without being acquired.");
+    m_slots[index].state = SlotState::InFlight;
+    m_slots[index].fenceValue = fenceValue;
+}
+
+void CommandAllocatorPool::EndFrame(uint64_t completedFenceValue, std::vector<uint32_t>& trimmed)
+{
+    m_frame++;
+    // Only free allocators are trimmed, in-flight ones still hold commands the GPU is reading
+    Retire(completedFenceValue);
+    for (uint32_t i = 0; i < m_slots.size(); i++)
+    {
+        Slot& slot = m_slots[i];
+        if (slot.state == SlotState::Free && m_frame - slot.lastUsedFrame > m_maxIdleFrames)
+        {
+            slot.state = SlotState::Empty;
+            m_live--;
+            m_stats.trimmed++;
+            trimmed.push_back(i);
+        }
+    }
+}
+
+void CommandAllocatorPool::Retire(uint64_t completedFenceValue)
+{
+    for (auto& slot : m_slots)
+    {
+        if (slot.state == SlotState::InFlight && slot.fenceValue <= completedFenceValue)
+        {
+            slot.state = SlotState::Free;
+        }
+    }
+}
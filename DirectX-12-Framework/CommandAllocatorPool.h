@@ -0,0 +1,112 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+
+/**
+* Decides which command allocator a recording thread should use next, out of a bounded set.
+* An allocator can only be reset once the GPU has finished the commands recorded into it, so each one is tagged with the fence value of the submission that used it.
+* A completed allocator is reused before a new one is created, the most recently used first so that rarely needed ones go idle.
+* At the cap, the caller is told to wait for the oldest in-flight allocator rather than create another, unless every allocator is still recording and none could ever complete,
+* in which case the pool grows. EndFrame() trims allocators left idle too long,
+* as an allocator keeps the memory of the largest list ever recorded into it until it's released.
+* Owns no D3D12 objects, it hands out slot indices, so fence progression can be simulated by feeding it plain values.
+*/
+class CommandAllocatorPool
+{
+public:
+	static const uint32_t InvalidIndex = UINT32_MAX;
+
+	/**
+	* Running totals of what Acquire() and EndFrame() did.
+	*/
+	struct Stats
+	{
+		/** New allocators the caller had to create */
+		uint64_t created = 0;
+		/** Allocators handed out again once their fence completed */
+		uint64_t reused = 0;
+		/** Acquires at the cap that had to wait for an allocator's fence */
+		uint64_t waited = 0;
+		/** Idle allocators released by EndFrame() */
+		uint64_t trimmed = 0;
+
+		Stats& operator+=(const Stats& other)
+		{
+			created += other.created;
+			reused += other.reused;
+			waited += other.waited;
+			trimmed += other.trimmed;
+			return *this;
+		}
+	};
+
+	/**
+	* @param capacity The most allocators the pool holds at once, unless more are recording at once than that
+	* @param maxIdleFrames How many frames an allocator can go unused before it's trimmed
+	*/
+	CommandAllocatorPool(uint32_t capacity, uint32_t maxIdleFrames);
+
+	/**
+	* Claim an allocator to record a command list with.
+	* @param completedFenceValue The value the fence has currently reached
+	* @param create Out, true if the slot is empty and the caller must create an allocator for it, otherwise the caller resets the one already there
+	* @param waitFenceValue Out, the fence value to wait for before resetting the allocator, 0 if it can be reset straight away
+	* @returns The allocator's slot, in [0, GetCapacity()). Past the cap if every allocator is recording, which grows the capacity
+	*/
+	uint32_t Acquire(uint64_t completedFenceValue, bool& create, uint64_t& waitFenceValue);
+	/**
+	* Hand an allocator back once the command list recorded with it has been submitted.
+	* @param index The slot from Acquire()
+	* @param fenceValue The fence value signalled after the submission, after which the allocator can be reset
+	*/
+	void Release(uint32_t index, uint64_t fenceValue);
+	/**
+	* Close a frame, and trim every completed allocator that hasn't been used for more than maxIdleFrames frames.
+	* @param completedFenceValue The value the fence has currently reached
+	* @param trimmed Out, appended with the slots emptied, whose allocators the caller should release
+	*/
+	void EndFrame(uint64_t completedFenceValue, std::vector<uint32_t>& trimmed);
+
+	/**
+	* @returns The number of allocators currently held, whether free, recording or in flight
+	*/
+	uint32_t GetLiveCount() const
+	{
+		return m_live;
+	}
+	uint32_t GetCapacity() const
+	{
+		return static_cast<uint32_t>(m_slots.size());
+	}
+	const Stats& GetStats() const
+	{
+		return m_stats;
+	}
+
+private:
+	/** Mark every in-flight allocator whose fence has been reached as free */
+	void Retire(uint64_t completedFenceValue);
+
+	enum class SlotState
+	{
+		Empty,
+		Free,
+		Recording,
+		InFlight
+	};
+
+	struct Slot
+	{
+		SlotState state;
+		/** Fence value of the last submission that used the allocator */
+		uint64_t fenceValue;
+		/** The frame the allocator was last acquired in */
+		uint64_t lastUsedFrame;
+	};
+
+	std::vector<Slot> m_slots;
+	const uint32_t m_maxIdleFrames;
+	uint32_t m_live;
+	uint64_t m_frame;
+	Stats m_stats;
+};
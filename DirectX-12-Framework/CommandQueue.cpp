@@ -10,47 +10,59 @@
 
 using namespace Microsoft::WRL;
 
-CommandQueue::CommandQueue(Microsoft::WRL::ComPtr<ID3D12Device> device, D3D12_COMMAND_LIST_TYPE type)
-    : m_fenceValue(0)
+CommandQueue::CommandQueue(Microsoft::WRL::ComPtr<ID3D12Device> device, D3D12_COMMAND_LIST_TYPE type, FenceCallbackDispatcher& fenceCallbacks, uint32_t allocatorsPerThread, uint32_t maxIdleFrames)
+    : m_allocatorsPerThread(allocatorsPerThread)
+    , m_maxIdleFrames(maxIdleFrames)
+    , m_submissions(0)
+    , m_commandListsSubmitted(0)
+    , m_lastFrameSubmissions(0)
+    , m_lastFrameCommandListsSubmitted(0)
     , m_commandListType(type)
     , m_device(device)
+    , m_fenceCallbacks(fenceCallbacks)
 {
     // create command queue
     m_commandQueue = CreateCommandQueue(m_device.Get(), m_commandListType);
-    // create fence
-    m_fence = CreateFence(m_device.Get());
-    // create fence event
-    m_fenceEvent = CreateEventHandle();
+    // create the fence the queue signals
+    m_timeline = std::make_unique<D3D12Timeline>(m_device.Get(), m_commandQueue.Get());
 }
 
 CommandQueue::~CommandQueue()
 {
-    ::CloseHandle(m_fenceEvent);
 }
 
 ComPtr<ID3D12GraphicsCommandList> CommandQueue::GetCommandList(ID3D12PipelineState* initialState)
 {
     ComPtr<ID3D12CommandAllocator> commandAllocator;
     ComPtr<ID3D12GraphicsCommandList> commandList;
-
-    // obtain an unused command allocator, that is not currently in flight on the command queue
-    // if there are any valid items in the queue, and the first (oldest) one has finished...
-    if (!m_commandAllocatorQueue.empty() && IsFenceComplete(m_commandAllocatorQueue.front().fenceValue))
+    RecordingAllocator recordingAllocator;
+    bool create;
+    uint64_t waitFenceValue;
+    // only the pools are shared, waiting, resetting and recording happen outside of the lock
+    std::unique_lock<std::mutex> lock(m_poolMutex);
+
+    // obtain an unused command allocator from this thread's pool, that is not currently in flight on the command queue
+    auto& threadAllocators = m_threadAllocators[std::this_thread::get_id()];
+    if (!threadAllocators)
     {
-        // reuse it and remove it from the front of the queue
-        commandAllocator = m_commandAllocatorQueue.front().commandAllocator;
-        m_commandAllocatorQueue.pop();
-
-        // reset it, ready for immediate resuse
-        ThrowIfFailed(commandAllocator->Reset());
+        threadAllocators = std::make_unique<ThreadAllocators>(ThreadAllocators{
+            CommandAllocatorPool(m_allocatorsPerThread, m_maxIdleFrames),
+            std::vector<ComPtr<ID3D12CommandAllocator>>(m_allocatorsPerThread)
+        });
     }
-    // if there are no free command allocators, create one
-    else
+    recordingAllocator.threadAllocators = threadAllocators.get();
+    recordingAllocator.index = threadAllocators->pool.Acquire(GetCompletedFenceValue(), create, waitFenceValue);
+    // if the pool has no allocator in that slot, create one
+    if (create)
     {
-        commandAllocator = CreateCommandAllocator();
+        // the pool grows past its cap if every allocator is recording
+        if (recordingAllocator.index >= threadAllocators->commandAllocators.size())
+        {
+            threadAllocators->commandAllocators.resize(recordingAllocator.index + 1);
+        }
+        threadAllocators->commandAllocators[recordingAllocator.index] = CreateCommandAllocator();
     }
-
-
+    commandAllocator = threadAllocators->commandAllocators[recordingAllocator.index];
 
     // obtain a command list ready for reuse
     // if there is a command list in the queue...
@@ -59,7 +71,22 @@ ComPtr<ID3D12GraphicsCommandList> CommandQueue::GetCommandList(ID3D12PipelineSta
         //...it will be reusable by nature, so pop it and use it
         commandList = m_commandListQueue.front();
         m_commandListQueue.pop();
+    }
+    lock.unlock();
+
+    if (!create)
+    {
+        // the pool is at its cap and every allocator is in flight, block until the oldest has finished
+        if (waitFenceValue)
+        {
+            m_timeline->WaitForValue(waitFenceValue);
+        }
+        // reset the allocator, ready for immediate reuse
+        ThrowIfFailed(commandAllocator->Reset());
+    }
 
+    if (commandList)
+    {
         // reset it, ready for immediate reuse
         ThrowIfFailed(commandList->Reset(commandAllocator.Get(), initialState));
     }
@@ -69,64 +96,132 @@ ComPtr<ID3D12GraphicsCommandList> CommandQueue::GetCommandList(ID3D12PipelineSta
         commandList = CreateCommandList(commandAllocator.Get(), initialState);
     }
 
-
-
-    // associate the command allocator with the command list
-    // assign a pointer to the command allocator to the private data of the command list
-    // this allows the command list to be easily tracked outside of this class. 
-    // The allocator can be retrieved from the command list and pushed back to the command allocator queue
-    ThrowIfFailed(commandList->SetPrivateDataInterface(__uuidof(ID3D12CommandAllocator), commandAllocator.Get()));
+    // associate the command allocator with the command list, so it can be handed back to its pool tagged with the fence value once the list is executed
+    lock.lock();
+    m_recordingAllocators[commandList.Get()] = recordingAllocator;
 
     return commandList;
 }
 
 uint64_t CommandQueue::ExecuteCommandList(ID3D12GraphicsCommandList* commandList)
 {
-    commandList->Close();
+    // a batch of one
+    ID3D12GraphicsCommandList* const commandLists[] = { commandList };
+    return ExecuteCommandLists(commandLists);
+}
 
-    // retreive assocaited command allocator from command list. This incrememnts reference counter
-    ID3D12CommandAllocator* commandAllocator;
-    UINT dataSize = sizeof(commandAllocator);
-    ThrowIfFailed(commandList->GetPrivateData(__uuidof(ID3D12CommandAllocator), &dataSize, &commandAllocator));
+uint64_t CommandQueue::ExecuteCommandLists(std::span<ID3D12GraphicsCommandList* const> commandLists)
+{
+    std::vector<ID3D12CommandList*> ppCommandLists;
+    ppCommandLists.reserve(commandLists.size());
 
-    // create a temporary array of command lists from the commandList
-    ID3D12CommandList* const ppCommandLists[] = { commandList };
+    for (auto commandList : commandLists)
+    {
+        commandList->Close();
+        ppCommandLists.push_back(commandList);
+    }
 
-    // pass the array to execution
-    m_commandQueue->ExecuteCommandLists(1, ppCommandLists);
-    // obtain the fence value that indicates this command allocator can be reused
+    // pass the whole batch to execution at once
+    m_commandQueue->ExecuteCommandLists(static_cast<UINT>(ppCommandLists.size()), ppCommandLists.data());
+    // obtain the fence value that indicates every allocator in the batch can be reused
     uint64_t fenceValue = Signal();
+    m_submissions++;
+    m_commandListsSubmitted += static_cast<uint32_t>(commandLists.size());
 
-    // assign this fence value to the command allocator and return it to the back of the queue for reuse
-    m_commandAllocatorQueue.emplace(CommandAllocatorEntry{ fenceValue, commandAllocator });
-    // return the (immediately free again) command list back to its queue
-    m_commandListQueue.push(commandList);
-
-    // decrement reference counter to command allocator by releasing this temporary pointer
-    commandAllocator->Release();
+    std::lock_guard<std::mutex> lock(m_poolMutex);
+    for (auto commandList : commandLists)
+    {
+        // assign this fence value to the list's allocator and return it to its pool for reuse
+        auto recordingAllocator = m_recordingAllocators.find(commandList);
+        assert(recordingAllocator != m_recordingAllocators.end() && "Command list was not taken from this queue.");
+        recordingAllocator->second.threadAllocators->pool.Release(recordingAllocator->second.index, fenceValue);
+        m_recordingAllocators.erase(recordingAllocator);
+
+        // return the (immediately free again) command list back to its queue
+        m_commandListQueue.push(commandList);
+    }
 
-    // return the fence value to wait for this commandlist to be executed
+    // return the fence value to wait for the batch to be executed
     return fenceValue;
 }
 
+void CommandQueue::EndFrame()
+{
+    m_lastFrameSubmissions = m_submissions.exchange(0);
+    m_lastFrameCommandListsSubmitted = m_commandListsSubmitted.exchange(0);
+
+    // an allocator keeps the memory of the largest list recorded into it, so release those that have gone unused, keeping memory flat over long sessions
+    std::lock_guard<std::mutex> lock(m_poolMutex);
+    uint64_t completedFenceValue = GetCompletedFenceValue();
+    std::vector<uint32_t> trimmed;
+    for (auto& threadAllocators : m_threadAllocators)
+    {
+        trimmed.clear();
+        threadAllocators.second->pool.EndFrame(completedFenceValue, trimmed);
+        for (auto index : trimmed)
+        {
+            threadAllocators.second->commandAllocators[index].Reset();
+        }
+    }
+}
+
+CommandAllocatorPool::Stats CommandQueue::GetAllocatorStats()
+{
+    std::lock_guard<std::mutex> lock(m_poolMutex);
+    CommandAllocatorPool::Stats stats;
+    for (auto& threadAllocators : m_threadAllocators)
+    {
+        stats += threadAllocators.second->pool.GetStats();
+    }
+    return stats;
+}
+
+uint32_t CommandQueue::GetLiveAllocatorCount()
+{
+    std::lock_guard<std::mutex> lock(m_poolMutex);
+    uint32_t live = 0;
+    for (auto& threadAllocators : m_threadAllocators)
+    {
+        live += threadAllocators.second->pool.GetLiveCount();
+    }
+    return live;
+}
+
 uint64_t CommandQueue::Signal()
 {
-    return Signal(m_commandQueue.Get(), m_fence.Get(), m_fenceValue);
+    return m_timeline->Signal();
 }
 
 bool CommandQueue::IsFenceComplete(uint64_t fenceValue)
 {
-    return m_fence->GetCompletedValue() > fenceValue;
+    // the fence holds the last value signalled, so a value is complete once the fence has reached it, not passed it
+    return m_timeline->IsComplete(fenceValue);
+}
+
+uint64_t CommandQueue::GetCompletedFenceValue()
+{
+    return m_timeline->GetCompletedValue();
 }
 
 void CommandQueue::WaitForFenceValue(uint64_t fenceValue)
 {
-    WaitForFenceValue(m_fence.Get(), fenceValue, m_fenceEvent);
+    m_timeline->WaitForValue(fenceValue);
 }
 
 void CommandQueue::Flush()
 {
-    Flush(m_commandQueue.Get(), m_fence.Get(), m_fenceValue, m_fenceEvent);
+    // Wait on a fresh signal, blocking the calling thread, meaning it is safe to release GPU referenced resources
+    m_timeline->Flush();
+}
+
+void CommandQueue::OnFenceComplete(uint64_t fenceValue, std::function<void()> callback)
+{
+    m_fenceCallbacks.OnFenceComplete(*m_timeline, fenceValue, std::move(callback));
+}
+
+void CommandQueue::Wait(const CommandQueue& other, uint64_t fenceValue)
+{
+    m_timeline->QueueWait(*other.m_timeline, fenceValue);
 }
 
 ComPtr<ID3D12CommandAllocator> CommandQueue::CreateCommandAllocator()
@@ -164,19 +259,6 @@ ComPtr<ID3D12CommandQueue> CommandQueue::CreateCommandQueue(ID3D12Device* device
     return d3d12CommandQueue;
 }
 
-ComPtr<ID3D12Fence> CommandQueue::CreateFence(ID3D12Device* device)
-{
-    ComPtr<ID3D12Fence> fence;
-
-    ThrowIfFailed(device->CreateFence(
-        0,  // initial value for the fence, often 0
-        D3D12_FENCE_FLAG_NONE,  // fence flags concerning sharing of the fence
-        IID_PPV_ARGS(&fence)    // out
-    ));
-
-    return fence;
-}
-
 ComPtr<ID3D12CommandAllocator> CommandQueue::CreateCommandAllocator(ID3D12Device* device, D3D12_COMMAND_LIST_TYPE type)
 {
     ComPtr<ID3D12CommandAllocator> commandAllocator;
@@ -206,50 +288,3 @@ ComPtr<ID3D12GraphicsCommandList> CommandQueue::CreateCommandList(ID3D12Device*
 
     return commandList;
 }
-
-HANDLE CommandQueue::CreateEventHandle()
-{
-    HANDLE fenceEvent;
-
-    //Create the OS event
-    fenceEvent = ::CreateEvent(
-        NULL,   // security attributes, allowing it to be inherited by child processes
-        FALSE,  // create a manual or auto-reset event
-        FALSE,  // initial state of the object, signalled or not
-        NULL    // name of the event object
-    );
-
-    //Ensure it was created
-    assert(fenceEvent && "Failed to create fence event.");
-
-    return fenceEvent;
-}
-
-uint64_t CommandQueue::Signal(ID3D12CommandQueue* commandQueue, ID3D12Fence* fence, uint64_t& fenceValue)
-{
-    uint64_t& fenceValueForSignal = ++fenceValue;
-
-    ThrowIfFailed(commandQueue->Signal(fence, fenceValueForSignal));
-
-    return fenceValueForSignal;
-}
-
-void CommandQueue::WaitForFenceValue(ID3D12Fence* fence, uint64_t fenceValue, HANDLE fenceEvent, std::chrono::milliseconds duration)
-{
-    // if the the fence has not yet reached the queried value
-    if (fence->GetCompletedValue() < fenceValue)
-    {
-        // register an event object with the fence, which is signalled once the fence has reached the specific value
-        ThrowIfFailed(fence->SetEventOnCompletion(fenceValue, fenceEvent));
-        // wait in turn for that event to a complete, to a maximum duration
-        ::WaitForSingleObject(fenceEvent, static_cast<DWORD>(duration.count()));
-    }
-}
-
-void CommandQueue::Flush(ID3D12CommandQueue* commandQueue, ID3D12Fence* fence, uint64_t fenceValue, HANDLE fenceEvent)
-{
-    // return the fence value to wait for
-    uint64_t fenceValueForSignal = Signal(commandQueue, fence, fenceValue);
-    // Wiat on that value, blocking the calling thread, meaning it is safe to release GPU referenced resources
-    WaitForFenceValue(fence, fenceValueForSignal, fenceEvent);
-}
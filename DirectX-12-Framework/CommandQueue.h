@@ -1,7 +1,17 @@
 #pragma once
 #include "stdafx.h"
+#include "CommandAllocatorPool.h"
+#include "D3D12Timeline.h"
+#include "FenceCallbackDispatcher.h"
+#include <atomic>
 #include <queue>
 #include <chrono>
+#include <memory>
+#include <mutex>
+#include <span>
+#include <thread>
+#include <unordered_map>
+#include <vector>
 
 #if defined(min)
 #undef min
@@ -14,20 +24,33 @@
 class CommandQueue
 {
 private:
-	/// <summary><para>associates a fence value with a command allocator</para>
+	/// <summary><para>the command allocators of one recording thread, and the pool deciding which to use next</para>
 	/// <para>command allocators cannot be reused until the commands stored in the allocator have finished execution on the command queue</para>
-	/// <para>a fence value is signalled on the command queue and is stored for later use</para></summary>
-	struct CommandAllocatorEntry
+	/// <para>so each is tagged with the fence value signalled after the batch it was submitted in</para></summary>
+	struct ThreadAllocators
 	{
-		uint64_t fenceValue;
-		Microsoft::WRL::ComPtr<ID3D12CommandAllocator> commandAllocator;
+		CommandAllocatorPool pool;
+		/// <summary>the allocator in each of the pool's slots, null while the slot is empty</summary>
+		std::vector<Microsoft::WRL::ComPtr<ID3D12CommandAllocator>> commandAllocators;
+	};
+	/// <summary>which pool and slot the allocator of a command list being recorded came from</summary>
+	struct RecordingAllocator
+	{
+		ThreadAllocators* threadAllocators;
+		uint32_t index;
 	};
 
-	/// <summary><para>queue of allocators currently in-flight on the GPU queue.</para>
-	/// <para>as soon as the fence value associated to each entry has been reached, the command allocator can be reused.</para></summary>
-	std::queue<CommandAllocatorEntry> m_commandAllocatorQueue;
+	/// <summary><para>allocators are pooled per recording thread, so a thread keeps reusing allocators sized for the passes it records</para></summary>
+	std::unordered_map<std::thread::id, std::unique_ptr<ThreadAllocators>> m_threadAllocators;
+	/// <summary>allocator of every command list handed out and not yet executed, keyed by the list</summary>
+	std::unordered_map<ID3D12GraphicsCommandList*, RecordingAllocator> m_recordingAllocators;
+	/// <summary>the most allocators each thread's pool holds, and how many frames one can go unused before it's released</summary>
+	const uint32_t m_allocatorsPerThread;
+	const uint32_t m_maxIdleFrames;
 	/// <summary>queue of command lists that can be reused, as the can be reused immediately after execution</summary>
 	std::queue<Microsoft::WRL::ComPtr<ID3D12GraphicsCommandList>> m_commandListQueue;
+	/// <summary>guards the allocator and command list pools, so passes can take their command lists from worker threads</summary>
+	std::mutex m_poolMutex;
 
 	/// <summary>type of d3d12 command queue</summary>
 	const D3D12_COMMAND_LIST_TYPE m_commandListType;
@@ -36,21 +59,29 @@ private:
 	/// <summary>command queue owned by this class</summary>
 	Microsoft::WRL::ComPtr<ID3D12CommandQueue> m_commandQueue;
 
-	/// <summary>Used to synchronize commands issued to command queue</summary>
-	Microsoft::WRL::ComPtr<ID3D12Fence> m_fence;
-	/// <summary>Handle to OS event used to recieve notification that fences have reached a certain value</summary>
-	HANDLE m_fenceEvent;
-	/// <summary>Next fence value to signal the command queue next</summary>
-	uint64_t m_fenceValue;
+	/// <summary>Used to synchronize commands issued to command queue, the queue's fence</summary>
+	std::unique_ptr<D3D12Timeline> m_timeline;
+	/// <summary>runs callbacks as the fence completes, on a thread shared with the other queues. It must be destroyed before the queue</summary>
+	FenceCallbackDispatcher& m_fenceCallbacks;
+
+	/// <summary>ExecuteCommandLists calls and command lists submitted since the last EndFrame(), atomic as passes may submit from several threads</summary>
+	std::atomic<uint32_t> m_submissions;
+	std::atomic<uint32_t> m_commandListsSubmitted;
+	/// <summary>the same counts for the last completed frame</summary>
+	uint32_t m_lastFrameSubmissions;
+	uint32_t m_lastFrameCommandListsSubmitted;
 
 public:
 	/// <summary>create the command queue</summary>
 	/// <param name="device">d3d device</param>
 	/// <param name="type">The type of cmmand queue to create</param>
-	CommandQueue(Microsoft::WRL::ComPtr<ID3D12Device> device, D3D12_COMMAND_LIST_TYPE type);
+	/// <param name="fenceCallbacks">the dispatcher that runs OnFenceComplete() callbacks, shared by every queue</param>
+	/// <param name="allocatorsPerThread">the most command allocators each recording thread can hold, past which it waits for one to complete</param>
+	/// <param name="maxIdleFrames">how many frames an allocator can go unused before it's released</param>
+	CommandQueue(Microsoft::WRL::ComPtr<ID3D12Device> device, D3D12_COMMAND_LIST_TYPE type, FenceCallbackDispatcher& fenceCallbacks, uint32_t allocatorsPerThread = 16, uint32_t maxIdleFrames = 120);
 	virtual ~CommandQueue();
 
-	/// <summary></summary>
+	/// <summary>safe to call from several threads at once, each list gets an allocator of its own</summary>
 	/// <returns>a command list immediately ready to issue commands, no need to reset or create a command allocator</returns>
 	Microsoft::WRL::ComPtr<ID3D12GraphicsCommandList> GetCommandList(ID3D12PipelineState* initialState);
 
@@ -59,19 +90,62 @@ public:
 	/// <param name="commandList">command list from GetCommandList(), with commands stored in it</param>
 	/// <returns>a fence value that can be used to check if/wait until the commands have finished executing</returns>
 	uint64_t ExecuteCommandList(ID3D12GraphicsCommandList* commandList);
+	/// <summary>closes and executes a batch of command lists from GetCommandList() in one submission, with a single signal for the whole batch</summary>
+	/// <param name="commandLists">command lists from GetCommandList(), executed in order</param>
+	/// <returns>a fence value that can be used to check if/wait until every list in the batch has finished executing</returns>
+	uint64_t ExecuteCommandLists(std::span<ID3D12GraphicsCommandList* const> commandLists);
+
+	/// <summary>close the frame's submission counts, and release allocators that have gone unused too long</summary>
+	void EndFrame();
+	/// <returns>created, reused, waited and trimmed allocator counts, summed over every recording thread, since the queue was created</returns>
+	CommandAllocatorPool::Stats GetAllocatorStats();
+	/// <returns>the number of command allocators currently held across every recording thread</returns>
+	uint32_t GetLiveAllocatorCount();
+	/// <returns>the number of ExecuteCommandLists submissions in the last completed frame</returns>
+	uint32_t GetSubmissionsLastFrame() const
+	{
+		return m_lastFrameSubmissions;
+	}
+	/// <returns>the number of command lists submitted in the last completed frame</returns>
+	uint32_t GetCommandListsLastFrame() const
+	{
+		return m_lastFrameCommandListsSubmitted;
+	}
 
 
 	/// <summary>Signal the fence from the GPU, done after all commands on the queue have finished executing</summary>
 	/// <returns>the fence value that the CPU thread should wait for before reusing any in-flight resources</returns>
 	uint64_t Signal();
-	/// <summary>Wait until the fence is signaled with a particular value, stalling the CPU thread until the GPU queue has finished executing commands</summary>
+	/// <summary>Wait until the fence is signaled with a particular value, stalling the CPU thread until the GPU queue has finished executing commands. Safe to call from several threads</summary>
 	void WaitForFenceValue(uint64_t fenceValue);
 	/// <summary>Wait until all previous commands have finished executing. Ensures back buffer resources have finsihed executing. A Singal followed by WaitForFenceValue</summary>
 	void Flush();
+	/// <summary>Make this queue wait GPU-side until another queue's fence reaches a value, without blocking the CPU thread. Only work submitted after the wait is held back</summary>
+	/// <param name="other">the queue to wait on, e.g. the copy queue uploads were submitted to</param>
+	/// <param name="fenceValue">the value returned when the work to wait for was submitted to the other queue</param>
+	void Wait(const CommandQueue& other, uint64_t fenceValue);
+	/// <summary>Run a callback once the fence reaches a value, rather than blocking a thread until it does, i.e. to release a resource the GPU has finished with. Safe to call from several threads</summary>
+	/// <param name="fenceValue">the fence value to wait for</param>
+	/// <param name="callback">run on the callback thread, so it must be safe to run from there</param>
+	void OnFenceComplete(uint64_t fenceValue, std::function<void()> callback);
 	/// <summary>Checks if a certain fence value is reached at this current point in time</summary>
 	/// <param name="fenceValue">the fence value to check</param>
 	/// <returns>true if this fence value has been reached</returns>
 	bool IsFenceComplete(uint64_t fenceValue);
+	/// <summary>Query how far the GPU has progressed through the queue, without blocking</summary>
+	/// <returns>the value the fence has currently reached</returns>
+	uint64_t GetCompletedFenceValue();
+	/// <summary>The value the next Signal() will use, so anything recorded but not yet signalled is covered by it</summary>
+	/// <returns>the fence value that retires all work submitted or recorded up to now</returns>
+	uint64_t GetNextFenceValue() const
+	{
+		return m_timeline->GetNextValue();
+	}
+	/// <returns>the queue's progress, for logic that works on any Timeline</returns>
+	Timeline& GetTimeline()
+	{
+		return *m_timeline;
+	}
 
 	/// <summary></summary>
 	/// <returns>Underlying ID3D12CommandQueue interface</returns>
@@ -95,10 +169,6 @@ protected:
 	/// <param name="type">copy, direct or compute</param>
 	/// <returns>comptr to the created command queue</returns>
 	Microsoft::WRL::ComPtr<ID3D12CommandQueue> CreateCommandQueue(ID3D12Device* device, D3D12_COMMAND_LIST_TYPE type);
-	/// <summary>Creates a fence, a GPU/CPU sync object. stores an internal value that is udated after singalling, used to wait for events</summary>
-	/// <param name="device">the d3d12 device</param>
-	/// <returns>comptr to the newly created fence</returns>
-	Microsoft::WRL::ComPtr < ID3D12Fence> CreateFence(ID3D12Device* device);
 	/// <summary>create the command allocator, used by a command list as backing memory</summary>
 	/// <param name="device">the d3d12 device</param>
 	/// <param name="type">a command list type specifying if it records either direct command lists or bundles: DIRECT, BUNDLE, COMPUTE, COPY</param>
@@ -110,30 +180,6 @@ protected:
 	/// <param name="type">the type: DIRECT, BUNDLE, COMPUTE, COPY</param>
 	/// <returns>comptr to the newly created CL</returns>
 	Microsoft::WRL::ComPtr < ID3D12GraphicsCommandList> CreateCommandList(ID3D12Device* device, ID3D12CommandAllocator* commandAllocator, ID3D12PipelineState* pipelineState, D3D12_COMMAND_LIST_TYPE type);
-	/// <summary>Create an OS event handle, used to allow the CPU thread to wait (block) for fence signalling</summary>
-	/// <returns>A handle to the os event</returns>
-	HANDLE CreateEventHandle();
-
-
-
-	/// <summary>Signal the fence from the GPU, done after all commands on the queue have finished executing</summary>
-	/// <param name="commandQueue">THe command queue to signal</param>
-	/// <param name="fence">The fence to be singalled</param>
-	/// <param name="fenceValue">value to singal the fence with</param>
-	/// <returns>the fence value that the CPU thread should wait for before reusing any in-flight resources</returns>
-	uint64_t Signal(ID3D12CommandQueue* commandQueue, ID3D12Fence* fence, uint64_t& fenceValue);
-	/// <summary>Wait until the fence is signaled with a particular value, stalling the CPU thread until the GPU queue has finished executing commands</summary>
-	/// <param name="fence">The fence to wait until it's signalled</param>
-	/// <param name="fenceValue">The value to query for</param>
-	/// <param name="fenceEvent">the event to wait on</param>
-	/// <param name="duration">the maximum duration to wait for</param>
-	void WaitForFenceValue(ID3D12Fence* fence, uint64_t fenceValue, HANDLE fenceEvent, std::chrono::milliseconds duration = std::chrono::milliseconds::max());
-	/// <summary>Wait until all previous commands have finished executing. Ensures back buffer resources have finsihed executing. A Singal followed by WaitForFenceValue</summary>
-	/// <param name="commandQueue">The command queue signal</param>
-	/// <param name="fence">The fence to wait until it's signalled</param>
-	/// <param name="fenceValue">The value to query for</param>
-	/// <param name="fenceEvent">the event to wait on</param>
-	void Flush(ID3D12CommandQueue* commandQueue, ID3D12Fence* fence, uint64_t fenceValue, HANDLE fenceEvent);
 
 };
 
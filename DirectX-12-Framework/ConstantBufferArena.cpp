@@ -0,0 +1,131 @@
+#include "ConstantBufferArena.h"
+#include "FrameConstantAllocator.h"
+#include "DescriptorHeap.h"
+
+using namespace DirectX;
+
+void ConstantBufferArena::Block::Set(ID3D12GraphicsCommandList* commandList) const
+{
+    // An empty block has no constants to bind, and nothing is drawn with it
+    if (IsEmpty())
+    {
+        return;
+    }
+    commandList->SetGraphicsRootConstantBufferView(DescriptorHeap::RootParameterIndices::CBV, viewConstants);
+    commandList->SetGraphicsRootShaderResourceView(DescriptorHeap::RootParameterIndices::ObjectConstants, objectConstants);
+}
+
+ConstantBufferArena::ConstantBufferArena(FrameConstantAllocator* frameConstants, UINT pageSize)
+    : m_frameConstants(frameConstants)
+    , m_pageSize(pageSize)
+    , m_pages()
+    , m_slotCount(0)
+    , m_worlds()
+    , m_worldsAddress(0)
+    , m_worldsCount(0)
+    , m_viewsWritten(0)
+    , m_objectsWritten(0)
+    , m_bytesWritten(0)
+    , m_lastFrameStats()
+{
+    AddPage();
+}
+
+UINT ConstantBufferArena::Allocate()
+{
+    // Earlier pages first, so slots stay packed towards the start
+    UINT slot = DescriptorAllocator::InvalidIndex;
+    for (size_t page = 0; page < m_pages.size() && slot == DescriptorAllocator::InvalidIndex; page++)
+    {
+        UINT index = m_pages[page]->Allocate();
+        if (index != DescriptorAllocator::InvalidIndex)
+        {
+            slot = static_cast<UINT>(page) * m_pageSize + index;
+        }
+    }
+    if (slot == DescriptorAllocator::InvalidIndex)
+    {
+        AddPage();
+        slot = static_cast<UINT>(m_pages.size() - 1) * m_pageSize + m_pages.back()->Allocate();
+    }
+
+    if (slot >= m_slotCount)
+    {
+        m_slotCount = slot + 1;
+    }
+    return slot;
+}
+
+void ConstantBufferArena::Free(UINT slot)
+{
+    // Free slots below the highest are still copied by UpdateWorlds(), just never drawn with
+    XMStoreFloat4x4(&m_worlds[slot], XMMatrixIdentity());
+    m_pages[slot / m_pageSize]->Free(slot % m_pageSize);
+}
+
+void ConstantBufferArena::AddPage()
+{
+    // Only between frames, so no pass is reading the matrices as they move
+    m_pages.push_back(std::make_unique<DescriptorAllocator>(m_pageSize));
+    XMFLOAT4X4 identity;
+    XMStoreFloat4x4(&identity, XMMatrixIdentity());
+    m_worlds.resize(m_worlds.size() + m_pageSize, identity);
+}
+
+void ConstantBufferArena::SetWorld(UINT slot, const DirectX::XMMATRIX& world)
+{
+    // Transposed here, when the object moves, rather than every frame, so the matrices are ready to copy as they are
+    XMStoreFloat4x4(&m_worlds[slot], XMMatrixTranspose(world));
+}
+
+void ConstantBufferArena::UpdateWorlds()
+{
+    m_worldsAddress = 0;
+    m_worldsCount = m_slotCount;
+    if (m_slotCount == 0)
+    {
+        return;
+    }
+
+    // The matrices are packed rather than each padded out to a constant buffer of its own, as the shader reads them as a structured buffer
+    UINT64 size = UINT64(m_slotCount) * sizeof(XMFLOAT4X4);
+    auto allocation = m_frameConstants->Allocate(size);
+    memcpy(allocation.cpuAddress, m_worlds.data(), size);
+    m_worldsAddress = allocation.gpuAddress;
+
+    m_objectsWritten.fetch_add(m_slotCount, std::memory_order_relaxed);
+    m_bytesWritten.fetch_add(size, std::memory_order_relaxed);
+}
+
+ConstantBufferArena::Block ConstantBufferArena::UpdateView(const DirectX::XMMATRIX& view, const DirectX::XMMATRIX& projection) const
+{
+    return UpdateView(view * projection);
+}
+
+ConstantBufferArena::Block ConstantBufferArena::UpdateView(const DirectX::XMMATRIX& viewProjection) const
+{
+    Block block;
+    if (m_worldsCount == 0)
+    {
+        return block;
+    }
+
+    // Only the matrix is written. The padding is never read, and skipping it saves write-combined bandwidth
+    auto allocation = m_frameConstants->Allocate(sizeof(ViewConstants));
+    XMStoreFloat4x4(&static_cast<ViewConstants*>(allocation.cpuAddress)->viewProjection, XMMatrixTranspose(viewProjection));
+
+    block.viewConstants = allocation.gpuAddress;
+    block.objectConstants = m_worldsAddress;
+    block.count = m_worldsCount;
+
+    m_viewsWritten.fetch_add(1, std::memory_order_relaxed);
+    m_bytesWritten.fetch_add(sizeof(XMFLOAT4X4), std::memory_order_relaxed);
+    return block;
+}
+
+void ConstantBufferArena::EndFrame()
+{
+    m_lastFrameStats.views = m_viewsWritten.exchange(0, std::memory_order_relaxed);
+    m_lastFrameStats.objects = m_objectsWritten.exchange(0, std::memory_order_relaxed);
+    m_lastFrameStats.bytes = m_bytesWritten.exchange(0, std::memory_order_relaxed);
+}
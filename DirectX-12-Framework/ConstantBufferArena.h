@@ -0,0 +1,146 @@
+#pragma once
+#include "stdafx.h"
+#include "DescriptorAllocator.h"
+#include <atomic>
+#include <memory>
+#include <vector>
+
+class FrameConstantAllocator;
+
+/**
+* Every object's constants, managed together rather than per object, and kept apart from each view's.
+* Each object has a slot holding its world matrix in one contiguous array. UpdateWorlds() copies the array into frame constants once a frame,
+* and every pass shares that copy, writing only its own view-projection with UpdateView(). The vertex shader combines the two,
+* so an object costs 64 bytes a frame however many views draw it, and a view costs 64 bytes however many objects it draws.
+* Slots are held in pages, and a page is added whenever every slot is taken, so the scene can hold any number of objects.
+*/
+class ConstantBufferArena
+{
+public:
+	/**
+	* A pass's constants: its view, and every slot's world matrix for the frame. Valid until the frame it was written in completes.
+	*/
+	struct Block
+	{
+		/** The view's constants, bound as the root CBV */
+		D3D12_GPU_VIRTUAL_ADDRESS viewConstants = 0;
+		/** Every slot's world matrix, slot after slot, bound as the root SRV the vertex shader indexes with each draw's object index */
+		D3D12_GPU_VIRTUAL_ADDRESS objectConstants = 0;
+		/** Slots written, those allocated later have no constants in the block */
+		UINT count = 0;
+
+		bool Contains(UINT slot) const
+		{
+			return slot < count;
+		}
+		/**
+		* @returns true if there were no slots when the block was written, so it holds no constants and contains no slot
+		*/
+		bool IsEmpty() const
+		{
+			return count == 0;
+		}
+		/**
+		* Bind the view and object constants for every draw after, including those in bundles, which inherit them. Does nothing for an empty block.
+		*/
+		void Set(ID3D12GraphicsCommandList* commandList) const;
+	};
+
+	/**
+	* What was written to frame constants over a frame.
+	*/
+	struct WriteStats
+	{
+		/** View constants written, one per pass */
+		uint32_t views = 0;
+		/** World matrices written, one per object, shared by every pass */
+		uint32_t objects = 0;
+		uint64_t bytes = 0;
+	};
+
+	/**
+	* @param frameConstants Where the constants are allocated from
+	* @param pageSize The number of slots added at a time, starting with one page
+	*/
+	ConstantBufferArena(FrameConstantAllocator* frameConstants, UINT pageSize);
+
+	/**
+	* Claim a slot, lowest first so the world matrices only cover as many slots as there have been objects at once. Adds a page if every slot is taken.
+	* Slots are only allocated and freed between frames, never while passes are being recorded.
+	* @returns The slot
+	*/
+	UINT Allocate();
+	void Free(UINT slot);
+	/**
+	* Set the world matrix of a slot, copied to the GPU by the next UpdateWorlds().
+	*/
+	void SetWorld(UINT slot, const DirectX::XMMATRIX& world);
+
+	/**
+	* Copy every slot's world matrix into frame constants, for every pass this frame to share. Call once a frame, before any pass's UpdateView().
+	*/
+	void UpdateWorlds();
+	/**
+	* Write the constants of one view, which every object drawn by a pass shares. Only reads the world matrices, so passes can each write their own view at once.
+	* @returns The pass's block, or an empty block if there are no slots
+	*/
+	Block UpdateView(const DirectX::XMMATRIX& viewProjection) const;
+	Block UpdateView(const DirectX::XMMATRIX& view, const DirectX::XMMATRIX& projection) const;
+
+	/**
+	* Close the frame's write counts, keeping them for GetLastFrameStats(). Call once every pass has been recorded.
+	*/
+	void EndFrame();
+	const WriteStats& GetLastFrameStats() const
+	{
+		return m_lastFrameStats;
+	}
+
+	FrameConstantAllocator* GetFrameConstants() const
+	{
+		return m_frameConstants;
+	}
+	/**
+	* @returns The number of slots UpdateWorlds() covers, i.e. one past the highest slot handed out
+	*/
+	UINT GetSlotCount() const
+	{
+		return m_slotCount;
+	}
+	/**
+	* @returns The number of slots in every page so far
+	*/
+	UINT GetCapacity() const
+	{
+		return static_cast<UINT>(m_worlds.size());
+	}
+
+private:
+	void AddPage();
+
+	/** A view's constants, padded out to the alignment every constant buffer starts on */
+	struct ViewConstants
+	{
+		DirectX::XMFLOAT4X4 viewProjection;
+		float padding[48];
+	};
+	static_assert((sizeof(ViewConstants) % D3D12_CONSTANT_BUFFER_DATA_PLACEMENT_ALIGNMENT) == 0, "Constant Buffer size must be 256-byte aligned");
+
+	FrameConstantAllocator* m_frameConstants;
+
+	const UINT m_pageSize;
+	/** Slot i is index i % pageSize of page i / pageSize */
+	std::vector<std::unique_ptr<DescriptorAllocator>> m_pages;
+	UINT m_slotCount;
+	/** Each slot's world matrix, transposed for the shader and in slot order, so UpdateWorlds() is a single copy */
+	std::vector<DirectX::XMFLOAT4X4> m_worlds;
+	/** Where this frame's UpdateWorlds() copied the world matrices to, and how many */
+	D3D12_GPU_VIRTUAL_ADDRESS m_worldsAddress;
+	UINT m_worldsCount;
+
+	/** Views are written by passes being recorded in parallel, so counted atomically */
+	mutable std::atomic<uint32_t> m_viewsWritten;
+	std::atomic<uint32_t> m_objectsWritten;
+	mutable std::atomic<uint64_t> m_bytesWritten;
+	WriteStats m_lastFrameStats;
+};
@@ -1,31 +1,61 @@
 #pragma once
 #include "stdafx.h"
 #include "Resource.h"
+#include "ConstantBufferArena.h"
+
+class CbvSrvUavHeap;
 
 struct ConstantBufferView : public Resource
 {
 public:
-	ConstantBufferView(const D3D12_CPU_DESCRIPTOR_HANDLE cpuDescriptorHandle, const D3D12_GPU_DESCRIPTOR_HANDLE gpuDescriptorHandle, const UINT rootParameterIndex)
-		: Resource(cpuDescriptorHandle, gpuDescriptorHandle, rootParameterIndex)
-		, cbvDataBegin(nullptr)
-		, cbvData()
-	{}
-	void Initialize(ID3D12Device* device);
-	// Update Model View Projection (MVP) Matrix according to camera position
-	void Update(const DirectX::XMMATRIX& model, const DirectX::XMMATRIX& view, const DirectX::XMMATRIX& projection);
-protected:
-	// Constant buffer used to translate the triangle in the shaders
-	struct SceneConstantBuffer
+	/**
+	* Create a constant buffer, i.e. a slot in the constant buffer arena holding an object's world matrix.
+	* It has no descriptor of its own. Draws pick out its world matrix from the pass's object constants by its slot.
+	* @param rootParameterIndex the root parameter index for all CBVs, RootParameterIndices::CBV
+	* @param heap The shader visible heap the object is drawn with
+	* @param arena Where the constant buffer's slot is, whose blocks each pass draws with
+	*/
+	ConstantBufferView(const UINT rootParameterIndex, CbvSrvUavHeap* heap, ConstantBufferArena* arena)
+		: Resource(DescriptorHandle(), rootParameterIndex, heap)
+		, arena(arena)
+		, slot(arena->Allocate())
+	{
+	}
+	~ConstantBufferView()
 	{
-		// Constant buffer must be 256-Byte aligned 
-		// Model View Projection matrix
-		DirectX::XMFLOAT4X4 mvp;	//4 * 4 * 4 =	64 Bytes
-		float padding[48];			//4 * 48 =		192 Bytes
-	};
-	// Ensure constant buffer is 256-byte aligned
-	static_assert((sizeof(SceneConstantBuffer) % 256) == 0, "Constant Buffer size must be 256-byte aligned");
+		arena->Free(slot);
+	}
+	ConstantBufferView(const ConstantBufferView&) = delete;
+	ConstantBufferView& operator=(const ConstantBufferView&) = delete;
 
-	SceneConstantBuffer cbvData;
-	UINT8* cbvDataBegin;
+	/**
+	* Set the world matrix of the slot, copied to the GPU by ConstantBufferArena::UpdateWorlds().
+	*/
+	void SetWorld(const DirectX::XMMATRIX& model)
+	{
+		arena->SetWorld(slot, model);
+	}
+	/**
+	* @returns Whether the block was written after this constant buffer was created, i.e. whether it holds its constants
+	*/
+	bool IsIn(const ConstantBufferArena::Block& block) const
+	{
+		return block.Contains(slot);
+	}
+	/**
+	* Nothing to bind for a single constant buffer, a pass binds every object's at once with ConstantBufferArena::Block::Set().
+	*/
+	void Set(ID3D12GraphicsCommandList* commandList) override
+	{
+	}
+	/**
+	* @returns The index draws pass the vertex shader to find the world matrix in a block's object constants
+	*/
+	UINT GetSlot() const
+	{
+		return slot;
+	}
+protected:
+	ConstantBufferArena* arena;
+	const UINT slot;
 };
-
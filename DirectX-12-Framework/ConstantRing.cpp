@@ -0,0 +1,61 @@
+#include "ConstantRing.h"
+#include <cassert>
+
+ConstantRing::ConstantRing(uint64_t capacity, uint64_t alignment)
+    : m_alignment(alignment)
+    , m_capacity(capacity & ~(alignment - 1))
+    , m_head(0)
+    , m_tail(0)
+    , m_frameStart(0)
+    , m_frames()
+{
+    assert(alignment && !(alignment & (alignment - 1)) && "Alignment must be a power of two.");
+}
+
+uint64_t ConstantRing::Allocate(uint64_t size)
+{
+    uint64_t alignedSize = (size + m_alignment - 1) & ~(m_alignment - 1);
+    if (alignedSize == 0 || alignedSize > m_capacity)
+    {
+        return InvalidOffset;
+    }
+
+    uint64_t head = m_head.load(std::memory_order_relaxed);
+    for (;;)
+    {
+        // Constants must be contiguous, so if they would run off the end of the range, skip the remainder and start again from 0
+        uint64_t offset = head % m_capacity;
+        uint64_t skipped = offset + alignedSize > m_capacity ? m_capacity - offset : 0;
+        uint64_t next = head + skipped + alignedSize;
+
+        // Not enough free space between the head and the tail, the rest is still read by in-flight frames
+        if (next - m_tail > m_capacity)
+        {
+            return InvalidOffset;
+        }
+        // Skipped bytes are charged to this frame, so they are returned when it retires
+        if (m_head.compare_exchange_weak(head, next, std::memory_order_relaxed))
+        {
+            return skipped ? 0 : offset;
+        }
+    }
+}
+
+void ConstantRing::EndFrame(uint64_t fenceValue)
+{
+    uint64_t head = m_head.load(std::memory_order_relaxed);
+    m_frames.push(FrameEntry{ fenceValue, head });
+    m_frameStart = head;
+}
+
+uint64_t ConstantRing::Retire(uint64_t completedFenceValue)
+{
+    uint64_t tail = m_tail;
+    // Frames complete in order, so stop at the first one still in flight
+    while (!m_frames.empty() && m_frames.front().fenceValue <= completedFenceValue)
+    {
+        m_tail = m_frames.front().end;
+        m_frames.pop();
+    }
+    return m_tail - tail;
+}
@@ -0,0 +1,82 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <queue>
+
+/**
+* Linear allocator over a byte range, for constants only needed by the frame they are written in.
+* Allocations are bump-allocated from the head and wrap round to the start, so a frame can take as much or as little of the range as it needs.
+* When a frame is submitted, EndFrame() tags everything allocated since the last EndFrame() with that frame's fence value,
+* and once the fence has completed Retire() releases the whole frame's worth in one go.
+* Owns no D3D12 objects, so fence progression can be simulated by feeding it plain values.
+*/
+class ConstantRing
+{
+public:
+	static const uint64_t InvalidOffset = UINT64_MAX;
+
+	/**
+	* @param capacity Size of the range in bytes, rounded down to a whole number of alignments
+	* @param alignment What every allocation's offset and size is rounded to, a power of two
+	*/
+	ConstantRing(uint64_t capacity, uint64_t alignment);
+
+	/**
+	* Claim bytes for the frame currently being recorded. Safe to call from several recording threads at once, but not alongside EndFrame() or Retire().
+	* @param size Size in bytes, rounded up to the alignment
+	* @returns Offset of the allocation from the start of the range, or InvalidOffset if the range is full of in-flight frames
+	*/
+	uint64_t Allocate(uint64_t size);
+
+	/**
+	* Close the frame currently being recorded.
+	* @param fenceValue The fence value signalled after the frame's command lists, after which its constants are no longer read by the GPU
+	*/
+	void EndFrame(uint64_t fenceValue);
+	/**
+	* Release every closed frame whose fence value has been reached.
+	* @param completedFenceValue The value the fence has currently reached
+	* @returns The number of bytes released
+	*/
+	uint64_t Retire(uint64_t completedFenceValue);
+
+	uint64_t GetCapacity() const
+	{
+		return m_capacity;
+	}
+	/**
+	* @returns Bytes held by in-flight frames and the frame being recorded, including any skipped at the end of the range when wrapping
+	*/
+	uint64_t GetUsed() const
+	{
+		return m_head.load(std::memory_order_relaxed) - m_tail;
+	}
+	/**
+	* @returns Bytes held by the frame being recorded
+	*/
+	uint64_t GetFrameUsed() const
+	{
+		return m_head.load(std::memory_order_relaxed) - m_frameStart;
+	}
+
+private:
+	struct FrameEntry
+	{
+		uint64_t fenceValue;
+		/** Where the frame's allocations end, in bytes ever allocated */
+		uint64_t end;
+	};
+
+	const uint64_t m_alignment;
+	const uint64_t m_capacity;
+	/**
+	* Bytes ever allocated and ever released, so the space in use is their difference and the head's position is the count modulo the capacity.
+	* Counting rather than wrapping keeps a full ring distinguishable from an empty one.
+	*/
+	std::atomic<uint64_t> m_head;
+	uint64_t m_tail;
+	/** Where the frame being recorded started allocating from */
+	uint64_t m_frameStart;
+
+	std::queue<FrameEntry> m_frames;
+};
@@ -0,0 +1,48 @@
+#include "D3D12Timeline.h"
+#include "WakeEvent.h"
+
+D3D12Timeline::D3D12Timeline(ID3D12Device* device, ID3D12CommandQueue* commandQueue)
+    : m_commandQueue(commandQueue)
+{
+    ThrowIfFailed(device->CreateFence(
+        0,  // initial value for the fence, often 0
+        D3D12_FENCE_FLAG_NONE,  // fence flags concerning sharing of the fence
+        IID_PPV_ARGS(&m_fence)    // out
+    ), "Couldn't create fence.\n");
+}
+
+uint64_t D3D12Timeline::Signal()
+{
+    std::lock_guard<std::mutex> lock(m_signalMutex);
+    uint64_t value = m_signalledValue.load(std::memory_order_relaxed) + 1;
+    ThrowIfFailed(m_commandQueue->Signal(m_fence.Get(), value));
+    m_signalledValue.store(value, std::memory_order_release);
+    return value;
+}
+
+uint64_t D3D12Timeline::GetCompletedValue()
+{
+    return m_fence->GetCompletedValue();
+}
+
+void D3D12Timeline::WaitForValue(uint64_t value)
+{
+    // if the the fence has not yet reached the queried value
+    if (m_fence->GetCompletedValue() < value)
+    {
+        // with no event, this blocks until the fence reaches the value, so several threads can wait without sharing an event
+        ThrowIfFailed(m_fence->SetEventOnCompletion(value, nullptr));
+    }
+}
+
+void D3D12Timeline::SetEventOnCompletion(uint64_t value, WakeEvent& event)
+{
+    // the fence sets the event as soon as it reaches the value, or straight away if it already has
+    ThrowIfFailed(m_fence->SetEventOnCompletion(value, event.GetHandle()));
+}
+
+void D3D12Timeline::QueueWait(const D3D12Timeline& other, uint64_t value)
+{
+    // queue a wait on the other queue's fence, the GPU holds back anything submitted to this queue afterwards until it's reached
+    ThrowIfFailed(m_commandQueue->Wait(other.m_fence.Get(), value));
+}
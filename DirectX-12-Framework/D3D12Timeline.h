@@ -0,0 +1,35 @@
+#pragma once
+#include "stdafx.h"
+#include "Timeline.h"
+#include <mutex>
+
+/**
+* Timeline of a D3D12 command queue, signalling an ID3D12Fence on the queue.
+*/
+class D3D12Timeline : public Timeline
+{
+public:
+	/**
+	* @param device The device to create the fence with
+	* @param commandQueue The queue to signal the fence on
+	*/
+	D3D12Timeline(ID3D12Device* device, ID3D12CommandQueue* commandQueue);
+
+	uint64_t Signal() override;
+	uint64_t GetCompletedValue() override;
+	void WaitForValue(uint64_t value) override;
+	void SetEventOnCompletion(uint64_t value, WakeEvent& event) override;
+
+	/**
+	* Make this timeline's queue wait GPU-side until another queue's timeline reaches a value, without blocking the CPU thread.
+	* @param other The timeline to wait on
+	* @param value The value to wait for
+	*/
+	void QueueWait(const D3D12Timeline& other, uint64_t value);
+
+private:
+	Microsoft::WRL::ComPtr<ID3D12CommandQueue> m_commandQueue;
+	Microsoft::WRL::ComPtr<ID3D12Fence> m_fence;
+	/** Held from taking a value to queueing its signal, so threads signalling at once queue their values in order and the fence never goes backwards */
+	std::mutex m_signalMutex;
+};
@@ -0,0 +1,50 @@
+#include "D3D12TimestampBackend.h"
+
+D3D12TimestampBackend::D3D12TimestampBackend(ID3D12Device* device, ID3D12CommandQueue* commandQueue, uint32_t queryCount)
+    : m_queryCount(queryCount)
+    , m_frequency(0)
+{
+    // Timestamps are in ticks of the queue's own clock
+    ThrowIfFailed(commandQueue->GetTimestampFrequency(&m_frequency), "Failed to get timestamp frequency.\n");
+
+    D3D12_QUERY_HEAP_DESC queryHeapDesc = {};
+    queryHeapDesc.Type = D3D12_QUERY_HEAP_TYPE_TIMESTAMP;
+    queryHeapDesc.Count = queryCount;
+    ThrowIfFailed(device->CreateQueryHeap(&queryHeapDesc, IID_PPV_ARGS(&m_queryHeap)), "Failed to create timestamp query heap.\n");
+    m_queryHeap->SetName(L"Timestamp Queries");
+
+    // Queries are resolved into a buffer the CPU can read back, one 64 bit timestamp per slot
+    auto heapProps = CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_READBACK);
+    auto bufferDesc = CD3DX12_RESOURCE_DESC::Buffer(UINT64(queryCount) * sizeof(uint64_t));
+    ThrowIfFailed(device->CreateCommittedResource(
+        &heapProps,
+        D3D12_HEAP_FLAG_NONE,
+        &bufferDesc,
+        D3D12_RESOURCE_STATE_COPY_DEST, // Required heap state for a readback heap
+        nullptr,
+        IID_PPV_ARGS(&m_readbackBuffer)
+    ), "Failed to create timestamp readback buffer.\n");
+    m_readbackBuffer->SetName(L"Timestamp Readback");
+}
+
+void D3D12TimestampBackend::WriteTimestamp(ID3D12GraphicsCommandList* commandList, uint32_t query)
+{
+    // Timestamp queries have no begin, ending one writes the clock
+    commandList->EndQuery(m_queryHeap.Get(), D3D12_QUERY_TYPE_TIMESTAMP, query);
+}
+
+void D3D12TimestampBackend::Resolve(ID3D12GraphicsCommandList* commandList, uint32_t firstQuery, uint32_t count)
+{
+    commandList->ResolveQueryData(m_queryHeap.Get(), D3D12_QUERY_TYPE_TIMESTAMP, firstQuery, count, m_readbackBuffer.Get(), UINT64(firstQuery) * sizeof(uint64_t));
+}
+
+void D3D12TimestampBackend::Read(uint32_t firstQuery, uint32_t count, uint64_t* timestamps)
+{
+    // Only map the range being read, and write nothing back
+    CD3DX12_RANGE readRange(SIZE_T(firstQuery) * sizeof(uint64_t), SIZE_T(firstQuery + count) * sizeof(uint64_t));
+    uint8_t* data = nullptr;
+    ThrowIfFailed(m_readbackBuffer->Map(0, &readRange, reinterpret_cast<void**>(&data)), "Failed to map timestamp readback buffer.\n");
+    memcpy(timestamps, data + readRange.Begin, SIZE_T(count) * sizeof(uint64_t));
+    CD3DX12_RANGE writeRange(0, 0);
+    m_readbackBuffer->Unmap(0, &writeRange);
+}
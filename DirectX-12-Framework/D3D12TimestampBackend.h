@@ -0,0 +1,37 @@
+#pragma once
+#include "stdafx.h"
+#include "TimestampBackend.h"
+
+/**
+* Timestamps written by a D3D12 queue into a timestamp query heap, and resolved into a readback buffer the CPU maps once the GPU is done.
+*/
+class D3D12TimestampBackend : public TimestampBackend
+{
+public:
+	/**
+	* @param device The device to create the query heap and readback buffer with
+	* @param commandQueue The queue the timestamps are written on, whose clock they're in
+	* @param queryCount The number of slots
+	*/
+	D3D12TimestampBackend(ID3D12Device* device, ID3D12CommandQueue* commandQueue, uint32_t queryCount);
+
+	void WriteTimestamp(ID3D12GraphicsCommandList* commandList, uint32_t query) override;
+	void Resolve(ID3D12GraphicsCommandList* commandList, uint32_t firstQuery, uint32_t count) override;
+	void Read(uint32_t firstQuery, uint32_t count, uint64_t* timestamps) override;
+
+	uint64_t GetFrequency() const override
+	{
+		return m_frequency;
+	}
+
+	uint32_t GetQueryCount() const override
+	{
+		return m_queryCount;
+	}
+
+private:
+	const uint32_t m_queryCount;
+	uint64_t m_frequency;
+	Microsoft::WRL::ComPtr<ID3D12QueryHeap> m_queryHeap;
+	Microsoft::WRL::ComPtr<ID3D12Resource> m_readbackBuffer;
+};
@@ -0,0 +1,19 @@
+#include "DeferredFreeQueue.h"
+
+void DeferredFreeQueue::Push(uint32_t offset, uint32_t count, uint64_t fenceValue)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    // Two threads may read the fence and push in opposite orders, so never let a value fall below the one before it.
+    // Holding a descriptor a little longer is safe, and keeps the queue sorted for Retire()
+    if (!m_entries.empty() && m_entries.back().fenceValue > fenceValue)
+    {
+        fenceValue = m_entries.back().fenceValue;
+    }
+    m_entries.push_back(Entry{ fenceValue, offset, count });
+}
+
+size_t DeferredFreeQueue::GetPendingCount()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_entries.size();
+}
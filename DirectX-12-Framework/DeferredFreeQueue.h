@@ -0,0 +1,62 @@
+#pragma once
+#include <cstdint>
+#include <deque>
+#include <mutex>
+
+/**
+* Holds freed descriptors back until the GPU can no longer be reading them.
+* Each free is tagged with the fence value of the last submission that could reference the descriptor,
+* and only once the fence has completed that value does Retire() hand it back to be reused.
+* Owns no D3D12 objects, so it can be driven by a simulated fence that just counts upwards.
+*/
+class DeferredFreeQueue
+{
+public:
+	/**
+	* A freed range of descriptors, single descriptors having a count of 1.
+	*/
+	struct Entry
+	{
+		uint64_t fenceValue;
+		uint32_t offset;
+		uint32_t count;
+	};
+
+	/**
+	* Queue a descriptor range to be reused after fenceValue completes. Safe to call from any thread.
+	* @param offset The offset of the first descriptor from the start of the heap
+	* @param count The number of descriptors in the range
+	* @param fenceValue The fence value signalled after the last command list that could reference the range
+	*/
+	void Push(uint32_t offset, uint32_t count, uint64_t fenceValue);
+
+	/**
+	* Hand every entry whose fence value has been reached to release, oldest first. Safe to call from any thread.
+	* @param completedFenceValue The value the fence has currently reached
+	* @param release Called with each retired Entry, to return it to its allocator
+	* @returns The number of entries retired
+	*/
+	template <typename Release>
+	uint32_t Retire(uint64_t completedFenceValue, Release&& release)
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		uint32_t retired = 0;
+		// Frees are tagged with fence values that only ever increase, so stop at the first one still in flight
+		while (!m_entries.empty() && m_entries.front().fenceValue <= completedFenceValue)
+		{
+			release(m_entries.front());
+			m_entries.pop_front();
+			retired++;
+		}
+		return retired;
+	}
+
+	/**
+	* @returns The number of ranges waiting on the GPU. Only a snapshot if other threads are freeing.
+	*/
+	size_t GetPendingCount();
+
+private:
+	std::mutex m_mutex;
+	std::deque<Entry> m_entries;
+};
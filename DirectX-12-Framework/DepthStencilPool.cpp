@@ -0,0 +1,100 @@
+#include "DepthStencilPool.h"
+
+DepthStencilPool::DepthStencilPool(ID3D12Device* device, UINT maxDepthStencils) :
+    m_device(device),
+    m_dsvHeap(device, D3D12_DESCRIPTOR_HEAP_DESC{ D3D12_DESCRIPTOR_HEAP_TYPE_DSV, maxDepthStencils, D3D12_DESCRIPTOR_HEAP_FLAG_NONE, 0 })
+{
+    m_dsvHeap.SetName("DSV pool");
+    m_depthStencils.reserve(maxDepthStencils);
+}
+
+D3D12_CPU_DESCRIPTOR_HANDLE DepthStencilPool::Acquire(UINT width, UINT height, DXGI_FORMAT format)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    auto& free = m_free[Key(width, height, format)];
+    if (!free.empty())
+    {
+        uint32_t index = free.back();
+        free.pop_back();
+        return m_depthStencils[index].dsvCpuDescriptorHandle;
+    }
+
+    m_depthStencils.push_back(Create(width, height, format));
+    return m_depthStencils.back().dsvCpuDescriptorHandle;
+}
+
+void DepthStencilPool::Release(const D3D12_CPU_DESCRIPTOR_HANDLE dsvCpuDescriptorHandle, uint64_t fenceValue)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    for (uint32_t i = 0; i < m_depthStencils.size(); i++)
+    {
+        if (m_depthStencils[i].dsvCpuDescriptorHandle.ptr == dsvCpuDescriptorHandle.ptr)
+        {
+            m_deferredReleases.Push(i, 1, fenceValue);
+            return;
+        }
+    }
+    ThrowIfFalse(false, "Depth stencil does not belong to this pool.\n");
+}
+
+void DepthStencilPool::Retire(uint64_t completedFenceValue)
+{
+    m_dsvHeap.Retire(completedFenceValue);
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_deferredReleases.Retire(completedFenceValue, [this](const DeferredFreeQueue::Entry& entry)
+        {
+            m_free[m_depthStencils[entry.offset].key].push_back(entry.offset);
+        });
+}
+
+void DepthStencilPool::EndFrame(uint64_t fenceValue)
+{
+    m_dsvHeap.EndFrame(fenceValue);
+}
+
+void DepthStencilPool::GetSnapshots(std::vector<DescriptorHeapSnapshot>& snapshots)
+{
+    m_dsvHeap.GetSnapshots(snapshots);
+}
+
+DepthStencilPool::DepthStencil DepthStencilPool::Create(UINT width, UINT height, DXGI_FORMAT format)
+{
+    DepthStencil depthStencil;
+    depthStencil.key = Key(width, height, format);
+
+    D3D12_CLEAR_VALUE depthOptimizedClearValue = {};
+    depthOptimizedClearValue.Format = format;
+    depthOptimizedClearValue.DepthStencil.Depth = 1.0f;
+    depthOptimizedClearValue.DepthStencil.Stencil = 0;
+
+    D3D12_RESOURCE_DESC dsDesc = CD3DX12_RESOURCE_DESC::Tex2D(
+        format,
+        width,
+        height,
+        1,  // Array size of 1
+        0,  // no MIP levels
+        1, 0,   // Sample count and quality (no Anti-Aliasing)
+        D3D12_RESOURCE_FLAG_ALLOW_DEPTH_STENCIL
+    );
+
+    auto heapProps = CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_DEFAULT);
+    ThrowIfFailed(m_device->CreateCommittedResource(
+        &heapProps,
+        D3D12_HEAP_FLAG_NONE,
+        &dsDesc,
+        D3D12_RESOURCE_STATE_DEPTH_WRITE,   // Only ever drawn to, so it never leaves this state
+        &depthOptimizedClearValue,
+        IID_PPV_ARGS(&depthStencil.resource)
+    ), "Failed to create pooled depth stencil.\n");
+    depthStencil.resource->SetName(L"Pooled Depth Stencil");
+
+    // Throws once the pool is full
+    m_dsvHeap.GetFreeHandle(depthStencil.dsvCpuDescriptorHandle);
+
+    D3D12_DEPTH_STENCIL_VIEW_DESC dsvDesc = {};
+    dsvDesc.Format = format;
+    dsvDesc.ViewDimension = D3D12_DSV_DIMENSION_TEXTURE2D;
+    dsvDesc.Flags = D3D12_DSV_FLAG_NONE;
+    m_device->CreateDepthStencilView(depthStencil.resource.Get(), &dsvDesc, depthStencil.dsvCpuDescriptorHandle);
+    return depthStencil;
+}
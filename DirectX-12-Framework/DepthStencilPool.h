@@ -0,0 +1,70 @@
+#pragma once
+#include "stdafx.h"
+#include "DescriptorHeap.h"
+#include "DeferredFreeQueue.h"
+#include <unordered_map>
+#include <vector>
+
+/**
+* Depth buffers for off-screen passes, grouped by size and format so a released one is handed to the next pass wanting the same kind.
+* Each pass drawing into its own depth buffer means passes neither clear nor wait on each other's depth.
+* Depth buffers are only ever created, a released one is kept in the pool until it's acquired again.
+*/
+class DepthStencilPool
+{
+public:
+    /**
+    * @param device The ID3D12Device
+    * @param maxDepthStencils The most depth buffers the pool's DSV heap can hold
+    */
+    DepthStencilPool(ID3D12Device* device, UINT maxDepthStencils);
+
+    /**
+    * Take a depth buffer out of the pool, creating one if none of this kind is free. Safe to call from any thread.
+    * @param width Width of the render target the depth buffer is drawn alongside
+    * @param height Height of the render target
+    * @param format A depth format
+    * @returns The depth buffer's DSV
+    */
+    D3D12_CPU_DESCRIPTOR_HANDLE Acquire(UINT width, UINT height, DXGI_FORMAT format);
+    /**
+    * Return a depth buffer to the pool once the GPU has finished with it. Safe to call from any thread.
+    * @param dsvCpuDescriptorHandle The DSV from Acquire()
+    * @param fenceValue The fence value signalled after the last command list that could draw to it
+    */
+    void Release(const D3D12_CPU_DESCRIPTOR_HANDLE dsvCpuDescriptorHandle, uint64_t fenceValue);
+    /**
+    * Make depth buffers released against a fence value the GPU has now reached available again.
+    * @param completedFenceValue The value the fence has currently reached
+    */
+    void Retire(uint64_t completedFenceValue);
+    void EndFrame(uint64_t fenceValue);
+    void GetSnapshots(std::vector<DescriptorHeapSnapshot>& snapshots);
+
+private:
+    struct DepthStencil
+    {
+        Microsoft::WRL::ComPtr<ID3D12Resource> resource;
+        D3D12_CPU_DESCRIPTOR_HANDLE dsvCpuDescriptorHandle;
+        uint64_t key;
+    };
+
+    static uint64_t Key(UINT width, UINT height, DXGI_FORMAT format)
+    {
+        // Textures are at most 16384 texels across, so 24 bits each for the size leaves 16 for the format
+        return (uint64_t(width) << 40) | (uint64_t(height) << 16) | uint64_t(format);
+    }
+    DepthStencil Create(UINT width, UINT height, DXGI_FORMAT format);
+
+    ID3D12Device* m_device;
+    DescriptorHeap m_dsvHeap;
+
+    /** Every depth buffer created, indexed by where its DSV is in the heap */
+    std::vector<DepthStencil> m_depthStencils;
+    /** Indices of free depth buffers, by size and format */
+    std::unordered_map<uint64_t, std::vector<uint32_t>> m_free;
+    /** Released depth buffers waiting on the GPU, the entry's offset holds the index */
+    DeferredFreeQueue m_deferredReleases;
+
+    std::mutex m_mutex;
+};
@@ -0,0 +1,74 @@
+#include "DescriptorAllocator.h"
+#include <cassert>
+
+DescriptorAllocator::DescriptorAllocator(uint32_t capacity)
+    : m_capacity(capacity)
+    , m_head(Pack(capacity == 0 ? InvalidIndex : 0, 0))
+    , m_next(std::make_unique<std::atomic<uint32_t>[]>(capacity))
+#ifndef NDEBUG
+    , m_allocated(std::make_unique<std::atomic<uint64_t>[]>((capacity + 63) / 64))
+#endif
+    , m_allocatedCount(0)
+{
+    // Chain every slot into the free stack in ascending order, so a fresh heap fills from the start
+    for (uint32_t i = 0; i < capacity; i++)
+    {
+        m_next[i].store(i + 1 < capacity ? i + 1 : InvalidIndex, std::memory_order_relaxed);
+    }
+#ifndef NDEBUG
+    for (uint32_t i = 0; i < (capacity + 63) / 64; i++)
+    {
+        m_allocated[i].store(0, std::memory_order_relaxed);
+    }
+#endif
+}
+
+uint32_t DescriptorAllocator::Allocate()
+{
+    uint64_t head = m_head.load(std::memory_order_acquire);
+    for (;;)
+    {
+        uint32_t index = Index(head);
+        // The stack is empty, the heap is full
+        if (index == InvalidIndex)
+        {
+            return InvalidIndex;
+        }
+
+        // If another thread pops this slot first, the tag will have moved on and the exchange fails, so a stale next is never published
+        uint64_t next = Pack(m_next[index].load(std::memory_order_relaxed), Tag(head) + 1);
+        if (m_head.compare_exchange_weak(head, next, std::memory_order_acq_rel, std::memory_order_acquire))
+        {
+#ifndef NDEBUG
+            uint64_t bit = 1ull << (index % 64);
+            uint64_t previous = m_allocated[index / 64].fetch_or(bit, std::memory_order_relaxed);
+            assert(!(previous & bit) && "Descriptor slot handed out twice.");
+#endif
+            m_allocatedCount.fetch_add(1, std::memory_order_relaxed);
+            return index;
+        }
+    }
+}
+
+void DescriptorAllocator::Free(uint32_t index)
+{
+    assert(index < m_capacity && "Descriptor slot does not belong to this heap.");
+
+#ifndef NDEBUG
+    uint64_t bit = 1ull << (index % 64);
+    uint64_t previous = m_allocated[index / 64].fetch_and(~bit, std::memory_order_relaxed);
+    assert((previous & bit) && "Descriptor slot freed twice.");
+#endif
+    m_allocatedCount.fetch_sub(1, std::memory_order_relaxed);
+
+    // Push the slot back onto the top of the stack, so it's the next to be reused while it's likely still in cache
+    uint64_t head = m_head.load(std::memory_order_relaxed);
+    for (;;)
+    {
+        m_next[index].store(Index(head), std::memory_order_relaxed);
+        if (m_head.compare_exchange_weak(head, Pack(index, Tag(head) + 1), std::memory_order_release, std::memory_order_relaxed))
+        {
+            return;
+        }
+    }
+}
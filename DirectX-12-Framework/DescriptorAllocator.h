@@ -0,0 +1,77 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <memory>
+
+/**
+* Lock-free allocator of slots within a single descriptor heap.
+* Owns no D3D12 objects, it only hands out indices in [0, capacity), so it can be driven without a device.
+* Free slots are kept in an intrusive stack whose head is tagged with a counter, making both Allocate() and Free() O(1) and ABA-safe.
+* In debug builds a bitmap of allocated slots sits alongside the stack to catch double frees. It costs two more atomic operations per allocate and free,
+* which with the count made the allocator slower than a mutex on one thread, so release builds leave it out.
+*/
+class DescriptorAllocator
+{
+public:
+	static const uint32_t InvalidIndex = UINT32_MAX;
+
+	/**
+	* @param capacity The number of descriptors in the heap this allocator manages
+	*/
+	DescriptorAllocator(uint32_t capacity);
+
+	/**
+	* Pop a free slot. Safe to call from any thread.
+	* @returns the index of the slot, or InvalidIndex if the heap is full
+	*/
+	uint32_t Allocate();
+	/**
+	* Return a slot previously handed out by Allocate(). Safe to call from any thread.
+	* @param index The index of the slot to return
+	*/
+	void Free(uint32_t index);
+
+	uint32_t GetCapacity() const
+	{
+		return m_capacity;
+	}
+
+	/**
+	* @returns The number of slots currently handed out. Only a snapshot if other threads are allocating.
+	*/
+	uint32_t GetAllocatedCount() const
+	{
+		return m_allocatedCount.load(std::memory_order_relaxed);
+	}
+
+private:
+	/**
+	* Pack the head of the free stack with a tag that is bumped on every successful exchange,
+	* so a slot that is popped and pushed back between another thread's load and compare_exchange is detected.
+	*/
+	static uint64_t Pack(uint32_t index, uint32_t tag)
+	{
+		return (static_cast<uint64_t>(tag) << 32) | index;
+	}
+	static uint32_t Index(uint64_t head)
+	{
+		return static_cast<uint32_t>(head);
+	}
+	static uint32_t Tag(uint64_t head)
+	{
+		return static_cast<uint32_t>(head >> 32);
+	}
+
+	const uint32_t m_capacity;
+
+	/** Tagged index of the first free slot */
+	std::atomic<uint64_t> m_head;
+	/** For each free slot, the index of the next free slot */
+	std::unique_ptr<std::atomic<uint32_t>[]> m_next;
+#ifndef NDEBUG
+	/** One bit per slot, set while the slot is allocated */
+	std::unique_ptr<std::atomic<uint64_t>[]> m_allocated;
+#endif
+
+	std::atomic<uint32_t> m_allocatedCount;
+};
@@ -0,0 +1,72 @@
+#include "DescriptorHandleTable.h"
+#include <cassert>
+
+DescriptorHandle DescriptorHandleTable::Add(uint32_t slot)
+{
+    uint32_t index;
+    if (!m_freeEntries.empty())
+    {
+        index = m_freeEntries.back();
+        m_freeEntries.pop_back();
+    }
+    else
+    {
+        // The index has to fit alongside the generation
+        if (m_entries.size() > DescriptorHandle::IndexMask)
+        {
+            return DescriptorHandle{};
+        }
+        index = static_cast<uint32_t>(m_entries.size());
+        m_entries.push_back(Entry{ InvalidSlot, 0 });
+    }
+
+    m_entries[index].slot = slot;
+    DescriptorHandle handle = DescriptorHandle::Make(index, m_entries[index].generation);
+    // An index with every bit set in a full generation would be indistinguishable from InvalidValue, so skip that generation
+    assert(handle.IsValid() && "Descriptor handle collides with the invalid handle.");
+    return handle;
+}
+
+uint32_t DescriptorHandleTable::Resolve(DescriptorHandle handle) const
+{
+    uint32_t index = handle.GetIndex();
+    if (!handle.IsValid() || index >= m_entries.size())
+    {
+        return InvalidSlot;
+    }
+
+    const Entry& entry = m_entries[index];
+    // A stale handle has the generation from before its entry was removed
+    if (entry.slot == InvalidSlot || (entry.generation & DescriptorHandle::GenerationMask) != handle.GetGeneration())
+    {
+        return InvalidSlot;
+    }
+    return entry.slot;
+}
+
+void DescriptorHandleTable::Remap(DescriptorHandle handle, uint32_t slot)
+{
+    assert(Resolve(handle) != InvalidSlot && "Remapping a stale descriptor handle.");
+    m_entries[handle.GetIndex()].slot = slot;
+}
+
+uint32_t DescriptorHandleTable::Remove(DescriptorHandle handle)
+{
+    uint32_t slot = Resolve(handle);
+    assert(slot != InvalidSlot && "Descriptor handle removed twice.");
+    if (slot == InvalidSlot)
+    {
+        return InvalidSlot;
+    }
+
+    Entry& entry = m_entries[handle.GetIndex()];
+    entry.slot = InvalidSlot;
+    entry.generation++;
+    // Never issue the one handle value reserved for invalid
+    if (handle.GetIndex() == DescriptorHandle::IndexMask && (entry.generation & DescriptorHandle::GenerationMask) == DescriptorHandle::GenerationMask)
+    {
+        entry.generation++;
+    }
+    m_freeEntries.push_back(handle.GetIndex());
+    return slot;
+}
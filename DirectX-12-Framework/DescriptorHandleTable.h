@@ -0,0 +1,107 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+
+/**
+* Stable 32-bit reference to a descriptor, which stays valid while the descriptor itself moves between heaps.
+* The low bits index an entry in a DescriptorHandleTable, the high bits hold the entry's generation when the handle was issued,
+* so a handle kept after its descriptor is freed no longer resolves, even once the entry is reused.
+*/
+struct DescriptorHandle
+{
+	static const uint32_t IndexBits = 20;
+	static const uint32_t IndexMask = (1u << IndexBits) - 1;
+	static const uint32_t GenerationMask = (1u << (32 - IndexBits)) - 1;
+	static const uint32_t InvalidValue = UINT32_MAX;
+
+	uint32_t value = InvalidValue;
+
+	static DescriptorHandle Make(uint32_t index, uint32_t generation)
+	{
+		return DescriptorHandle{ ((generation & GenerationMask) << IndexBits) | (index & IndexMask) };
+	}
+
+	uint32_t GetIndex() const
+	{
+		return value & IndexMask;
+	}
+	uint32_t GetGeneration() const
+	{
+		return value >> IndexBits;
+	}
+	bool IsValid() const
+	{
+		return value != InvalidValue;
+	}
+	bool operator==(const DescriptorHandle& other) const
+	{
+		return value == other.value;
+	}
+};
+
+/**
+* Indirection from DescriptorHandles to the slot each descriptor currently occupies in its heap.
+* Remapping an entry moves the descriptor without invalidating any handle to it, which is what lets a heap grow and compact.
+* Owns no D3D12 objects and isn't thread safe, the owning heap serializes access.
+*/
+class DescriptorHandleTable
+{
+public:
+	static const uint32_t InvalidSlot = UINT32_MAX;
+
+	/**
+	* Issue a handle for a descriptor.
+	* @param slot The slot the descriptor occupies in the heap
+	* @returns A handle resolving to slot, or an invalid handle if every index is in use
+	*/
+	DescriptorHandle Add(uint32_t slot);
+	/**
+	* @param handle A handle from Add()
+	* @returns The slot the descriptor currently occupies, or InvalidSlot if the handle has been removed
+	*/
+	uint32_t Resolve(DescriptorHandle handle) const;
+	/**
+	* Point a live handle at a new slot.
+	* @param handle A handle from Add()
+	* @param slot The slot the descriptor has been moved to
+	*/
+	void Remap(DescriptorHandle handle, uint32_t slot);
+	/**
+	* Retire a handle, so it and any copies of it no longer resolve, and its index can be reissued.
+	* @param handle A handle from Add()
+	* @returns The slot the descriptor occupied, to be returned to the heap
+	*/
+	uint32_t Remove(DescriptorHandle handle);
+
+	/**
+	* Call fn(handle, slot) for every live handle, in index order.
+	*/
+	template <typename Fn>
+	void ForEach(Fn&& fn) const
+	{
+		for (uint32_t index = 0; index < m_entries.size(); index++)
+		{
+			if (m_entries[index].slot != InvalidSlot)
+			{
+				fn(DescriptorHandle::Make(index, m_entries[index].generation), m_entries[index].slot);
+			}
+		}
+	}
+
+	uint32_t GetLiveCount() const
+	{
+		return static_cast<uint32_t>(m_entries.size() - m_freeEntries.size());
+	}
+
+private:
+	struct Entry
+	{
+		/** Slot in the heap, or InvalidSlot while the entry is free */
+		uint32_t slot;
+		uint32_t generation;
+	};
+
+	std::vector<Entry> m_entries;
+	/** Indices of removed entries, reissued before the table is extended */
+	std::vector<uint32_t> m_freeEntries;
+};
@@ -1,78 +1,186 @@
 #include "DescriptorHeap.h"
+#include <chrono>
 
 
-DescriptorHeap::DescriptorHeap(ID3D12Device* device, const D3D12_DESCRIPTOR_HEAP_DESC desc) :
-    m_freeHandles()
+DescriptorHeap::DescriptorHeap(ID3D12Device* device, const D3D12_DESCRIPTOR_HEAP_DESC desc, UINT reservedDescriptors, UINT tableDescriptors) :
+    m_cpuHeapStart(),
+    m_gpuHeapStart(),
+    m_tableStart(),
+    m_name(GetDefaultName(desc)),
+    m_tableOccupied(0)
 {
-    CreateHeap(device, desc);
+    CreateHeap(device, desc, reservedDescriptors, tableDescriptors);
 }
 
-void DescriptorHeap::CreateHeap(ID3D12Device* device, const D3D12_DESCRIPTOR_HEAP_DESC desc)
+void DescriptorHeap::CreateHeap(ID3D12Device* device, const D3D12_DESCRIPTOR_HEAP_DESC desc, UINT reservedDescriptors, UINT tableDescriptors)
 {
     ThrowIfFailed(device->CreateDescriptorHeap(&desc, IID_PPV_ARGS(&m_descriptorHeap)));
-    m_descriptorHeap->SetName(L"m_descriptorHeap");
+    // Every type of heap is created here, so it's named after its type until its owner gives it a name of its own
+    m_descriptorHeap->SetName(std::wstring(m_name.begin(), m_name.end()).c_str());
 
-    // How much to offset the shared SRV/SBV heap by to get the next available handle
+    // Distance between neighbouring descriptors, which depends on the heap's type
     m_descriptorSize = device->GetDescriptorHandleIncrementSize(desc.Type);
-}
-
-void DescriptorHeap::GetFreeHandle(D3D12_CPU_DESCRIPTOR_HANDLE& cpuDescriptorHandle, D3D12_GPU_DESCRIPTOR_HANDLE& gpuDescriptorHandle)
-{
 
-    // If there are no existing freed handles to reuse
-    if (m_freeHandles.empty())
+    m_cpuHeapStart = m_descriptorHeap->GetCPUDescriptorHandleForHeapStart();
+    if (desc.Flags & D3D12_DESCRIPTOR_HEAP_FLAG_SHADER_VISIBLE)
     {
-        // Store the next 'final' offset, representing the next never allocated offset
-        static UINT nextOffset = 0;
-        // Create a new set of handles from the next offset 
-        cpuDescriptorHandle = CD3DX12_CPU_DESCRIPTOR_HANDLE(m_descriptorHeap->GetCPUDescriptorHandleForHeapStart(), nextOffset, m_descriptorSize);
-        gpuDescriptorHandle = CD3DX12_GPU_DESCRIPTOR_HANDLE(m_descriptorHeap->GetGPUDescriptorHandleForHeapStart(), nextOffset, m_descriptorSize);
-        nextOffset++;
+        m_gpuHeapStart = m_descriptorHeap->GetGPUDescriptorHandleForHeapStart();
     }
-    else
+
+    // The heap is laid out as [single descriptors | tables | reserved], anything reserved at the end is left to derived heaps
+    m_tableStart = desc.NumDescriptors - reservedDescriptors - tableDescriptors;
+    m_allocator = std::make_unique<DescriptorAllocator>(m_tableStart);
+    m_tableAllocator = std::make_unique<DescriptorRangeAllocator>(tableDescriptors);
+}
+
+std::string DescriptorHeap::GetDefaultName(const D3D12_DESCRIPTOR_HEAP_DESC& desc)
+{
+    std::string name;
+    switch (desc.Type)
     {
-        // Or, If there are existing freed handles to reuse
-        // Pop the first one and return it
-        cpuDescriptorHandle = m_freeHandles.front().first;
-        gpuDescriptorHandle = m_freeHandles.front().second;
-        m_freeHandles.pop();
+    case D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV:
+        name = "CBV/SRV/UAV heap";
+        break;
+    case D3D12_DESCRIPTOR_HEAP_TYPE_SAMPLER:
+        name = "Sampler heap";
+        break;
+    case D3D12_DESCRIPTOR_HEAP_TYPE_RTV:
+        name = "RTV heap";
+        break;
+    case D3D12_DESCRIPTOR_HEAP_TYPE_DSV:
+        name = "DSV heap";
+        break;
+    default:
+        name = "Descriptor heap";
+        break;
     }
+    return name + ((desc.Flags & D3D12_DESCRIPTOR_HEAP_FLAG_SHADER_VISIBLE) ? " (shader visible)" : " (CPU only)");
+}
+
+void DescriptorHeap::SetName(const std::string& name)
+{
+    m_name = name;
+    m_descriptorHeap->SetName(std::wstring(name.begin(), name.end()).c_str());
+}
+
+void DescriptorHeap::GetFreeHandle(D3D12_CPU_DESCRIPTOR_HANDLE& cpuDescriptorHandle, D3D12_GPU_DESCRIPTOR_HANDLE& gpuDescriptorHandle)
+{
+    auto start = std::chrono::high_resolution_clock::now();
+    UINT index = m_allocator->Allocate();
+    ThrowIfFalse(index != DescriptorAllocator::InvalidIndex, "Descriptor heap is full.\n");
+    m_stats.RecordAllocation(m_allocator->GetAllocatedCount() + m_tableOccupied.load(std::memory_order_relaxed),
+        std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::high_resolution_clock::now() - start).count());
+
+    cpuDescriptorHandle = CD3DX12_CPU_DESCRIPTOR_HANDLE(m_cpuHeapStart, index, m_descriptorSize);
+    gpuDescriptorHandle = CD3DX12_GPU_DESCRIPTOR_HANDLE(m_gpuHeapStart, index, m_descriptorSize);
 }
 
 void DescriptorHeap::GetFreeHandle(D3D12_CPU_DESCRIPTOR_HANDLE& cpuDescriptorHandle)
 {
-    // If there are no existing freed handles to reuse
-    if (m_freeHandles.empty())
+    auto start = std::chrono::high_resolution_clock::now();
+    UINT index = m_allocator->Allocate();
+    ThrowIfFalse(index != DescriptorAllocator::InvalidIndex, "Descriptor heap is full.\n");
+    m_stats.RecordAllocation(m_allocator->GetAllocatedCount() + m_tableOccupied.load(std::memory_order_relaxed),
+        std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::high_resolution_clock::now() - start).count());
+
+    cpuDescriptorHandle = CD3DX12_CPU_DESCRIPTOR_HANDLE(m_cpuHeapStart, index, m_descriptorSize);
+}
+
+void DescriptorHeap::Free(const D3D12_CPU_DESCRIPTOR_HANDLE cpuDescriptorHandle, const D3D12_GPU_DESCRIPTOR_HANDLE gpuDescriptorHandle)
+{
+    // The GPU handle sits at the same offset as the CPU one, so the CPU handle alone identifies the slot
+    Free(cpuDescriptorHandle);
+}
+
+void DescriptorHeap::Free(const D3D12_CPU_DESCRIPTOR_HANDLE cpuDescriptorHandle)
+{
+    m_allocator->Free(GetIndex(cpuDescriptorHandle));
+    m_stats.RecordFree();
+}
+
+void DescriptorHeap::Free(const D3D12_CPU_DESCRIPTOR_HANDLE cpuDescriptorHandle, uint64_t fenceValue)
+{
+    m_deferredFrees.Push(GetIndex(cpuDescriptorHandle), 1, fenceValue);
+}
+
+void DescriptorHeap::GetFreeRange(UINT count, D3D12_CPU_DESCRIPTOR_HANDLE& cpuDescriptorHandle, D3D12_GPU_DESCRIPTOR_HANDLE& gpuDescriptorHandle)
+{
+    auto start = std::chrono::high_resolution_clock::now();
+    UINT offset;
     {
-        // Store the next 'final' offset, representing the next never allocated offset
-        static UINT nextOffset = 0;
-        // Create a new set of handles from the next offset 
-        cpuDescriptorHandle = CD3DX12_CPU_DESCRIPTOR_HANDLE(m_descriptorHeap->GetCPUDescriptorHandleForHeapStart(), nextOffset, m_descriptorSize);
-        nextOffset++;
+        std::lock_guard<std::mutex> lock(m_tableMutex);
+        offset = m_tableAllocator->Allocate(count);
     }
-    else
+    ThrowIfFalse(offset != DescriptorRangeAllocator::InvalidIndex, "No free descriptor range is large enough for this table.\n");
+    uint32_t tableOccupied = m_tableOccupied.fetch_add(count, std::memory_order_relaxed) + count;
+    m_stats.RecordAllocation(m_allocator->GetAllocatedCount() + tableOccupied,
+        std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::high_resolution_clock::now() - start).count());
+
+    cpuDescriptorHandle = CD3DX12_CPU_DESCRIPTOR_HANDLE(m_cpuHeapStart, m_tableStart + offset, m_descriptorSize);
+    gpuDescriptorHandle = CD3DX12_GPU_DESCRIPTOR_HANDLE(m_gpuHeapStart, m_tableStart + offset, m_descriptorSize);
+}
+
+void DescriptorHeap::FreeRange(const D3D12_CPU_DESCRIPTOR_HANDLE cpuDescriptorHandle, UINT count)
+{
     {
-        // Or, If there are existing freed handles to reuse
-        // Pop the first one and return it
-        cpuDescriptorHandle = m_freeHandles.front().first;
-        m_freeHandles.pop();
+        std::lock_guard<std::mutex> lock(m_tableMutex);
+        m_tableAllocator->Free(GetIndex(cpuDescriptorHandle) - m_tableStart, count);
     }
+    m_tableOccupied.fetch_sub(count, std::memory_order_relaxed);
+    m_stats.RecordFree(count);
 }
 
-void DescriptorHeap::Free(const D3D12_CPU_DESCRIPTOR_HANDLE cpuDescriptorHandle, const D3D12_GPU_DESCRIPTOR_HANDLE gpuDescriptorHandle)
+void DescriptorHeap::FreeRange(const D3D12_CPU_DESCRIPTOR_HANDLE cpuDescriptorHandle, UINT count, uint64_t fenceValue)
 {
-    std::pair<D3D12_CPU_DESCRIPTOR_HANDLE, D3D12_GPU_DESCRIPTOR_HANDLE> freeHandle(cpuDescriptorHandle, gpuDescriptorHandle);
-    m_freeHandles.emplace(freeHandle);
+    m_deferredFrees.Push(GetIndex(cpuDescriptorHandle), count, fenceValue);
 }
 
-void DescriptorHeap::Free(const D3D12_CPU_DESCRIPTOR_HANDLE cpuDescriptorHandle)
+void DescriptorHeap::Retire(uint64_t completedFenceValue)
 {
-    // TODO : Make this safer, segment this class properly into CPU only/CPU and GPU
+    m_deferredFrees.Retire(completedFenceValue, [this](const DeferredFreeQueue::Entry& entry)
+        {
+            // Singles and tables live in separate regions, so the offset tells which allocator the entry came from
+            if (entry.offset < m_tableStart)
+            {
+                m_allocator->Free(entry.offset);
+            }
+            else
+            {
+                std::lock_guard<std::mutex> lock(m_tableMutex);
+                m_tableAllocator->Free(entry.offset - m_tableStart, entry.count);
+                m_tableOccupied.fetch_sub(entry.count, std::memory_order_relaxed);
+            }
+            m_stats.RecordFree(entry.count);
+        });
+}
 
-    std::pair<D3D12_CPU_DESCRIPTOR_HANDLE, D3D12_GPU_DESCRIPTOR_HANDLE> freeHandle;
-    freeHandle.first = cpuDescriptorHandle;
-    freeHandle.second = {};
-    m_freeHandles.emplace(freeHandle);
+void DescriptorHeap::EndFrame(uint64_t fenceValue)
+{
+    m_stats.EndFrame(fenceValue);
 }
 
+void DescriptorHeap::GetSnapshots(std::vector<DescriptorHeapSnapshot>& snapshots)
+{
+    DescriptorHeapSnapshot snapshot;
+    snapshot.name = m_name;
+    m_stats.Fill(snapshot);
+    // Only the single descriptors and tables are counted, any reserved region reports its own snapshot
+    snapshot.capacity = m_allocator->GetCapacity() + m_tableAllocator->GetCapacity();
+    snapshot.occupied = m_allocator->GetAllocatedCount() + m_tableOccupied.load(std::memory_order_relaxed);
+    snapshot.freeListLength = snapshot.capacity - snapshot.occupied;
+    snapshot.pendingFrees = static_cast<uint32_t>(m_deferredFrees.GetPendingCount());
+    // Any free slot fits a single descriptor, so only the table region can fragment
+    snapshot.fragmentation = GetTableFragmentation();
+    snapshots.push_back(snapshot);
+}
 
+float DescriptorHeap::GetTableFragmentation()
+{
+    std::lock_guard<std::mutex> lock(m_tableMutex);
+    return m_tableAllocator->GetFragmentation();
+}
+
+UINT DescriptorHeap::GetIndex(const D3D12_CPU_DESCRIPTOR_HANDLE cpuDescriptorHandle) const
+{
+    return static_cast<UINT>((cpuDescriptorHandle.ptr - m_cpuHeapStart.ptr) / m_descriptorSize);
+}
@@ -1,40 +1,154 @@
 #pragma once
 #include "stdafx.h"
-#include <queue>
+#include "DescriptorAllocator.h"
+#include "DescriptorRangeAllocator.h"
+#include "DeferredFreeQueue.h"
+#include "DescriptorHeapStats.h"
+#include <mutex>
 
 class DescriptorHeap
 {
 public:
-    DescriptorHeap(ID3D12Device* device, const D3D12_DESCRIPTOR_HEAP_DESC desc);
+    /**
+    * @param device The ID3D12Device
+    * @param desc Description of the heap to create
+    * @param reservedDescriptors Number of descriptors at the end of the heap withheld from GetFreeHandle, for derived heaps to manage themselves
+    * @param tableDescriptors Number of descriptors, before the reserved ones, set aside for contiguous descriptor tables from GetFreeRange
+    */
+    DescriptorHeap(ID3D12Device* device, const D3D12_DESCRIPTOR_HEAP_DESC desc, UINT reservedDescriptors = 0, UINT tableDescriptors = 0);
     ID3D12DescriptorHeap* GetDescriptorHeap()
     {
         return m_descriptorHeap.Get();
     }
+    /**
+    * Name the heap, both for the debug layer and in its statistics.
+    */
+    void SetName(const std::string& name);
+    /**
+    * @returns What a heap is named until SetName() is called, after its type and whether shaders can see it, e.g. "CBV/SRV/UAV heap (shader visible)"
+    */
+    static std::string GetDefaultName(const D3D12_DESCRIPTOR_HEAP_DESC& desc);
 
     enum RootParameterIndices
     {
         SRV,
+        /** Root CBV holding the pass's view constants, bound by GPU virtual address */
         CBV,
         Sampler,
+        /** Bindless index of the draw's texture and where its world matrix is in the object constants, as 32-bit root constants */
+        DrawConstants,
+        /** Unbounded SRV array over the bindless region, set once per command list */
+        BindlessSRV,
+        /** Root SRV holding every object's world matrix for the frame, bound by GPU virtual address once per pass */
+        ObjectConstants,
+    };
+    /** Compute passes have a root signature of their own, with no samplers or input assembler */
+    enum ComputeRootParameterIndices
+    {
+        /** Whatever a pass passes its shader directly, i.e. bindless indices of its inputs and outputs, as 32-bit root constants */
+        ComputeConstants,
+        /** Unbounded SRV array over the bindless region, set once per command list */
+        ComputeBindlessSRV,
+        /** A pass's output, staged like a draw's SRV since unbounded UAV arrays need binding tier 3 */
+        ComputeUAV,
     };
 
+    /**
+    * Claim a free descriptor in this heap. Safe to call from any thread.
+    * Throws if every descriptor in the heap is already in use.
+    */
     void GetFreeHandle(D3D12_CPU_DESCRIPTOR_HANDLE& cpuDescriptorHandle, D3D12_GPU_DESCRIPTOR_HANDLE& gpuDescriptorHandle);
     void GetFreeHandle(D3D12_CPU_DESCRIPTOR_HANDLE& cpuDescriptorHandle);
+    /**
+    * Return a descriptor claimed with GetFreeHandle to the heap immediately. Safe to call from any thread.
+    * Only valid once the GPU has no work in flight that could reference the descriptor.
+    */
     void Free(const D3D12_CPU_DESCRIPTOR_HANDLE cpuDescriptorHandle, const D3D12_GPU_DESCRIPTOR_HANDLE gpuDescriptorHandle);
     void Free(const D3D12_CPU_DESCRIPTOR_HANDLE cpuDescriptorHandle);
+    /**
+    * Return a descriptor claimed with GetFreeHandle to the heap, once the GPU has finished with it. Safe to call from any thread.
+    * @param cpuDescriptorHandle The descriptor to free
+    * @param fenceValue The fence value signalled after the last command list that could reference the descriptor
+    */
+    void Free(const D3D12_CPU_DESCRIPTOR_HANDLE cpuDescriptorHandle, uint64_t fenceValue);
+
+    /**
+    * Claim count contiguous descriptors, so they can be bound as one descriptor table. Safe to call from any thread.
+    * Throws if no free range in the table region is large enough.
+    * @param count The number of descriptors in the table
+    * @param cpuDescriptorHandle Out, handle to the first descriptor in the table
+    * @param gpuDescriptorHandle Out, handle to bind the table with
+    */
+    void GetFreeRange(UINT count, D3D12_CPU_DESCRIPTOR_HANDLE& cpuDescriptorHandle, D3D12_GPU_DESCRIPTOR_HANDLE& gpuDescriptorHandle);
+    /**
+    * Return a table claimed with GetFreeRange to the heap. Safe to call from any thread.
+    * @param cpuDescriptorHandle Handle to the first descriptor in the table
+    * @param count The count passed to GetFreeRange
+    */
+    void FreeRange(const D3D12_CPU_DESCRIPTOR_HANDLE cpuDescriptorHandle, UINT count);
+    /**
+    * Return a table claimed with GetFreeRange to the heap, once the GPU has finished with it. Safe to call from any thread.
+    * @param cpuDescriptorHandle Handle to the first descriptor in the table
+    * @param count The count passed to GetFreeRange
+    * @param fenceValue The fence value signalled after the last command list that could reference the table
+    */
+    void FreeRange(const D3D12_CPU_DESCRIPTOR_HANDLE cpuDescriptorHandle, UINT count, uint64_t fenceValue);
+    /**
+    * Reuse every descriptor freed against a fence value the GPU has now reached.
+    * @param completedFenceValue The value the fence has currently reached
+    */
+    virtual void Retire(uint64_t completedFenceValue);
+    /**
+    * Close the frame for the heap's statistics.
+    * @param fenceValue The fence value signalled after the frame's final command list
+    */
+    virtual void EndFrame(uint64_t fenceValue);
+    /**
+    * Append the current statistics of this heap, and any regions or heaps it manages, to snapshots.
+    */
+    virtual void GetSnapshots(std::vector<DescriptorHeapSnapshot>& snapshots);
+    /**
+    * @returns how fragmented the table region is, from 0 when all free descriptors are contiguous towards 1
+    */
+    float GetTableFragmentation();
 protected:
-    virtual void CreateHeap(ID3D12Device* device, const D3D12_DESCRIPTOR_HEAP_DESC desc);
+    virtual void CreateHeap(ID3D12Device* device, const D3D12_DESCRIPTOR_HEAP_DESC desc, UINT reservedDescriptors, UINT tableDescriptors);
+
+    /**
+    * @param cpuDescriptorHandle a handle within this heap
+    * @returns the offset of the handle from the start of the heap, in descriptors
+    */
+    UINT GetIndex(const D3D12_CPU_DESCRIPTOR_HANDLE cpuDescriptorHandle) const;
 
 
     Microsoft::WRL::ComPtr<ID3D12DescriptorHeap> m_descriptorHeap;
     UINT m_descriptorSize;
+    // Cached, as querying the heap start isn't free and the GPU start is only valid for shader visible heaps
+    D3D12_CPU_DESCRIPTOR_HANDLE m_cpuHeapStart;
+    D3D12_GPU_DESCRIPTOR_HANDLE m_gpuHeapStart;
 
     /**
-    * Queue of indexes that have been intentionally freed
-    * These are always written to over the end of the list as it eliminates the to check if array has been exceeded
-    * While a priority queue would encourage contiguous placement of resources, such contiguity cannot be expected, and this makes deletion from the array (i.e. pushing to the queue) cheaper
+    * Tracks which descriptors in this heap are in use.
+    * Owned per heap, so the RTV and CBV/SRV/UAV heaps no longer share one offset, and bounded by the heap's NumDescriptors.
+    * Reused slots are handed out most recently freed first rather than in address order, as contiguity cannot be expected anyway.
     */
-    std::queue<std::pair<D3D12_CPU_DESCRIPTOR_HANDLE, D3D12_GPU_DESCRIPTOR_HANDLE>> m_freeHandles;
+    std::unique_ptr<DescriptorAllocator> m_allocator;
 
-};
+    /** Offset of the table region from the start of the heap, in descriptors */
+    UINT m_tableStart;
+    /**
+    * Hands out contiguous ranges of the table region, coalescing them again as they're freed.
+    * Tables are claimed far less often than single descriptors, so a lock is acceptable here.
+    */
+    std::unique_ptr<DescriptorRangeAllocator> m_tableAllocator;
+    std::mutex m_tableMutex;
+
+    /** Descriptors and tables that have been freed, but may still be read by command lists in flight */
+    DeferredFreeQueue m_deferredFrees;
 
+    std::string m_name;
+    DescriptorHeapStats m_stats;
+    /** Descriptors handed out from the table region, kept alongside the allocator so stats needn't take the table lock */
+    std::atomic<uint32_t> m_tableOccupied;
+
+};
@@ -0,0 +1,82 @@
+#include "DescriptorHeapStats.h"
+#include "Json.h"
+#include <bit>
+#include <sstream>
+
+void DescriptorHeapStats::RecordAllocation(uint32_t occupied, uint64_t latencyNanoseconds)
+{
+    m_frameAllocations.fetch_add(1, std::memory_order_relaxed);
+    m_totalAllocations.fetch_add(1, std::memory_order_relaxed);
+
+    // Raise the high-water mark, unless another thread has already raised it further
+    uint32_t highWater = m_highWater.load(std::memory_order_relaxed);
+    while (occupied > highWater && !m_highWater.compare_exchange_weak(highWater, occupied, std::memory_order_relaxed))
+    {
+    }
+
+    // Bucket by the position of the highest set bit, so each bucket covers twice the range of the one before it
+    size_t bucket = latencyNanoseconds ? static_cast<size_t>(std::bit_width(latencyNanoseconds) - 1) : 0;
+    if (bucket >= DescriptorHeapSnapshot::LatencyBuckets)
+    {
+        bucket = DescriptorHeapSnapshot::LatencyBuckets - 1;
+    }
+    m_latencyHistogram[bucket].fetch_add(1, std::memory_order_relaxed);
+}
+
+void DescriptorHeapStats::RecordFree(uint32_t count)
+{
+    m_frameFrees.fetch_add(count, std::memory_order_relaxed);
+    m_totalFrees.fetch_add(count, std::memory_order_relaxed);
+}
+
+void DescriptorHeapStats::EndFrame(uint64_t fenceValue)
+{
+    m_lastFrameFenceValue.store(fenceValue, std::memory_order_relaxed);
+    m_lastFrameAllocations.store(m_frameAllocations.exchange(0, std::memory_order_relaxed), std::memory_order_relaxed);
+    m_lastFrameFrees.store(m_frameFrees.exchange(0, std::memory_order_relaxed), std::memory_order_relaxed);
+}
+
+void DescriptorHeapStats::Fill(DescriptorHeapSnapshot& snapshot) const
+{
+    snapshot.lastFrameFenceValue = m_lastFrameFenceValue.load(std::memory_order_relaxed);
+    snapshot.highWater = m_highWater.load(std::memory_order_relaxed);
+    snapshot.allocationsLastFrame = m_lastFrameAllocations.load(std::memory_order_relaxed);
+    snapshot.freesLastFrame = m_lastFrameFrees.load(std::memory_order_relaxed);
+    snapshot.totalAllocations = m_totalAllocations.load(std::memory_order_relaxed);
+    snapshot.totalFrees = m_totalFrees.load(std::memory_order_relaxed);
+    for (size_t i = 0; i < DescriptorHeapSnapshot::LatencyBuckets; i++)
+    {
+        snapshot.latencyHistogram[i] = m_latencyHistogram[i].load(std::memory_order_relaxed);
+    }
+}
+
+std::string DescriptorHeapStats::ToJson(const std::vector<DescriptorHeapSnapshot>& snapshots)
+{
+    std::ostringstream json;
+    json << "[\n";
+    for (size_t i = 0; i < snapshots.size(); i++)
+    {
+        const DescriptorHeapSnapshot& snapshot = snapshots[i];
+        json << "  {\n"
+            << "    \"name\": \"" << EscapeJson(snapshot.name) << "\",\n"
+            << "    \"lastFrameFenceValue\": " << snapshot.lastFrameFenceValue << ",\n"
+            << "    \"capacity\": " << snapshot.capacity << ",\n"
+            << "    \"occupied\": " << snapshot.occupied << ",\n"
+            << "    \"highWater\": " << snapshot.highWater << ",\n"
+            << "    \"freeListLength\": " << snapshot.freeListLength << ",\n"
+            << "    \"pendingFrees\": " << snapshot.pendingFrees << ",\n"
+            << "    \"fragmentation\": " << snapshot.fragmentation << ",\n"
+            << "    \"allocationsLastFrame\": " << snapshot.allocationsLastFrame << ",\n"
+            << "    \"freesLastFrame\": " << snapshot.freesLastFrame << ",\n"
+            << "    \"totalAllocations\": " << snapshot.totalAllocations << ",\n"
+            << "    \"totalFrees\": " << snapshot.totalFrees << ",\n"
+            << "    \"allocationLatencyHistogramNs\": [";
+        for (size_t bucket = 0; bucket < DescriptorHeapSnapshot::LatencyBuckets; bucket++)
+        {
+            json << (bucket ? ", " : "") << snapshot.latencyHistogram[bucket];
+        }
+        json << "]\n  }" << (i + 1 < snapshots.size() ? "," : "") << "\n";
+    }
+    json << "]\n";
+    return json.str();
+}
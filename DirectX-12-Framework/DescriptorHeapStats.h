@@ -0,0 +1,84 @@
+#pragma once
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/**
+* A point-in-time copy of a descriptor heap's statistics, for display or dumping.
+*/
+struct DescriptorHeapSnapshot
+{
+	/** Buckets of the allocation latency histogram, bucket i counting allocations that took [2^i, 2^(i+1)) nanoseconds */
+	static const size_t LatencyBuckets = 16;
+
+	std::string name;
+	/** Descriptors the heap, or region, can hold */
+	uint32_t capacity = 0;
+	/** Descriptors currently handed out */
+	uint32_t occupied = 0;
+	/** The most descriptors ever handed out at once */
+	uint32_t highWater = 0;
+	/** Descriptors free to be handed out */
+	uint32_t freeListLength = 0;
+	/** Descriptors freed, but waiting on the GPU before they can be reused */
+	uint32_t pendingFrees = 0;
+	/** The fence value of the last frame to have ended, which the per-frame counts are of */
+	uint64_t lastFrameFenceValue = 0;
+	/** 0 when all free descriptors are contiguous, approaching 1 as they're split into ever smaller ranges */
+	float fragmentation = 0.0f;
+	uint32_t allocationsLastFrame = 0;
+	uint32_t freesLastFrame = 0;
+	uint64_t totalAllocations = 0;
+	uint64_t totalFrees = 0;
+	std::array<uint64_t, LatencyBuckets> latencyHistogram = {};
+};
+
+/**
+* Counters a descriptor heap keeps about its own use. Safe to record into from any thread.
+* Owns no D3D12 objects, so it can be driven without a device.
+*/
+class DescriptorHeapStats
+{
+public:
+	/**
+	* Count an allocation.
+	* @param occupied The number of descriptors handed out after the allocation, to update the high-water mark with
+	* @param latencyNanoseconds How long the allocation took
+	*/
+	void RecordAllocation(uint32_t occupied, uint64_t latencyNanoseconds);
+	/**
+	* Count descriptors returned to the heap.
+	* @param count The number of descriptors freed
+	*/
+	void RecordFree(uint32_t count = 1);
+	/**
+	* Close the frame, making its allocation and free counts available to Fill().
+	* @param fenceValue The fence value the frame was signalled with, to tag its counts with
+	*/
+	void EndFrame(uint64_t fenceValue);
+
+	/**
+	* Copy the counters into a snapshot. The heap fills in the fields describing its current state itself.
+	* @param snapshot The snapshot to fill in
+	*/
+	void Fill(DescriptorHeapSnapshot& snapshot) const;
+
+	/**
+	* @param snapshots Snapshots of every heap to dump
+	* @returns The snapshots as a JSON array
+	*/
+	static std::string ToJson(const std::vector<DescriptorHeapSnapshot>& snapshots);
+
+private:
+	std::atomic<uint32_t> m_frameAllocations{ 0 };
+	std::atomic<uint32_t> m_frameFrees{ 0 };
+	std::atomic<uint32_t> m_lastFrameAllocations{ 0 };
+	std::atomic<uint32_t> m_lastFrameFrees{ 0 };
+	std::atomic<uint64_t> m_lastFrameFenceValue{ 0 };
+	std::atomic<uint64_t> m_totalAllocations{ 0 };
+	std::atomic<uint64_t> m_totalFrees{ 0 };
+	std::atomic<uint32_t> m_highWater{ 0 };
+	std::array<std::atomic<uint64_t>, DescriptorHeapSnapshot::LatencyBuckets> m_latencyHistogram = {};
+};
@@ -0,0 +1,106 @@
+#include "DescriptorRangeAllocator.h"
+#include <cassert>
+
+DescriptorRangeAllocator::DescriptorRangeAllocator(uint32_t capacity)
+    : m_capacity(capacity)
+    , m_freeCount(0)
+    , m_freeByOffset()
+    , m_freeBySize()
+{
+    if (capacity > 0)
+    {
+        Insert(0, capacity);
+    }
+}
+
+uint32_t DescriptorRangeAllocator::Allocate(uint32_t count)
+{
+    if (count == 0)
+    {
+        return InvalidIndex;
+    }
+
+    // Best fit, take the smallest free range that is large enough, which keeps the large ranges intact for large tables
+    auto bySize = m_freeBySize.lower_bound(count);
+    if (bySize == m_freeBySize.end())
+    {
+        return InvalidIndex;
+    }
+
+    uint32_t offset = bySize->second;
+    uint32_t size = bySize->first;
+    Erase(m_freeByOffset.find(offset));
+
+    // Return whatever is left of the range to the free lists
+    if (size > count)
+    {
+        Insert(offset + count, size - count);
+    }
+    return offset;
+}
+
+void DescriptorRangeAllocator::Free(uint32_t offset, uint32_t count)
+{
+    assert(offset + count <= m_capacity && "Descriptor range does not belong to this allocator.");
+
+    // Merge with the free range directly after this one
+    auto next = m_freeByOffset.find(offset + count);
+    if (next != m_freeByOffset.end())
+    {
+        count += next->second;
+        Erase(next);
+    }
+
+    // Merge with the free range directly before this one
+    auto previous = m_freeByOffset.lower_bound(offset);
+    if (previous != m_freeByOffset.begin())
+    {
+        previous--;
+        assert(previous->first + previous->second <= offset && "Descriptor range freed twice.");
+        if (previous->first + previous->second == offset)
+        {
+            offset = previous->first;
+            count += previous->second;
+            Erase(previous);
+        }
+    }
+
+    Insert(offset, count);
+}
+
+uint32_t DescriptorRangeAllocator::GetLargestFreeRange() const
+{
+    return m_freeBySize.empty() ? 0 : m_freeBySize.rbegin()->first;
+}
+
+float DescriptorRangeAllocator::GetFragmentation() const
+{
+    if (m_freeCount == 0)
+    {
+        return 0.0f;
+    }
+    return 1.0f - static_cast<float>(GetLargestFreeRange()) / static_cast<float>(m_freeCount);
+}
+
+void DescriptorRangeAllocator::Insert(uint32_t offset, uint32_t count)
+{
+    m_freeByOffset.emplace(offset, count);
+    m_freeBySize.emplace(count, offset);
+    m_freeCount += count;
+}
+
+void DescriptorRangeAllocator::Erase(std::map<uint32_t, uint32_t>::iterator range)
+{
+    // Several ranges can share a size, so find the entry for this exact offset
+    auto bySize = m_freeBySize.equal_range(range->second);
+    for (auto it = bySize.first; it != bySize.second; it++)
+    {
+        if (it->second == range->first)
+        {
+            m_freeBySize.erase(it);
+            break;
+        }
+    }
+    m_freeCount -= range->second;
+    m_freeByOffset.erase(range);
+}
@@ -0,0 +1,76 @@
+#pragma once
+#include <cstdint>
+#include <map>
+
+/**
+* Allocator of contiguous ranges of descriptors, so a descriptor table can be bound with a single SetGraphicsRootDescriptorTable.
+* Free ranges are tracked both by offset, so neighbours can be found and coalesced when a range is freed,
+* and by size, so Allocate() can find the smallest range that fits in O(log n).
+* Owns no D3D12 objects and isn't thread safe, the owning heap serializes access.
+*/
+class DescriptorRangeAllocator
+{
+public:
+	static const uint32_t InvalidIndex = UINT32_MAX;
+
+	/**
+	* @param capacity The number of descriptors in the region this allocator manages
+	*/
+	DescriptorRangeAllocator(uint32_t capacity);
+
+	/**
+	* Claim count contiguous descriptors, from the smallest free range that fits them.
+	* @param count The number of descriptors in the range
+	* @returns The offset of the first descriptor in the range, or InvalidIndex if no free range is large enough
+	*/
+	uint32_t Allocate(uint32_t count);
+	/**
+	* Return a range claimed with Allocate(), merging it with any free neighbours.
+	* @param offset The offset returned by Allocate()
+	* @param count The count passed to Allocate()
+	*/
+	void Free(uint32_t offset, uint32_t count);
+
+	uint32_t GetCapacity() const
+	{
+		return m_capacity;
+	}
+
+	/**
+	* @returns The total number of free descriptors, across all free ranges
+	*/
+	uint32_t GetFreeCount() const
+	{
+		return m_freeCount;
+	}
+
+	/**
+	* @returns The number of separate free ranges
+	*/
+	uint32_t GetFreeRangeCount() const
+	{
+		return static_cast<uint32_t>(m_freeByOffset.size());
+	}
+
+	/**
+	* @returns The size of the largest range that could currently be allocated
+	*/
+	uint32_t GetLargestFreeRange() const;
+
+	/**
+	* @returns 0 when all free descriptors form one range, approaching 1 as free space is split into ever smaller ranges
+	*/
+	float GetFragmentation() const;
+
+private:
+	void Insert(uint32_t offset, uint32_t count);
+	void Erase(std::map<uint32_t, uint32_t>::iterator range);
+
+	const uint32_t m_capacity;
+	uint32_t m_freeCount;
+
+	/** Offset of each free range to its size */
+	std::map<uint32_t, uint32_t> m_freeByOffset;
+	/** Size of each free range to its offset */
+	std::multimap<uint32_t, uint32_t> m_freeBySize;
+};
@@ -0,0 +1,57 @@
+#include "DescriptorRing.h"
+
+DescriptorRing::DescriptorRing(uint32_t capacity)
+    : m_capacity(capacity)
+    , m_head(0)
+    , m_used(0)
+    , m_frameUsed(0)
+    , m_frames()
+{
+}
+
+uint32_t DescriptorRing::Allocate(uint32_t count)
+{
+    if (count == 0 || count > m_capacity)
+    {
+        return InvalidIndex;
+    }
+
+    // Tables must be contiguous, so if the range would run off the end of the region, skip the remainder and start again from 0
+    uint32_t skipped = 0;
+    if (m_head + count > m_capacity)
+    {
+        skipped = m_capacity - m_head;
+    }
+
+    // Not enough free space between the head and the tail, every slot is still referenced by in-flight frames
+    if (m_used + skipped + count > m_capacity)
+    {
+        return InvalidIndex;
+    }
+
+    uint32_t offset = skipped ? 0 : m_head;
+    m_head = (offset + count) % m_capacity;
+    // Skipped slots are charged to this frame, so they are returned when it retires
+    m_used += skipped + count;
+    m_frameUsed += skipped + count;
+    return offset;
+}
+
+void DescriptorRing::EndFrame(uint64_t fenceValue)
+{
+    m_frames.push(FrameEntry{ fenceValue, m_frameUsed });
+    m_frameUsed = 0;
+}
+
+uint32_t DescriptorRing::Retire(uint64_t completedFenceValue)
+{
+    uint32_t released = 0;
+    // Frames complete in order, so stop at the first one still in flight
+    while (!m_frames.empty() && m_frames.front().fenceValue <= completedFenceValue)
+    {
+        released += m_frames.front().used;
+        m_frames.pop();
+    }
+    m_used -= released;
+    return released;
+}
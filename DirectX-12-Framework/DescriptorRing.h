@@ -0,0 +1,89 @@
+#pragma once
+#include <cstdint>
+#include <queue>
+
+/**
+* Linear allocator over a region of a descriptor heap, for descriptors only needed for the frame they are drawn in.
+* Slots are bump-allocated from the head. When a frame is submitted, EndFrame() tags everything allocated since the last EndFrame() with that frame's fence value,
+* and once the fence has completed Retire() releases the whole frame's worth in one go.
+* Owns no D3D12 objects, so fence progression can be simulated by feeding it plain values.
+*/
+class DescriptorRing
+{
+public:
+	static const uint32_t InvalidIndex = UINT32_MAX;
+
+	/**
+	* @param capacity number of descriptors in the region the ring manages
+	*/
+	DescriptorRing(uint32_t capacity);
+
+	/**
+	* Claim count contiguous slots for the frame currently being recorded.
+	* @param count number of contiguous descriptors, i.e. the size of the descriptor table
+	* @returns offset of the first slot from the start of the region, or InvalidIndex if the ring is full of in-flight frames
+	*/
+	uint32_t Allocate(uint32_t count = 1);
+
+	/**
+	* Close the frame currently being recorded.
+	* @param fenceValue the fence value signalled after the frame's command lists, after which its descriptors are no longer referenced by the GPU
+	*/
+	void EndFrame(uint64_t fenceValue);
+
+	/**
+	* Release every closed frame whose fence value has been reached.
+	* @param completedFenceValue the value the fence has currently reached
+	* @returns the number of slots released
+	*/
+	uint32_t Retire(uint64_t completedFenceValue);
+
+	uint32_t GetCapacity() const
+	{
+		return m_capacity;
+	}
+
+	/**
+	* @returns slots held by in-flight frames and the frame being recorded
+	*/
+	uint32_t GetUsed() const
+	{
+		return m_used;
+	}
+
+	/**
+	* @returns slots held by the frame currently being recorded
+	*/
+	uint32_t GetFrameUsed() const
+	{
+		return m_frameUsed;
+	}
+
+	/**
+	* @returns the fence value of the oldest closed frame not yet retired, i.e. what to wait for to free slots, or 0 if every frame has retired
+	*/
+	uint64_t GetOldestFenceValue() const
+	{
+		return m_frames.empty() ? 0 : m_frames.front().fenceValue;
+	}
+
+private:
+	/**
+	* The number of slots a closed frame holds, and the fence value that retires them.
+	*/
+	struct FrameEntry
+	{
+		uint64_t fenceValue;
+		uint32_t used;
+	};
+
+	const uint32_t m_capacity;
+	/** Next slot to be handed out */
+	uint32_t m_head;
+	/** Slots held by unretired frames, including any skipped at the end of the region when wrapping */
+	uint32_t m_used;
+	/** Slots used by the frame currently being recorded */
+	uint32_t m_frameUsed;
+
+	std::queue<FrameEntry> m_frames;
+};
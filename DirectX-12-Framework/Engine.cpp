@@ -31,24 +31,17 @@ Engine::~Engine()
     m_portals.clear();
     for (auto srv = m_textures.begin(); srv != m_textures.end(); srv++)
     {
-        auto srvCpuDescriptorHandle = (*srv)->cpuDescriptorHandle;
-        auto srvGpuDescriptorHandle = (*srv)->gpuDescriptorHandle;
-        m_renderer->UnloadResource(srvCpuDescriptorHandle, srvGpuDescriptorHandle);
+        m_renderer->UnloadResource((*srv)->descriptorHandle);
     }
     m_textures.clear();
-    for (auto cbv = m_constantBuffers.begin(); cbv != m_constantBuffers.end(); cbv++)
-    {
-        auto cbvCpuDescriptorHandle = (*cbv)->cpuDescriptorHandle;
-        auto cbvGpuDescriptorHandle = (*cbv)->gpuDescriptorHandle;
-        m_renderer->UnloadResource(cbvCpuDescriptorHandle, cbvGpuDescriptorHandle);
-    }
+    // Constant buffers hold no descriptors, their constants are released with the frame that wrote them
     m_constantBuffers.clear();
     for (auto renderTexture = m_renderTextures.begin(); renderTexture != m_renderTextures.end(); renderTexture++)
     {
-        auto srvCpuDescriptorHandle = (*renderTexture)->cpuDescriptorHandle;
-        auto srvGpuDescriptorHandle = (*renderTexture)->gpuDescriptorHandle;
+        auto srvDescriptorHandle = (*renderTexture)->descriptorHandle;
         auto rtvCpuDescriptorHandle = (*renderTexture)->rtvCpuDescriptorHandle;
-        m_renderer->UnloadResource(srvCpuDescriptorHandle, srvGpuDescriptorHandle, rtvCpuDescriptorHandle);
+        auto dsvCpuDescriptorHandle = (*renderTexture)->dsvCpuDescriptorHandle;
+        m_renderer->UnloadResource(srvDescriptorHandle, rtvCpuDescriptorHandle, dsvCpuDescriptorHandle);
     }
     m_renderTextures.clear();
 
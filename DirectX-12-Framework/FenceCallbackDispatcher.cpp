@@ -0,0 +1,118 @@
+#include "FenceCallbackDispatcher.h"
+#include <algorithm>
+#include <vector>
+
+FenceCallbackDispatcher::FenceCallbackDispatcher()
+    : m_registrations(nullptr)
+    , m_wake()
+    , m_registered(0)
+    , m_dispatched(0)
+    , m_stopping(false)
+    , m_thread(&FenceCallbackDispatcher::Dispatch, this)
+{
+}
+
+FenceCallbackDispatcher::~FenceCallbackDispatcher()
+{
+    m_stopping.store(true, std::memory_order_release);
+    m_wake.Set();
+    m_thread.join();
+}
+
+void FenceCallbackDispatcher::OnFenceComplete(Timeline& timeline, uint64_t value, std::function<void()> callback)
+{
+    Node* node = new Node{ &timeline, value, std::move(callback), m_registrations.load(std::memory_order_relaxed) };
+    // Nodes are only ever pushed here and taken all at once by the dispatcher thread, never popped singly, so there is no ABA to guard against
+    while (!m_registrations.compare_exchange_weak(node->next, node, std::memory_order_release, std::memory_order_relaxed))
+    {
+    }
+    m_registered.fetch_add(1, std::memory_order_relaxed);
+    m_wake.Set();
+}
+
+void FenceCallbackDispatcher::Dispatch()
+{
+    struct Pending
+    {
+        uint64_t value;
+        /** Registration order, so callbacks for the same value run in the order they were registered */
+        uint64_t sequence;
+        std::function<void()> callback;
+    };
+    // A min-heap on value then sequence
+    auto later = [](const Pending& a, const Pending& b)
+    {
+        return a.value != b.value ? a.value > b.value : a.sequence > b.sequence;
+    };
+    struct TimelineCallbacks
+    {
+        Timeline* timeline;
+        std::vector<Pending> pending;
+        /** The value the timeline was last asked to set the event at, 0 if it hasn't been */
+        uint64_t armedValue;
+    };
+    // Only as many as there are queues, so a linear search is quickest
+    std::vector<TimelineCallbacks> timelines;
+    std::vector<Node*> taken;
+    uint64_t sequence = 0;
+
+    for (;;)
+    {
+        // Read before taking the stack. A registration made after it's taken sets the event, so the wait below returns straight away
+        bool stopping = m_stopping.load(std::memory_order_acquire);
+
+        // The stack is most recent first, so reverse it back into registration order
+        for (Node* node = m_registrations.exchange(nullptr, std::memory_order_acquire); node; node = node->next)
+        {
+            taken.push_back(node);
+        }
+        for (auto node = taken.rbegin(); node != taken.rend(); ++node)
+        {
+            auto callbacks = std::find_if(timelines.begin(), timelines.end(), [&](const TimelineCallbacks& c) { return c.timeline == (*node)->timeline; });
+            if (callbacks == timelines.end())
+            {
+                callbacks = timelines.insert(timelines.end(), TimelineCallbacks{ (*node)->timeline, {}, 0 });
+            }
+            callbacks->pending.push_back(Pending{ (*node)->value, sequence++, std::move((*node)->callback) });
+            std::push_heap(callbacks->pending.begin(), callbacks->pending.end(), later);
+            delete *node;
+        }
+        taken.clear();
+
+        for (auto& callbacks : timelines)
+        {
+            auto& pending = callbacks.pending;
+            if (pending.empty())
+            {
+                continue;
+            }
+            uint64_t completedValue = callbacks.timeline->GetCompletedValue();
+            while (!pending.empty() && pending.front().value <= completedValue)
+            {
+                std::pop_heap(pending.begin(), pending.end(), later);
+                auto callback = std::move(pending.back().callback);
+                pending.pop_back();
+                callback();
+                m_dispatched.fetch_add(1, std::memory_order_relaxed);
+            }
+        }
+
+        if (stopping)
+        {
+            // Anything left is for work that will never complete, so the callbacks are destroyed without running
+            return;
+        }
+
+        // Only the lowest pending value of each timeline needs to wake the thread, and only once. Reaching it runs those callbacks,
+        // after which the next lowest is armed. Arming again for a value already armed would just queue duplicate wake-ups
+        for (auto& callbacks : timelines)
+        {
+            if (!callbacks.pending.empty() && callbacks.pending.front().value != callbacks.armedValue)
+            {
+                callbacks.armedValue = callbacks.pending.front().value;
+                callbacks.timeline->SetEventOnCompletion(callbacks.armedValue, m_wake);
+            }
+        }
+        m_wake.Wait();
+    }
+}
@@ -0,0 +1,70 @@
+#pragma once
+#include "Timeline.h"
+#include "WakeEvent.h"
+#include <atomic>
+#include <functional>
+#include <thread>
+
+/**
+* Runs callbacks once timelines reach the values they were registered for, on a thread of its own, so the threads registering them never block on the GPU.
+* One dispatcher serves every queue. Registering pushes onto a lock-free stack, the dispatcher thread takes the whole stack at once
+* and keeps what isn't complete yet in a heap per timeline ordered by value.
+* The thread blocks on a single event, which each timeline sets once it reaches its lowest pending value, and which registering also sets, so it never polls.
+* Owns no D3D12 objects, and WakeEvent only needs Win32 on Windows, so it can be driven by SimulatedTimelines on any platform.
+*/
+class FenceCallbackDispatcher
+{
+public:
+	FenceCallbackDispatcher();
+	/**
+	* Runs the callbacks of values already reached, and destroys the rest without running them.
+	* Every timeline with callbacks registered must outlive the dispatcher, and be flushed before it's destroyed, as it may still be due to set the dispatcher's event.
+	*/
+	~FenceCallbackDispatcher();
+
+	FenceCallbackDispatcher(const FenceCallbackDispatcher&) = delete;
+	FenceCallbackDispatcher& operator=(const FenceCallbackDispatcher&) = delete;
+
+	/**
+	* Run a callback once a timeline reaches a value. Callbacks for the same timeline and value run in the order they were registered, lower values first.
+	* Safe to call from any thread, including from a callback, without taking a lock.
+	* @param timeline The timeline the value is on
+	* @param value The value to wait for, the callback runs soon after if it's already been reached
+	* @param callback Run on the dispatcher thread, so anything it touches must be safe to touch from there. Must not throw
+	*/
+	void OnFenceComplete(Timeline& timeline, uint64_t value, std::function<void()> callback);
+
+	/**
+	* @returns The number of callbacks registered and run so far
+	*/
+	uint64_t GetRegisteredCount() const
+	{
+		return m_registered.load(std::memory_order_relaxed);
+	}
+	uint64_t GetDispatchedCount() const
+	{
+		return m_dispatched.load(std::memory_order_relaxed);
+	}
+
+private:
+	struct Node
+	{
+		Timeline* timeline;
+		uint64_t value;
+		std::function<void()> callback;
+		Node* next;
+	};
+
+	/** The dispatcher thread */
+	void Dispatch();
+
+	/** Callbacks registered since the dispatcher thread last looked, most recent first */
+	std::atomic<Node*> m_registrations;
+	/** Set by registrations and by timelines reaching the values the thread is waiting for */
+	WakeEvent m_wake;
+	std::atomic<uint64_t> m_registered;
+	std::atomic<uint64_t> m_dispatched;
+	std::atomic<bool> m_stopping;
+
+	std::thread m_thread;
+};
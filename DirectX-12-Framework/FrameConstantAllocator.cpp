@@ -0,0 +1,140 @@
+#include "FrameConstantAllocator.h"
+
+FrameConstantAllocator::Buffer::Buffer(UINT64 capacity) :
+    resource(),
+    cpuStart(nullptr),
+    gpuStart(0),
+    // Offsets within the buffer are aligned, and the buffer itself starts at a 64KB boundary, so every allocation's address is aligned too
+    ring(capacity, D3D12_CONSTANT_BUFFER_DATA_PLACEMENT_ALIGNMENT)
+{
+}
+
+FrameConstantAllocator::FrameConstantAllocator(ID3D12Device* device, UINT64 capacity) :
+    m_device(device),
+    m_buffers(),
+    m_current(nullptr),
+    m_growMutex()
+{
+    m_buffers.push_back(CreateBuffer(capacity));
+    m_current.store(m_buffers.back().get(), std::memory_order_release);
+}
+
+FrameConstantAllocator::FrameConstantAllocator(void* cpuStart, D3D12_GPU_VIRTUAL_ADDRESS gpuStart, UINT64 capacity) :
+    m_device(nullptr),
+    m_buffers(),
+    m_current(nullptr),
+    m_growMutex()
+{
+    auto buffer = std::make_unique<Buffer>(capacity);
+    buffer->cpuStart = static_cast<UINT8*>(cpuStart);
+    buffer->gpuStart = gpuStart;
+    m_buffers.push_back(std::move(buffer));
+    m_current.store(m_buffers.back().get(), std::memory_order_release);
+}
+
+FrameConstantAllocator::~FrameConstantAllocator()
+{
+    // Memory the caller passed in is theirs to unmap
+    for (auto& buffer : m_buffers)
+    {
+        if (buffer->resource)
+        {
+            buffer->resource->Unmap(0, nullptr);
+        }
+    }
+}
+
+std::unique_ptr<FrameConstantAllocator::Buffer> FrameConstantAllocator::CreateBuffer(UINT64 capacity)
+{
+    auto buffer = std::make_unique<Buffer>(capacity);
+    auto heapProps = CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_UPLOAD);
+    auto bufferDesc = CD3DX12_RESOURCE_DESC::Buffer(buffer->ring.GetCapacity());
+    ThrowIfFailed(m_device->CreateCommittedResource(
+        &heapProps,
+        D3D12_HEAP_FLAG_NONE,
+        &bufferDesc,
+        D3D12_RESOURCE_STATE_GENERIC_READ,  // Required heap state for an upload heap
+        nullptr,
+        IID_PPV_ARGS(&buffer->resource)
+    ), "Failed to create frame constant buffer.\n");
+    buffer->resource->SetName(L"Frame Constants");
+
+    // Mapped for the lifetime of the buffer, the CPU only ever writes to it
+    CD3DX12_RANGE readRange(0, 0);
+    ThrowIfFailed(buffer->resource->Map(0, &readRange, reinterpret_cast<void**>(&buffer->cpuStart)), "Failed to map frame constant buffer.\n");
+    buffer->gpuStart = buffer->resource->GetGPUVirtualAddress();
+    return buffer;
+}
+
+FrameConstantAllocator::Allocation FrameConstantAllocator::Allocate(UINT64 size)
+{
+    for (;;)
+    {
+        Buffer* buffer = m_current.load(std::memory_order_acquire);
+        UINT64 offset = buffer->ring.Allocate(size);
+        if (offset != ConstantRing::InvalidOffset)
+        {
+            return Allocation{ buffer->cpuStart + offset, buffer->gpuStart + offset };
+        }
+
+        std::lock_guard<std::mutex> lock(m_growMutex);
+        // Another thread may have grown it while this one waited, in which case try the new buffer
+        if (m_current.load(std::memory_order_relaxed) == buffer)
+        {
+            ThrowIfFalse(m_device != nullptr, "Frame constant buffer is full.\n");
+            UINT64 capacity = buffer->ring.GetCapacity() * 2;
+            while (capacity < size)
+            {
+                capacity *= 2;
+            }
+            // The frame's earlier constants stay where they are, the old buffer is kept until every frame that wrote to it completes
+            m_buffers.push_back(CreateBuffer(capacity));
+            m_current.store(m_buffers.back().get(), std::memory_order_release);
+        }
+    }
+}
+
+void FrameConstantAllocator::EndFrame(UINT64 fenceValue)
+{
+    for (auto& buffer : m_buffers)
+    {
+        buffer->ring.EndFrame(fenceValue);
+    }
+}
+
+void FrameConstantAllocator::Retire(UINT64 completedFenceValue)
+{
+    for (auto& buffer : m_buffers)
+    {
+        buffer->ring.Retire(completedFenceValue);
+    }
+    // Buffers before the current one are never allocated from again, so once empty nothing reads them
+    while (m_buffers.size() > 1 && m_buffers.front()->ring.GetUsed() == 0)
+    {
+        if (m_buffers.front()->resource)
+        {
+            m_buffers.front()->resource->Unmap(0, nullptr);
+        }
+        m_buffers.erase(m_buffers.begin());
+    }
+}
+
+UINT64 FrameConstantAllocator::GetFrameUsed() const
+{
+    UINT64 used = 0;
+    for (auto& buffer : m_buffers)
+    {
+        used += buffer->ring.GetFrameUsed();
+    }
+    return used;
+}
+
+UINT64 FrameConstantAllocator::GetUsed() const
+{
+    UINT64 used = 0;
+    for (auto& buffer : m_buffers)
+    {
+        used += buffer->ring.GetUsed();
+    }
+    return used;
+}
@@ -0,0 +1,102 @@
+#pragma once
+#include "stdafx.h"
+#include "ConstantRing.h"
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+/**
+* Persistently mapped upload buffer used as a ring, which constants are bump-allocated from and bound by GPU virtual address.
+* Every write of a constant buffer gets fresh memory, so the CPU never overwrites constants a queued frame is yet to read,
+* and a frame's constants are released all at once when its fence completes.
+* If a frame needs more than the buffer has free, a buffer twice the size takes over, and the old one is released once the frames that wrote to it complete.
+*/
+class FrameConstantAllocator
+{
+public:
+    /**
+    * A block of constant memory, valid until the frame that allocated it completes.
+    */
+    struct Allocation
+    {
+        void* cpuAddress;
+        D3D12_GPU_VIRTUAL_ADDRESS gpuAddress;
+    };
+
+    /**
+    * @param device The ID3D12Device
+    * @param capacity Initial size of the buffer, shared by every frame in flight
+    */
+    FrameConstantAllocator(ID3D12Device* device, UINT64 capacity);
+    /**
+    * Allocate from memory the caller owns and keeps mapped instead, e.g. ordinary CPU memory to run the allocator without a device.
+    * Without a device it can't grow, so Allocate() throws once the memory is full.
+    * @param cpuStart Where the CPU writes the memory
+    * @param gpuStart Where the GPU reads the same memory, 256-byte aligned
+    * @param capacity Size of the memory, shared by every frame in flight
+    */
+    FrameConstantAllocator(void* cpuStart, D3D12_GPU_VIRTUAL_ADDRESS gpuStart, UINT64 capacity);
+    ~FrameConstantAllocator();
+
+    /**
+    * Claim constant memory for the frame being recorded. Safe to call from any thread.
+    * Grows the buffer if it's full of constants in-flight frames are yet to read, or throws if it can't grow, leaving what was allocated intact.
+    * @param size Size of the constants, rounded up to the 256 bytes constant buffers must be aligned to
+    */
+    Allocation Allocate(UINT64 size);
+    /**
+    * Close the frame being recorded.
+    * @param fenceValue The fence value signalled after the frame's command lists, after which its constants can be overwritten
+    */
+    void EndFrame(UINT64 fenceValue);
+    /**
+    * Release the constants of every frame the GPU has finished with, and any buffer grown out of once nothing in flight reads it.
+    * @param completedFenceValue The value the frame fence has currently reached
+    */
+    void Retire(UINT64 completedFenceValue);
+
+    /**
+    * @returns Bytes allocated by the frame being recorded
+    */
+    UINT64 GetFrameUsed() const;
+    /**
+    * @returns Bytes held by frames in flight and the frame being recorded
+    */
+    UINT64 GetUsed() const;
+    /**
+    * @returns Size of the buffer being allocated from
+    */
+    UINT64 GetCapacity() const
+    {
+        return m_current.load(std::memory_order_acquire)->ring.GetCapacity();
+    }
+    /**
+    * @returns The number of buffers, more than one while frames written before the last growth are in flight
+    */
+    UINT GetBufferCount() const
+    {
+        return static_cast<UINT>(m_buffers.size());
+    }
+
+private:
+    struct Buffer
+    {
+        Microsoft::WRL::ComPtr<ID3D12Resource> resource;
+        UINT8* cpuStart;
+        D3D12_GPU_VIRTUAL_ADDRESS gpuStart;
+        ConstantRing ring;
+
+        Buffer(UINT64 capacity);
+    };
+    std::unique_ptr<Buffer> CreateBuffer(UINT64 capacity);
+
+    /** Null if the caller owns the memory, which can't grow */
+    ID3D12Device* m_device;
+    /** Every buffer, oldest first, ending with the one being allocated from */
+    std::vector<std::unique_ptr<Buffer>> m_buffers;
+    /** The last of m_buffers, swapped for a bigger one while threads are allocating */
+    std::atomic<Buffer*> m_current;
+    /** Serialises growing, never taken while there's room */
+    std::mutex m_growMutex;
+};
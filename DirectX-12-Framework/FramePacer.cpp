@@ -0,0 +1,33 @@
+#include "FramePacer.h"
+#include <cassert>
+
+FramePacer::FramePacer(uint32_t maxFramesInFlight, uint32_t framesInFlight)
+	: m_framesInFlight(1)
+	, m_frameNumber(0)
+	, m_frameFences(maxFramesInFlight, 0)
+{
+	assert(maxFramesInFlight > 0 && "Need at least one copy of per-frame resources.");
+	SetFramesInFlight(framesInFlight);
+}
+
+uint64_t FramePacer::BeginFrame()
+{
+	// The frame N frames ago. With N at most the number of copies, that's no older than the last frame to use this frame's copy
+	if (m_frameNumber < m_framesInFlight)
+	{
+		return 0;
+	}
+	return m_frameFences[(m_frameNumber - m_framesInFlight) % m_frameFences.size()];
+}
+
+void FramePacer::EndFrame(uint64_t fenceValue)
+{
+	m_frameFences[GetFrameIndex()] = fenceValue;
+	m_frameNumber++;
+}
+
+void FramePacer::SetFramesInFlight(uint32_t framesInFlight)
+{
+	assert(framesInFlight > 0 && framesInFlight <= m_frameFences.size() && "Frames in flight out of range.");
+	m_framesInFlight = framesInFlight;
+}
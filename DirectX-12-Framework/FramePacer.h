@@ -0,0 +1,57 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+
+/**
+* Decides how long the CPU has to wait before recording each frame, so that up to N frames are queued on the GPU at once.
+* Per-frame resources come in MaxFramesInFlight copies, selected by GetFrameIndex(). Before recording, BeginFrame() gives the fence value of the frame N frames ago,
+* which is also new enough that the copy about to be reused has been finished with, however N is changed between frames.
+* Owns no D3D12 objects, so the schedule can be checked against a simulated GPU by feeding it plain fence values.
+*/
+class FramePacer
+{
+public:
+	/**
+	* @param maxFramesInFlight The number of copies of per-frame resources, the highest N can be set to
+	* @param framesInFlight The initial N
+	*/
+	FramePacer(uint32_t maxFramesInFlight, uint32_t framesInFlight);
+
+	/**
+	* Start recording the next frame.
+	* @returns The fence value to wait for before recording, or 0 if there's no need to wait
+	*/
+	uint64_t BeginFrame();
+	/**
+	* Close the frame being recorded.
+	* @param fenceValue The fence value signalled after the frame's command lists
+	*/
+	void EndFrame(uint64_t fenceValue);
+
+	/**
+	* @returns Which copy of the per-frame resources the frame being recorded uses, in [0, maxFramesInFlight)
+	*/
+	uint32_t GetFrameIndex() const
+	{
+		return static_cast<uint32_t>(m_frameNumber % m_frameFences.size());
+	}
+	uint32_t GetFramesInFlight() const
+	{
+		return m_framesInFlight;
+	}
+	/**
+	* Change N, taking effect from the next BeginFrame(). 1 waits for each frame before recording the next.
+	*/
+	void SetFramesInFlight(uint32_t framesInFlight);
+	uint32_t GetMaxFramesInFlight() const
+	{
+		return static_cast<uint32_t>(m_frameFences.size());
+	}
+
+private:
+	uint32_t m_framesInFlight;
+	/** Frames begun so far, the frame being recorded is m_frameNumber */
+	uint64_t m_frameNumber;
+	/** Fence value of each of the last maxFramesInFlight frames, by frame number modulo maxFramesInFlight */
+	std::vector<uint64_t> m_frameFences;
+};
@@ -0,0 +1,192 @@
+#include "GpuProfiler.h"
+#include "Json.h"
+#include <algorithm>
+#include <cassert>
+#include <sstream>
+
+float GpuProfiler::MarkerHistory::GetLatest() const
+{
+    if (count == 0)
+    {
+        return 0.0f;
+    }
+    return milliseconds[(head + milliseconds.size() - 1) % milliseconds.size()];
+}
+
+float GpuProfiler::MarkerHistory::GetAverage() const
+{
+    if (count == 0)
+    {
+        return 0.0f;
+    }
+    float total = 0.0f;
+    for (uint32_t i = 0; i < count; i++)
+    {
+        total += milliseconds[i];
+    }
+    return total / float(count);
+}
+
+float GpuProfiler::MarkerHistory::GetMax() const
+{
+    if (count == 0)
+    {
+        return 0.0f;
+    }
+    return *std::max_element(milliseconds.begin(), milliseconds.begin() + count);
+}
+
+GpuProfiler::GpuProfiler(TimestampBackend& backend, uint32_t frameCount, uint32_t historyLength)
+    : m_backend(backend)
+    // A begin and an end timestamp per marker
+    , m_markersPerFrame(backend.GetQueryCount() / frameCount / 2)
+    , m_historyLength(historyLength)
+    , m_frames(frameCount)
+    , m_pendingFrames()
+    , m_frameIndex(0)
+    , m_timing(false)
+    , m_frameNumber(0)
+    , m_markerCount(0)
+{
+    assert(m_markersPerFrame > 0 && "Too few timestamp queries for the number of frames.");
+    assert(m_historyLength > 0 && "History must hold at least one timing.");
+    for (auto& frame : m_frames)
+    {
+        frame.names.resize(m_markersPerFrame);
+    }
+}
+
+bool GpuProfiler::BeginFrame(uint64_t completedFenceValue)
+{
+    // Frames complete in order, so stop at the first one still in flight
+    while (!m_pendingFrames.empty() && m_frames[m_pendingFrames.front()].fenceValue <= completedFenceValue)
+    {
+        auto index = m_pendingFrames.front();
+        ReadFrame(m_frames[index], index * m_markersPerFrame * 2);
+        m_pendingFrames.pop();
+    }
+
+    // The region this frame would use is still in flight when more frames are queued than there are regions
+    m_timing = m_pendingFrames.size() < m_frames.size();
+    if (m_timing)
+    {
+        m_frameIndex = (m_pendingFrames.empty() ? m_frameIndex : (m_pendingFrames.back() + 1)) % m_frames.size();
+    }
+    m_markerCount.store(0, std::memory_order_relaxed);
+    return m_timing;
+}
+
+uint32_t GpuProfiler::BeginMarker(ID3D12GraphicsCommandList* commandList, const std::string& name)
+{
+    if (!m_timing)
+    {
+        return InvalidIndex;
+    }
+    uint32_t marker = m_markerCount.fetch_add(1, std::memory_order_relaxed);
+    if (marker >= m_markersPerFrame)
+    {
+        return InvalidIndex;
+    }
+    // The marker is this thread's alone, and the name is only read once the frame has been submitted
+    m_frames[m_frameIndex].names[marker] = name;
+    m_backend.WriteTimestamp(commandList, (m_frameIndex * m_markersPerFrame + marker) * 2);
+    return marker;
+}
+
+void GpuProfiler::EndMarker(ID3D12GraphicsCommandList* commandList, uint32_t marker)
+{
+    if (marker == InvalidIndex)
+    {
+        return;
+    }
+    m_backend.WriteTimestamp(commandList, (m_frameIndex * m_markersPerFrame + marker) * 2 + 1);
+}
+
+void GpuProfiler::ResolveFrame(ID3D12GraphicsCommandList* commandList)
+{
+    if (!m_timing)
+    {
+        return;
+    }
+    // Markers that ran out of slots were never given one
+    uint32_t markerCount = std::min(m_markerCount.load(std::memory_order_relaxed), m_markersPerFrame);
+    if (markerCount)
+    {
+        m_backend.Resolve(commandList, m_frameIndex * m_markersPerFrame * 2, markerCount * 2);
+    }
+}
+
+void GpuProfiler::EndFrame(uint64_t fenceValue)
+{
+    if (m_timing)
+    {
+        auto& frame = m_frames[m_frameIndex];
+        frame.fenceValue = fenceValue;
+        frame.frameNumber = m_frameNumber;
+        frame.markerCount = std::min(m_markerCount.load(std::memory_order_relaxed), m_markersPerFrame);
+        m_pendingFrames.push(m_frameIndex);
+        m_timing = false;
+    }
+    m_frameNumber++;
+}
+
+void GpuProfiler::ReadFrame(Frame& frame, uint32_t firstQuery)
+{
+    if (frame.markerCount == 0)
+    {
+        return;
+    }
+    std::vector<uint64_t> timestamps(frame.markerCount * 2);
+    m_backend.Read(firstQuery, frame.markerCount * 2, timestamps.data());
+
+    double millisecondsPerTick = 1000.0 / double(m_backend.GetFrequency());
+    for (uint32_t marker = 0; marker < frame.markerCount; marker++)
+    {
+        uint64_t begin = timestamps[marker * 2];
+        uint64_t end = timestamps[marker * 2 + 1];
+        // A pass split across queues, or a clock reset by a power state change, can end up with an end before its begin
+        float milliseconds = end > begin ? float(double(end - begin) * millisecondsPerTick) : 0.0f;
+        AddTiming(frame.names[marker], milliseconds, frame.frameNumber);
+    }
+}
+
+void GpuProfiler::AddTiming(const std::string& name, float milliseconds, uint64_t frameNumber)
+{
+    auto found = m_historyIndices.find(name);
+    if (found == m_historyIndices.end())
+    {
+        found = m_historyIndices.emplace(name, static_cast<uint32_t>(m_histories.size())).first;
+        m_histories.push_back(MarkerHistory{ name, std::vector<float>(m_historyLength, 0.0f) });
+    }
+    auto& history = m_histories[found->second];
+    history.milliseconds[history.head] = milliseconds;
+    history.head = (history.head + 1) % m_historyLength;
+    history.count = std::min(history.count + 1, m_historyLength);
+    history.lastFrame = frameNumber;
+}
+
+std::string GpuProfiler::ToJson() const
+{
+    std::ostringstream json;
+    json << "[\n";
+    for (size_t i = 0; i < m_histories.size(); i++)
+    {
+        const MarkerHistory& history = m_histories[i];
+        // Portals are named after scene objects, which can be renamed in the editor
+        json << "  {\n"
+            << "    \"name\": \"" << EscapeJson(history.name) << "\",\n"
+            << "    \"lastFrame\": " << history.lastFrame << ",\n"
+            << "    \"averageMilliseconds\": " << history.GetAverage() << ",\n"
+            << "    \"maxMilliseconds\": " << history.GetMax() << ",\n"
+            << "    \"milliseconds\": [";
+        // Oldest first, the ring only starts at head once it's full
+        uint32_t start = history.count < m_historyLength ? 0 : history.head;
+        for (uint32_t sample = 0; sample < history.count; sample++)
+        {
+            json << (sample ? ", " : "") << history.milliseconds[(start + sample) % m_historyLength];
+        }
+        json << "]\n  }" << (i + 1 < m_histories.size() ? "," : "") << "\n";
+    }
+    json << "]\n";
+    return json.str();
+}
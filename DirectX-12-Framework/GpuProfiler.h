@@ -0,0 +1,143 @@
+#pragma once
+#include "TimestampBackend.h"
+#include <atomic>
+#include <queue>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+/**
+* Times passes on the GPU with a pair of timestamps around each, and keeps a history of every pass's recent timings.
+* The backend's slots are split into one region per frame that can be in flight, each resolved by the frame's last command list
+* and read back once the frame's fence shows the GPU is done with it, so reading timings never stalls the GPU.
+* Owns no D3D12 objects, with a NullTimestampBackend the resolve and aggregation run without a device.
+*/
+class GpuProfiler
+{
+public:
+	static const uint32_t InvalidIndex = UINT32_MAX;
+
+	/**
+	* The most recent timings of every marker with one name, oldest first from head.
+	*/
+	struct MarkerHistory
+	{
+		std::string name;
+		/** Ring of timings in milliseconds, head is where the next will be written */
+		std::vector<float> milliseconds;
+		uint32_t head = 0;
+		uint32_t count = 0;
+		/** The frame the latest timing was from */
+		uint64_t lastFrame = 0;
+
+		float GetLatest() const;
+		float GetAverage() const;
+		float GetMax() const;
+	};
+
+	/**
+	* Times everything recorded into a command list between its construction and destruction.
+	*/
+	class Scope
+	{
+	public:
+		Scope(GpuProfiler& profiler, ID3D12GraphicsCommandList* commandList, const std::string& name)
+			: m_profiler(profiler)
+			, m_commandList(commandList)
+			, m_marker(profiler.BeginMarker(commandList, name))
+		{
+		}
+		~Scope()
+		{
+			m_profiler.EndMarker(m_commandList, m_marker);
+		}
+		Scope(const Scope&) = delete;
+		Scope& operator=(const Scope&) = delete;
+
+	private:
+		GpuProfiler& m_profiler;
+		ID3D12GraphicsCommandList* m_commandList;
+		uint32_t m_marker;
+	};
+
+	/**
+	* @param backend Where timestamps are written and read back, its slots are split evenly between the frames
+	* @param frameCount The most frames that can be in flight at once
+	* @param historyLength How many timings of each marker to keep
+	*/
+	GpuProfiler(TimestampBackend& backend, uint32_t frameCount, uint32_t historyLength);
+
+	/**
+	* Read back the timings of every frame the GPU has finished, and start recording a new one.
+	* If the new frame's region is still in flight, the frame goes untimed rather than waiting for it.
+	* @param completedFenceValue The value the frame fence has currently reached
+	* @returns true if this frame's markers will be timed
+	*/
+	bool BeginFrame(uint64_t completedFenceValue);
+	/**
+	* Start timing a pass. Safe to call from several recording threads at once.
+	* @param name Timings of markers with the same name are gathered into one history
+	* @returns The marker, for EndMarker(), or InvalidIndex if the frame isn't being timed or has run out of slots
+	*/
+	uint32_t BeginMarker(ID3D12GraphicsCommandList* commandList, const std::string& name);
+	/**
+	* Stop timing a pass. Must be recorded into a list executed no earlier than the BeginMarker() list.
+	*/
+	void EndMarker(ID3D12GraphicsCommandList* commandList, uint32_t marker);
+	/**
+	* Record resolving the frame's timestamps, into a list executed after every list the frame's markers were recorded into.
+	*/
+	void ResolveFrame(ID3D12GraphicsCommandList* commandList);
+	/**
+	* Close the frame.
+	* @param fenceValue The fence value signalled after the frame's resolve, after which its timestamps can be read
+	*/
+	void EndFrame(uint64_t fenceValue);
+
+	/**
+	* @returns Every marker's history, in the order each name was first seen
+	*/
+	const std::vector<MarkerHistory>& GetHistories() const
+	{
+		return m_histories;
+	}
+	/**
+	* @returns Every marker's history as JSON, timings oldest first
+	*/
+	std::string ToJson() const;
+
+	uint32_t GetMarkersPerFrame() const
+	{
+		return m_markersPerFrame;
+	}
+
+private:
+	struct Frame
+	{
+		uint64_t fenceValue = 0;
+		uint64_t frameNumber = 0;
+		uint32_t markerCount = 0;
+		/** Each marker's name, written by the thread which began it */
+		std::vector<std::string> names;
+	};
+
+	void ReadFrame(Frame& frame, uint32_t firstQuery);
+	void AddTiming(const std::string& name, float milliseconds, uint64_t frameNumber);
+
+	TimestampBackend& m_backend;
+	const uint32_t m_markersPerFrame;
+	const uint32_t m_historyLength;
+
+	std::vector<Frame> m_frames;
+	/** Closed frames still waiting on the GPU, in the order they were submitted */
+	std::queue<uint32_t> m_pendingFrames;
+	/** The frame being recorded, and whether it's being timed */
+	uint32_t m_frameIndex;
+	bool m_timing;
+	uint64_t m_frameNumber;
+	/** Markers begun in the frame being recorded, handed out to recording threads without a lock */
+	std::atomic<uint32_t> m_markerCount;
+
+	std::vector<MarkerHistory> m_histories;
+	std::unordered_map<std::string, uint32_t> m_historyIndices;
+};
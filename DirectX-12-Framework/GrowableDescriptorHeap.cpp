@@ -0,0 +1,148 @@
+#include "GrowableDescriptorHeap.h"
+#include "DescriptorHeap.h"
+#include <vector>
+#include <chrono>
+
+// Named after its type, as the staging heap of any heap type is one of these, and marked as growable as it's replaced as it grows
+static void SetHeapName(ID3D12DescriptorHeap* descriptorHeap, const D3D12_DESCRIPTOR_HEAP_DESC& desc)
+{
+    std::string name = DescriptorHeap::GetDefaultName(desc) + " (growable)";
+    descriptorHeap->SetName(std::wstring(name.begin(), name.end()).c_str());
+}
+
+GrowableDescriptorHeap::GrowableDescriptorHeap(ID3D12Device* device, D3D12_DESCRIPTOR_HEAP_TYPE type, UINT initialCapacity) :
+    m_device(device),
+    m_type(type),
+    m_descriptorSize(device->GetDescriptorHandleIncrementSize(type)),
+    m_cpuHeapStart(),
+    m_capacity(initialCapacity)
+{
+    D3D12_DESCRIPTOR_HEAP_DESC desc = {};
+    desc.NumDescriptors = m_capacity;
+    desc.Type = m_type;
+    desc.Flags = D3D12_DESCRIPTOR_HEAP_FLAG_NONE;
+    ThrowIfFailed(m_device->CreateDescriptorHeap(&desc, IID_PPV_ARGS(&m_descriptorHeap)), "Couldn't create growable descriptor heap.\n");
+    SetHeapName(m_descriptorHeap.Get(), desc);
+
+    m_cpuHeapStart = m_descriptorHeap->GetCPUDescriptorHandleForHeapStart();
+    m_allocator = std::make_unique<DescriptorAllocator>(m_capacity);
+}
+
+DescriptorHandle GrowableDescriptorHeap::Allocate()
+{
+    // Latency includes waiting for the lock and any growth, as that's what the caller sees
+    auto start = std::chrono::high_resolution_clock::now();
+    std::unique_lock<std::shared_mutex> lock(m_mutex);
+
+    UINT slot = m_allocator->Allocate();
+    if (slot == DescriptorAllocator::InvalidIndex)
+    {
+        Grow();
+        slot = m_allocator->Allocate();
+    }
+
+    DescriptorHandle handle = m_handles.Add(slot);
+    ThrowIfFalse(handle.IsValid(), "Ran out of descriptor handles.\n");
+    m_stats.RecordAllocation(m_handles.GetLiveCount(),
+        std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::high_resolution_clock::now() - start).count());
+    return handle;
+}
+
+void GrowableDescriptorHeap::Free(DescriptorHandle handle, uint64_t fenceValue)
+{
+    m_deferredFrees.Push(handle.value, 1, fenceValue);
+}
+
+void GrowableDescriptorHeap::Retire(uint64_t completedFenceValue)
+{
+    std::unique_lock<std::shared_mutex> lock(m_mutex);
+    m_deferredFrees.Retire(completedFenceValue, [this](const DeferredFreeQueue::Entry& entry)
+        {
+            // Removing the handle before freeing the slot means nothing can resolve to the slot once it's reissued
+            UINT slot = m_handles.Remove(DescriptorHandle{ entry.offset });
+            if (slot != DescriptorHandleTable::InvalidSlot)
+            {
+                m_allocator->Free(slot);
+                m_stats.RecordFree();
+            }
+        });
+}
+
+void GrowableDescriptorHeap::EndFrame(uint64_t fenceValue)
+{
+    m_stats.EndFrame(fenceValue);
+}
+
+DescriptorHeapSnapshot GrowableDescriptorHeap::GetSnapshot(const std::string& name)
+{
+    std::shared_lock<std::shared_mutex> lock(m_mutex);
+    DescriptorHeapSnapshot snapshot;
+    snapshot.name = name;
+    m_stats.Fill(snapshot);
+    snapshot.capacity = m_capacity;
+    snapshot.occupied = m_handles.GetLiveCount();
+    snapshot.freeListLength = m_capacity - m_allocator->GetAllocatedCount();
+    snapshot.pendingFrees = static_cast<uint32_t>(m_deferredFrees.GetPendingCount());
+    // Slots are single descriptors and growing compacts them, so fragmentation stays 0
+    return snapshot;
+}
+
+void GrowableDescriptorHeap::WriteView(DescriptorHandle handle, const std::function<void(D3D12_CPU_DESCRIPTOR_HANDLE)>& writeView)
+{
+    // Shared, so views are written in parallel with each other, but never alongside Grow() copying the heap and releasing it
+    std::shared_lock<std::shared_mutex> lock(m_mutex);
+    UINT slot = m_handles.Resolve(handle);
+    ThrowIfFalse(slot != DescriptorHandleTable::InvalidSlot, "Stale descriptor handle.\n");
+    writeView(CD3DX12_CPU_DESCRIPTOR_HANDLE(m_cpuHeapStart, slot, m_descriptorSize));
+}
+
+void GrowableDescriptorHeap::CopyDescriptors(UINT destinationRangeCount, const D3D12_CPU_DESCRIPTOR_HANDLE* destinationStarts, const UINT* destinationSizes, const DescriptorHandle* sources, UINT sourceCount)
+{
+    std::shared_lock<std::shared_mutex> lock(m_mutex);
+
+    std::vector<D3D12_CPU_DESCRIPTOR_HANDLE> sourceStarts(sourceCount);
+    for (UINT i = 0; i < sourceCount; i++)
+    {
+        UINT slot = m_handles.Resolve(sources[i]);
+        ThrowIfFalse(slot != DescriptorHandleTable::InvalidSlot, "Stale descriptor handle.\n");
+        sourceStarts[i] = CD3DX12_CPU_DESCRIPTOR_HANDLE(m_cpuHeapStart, slot, m_descriptorSize);
+    }
+
+    // Sources are scattered through the heap, so each is its own range of one, which nullptr sizes stands for
+    m_device->CopyDescriptors(destinationRangeCount, destinationStarts, destinationSizes, sourceCount, sourceStarts.data(), nullptr, m_type);
+}
+
+void GrowableDescriptorHeap::Grow()
+{
+    UINT capacity = m_capacity ? m_capacity * 2 : 1;
+
+    D3D12_DESCRIPTOR_HEAP_DESC desc = {};
+    desc.NumDescriptors = capacity;
+    desc.Type = m_type;
+    desc.Flags = D3D12_DESCRIPTOR_HEAP_FLAG_NONE;
+    Microsoft::WRL::ComPtr<ID3D12DescriptorHeap> descriptorHeap;
+    ThrowIfFailed(m_device->CreateDescriptorHeap(&desc, IID_PPV_ARGS(&descriptorHeap)), "Couldn't grow descriptor heap.\n");
+    SetHeapName(descriptorHeap.Get(), desc);
+    D3D12_CPU_DESCRIPTOR_HANDLE cpuHeapStart = descriptorHeap->GetCPUDescriptorHandleForHeapStart();
+
+    // A fresh allocator hands out slots from 0 upwards, so claiming one per live descriptor packs them into the start of the new heap,
+    // compacting away any holes left by frees
+    auto allocator = std::make_unique<DescriptorAllocator>(capacity);
+    std::vector<D3D12_CPU_DESCRIPTOR_HANDLE> sources;
+    sources.reserve(m_handles.GetLiveCount());
+    m_handles.ForEach([&](DescriptorHandle handle, uint32_t slot)
+        {
+            sources.push_back(CD3DX12_CPU_DESCRIPTOR_HANDLE(m_cpuHeapStart, slot, m_descriptorSize));
+            m_handles.Remap(handle, allocator->Allocate());
+        });
+
+    // The live descriptors now occupy one contiguous range of the new heap, so a single destination range covers them.
+    // Neither heap is shader visible, so the old one can be released as soon as the copy returns
+    UINT count = static_cast<UINT>(sources.size());
+    m_device->CopyDescriptors(1, &cpuHeapStart, &count, count, sources.data(), nullptr, m_type);
+
+    m_descriptorHeap = descriptorHeap;
+    m_cpuHeapStart = cpuHeapStart;
+    m_capacity = capacity;
+    m_allocator = std::move(allocator);
+}
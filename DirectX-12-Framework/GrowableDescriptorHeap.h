@@ -0,0 +1,103 @@
+#pragma once
+#include "stdafx.h"
+#include "DescriptorAllocator.h"
+#include "DescriptorHandleTable.h"
+#include "DeferredFreeQueue.h"
+#include "DescriptorHeapStats.h"
+#include <functional>
+#include <shared_mutex>
+
+/**
+* CPU only descriptor heap addressed through stable DescriptorHandles rather than raw CPU handles.
+* When every slot is taken the heap grows, copying the live descriptors packed together into a heap twice the size and remapping their handles,
+* so there's no ceiling on how many descriptors a scene can create.
+* Only for heaps that are never bound, as a shader visible heap can't be swapped out from under recorded command lists.
+*/
+class GrowableDescriptorHeap
+{
+public:
+    /**
+    * @param device The ID3D12Device
+    * @param type The type of descriptors the heap holds
+    * @param initialCapacity The number of descriptors in the heap before it first grows
+    */
+    GrowableDescriptorHeap(ID3D12Device* device, D3D12_DESCRIPTOR_HEAP_TYPE type, UINT initialCapacity);
+
+    /**
+    * Claim a descriptor, growing the heap if it's full. Safe to call from any thread.
+    * @returns A handle to the descriptor, which stays valid until it's freed and retired
+    */
+    DescriptorHandle Allocate();
+    /**
+    * Return a descriptor to the heap once the GPU has finished with it. Safe to call from any thread.
+    * The handle keeps resolving until then, so command lists already recorded can still copy from it.
+    * @param handle The handle from Allocate()
+    * @param fenceValue The fence value signalled after the last command list that could reference the descriptor
+    */
+    void Free(DescriptorHandle handle, uint64_t fenceValue);
+    /**
+    * Reuse every descriptor freed against a fence value the GPU has now reached.
+    * @param completedFenceValue The value the fence has currently reached
+    */
+    void Retire(uint64_t completedFenceValue);
+
+    /**
+    * Create a view into a descriptor. Safe to call from any thread, including while others allocate and grow the heap.
+    * The heap is locked while the view is written, so it can't grow and move the descriptor part way through. Throws if the handle is stale.
+    * @param handle The handle from Allocate()
+    * @param writeView Creates the view at the CPU handle it's passed, which is only valid during the call. Mustn't call back into the heap
+    */
+    void WriteView(DescriptorHandle handle, const std::function<void(D3D12_CPU_DESCRIPTOR_HANDLE)>& writeView);
+    /**
+    * Copy descriptors out of this heap, resolving their handles and copying under the same lock so the heap can't grow in between.
+    * @param destinationRangeCount The number of destination ranges
+    * @param destinationStarts The first descriptor of each destination range
+    * @param destinationSizes The size of each destination range
+    * @param sources Handles of the descriptors to copy, in order, as many as the destination ranges add up to
+    * @param sourceCount The number of source handles
+    */
+    void CopyDescriptors(UINT destinationRangeCount, const D3D12_CPU_DESCRIPTOR_HANDLE* destinationStarts, const UINT* destinationSizes, const DescriptorHandle* sources, UINT sourceCount);
+
+    UINT GetCapacity() const
+    {
+        return m_capacity;
+    }
+
+    /**
+    * Close the frame for the heap's statistics.
+    * @param fenceValue The fence value signalled after the frame's final command list
+    */
+    void EndFrame(uint64_t fenceValue);
+    /**
+    * @param name The name to report the heap's statistics under
+    * @returns The heap's current statistics
+    */
+    DescriptorHeapSnapshot GetSnapshot(const std::string& name);
+
+private:
+    /**
+    * Replace the heap with one twice the size, copying the live descriptors into its start in handle order and remapping their handles.
+    * Requires the exclusive lock.
+    */
+    void Grow();
+
+    ID3D12Device* m_device;
+    const D3D12_DESCRIPTOR_HEAP_TYPE m_type;
+    UINT m_descriptorSize;
+
+    Microsoft::WRL::ComPtr<ID3D12DescriptorHeap> m_descriptorHeap;
+    D3D12_CPU_DESCRIPTOR_HANDLE m_cpuHeapStart;
+    UINT m_capacity;
+
+    /** Slots within the current heap, replaced whenever the heap grows */
+    std::unique_ptr<DescriptorAllocator> m_allocator;
+    /** Where each handle's descriptor currently lives */
+    DescriptorHandleTable m_handles;
+    /** Freed handles waiting on the GPU, the entry's offset holds the handle's value */
+    DeferredFreeQueue m_deferredFrees;
+
+    DescriptorHeapStats m_stats;
+
+    /** Shared to write views into or copy descriptors, exclusive to issue or remove handles and to grow */
+    std::shared_mutex m_mutex;
+};
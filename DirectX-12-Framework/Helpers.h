@@ -21,4 +21,13 @@ inline void ThrowIfFailed(HRESULT hr, const char* errorMessage)
         std::cerr << errorMessage;
         throw std::exception();
     }
+}
+
+inline void ThrowIfFalse(bool condition, const char* errorMessage)
+{
+    if (!condition)
+    {
+        std::cerr << errorMessage;
+        throw std::exception();
+    }
 }
\ No newline at end of file
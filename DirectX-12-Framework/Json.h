@@ -0,0 +1,33 @@
+#pragma once
+#include <cstdio>
+#include <string>
+
+/**
+* Escape a string to be written between quotes in JSON. Names dumped by the profiler and heap statistics can come from the editor, so can hold anything.
+* @param text The string to escape
+* @returns The string with quotes, backslashes and control characters escaped
+*/
+inline std::string EscapeJson(const std::string& text)
+{
+	std::string escaped;
+	escaped.reserve(text.size());
+	for (char c : text)
+	{
+		if (c == '"' || c == '\\')
+		{
+			escaped += '\\';
+			escaped += c;
+		}
+		else if (static_cast<unsigned char>(c) < 0x20)
+		{
+			char code[7];
+			snprintf(code, sizeof(code), "\\u%04x", static_cast<unsigned char>(c));
+			escaped += code;
+		}
+		else
+		{
+			escaped += c;
+		}
+	}
+	return escaped;
+}
@@ -0,0 +1,30 @@
+#include "NullTimestampBackend.h"
+#include <algorithm>
+#include <cassert>
+
+NullTimestampBackend::NullTimestampBackend(uint32_t queryCount, uint64_t frequency, uint64_t ticksPerTimestamp)
+    : m_frequency(frequency)
+    , m_ticksPerTimestamp(ticksPerTimestamp)
+    , m_clock(0)
+    , m_written(queryCount, 0)
+    , m_resolved(queryCount, 0)
+{
+}
+
+void NullTimestampBackend::WriteTimestamp(ID3D12GraphicsCommandList* /*commandList*/, uint32_t query)
+{
+    assert(query < m_written.size() && "Timestamp query out of range.");
+    m_written[query] = m_clock.fetch_add(m_ticksPerTimestamp, std::memory_order_relaxed);
+}
+
+void NullTimestampBackend::Resolve(ID3D12GraphicsCommandList* /*commandList*/, uint32_t firstQuery, uint32_t count)
+{
+    assert(firstQuery + count <= m_written.size() && "Timestamp queries out of range.");
+    std::copy_n(m_written.begin() + firstQuery, count, m_resolved.begin() + firstQuery);
+}
+
+void NullTimestampBackend::Read(uint32_t firstQuery, uint32_t count, uint64_t* timestamps)
+{
+    assert(firstQuery + count <= m_resolved.size() && "Timestamp queries out of range.");
+    std::copy_n(m_resolved.begin() + firstQuery, count, timestamps);
+}
@@ -0,0 +1,49 @@
+#pragma once
+#include "TimestampBackend.h"
+#include <atomic>
+#include <vector>
+
+/**
+* Timestamps from a synthetic clock rather than a GPU. A timestamp reads the clock as the command is recorded, and is resolved straight away.
+* The clock moves on by a fixed step with each timestamp, and by however much Advance() says, so markers get known durations without a device.
+*/
+class NullTimestampBackend : public TimestampBackend
+{
+public:
+	/**
+	* @param queryCount The number of slots
+	* @param frequency Ticks per second of the synthetic clock
+	* @param ticksPerTimestamp How far the clock moves on with each timestamp written
+	*/
+	NullTimestampBackend(uint32_t queryCount, uint64_t frequency = 1000000, uint64_t ticksPerTimestamp = 1);
+
+	void WriteTimestamp(ID3D12GraphicsCommandList* commandList, uint32_t query) override;
+	void Resolve(ID3D12GraphicsCommandList* commandList, uint32_t firstQuery, uint32_t count) override;
+	void Read(uint32_t firstQuery, uint32_t count, uint64_t* timestamps) override;
+
+	uint64_t GetFrequency() const override
+	{
+		return m_frequency;
+	}
+
+	uint32_t GetQueryCount() const override
+	{
+		return static_cast<uint32_t>(m_written.size());
+	}
+
+	/**
+	* Move the clock on, as if the GPU had spent that long on the commands recorded since the last timestamp.
+	*/
+	void Advance(uint64_t ticks)
+	{
+		m_clock.fetch_add(ticks, std::memory_order_relaxed);
+	}
+
+private:
+	const uint64_t m_frequency;
+	const uint64_t m_ticksPerTimestamp;
+	/** Timestamps can be written from several recording threads at once */
+	std::atomic<uint64_t> m_clock;
+	std::vector<uint64_t> m_written;
+	std::vector<uint64_t> m_resolved;
+};
@@ -0,0 +1,114 @@
+#include "PassScheduler.h"
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <utility>
+
+// Defined here as well as declared, as the schedule passes it to fill() by reference
+const uint32_t PassScheduler::InvalidIndex;
+
+uint32_t PassScheduler::AddPass(Queue queue, std::vector<uint32_t> dependencies)
+{
+    assert(queue < Queue::Count && "Pass must run on a real queue.");
+    for ([[maybe_unused]] auto dependency : dependencies)
+    {
+        // Passes are scheduled in the order they're added, so a pass can only read what's already been added
+        assert(dependency < m_passes.size() && "Pass depends on a pass added after it.");
+    }
+    m_passes.push_back(Pass{ queue, std::move(dependencies) });
+    return static_cast<uint32_t>(m_passes.size() - 1);
+}
+
+std::vector<PassScheduler::Submission> PassScheduler::Schedule() const
+{
+    constexpr size_t queueCount = static_cast<size_t>(Queue::Count);
+
+    std::vector<Submission> submissions;
+    // The submission each pass ended up in
+    std::vector<uint32_t> passSubmissions(m_passes.size(), InvalidIndex);
+    // Submission still taking passes on each queue. Closed once another queue waits on it, so the wait doesn't hold back passes added after it
+    std::array<uint32_t, queueCount> open;
+    open.fill(InvalidIndex);
+    // Latest submission on each queue, and the latest submission of each queue that every other queue has waited for.
+    // Queues run their submissions in order, so waiting on one submission covers every earlier one on that queue
+    std::array<uint32_t, queueCount> last;
+    last.fill(InvalidIndex);
+    std::array<std::array<uint32_t, queueCount>, queueCount> waited;
+    for (auto& row : waited)
+    {
+        row.fill(InvalidIndex);
+    }
+
+    auto covered = [](uint32_t waitedSubmission, uint32_t submission)
+    {
+        return waitedSubmission != InvalidIndex && waitedSubmission >= submission;
+    };
+
+    for (uint32_t pass = 0; pass < m_passes.size(); pass++)
+    {
+        auto queue = static_cast<size_t>(m_passes[pass].queue);
+
+        std::vector<Wait> waits;
+        for (auto dependency : m_passes[pass].dependencies)
+        {
+            auto producerQueue = static_cast<size_t>(m_passes[dependency].queue);
+            auto producerSubmission = passSubmissions[dependency];
+            if (producerQueue == queue || covered(waited[queue][producerQueue], producerSubmission))
+            {
+                continue;
+            }
+            // The producer's submission has to signal before this pass can start, so nothing more is added to it
+            if (open[producerQueue] == producerSubmission)
+            {
+                open[producerQueue] = InvalidIndex;
+            }
+            waited[queue][producerQueue] = producerSubmission;
+            // Several dependencies on one queue collapse to a wait on the latest
+            bool merged = false;
+            for (auto& wait : waits)
+            {
+                if (static_cast<size_t>(wait.queue) == producerQueue)
+                {
+                    wait.submission = std::max(wait.submission, producerSubmission);
+                    merged = true;
+                }
+            }
+            if (!merged)
+            {
+                waits.push_back(Wait{ static_cast<Queue>(producerQueue), producerSubmission });
+            }
+        }
+
+        // A wait is made before a submission's lists execute, so a pass with new waits starts a fresh submission rather than holding back those already batched
+        if (open[queue] == InvalidIndex || !waits.empty())
+        {
+            open[queue] = static_cast<uint32_t>(submissions.size());
+            submissions.push_back(Submission{ static_cast<Queue>(queue), {}, std::move(waits) });
+        }
+        submissions[open[queue]].passes.push_back(pass);
+        passSubmissions[pass] = open[queue];
+        last[queue] = open[queue];
+    }
+
+    // Join every other queue back onto the graphics queue, so its last signal retires the whole frame
+    auto graphics = static_cast<size_t>(Queue::Graphics);
+    std::vector<Wait> joins;
+    for (size_t queue = 0; queue < queueCount; queue++)
+    {
+        if (queue != graphics && last[queue] != InvalidIndex && !covered(waited[graphics][queue], last[queue]))
+        {
+            joins.push_back(Wait{ static_cast<Queue>(queue), last[queue] });
+        }
+    }
+    if (!joins.empty())
+    {
+        submissions.push_back(Submission{ Queue::Graphics, {}, std::move(joins) });
+    }
+
+    return submissions;
+}
+
+void PassScheduler::Clear()
+{
+    m_passes.clear();
+}
@@ -0,0 +1,85 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+
+/**
+* Turns a frame's passes, each tagged with the queue it runs on and the earlier passes it reads from, into the submissions to make and the cross-queue waits between them.
+* Passes on the same queue run in the order they were added, so only dependencies across queues need a fence.
+* Consecutive passes on a queue are batched into one submission until a pass needs to wait on another queue, which starts a new one,
+* and a wait already covered by an earlier wait between the same two queues is dropped.
+* Owns no D3D12 objects, so a frame's schedule can be worked out and checked without a device.
+*/
+class PassScheduler
+{
+public:
+	static const uint32_t InvalidIndex = UINT32_MAX;
+
+	enum class Queue : uint8_t
+	{
+		Graphics,
+		Compute,
+		Copy,
+		Count
+	};
+
+	/**
+	* A queue waits GPU-side until another queue has finished one of the submissions before it.
+	*/
+	struct Wait
+	{
+		Queue queue;
+		/** Index of the submission waited for, always lower than that of the submission waiting */
+		uint32_t submission;
+	};
+
+	/**
+	* One ExecuteCommandLists call and the signal after it, preceded by the waits it needs.
+	*/
+	struct Submission
+	{
+		Queue queue;
+		/** Passes in the order they were added, possibly none for the final join */
+		std::vector<uint32_t> passes;
+		std::vector<Wait> waits;
+	};
+
+	/**
+	* Add a pass to the end of the frame.
+	* @param queue The queue the pass is recorded for and runs on
+	* @param dependencies Passes already added whose results this pass reads
+	* @returns The index of the pass, for later passes to depend on
+	*/
+	uint32_t AddPass(Queue queue, std::vector<uint32_t> dependencies = {});
+
+	/**
+	* Work out the frame's submissions. Executing them in order, applying each one's waits before it, honours every dependency.
+	* Finally the graphics queue waits on the last submission of every other queue used, with an empty submission if need be,
+	* so the graphics queue's last signal retires the whole frame.
+	* @returns The submissions in the order they're to be made
+	*/
+	std::vector<Submission> Schedule() const;
+
+	/**
+	* Forget every pass, ready for the next frame.
+	*/
+	void Clear();
+
+	uint32_t GetPassCount() const
+	{
+		return static_cast<uint32_t>(m_passes.size());
+	}
+
+	Queue GetQueue(uint32_t pass) const
+	{
+		return m_passes[pass].queue;
+	}
+
+private:
+	struct Pass
+	{
+		Queue queue;
+		std::vector<uint32_t> dependencies;
+	};
+
+	std::vector<Pass> m_passes;
+};
@@ -0,0 +1,67 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+
+/**
+* One T for every thread that uses it, made on the thread's first call to Get().
+* Only a thread's first Get() locks, after that it finds its own T through a thread local pointer, so recording threads share nothing to reach their state.
+* Owns no D3D12 objects.
+*/
+template <typename T>
+class PerThread
+{
+public:
+	PerThread() :
+		m_id(s_nextId++)
+	{
+	}
+
+	/**
+	* @returns The calling thread's T, which only it may use until ForEach()
+	*/
+	T& Get()
+	{
+		// Remembers the last PerThread the thread used, which is enough as each thread mostly uses one. Ids are never reused, so a destroyed one is never matched
+		thread_local uint64_t cachedId = 0;
+		thread_local T* cached = nullptr;
+		if (cachedId == m_id)
+		{
+			return *cached;
+		}
+
+		std::lock_guard<std::mutex> lock(m_mutex);
+		auto& value = m_values[std::this_thread::get_id()];
+		if (!value)
+		{
+			value = std::make_unique<T>();
+		}
+		cachedId = m_id;
+		cached = value.get();
+		return *value;
+	}
+
+	/**
+	* Visit every thread's T, e.g. to merge what they recorded. No other thread may be using its T at the same time.
+	*/
+	template <typename Function>
+	void ForEach(Function function)
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		for (auto& value : m_values)
+		{
+			function(*value.second);
+		}
+	}
+
+private:
+	inline static std::atomic<uint64_t> s_nextId{ 1 };
+	const uint64_t m_id;
+
+	/** Guards the map, never a thread's T */
+	std::mutex m_mutex;
+	std::unordered_map<std::thread::id, std::unique_ptr<T>> m_values;
+};
@@ -11,21 +11,20 @@ Portal::Portal(std::shared_ptr<Primitive> model, std::shared_ptr<RenderTexture>
 	, g_objects(objects)
 	, g_camera(camera)
 {
-	m_camera = std::make_shared<Camera>(m_position, m_forward, XMFLOAT3(0.0f, 1.0f, 0.0f), m_scale.x / m_scale.y);	// Create the camera from the scene objects position
-	SetRotation(m_rotation);	// Update the forward vector according to orientation
+	m_camera = std::make_shared<Camera>(GetPosition(), m_forward, XMFLOAT3(0.0f, 1.0f, 0.0f), GetScale().x / GetScale().y);	// Create the camera from the scene objects position
+	SetRotation(GetRotation());	// Update the forward vector according to orientation
 }
 
-void Portal::DrawTexture(ID3D12GraphicsCommandList* commandList)
+void Portal::UpdateCamera()
 {
-	m_renderTexture->BeginDraw(commandList);
 	if (m_otherPortal)
 	{
 		auto targetRotation = m_otherPortal->GetRotation();
 		auto cameraPos = g_camera->GetPosition();
 
-		auto cameraToThisV = XMLoadFloat3(&m_position) - XMLoadFloat3(&cameraPos);
+		auto cameraToThisV = XMLoadFloat3(&GetPosition()) - XMLoadFloat3(&cameraPos);
 		// Find the difference in rotation between this portal and the target
-		auto qDifferenceRotationV = XMQuaternionRotationRollPitchYawFromVector(XMLoadFloat3(&targetRotation) - XMLoadFloat3(&m_rotation));
+		auto qDifferenceRotationV = XMQuaternionRotationRollPitchYawFromVector(XMLoadFloat3(&targetRotation) - XMLoadFloat3(&GetRotation()));
 		// rotate Camera->This to put it in respect to This' forward
 		cameraToThisV = XMVector3Rotate(cameraToThisV, qDifferenceRotationV);
 
@@ -33,13 +32,22 @@ void Portal::DrawTexture(ID3D12GraphicsCommandList* commandList)
 		XMStoreFloat3(&targetDirection, cameraToThisV);
 
 		m_otherPortal->m_camera->SetDirection(targetDirection);
+	}
+}
 
+void Portal::DrawTexture(ID3D12GraphicsCommandList* commandList, const ConstantBufferArena& constantArena)
+{
+	m_renderTexture->BeginDraw(commandList);
+	if (m_otherPortal)
+	{
+		// The objects' world matrices are shared with every other pass, only the view is this pass's own
+		auto constants = constantArena.UpdateView(m_otherPortal->GetViewProjection());
+		constants.Set(commandList);
 		for (auto object : g_objects)
 		{
 			if (object->GetName() != m_name)
 			{
-				object->UpdateConstantBuffer(m_otherPortal->GetView(), m_otherPortal->GetProj());
-				object->Draw(commandList);
+				object->Draw(commandList, constants);
 			}
 		}
 	}
@@ -81,3 +89,8 @@ const DirectX::XMMATRIX Portal::GetProj()
 {
 	return m_camera->GetProj();
 }
+
+const DirectX::XMMATRIX Portal::GetViewProjection()
+{
+	return m_camera->GetViewProjection();
+}
@@ -24,7 +24,16 @@ public:
 		return m_otherPortal;
 	}
 	
-	void DrawTexture(ID3D12GraphicsCommandList* commandList);
+	/**
+	* Aim the other portal's camera, which DrawTexture() renders from, according to the player camera.
+	* Done for every portal before any pass is recorded, as passes are recorded in parallel and read each other's cameras.
+	*/
+	void UpdateCamera();
+	/**
+	* Record the pass drawing the scene into the render texture. Only reads shared state, so passes can be recorded on several threads at once.
+	* @param constantArena Every object's constants, shared by every pass, which the pass writes its own view's constants alongside
+	*/
+	void DrawTexture(ID3D12GraphicsCommandList* commandList, const ConstantBufferArena& constantArena);
 
 	virtual void SetPosition(const DirectX::XMFLOAT3& position) override;
 	virtual void SetRotation(const DirectX::XMFLOAT3& rotation) override;
@@ -32,6 +41,7 @@ public:
 
 	const DirectX::XMMATRIX GetView();
 	const DirectX::XMMATRIX GetProj();
+	const DirectX::XMMATRIX GetViewProjection();
 protected:
 
 	/** 
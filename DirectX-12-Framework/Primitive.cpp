@@ -3,25 +3,47 @@
 Primitive::Primitive(std::string name) :
 m_indexBufferView(),
 m_vertexBufferView(),
+m_uploadFenceValue(0),
 m_name(name)
 {
 }
 
-bool Primitive::Initialize(ID3D12Device* device, ID3D12GraphicsCommandList* commandList, ID3D12PipelineState* pipelineState, ID3D12RootSignature* rootSignature, const wchar_t* path)
+bool Primitive::Initialize(ID3D12Device* device, ID3D12GraphicsCommandList* commandList, ID3D12PipelineState* pipelineState, ID3D12PipelineState* bindlessPipelineState, ID3D12RootSignature* rootSignature, const wchar_t* path)
 {
     if (LoadModel(path))
     {
         CreateVertexBuffer(device, commandList);
         CreateIndexBuffer(device, commandList);
-        CreateBundle(device, pipelineState, rootSignature);
+        // Create bundle allocator, shared by both bundles
+        ThrowIfFailed(device->CreateCommandAllocator(D3D12_COMMAND_LIST_TYPE_BUNDLE, IID_PPV_ARGS(&m_bundleAllocator)), "Couldn't create command bundle.\n");
+        CreateBundle(device, pipelineState, rootSignature, m_bundle);
+        CreateBundle(device, bindlessPipelineState, rootSignature, m_bindlessBundle);
+        m_bindlessPipelineState = bindlessPipelineState;
+        m_rootSignature = rootSignature;
         return true;
     }
     return false;
 }
 
-void Primitive::Draw(ID3D12GraphicsCommandList* commandList)
+void Primitive::Draw(ID3D12GraphicsCommandList* commandList, bool bindless)
 {
-    commandList->ExecuteBundle(m_bundle.Get());
+    commandList->ExecuteBundle(bindless ? m_bindlessBundle.Get() : m_bundle.Get());
+}
+
+void Primitive::RecordDraw(ID3D12GraphicsCommandList* bundle)
+{
+    bundle->IASetPrimitiveTopology(D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
+    bundle->IASetVertexBuffers(0, 1, &m_vertexBufferView);
+    bundle->IASetIndexBuffer(&m_indexBufferView);
+    bundle->DrawIndexedInstanced(m_indicesCount, 1, 0, 0, 0);
+}
+
+std::vector<Microsoft::WRL::ComPtr<ID3D12Resource>> Primitive::TakeUploadHeaps()
+{
+    std::vector<Microsoft::WRL::ComPtr<ID3D12Resource>> uploadHeaps;
+    uploadHeaps.push_back(std::move(m_vbUploadHeap));
+    uploadHeaps.push_back(std::move(m_ibUploadHeap));
+    return uploadHeaps;
 }
 
 bool Primitive::LoadModel(const wchar_t* path)
@@ -154,7 +176,7 @@ void Primitive::CreateVertexBuffer(ID3D12Device* device, ID3D12GraphicsCommandLi
             &heapProps, // Default heap
             D3D12_HEAP_FLAG_NONE,
             &bufferDesc,
-            D3D12_RESOURCE_STATE_COPY_DEST, // Create this as a copy destination for the upload heap, it is the vertex buffers final resting place.
+            D3D12_RESOURCE_STATE_COMMON, // Buffers are copied to on the copy queue straight from COMMON, and promoted to the VB state implicitly on first use by the direct queue
             nullptr,    // Only need optimized clear value for RTV/DSV
             IID_PPV_ARGS(&m_vertexBuffer)   // GUID of vertex buffer interface
         ), "Failed to create vertex buffer.\n");
@@ -201,17 +223,8 @@ void Primitive::CreateVertexBuffer(ID3D12Device* device, ID3D12GraphicsCommandLi
         &vertexData // Vertices to copy to GPU
     );
 
-    // Once the vertex data has been copied to the VB, transition it to the VB state from the copy destination state, as it needn't be copied to any longer
-    {
-        // Create a transition barrier to transition the VB from copy destination to VB state
-        CD3DX12_RESOURCE_BARRIER transitionBarrier = CD3DX12_RESOURCE_BARRIER::Transition(
-            m_vertexBuffer.Get(),   // Resource to transtition
-            D3D12_RESOURCE_STATE_COPY_DEST, // Resource's starting state, as copy dest for the upload heap
-            D3D12_RESOURCE_STATE_VERTEX_AND_CONSTANT_BUFFER // VB state to transition to
-        );
-        // Queue the aforementioned transition in the command list
-        commandList->ResourceBarrier(1, &transitionBarrier);
-    }
+    // No transition to the VB state here, a copy command list can't transition to it.
+    // The buffer decays back to COMMON once the copy queue is done with it, and is promoted when it's first drawn
 
     // create vertex buffer view, used to tell input assembler where vertices are stored in GPU memory
     {
@@ -238,7 +251,7 @@ void Primitive::CreateIndexBuffer(ID3D12Device* device, ID3D12GraphicsCommandLis
             &heapProps, // Default heap
             D3D12_HEAP_FLAG_NONE,
             &bufferDesc,
-            D3D12_RESOURCE_STATE_COPY_DEST, // Create this as a copy destination for the upload heap, it is the index buffers final resting place.
+            D3D12_RESOURCE_STATE_COMMON, // Buffers are copied to on the copy queue straight from COMMON, and promoted to the IB state implicitly on first use by the direct queue
             nullptr,    // Only need optimized clear value for RTV/DSV
             IID_PPV_ARGS(&m_indexBuffer)   // GUID of index buffer interface
         ), "Failed to create index buffer.\n");
@@ -285,17 +298,7 @@ void Primitive::CreateIndexBuffer(ID3D12Device* device, ID3D12GraphicsCommandLis
         &indexData // Indices to copy to GPU
     );
 
-    // Once the index data has been copied to the IB, transition it to the IB state from the copy destination state, as it needn't be copied to any longer
-    {
-        // Create a transition barrier to transition the IB from copy destination to IB state
-        CD3DX12_RESOURCE_BARRIER transitionBarrier = CD3DX12_RESOURCE_BARRIER::Transition(
-            m_indexBuffer.Get(),   // Resource to transtition
-            D3D12_RESOURCE_STATE_COPY_DEST, // Resource's starting state, as copy dest for the upload heap
-            D3D12_RESOURCE_STATE_INDEX_BUFFER // IB state to transition to
-        );
-        // Queue the aforementioned transition in the command list
-        commandList->ResourceBarrier(1, &transitionBarrier);
-    }
+    // As with the VB, the IB is promoted from COMMON when it's first drawn rather than transitioned on the copy list
 
     // create index buffer view, used to tell input assembler where indices are stored in GPU memory
     {
@@ -305,22 +308,16 @@ void Primitive::CreateIndexBuffer(ID3D12Device* device, ID3D12GraphicsCommandLis
     }
 }
 
-void Primitive::CreateBundle(ID3D12Device* device, ID3D12PipelineState* pipelineState, ID3D12RootSignature* rootSignature)
+void Primitive::CreateBundle(ID3D12Device* device, ID3D12PipelineState* pipelineState, ID3D12RootSignature* rootSignature, Microsoft::WRL::ComPtr<ID3D12GraphicsCommandList>& bundle)
 {
-    // Create bundle allocator
-    ThrowIfFailed(device->CreateCommandAllocator(D3D12_COMMAND_LIST_TYPE_BUNDLE, IID_PPV_ARGS(&m_bundleAllocator)), "Couldn't create command bundle.\n");
-
     // Create the bundle for drawing this model
-    ThrowIfFailed(device->CreateCommandList(0, D3D12_COMMAND_LIST_TYPE_BUNDLE, m_bundleAllocator.Get(), pipelineState, IID_PPV_ARGS(&m_bundle)));
+    ThrowIfFailed(device->CreateCommandList(0, D3D12_COMMAND_LIST_TYPE_BUNDLE, m_bundleAllocator.Get(), pipelineState, IID_PPV_ARGS(&bundle)));
 
     // Populate the bundle with what is necessary to draw this model
-    m_bundle->SetGraphicsRootSignature(rootSignature);
-    m_bundle->IASetPrimitiveTopology(D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
-    m_bundle->IASetVertexBuffers(0, 1, &m_vertexBufferView);
-    m_bundle->IASetIndexBuffer(&m_indexBufferView);
-    m_bundle->DrawIndexedInstanced(m_indicesCount, 1, 0, 0, 0);
+    bundle->SetGraphicsRootSignature(rootSignature);
+    RecordDraw(bundle.Get());
 
     // Cease recording of this bundle
-    ThrowIfFailed(m_bundle->Close());
+    ThrowIfFailed(bundle->Close());
 
 }
@@ -6,18 +6,52 @@ class Primitive
 {
 public:
 	Primitive(std::string name);
-	bool Initialize(ID3D12Device* device, ID3D12GraphicsCommandList* commandList, ID3D12PipelineState* pipelineState, ID3D12RootSignature* rootSignature, const wchar_t* path);
-	void Draw(ID3D12GraphicsCommandList* commandList);
+	bool Initialize(ID3D12Device* device, ID3D12GraphicsCommandList* commandList, ID3D12PipelineState* pipelineState, ID3D12PipelineState* bindlessPipelineState, ID3D12RootSignature* rootSignature, const wchar_t* path);
+	/**
+	* @param bindless Whether to draw with the pipeline state that reads its texture and constants through bindless indices
+	*/
+	void Draw(ID3D12GraphicsCommandList* commandList, bool bindless);
+	/**
+	* Record setting the vertex and index buffers and drawing them, for bundles that bind more than the model's own bundles do.
+	*/
+	void RecordDraw(ID3D12GraphicsCommandList* bundle);
+
+	/**
+	* @returns The pipeline state and root signature the bindless bundle was recorded with
+	*/
+	ID3D12PipelineState* GetBindlessPipelineState() const
+	{
+		return m_bindlessPipelineState.Get();
+	}
+	ID3D12RootSignature* GetRootSignature() const
+	{
+		return m_rootSignature.Get();
+	}
 
 	std::string GetName()
 	{
 		return m_name;
 	}
+	/**
+	* @returns Copy queue fence value the vertex and index buffers are uploaded by
+	*/
+	uint64_t GetUploadFenceValue() const
+	{
+		return m_uploadFenceValue;
+	}
+	void SetUploadFenceValue(uint64_t uploadFenceValue)
+	{
+		m_uploadFenceValue = uploadFenceValue;
+	}
+	/**
+	* Hand over the intermediate buffers the vertex and index buffers are uploaded from, so they can be released once the upload completes
+	*/
+	std::vector<Microsoft::WRL::ComPtr<ID3D12Resource>> TakeUploadHeaps();
 private:
 	bool LoadModel(const wchar_t* path);
 	void CreateVertexBuffer(ID3D12Device* device, ID3D12GraphicsCommandList* commandList);
 	void CreateIndexBuffer(ID3D12Device* device, ID3D12GraphicsCommandList* commandList);
-	void CreateBundle(ID3D12Device* device, ID3D12PipelineState* pipelineState, ID3D12RootSignature* rootSignature);
+	void CreateBundle(ID3D12Device* device, ID3D12PipelineState* pipelineState, ID3D12RootSignature* rootSignature, Microsoft::WRL::ComPtr<ID3D12GraphicsCommandList>& bundle);
 	
 	
 	
@@ -52,6 +86,14 @@ private:
 	* Bundle to hand to the application that encompasses the drawing of this model
 	*/
 	Microsoft::WRL::ComPtr<ID3D12GraphicsCommandList> m_bundle;
+	/**
+	* The same draw, with the bindless pipeline state
+	*/
+	Microsoft::WRL::ComPtr<ID3D12GraphicsCommandList> m_bindlessBundle;
+	Microsoft::WRL::ComPtr<ID3D12PipelineState> m_bindlessPipelineState;
+	Microsoft::WRL::ComPtr<ID3D12RootSignature> m_rootSignature;
+
+	uint64_t m_uploadFenceValue;
 
 	std::string m_name;
 };
@@ -6,8 +6,8 @@ void RenderTexture::Initialize(ID3D12Device* device)
 	// Describe the render texture
 	D3D12_RESOURCE_DESC srvDesc = CD3DX12_RESOURCE_DESC::Tex2D(
 		DXGI_FORMAT_R8G8B8A8_UNORM,  // Use established DS format
-		1280,  // Depth Stencil to encompass the whole screen (ensure to resize it alongside the screen.)
-		720,
+		Width,  // Must match the size of the pooled depth buffer
+		Height,
 		1,  // Array size of 1
 		1,  // MUST NEVER BE 0 OR IT BREAKS
 		1, 0,   // Sample count and quality (no Anti-Aliasing)
@@ -43,7 +43,10 @@ void RenderTexture::Initialize(ID3D12Device* device)
 	// TODO : apply the RTV desc
 	device->CreateRenderTargetView(resource.Get(), nullptr, rtvCpuDescriptorHandle);
 	// Create the shader resource view
-	device->CreateShaderResourceView(resource.Get(), nullptr, cpuDescriptorHandle);
+	WriteView([&](D3D12_CPU_DESCRIPTOR_HANDLE cpuHandle)
+	{
+		device->CreateShaderResourceView(resource.Get(), nullptr, cpuHandle);
+	});
 }
 
 void RenderTexture::BeginDraw(ID3D12GraphicsCommandList* commandList)
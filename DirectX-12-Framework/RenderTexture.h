@@ -4,17 +4,21 @@
 
 struct RenderTexture : public Resource
 {
+	/** Size of every render texture, and of the depth buffer drawn alongside it */
+	static const UINT Width = 1280;
+	static const UINT Height = 720;
+
 	/** 
 	* Create a render texture, a combination Shader Resource View (SRV), Render Target View (RTV), and Depth Stencil View (DSV).
 	* It is intended to be both drawn to (as an RTV) and drawn as an (SRV).
-	* @param srvCpuDescriptorHandle CPU descriptor handle to where this' SRV is to be stored in the SRV heap
-	* @param srvGpuDescriptorHandle GPU descriptor handle to where this' SRV is to be stored in the SRV heap
+	* @param srvDescriptorHandle Handle to where this' SRV is to be stored in the staging heap
 	* @param srvRootParameterIndex the root parameter index for all SRVs, RootParameterIndices::SRV
+	* @param heap The shader visible heap the SRV is copied into when drawn
 	* @param rtvCpuDescriptorHandle CPU descriptor handle to where this' RTV is to be stored in the RTV heap
-	* @param dsvCpuDescriptorHandle CPU descriptor handle to where this' DSV is to be stored in the DSV heap
+	* @param dsvCpuDescriptorHandle CPU descriptor handle to this' own depth buffer's DSV, from the DepthStencilPool
 	*/
-	RenderTexture(const D3D12_CPU_DESCRIPTOR_HANDLE srvCpuDescriptorHandle, const D3D12_GPU_DESCRIPTOR_HANDLE srvGpuDescriptorHandle, const UINT srvRootParameterIndex, const D3D12_CPU_DESCRIPTOR_HANDLE rtvCpuDescriptorHandle, const D3D12_CPU_DESCRIPTOR_HANDLE dsvCpuDescriptorHandle)
-		: Resource(srvCpuDescriptorHandle, srvGpuDescriptorHandle, srvRootParameterIndex)
+	RenderTexture(const DescriptorHandle srvDescriptorHandle, const UINT srvRootParameterIndex, CbvSrvUavHeap* heap, const D3D12_CPU_DESCRIPTOR_HANDLE rtvCpuDescriptorHandle, const D3D12_CPU_DESCRIPTOR_HANDLE dsvCpuDescriptorHandle)
+		: Resource(srvDescriptorHandle, srvRootParameterIndex, heap)
 		, rtvCpuDescriptorHandle(rtvCpuDescriptorHandle)
 		, dsvCpuDescriptorHandle(dsvCpuDescriptorHandle)
 	{}
@@ -26,8 +30,7 @@ struct RenderTexture : public Resource
 	D3D12_CPU_DESCRIPTOR_HANDLE rtvCpuDescriptorHandle;
 	D3D12_CPU_DESCRIPTOR_HANDLE dsvCpuDescriptorHandle;
 	/** 
-	* Creates this' SRV and RTV into the descriptor handles provided.
-	* TODO : Also create DSV as opposed to piggybacking off an existing one.
+	* Creates this' SRV and RTV into the descriptor handles provided. The DSV is already created by the pool it came from.
 	* @param device The ID3D12Device.
 	*/
 	void Initialize(ID3D12Device* device);
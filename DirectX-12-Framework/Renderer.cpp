@@ -5,6 +5,7 @@
 #include "imgui_impl_win32.h"
 #include "misc/cpp/imgui_stdlib.h"
 #include <chrono>
+#include <fstream>
 #include "Camera.h"
 #include "RtvHeap.h"
 #include "Portal.h"
@@ -16,6 +17,7 @@
 #include "ConstantBufferView.h"
 #include "Primitive.h"
 #include "Engine.h"
+#include "TransformStats.h"
 
 using namespace Microsoft::WRL;
 using namespace DirectX;
@@ -25,6 +27,15 @@ using namespace DirectX;
 Renderer::Renderer(std::shared_ptr<Engine>& scene)
 	: m_framebuffers{}
 	, m_frameIndex()
+	, m_defaultSampler(SamplerCache::InvalidIndex)
+	// Two frames in flight lets the CPU record one while the GPU draws the last
+	, m_framePacer(m_frameCount, 2)
+	, m_frameWaitMilliseconds(0.0)
+	// The thread calling Render() records too, so one worker fewer than there are cores
+	, m_workerPool(std::thread::hardware_concurrency() > 1 ? std::thread::hardware_concurrency() - 1 : 0)
+	, m_recordMilliseconds(0.0)
+	, m_scheduledSubmissions(0)
+	, m_scheduledWaits(0)
 	, g_scene(scene)
 {
 
@@ -74,37 +85,179 @@ void Renderer::Render()
 
 	UpdateGUI(g_scene->m_sceneObjects, g_scene->m_selectedObject);
 
-	// Put the command list into an array (of one) for execution on the queue
-	// TODO : Change this to take advantage of CommandQueue
-	if (m_cbvSrvUavHeap->Load(m_commandQueue->GetD3D12CommandQueue()))
-		m_commandQueue->Flush();
+	// Only block if the GPU is more than N frames behind, which also means this frame's copy of the per-frame resources is free
+	{
+		auto start = std::chrono::high_resolution_clock::now();
+		m_commandQueue->WaitForFenceValue(m_framePacer.BeginFrame());
+		m_frameWaitMilliseconds = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+	}
+
+	// Release the transient descriptors and constants of any frames the GPU has finished with, and reuse any descriptors freed before them
+	auto completedFenceValue = m_commandQueue->GetCompletedFenceValue();
+	m_frameConstants->Retire(completedFenceValue);
+	m_cbvSrvUavHeap->Retire(completedFenceValue);
+	m_rtvHeap->Retire(completedFenceValue);
+	m_samplerCache->Retire(completedFenceValue);
+	m_depthStencilPool->Retire(completedFenceValue);
+	// Read back the pass timings of those frames too, into the profiler's history
+	m_gpuProfiler->BeginFrame(completedFenceValue);
+
+	// Kick off any uploads recorded since the last frame on the copy queue, without waiting for them
+	m_cbvSrvUavHeap->Load();
 
 
-	// Record portal commands
-	for (auto portal : g_scene->m_portals)
+	// Each portal aims the camera its other side renders from, so every camera is set before any pass reads one
+	std::vector<std::shared_ptr<Portal>> portals(g_scene->m_portals.begin(), g_scene->m_portals.end());
+	for (auto& portal : portals)
+	{
+		portal->UpdateCamera();
+	}
+	// Likewise every object's world matrix is set, and copied once for every pass to share, before any pass writes its view
+	for (auto& object : g_scene->m_sceneObjects)
+	{
+		object->UpdateConstantBuffer();
+	}
+	m_constantArena->UpdateWorlds();
+
+	// Passes are added in submission order: the compute passes first so they overlap the portal passes on the graphics queue,
+	// then the portal passes, then the main pass which samples the portal textures and reads whatever the compute passes wrote.
+	// The graphics passes run in order on one queue, so only the main pass's dependency on the compute passes needs stating
+	m_passScheduler.Clear();
+	std::vector<uint32_t> computePasses;
+	for (size_t i = 0; i < m_computePasses.size(); i++)
+	{
+		computePasses.push_back(m_passScheduler.AddPass(PassScheduler::Queue::Compute));
+	}
+	for (size_t i = 0; i < portals.size(); i++)
 	{
+		m_passScheduler.AddPass(PassScheduler::Queue::Graphics);
+	}
+	m_passScheduler.AddPass(PassScheduler::Queue::Graphics, computePasses);
+	// Last of all, the pass timings are resolved once every pass has been timed
+	auto resolvePass = m_passScheduler.AddPass(PassScheduler::Queue::Graphics);
+
+#if defined (_GUI)
+	// The GUI's draw data is finalised here, as ImGui's context is only used from this thread. The main pass just records it
+	ImGui::Render();
+#endif
+
+	// Every pass of the frame is recorded in parallel, each into its own command list
+	std::vector<ComPtr<ID3D12GraphicsCommandList>> commandLists(m_passScheduler.GetPassCount());
+	auto recordStart = std::chrono::high_resolution_clock::now();
+	m_workerPool.Run(resolvePass, [&](uint32_t pass)
+	{
+		if (pass < m_computePasses.size())
+		{
+			RecordComputePass(m_computePasses[pass], commandLists[pass]);
+		}
+		else if (pass - m_computePasses.size() < portals.size())
+		{
+			RecordPortalPass(*portals[pass - m_computePasses.size()], commandLists[pass]);
+		}
+		else
+		{
+			RecordMainPass(commandLists[pass]);
+		}
+	});
+	m_recordMilliseconds = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - recordStart).count();
+	// Only now is it known how many markers the passes began
+	commandLists[resolvePass] = m_commandQueue->GetCommandList(nullptr);
+	commandLists[resolvePass]->SetName(L"Profiler Command List");
+	m_gpuProfiler->ResolveFrame(commandLists[resolvePass].Get());
+
+	// Fill in the descriptors every pass bound, then make the scheduled submissions in order, each batching consecutive passes on one queue with one signal.
+	// With no compute passes, that's the portal passes and the main pass in a single batch
+	m_cbvSrvUavHeap->CopyStagedDescriptors();
+	auto submissions = m_passScheduler.Schedule();
+	std::vector<uint64_t> submissionFenceValues(submissions.size());
+	// If the frame draws anything whose upload hasn't been waited for yet, each queue's first submission is held back on the GPU until the copy queue has finished it
+	auto uploadFenceValue = m_cbvSrvUavHeap->TakeUploadWait();
+	std::array<bool, static_cast<size_t>(PassScheduler::Queue::Count)> waitedForUpload = {};
+	uint64_t frameFenceValue = 0;
+	m_scheduledWaits = 0;
+	for (size_t i = 0; i < submissions.size(); i++)
+	{
+		auto& submission = submissions[i];
+		auto queue = GetCommandQueue(submission.queue);
+		auto& waited = waitedForUpload[static_cast<size_t>(submission.queue)];
+		if (uploadFenceValue && !waited && queue != m_copyQueue.get())
+		{
+			queue->Wait(*m_copyQueue, uploadFenceValue);
+			waited = true;
+		}
+		// Waits only ever name earlier submissions, so their fence values are already known
+		for (auto& wait : submission.waits)
 		{
-			auto commandList = m_commandQueue->GetCommandList(m_pipelineState.Get());
-			commandList->SetName(L"Portal Command List");
-			PrepareCommandList(commandList.Get());
-			portal->DrawTexture(commandList.Get());
-			m_commandQueue->ExecuteCommandList(commandList.Get());
+			queue->Wait(*GetCommandQueue(wait.queue), submissionFenceValues[wait.submission]);
 		}
+		m_scheduledWaits += static_cast<uint32_t>(submission.waits.size());
+
+		std::vector<ID3D12GraphicsCommandList*> batch;
+		for (auto pass : submission.passes)
+		{
+			batch.push_back(commandLists[pass].Get());
+		}
+		// The final join onto the graphics queue has no lists of its own, only a signal after its waits
+		submissionFenceValues[i] = batch.empty() ? queue->Signal() : queue->ExecuteCommandLists(batch);
+		// The graphics queue waits on every other queue before its last signal, so that signal covers all of the frame's work
+		if (submission.queue == PassScheduler::Queue::Graphics)
 		{
-			// proceed to the next frame
-			// insert a signal into the queue, to stall the cpu with
-			auto frameFenceValue = m_commandQueue->Signal();
-			// stall the CPU until any writable resources (i.e the back buffer's RTV) are finished being used
-			m_commandQueue->WaitForFenceValue(frameFenceValue);
+			frameFenceValue = submissionFenceValues[i];
 		}
 	}
-	
+	m_scheduledSubmissions = static_cast<uint32_t>(submissions.size());
+
+	// Present the frame
+	ThrowIfFailed(m_swapChain->Present(1, 0), "Failed to present frame.\n");
 
-	// Draw the remainder of the scene once the portal textures have been updated
-	{
 
-		auto commandList = m_commandQueue->GetCommandList(m_pipelineState.Get());
+	// update the index of the back buffer, which may not be sequential
+	m_frameIndex = m_swapChain->GetCurrentBackBufferIndex();
+
+	// proceed to the next frame
+	// the graphics queue's last signal covers all of the frame's work
+	m_commandQueue->EndFrame();
+	m_copyQueue->EndFrame();
+	m_computeQueue->EndFrame();
+	// this frame's transient descriptors can be reused once the GPU has passed this point
+	m_frameConstants->EndFrame(frameFenceValue);
+	m_cbvSrvUavHeap->EndFrame(frameFenceValue);
+	m_rtvHeap->EndFrame(frameFenceValue);
+	m_samplerCache->EndFrame(frameFenceValue);
+	m_depthStencilPool->EndFrame(frameFenceValue);
+	m_gpuProfiler->EndFrame(frameFenceValue);
+	// Rather than waiting for this frame, the next frame waits for the one N frames before it
+	m_framePacer.EndFrame(frameFenceValue);
+	m_constantArena->EndFrame();
+	TransformStats::EndFrame();
+}
+
+void Renderer::RecordComputePass(const ComputePass& pass, ComPtr<ID3D12GraphicsCommandList>& commandList)
+{
+	// Passes set their own pipeline state, as each dispatch is likely to use a different shader
+	commandList = m_computeQueue->GetCommandList(nullptr);
+	commandList->SetName(pass.name.c_str());
+	PrepareComputeCommandList(commandList.Get());
+	pass.record(commandList.Get());
+}
+
+void Renderer::RecordPortalPass(Portal& portal, ComPtr<ID3D12GraphicsCommandList>& commandList)
+{
+	commandList = m_commandQueue->GetCommandList(m_pipelineState.Get());
+	commandList->SetName(L"Portal Command List");
+	PrepareCommandList(commandList.Get());
+	GpuProfiler::Scope profile(*m_gpuProfiler, commandList.Get(), portal.GetName());
+	// Each pass draws with its own constants and depth buffer, so passes needn't be submitted separately
+	portal.DrawTexture(commandList.Get(), *m_constantArena);
+}
+
+void Renderer::RecordMainPass(ComPtr<ID3D12GraphicsCommandList>& commandList)
+{
+	// Draw the remainder of the scene, which is executed once the portal textures have been updated
+	{
+		commandList = m_commandQueue->GetCommandList(m_pipelineState.Get());
 		commandList->SetName(L"Backbuffer Command List");
+		GpuProfiler::Scope profile(*m_gpuProfiler, commandList.Get(), "Main pass");
 		auto backBuffer = m_framebuffers[m_frameIndex].first;
 		auto backBufferCpuDescriptorHandle = m_framebuffers[m_frameIndex].second;
 		PrepareCommandList(commandList.Get());
@@ -129,13 +282,14 @@ void Renderer::Render()
 				0,  // Value to clear the stencil view
 				0, nullptr  // Clear the whole view. Set these to only clear specific rects.
 			);
-			// Update Model View Projection (MVP) Matrix according to camera position
+			// View projection matrix according to camera position, combined with each object's world matrix in the vertex shader
+			auto constants = m_constantArena->UpdateView(g_scene->m_camera->GetViewProjection());
+			constants.Set(commandList.Get());
 
 			// Draw objects, including the portals scene objects.
 			for (auto object : g_scene->m_sceneObjects)
 			{
-				object->UpdateConstantBuffer(g_scene->m_camera->GetView(), g_scene->m_camera->GetProj());
-				object->Draw(commandList.Get());
+				object->Draw(commandList.Get(), constants);
 			}
 
 			RenderGUI(commandList.Get());
@@ -145,28 +299,15 @@ void Renderer::Render()
 			commandList->ResourceBarrier(1, &barrier);
 		}
 
-
-		m_commandQueue->ExecuteCommandList(commandList.Get());
 	}
-
-	// Present the frame
-	ThrowIfFailed(m_swapChain->Present(1, 0), "Failed to present frame.\n");
-
-
-	// update the index of the back buffer, which may not be sequential
-	m_frameIndex = m_swapChain->GetCurrentBackBufferIndex();
-
-	// proceed to the next frame
-	// insert a signal into the queue, to stall the cpu with
-	auto frameFenceValue = m_commandQueue->Signal();
-	// stall the CPU until any writable resources (i.e the back buffer's RTV) are finished being used
-	m_commandQueue->WaitForFenceValue(frameFenceValue);
 }
 
 void Renderer::Destroy()
 {
 	// Wait for the GPU to be done with all resources.
 	m_commandQueue->Flush();
+	m_copyQueue->Flush();
+	m_computeQueue->Flush();
 
 	DestroyGUI();
 }
@@ -214,7 +355,7 @@ void Renderer::Resize(UINT width, UINT height)
 
 std::shared_ptr<Resource> Renderer::CreateTexture(const wchar_t* path, std::string name)
 {
-	return m_cbvSrvUavHeap->CreateShaderResourceView(m_device.Get(), m_pipelineState.Get(), path, name);
+	return m_cbvSrvUavHeap->CreateShaderResourceView(m_device.Get(), path, name);
 }
 
 std::shared_ptr<Resource> Renderer::CreateTexture(std::string name)
@@ -227,34 +368,48 @@ std::shared_ptr<RenderTexture> Renderer::CreateRenderTexture(std::string name)
 	auto texture = CreateTexture(name);
 	D3D12_CPU_DESCRIPTOR_HANDLE rtvHandle;
 	m_rtvHeap->GetFreeHandle(rtvHandle);
-	D3D12_CPU_DESCRIPTOR_HANDLE dsvHandle;
-	// TODO : Acquire a new DSV handle
-	dsvHandle = m_dsvHeap->GetCPUDescriptorHandleForHeapStart();
-	auto renderTexture = std::make_shared<RenderTexture>(texture->cpuDescriptorHandle, texture->gpuDescriptorHandle, texture->rootParameterIndex, rtvHandle, dsvHandle);
+	// Each render texture draws with its own depth buffer, the same size as the texture
+	D3D12_CPU_DESCRIPTOR_HANDLE dsvHandle = m_depthStencilPool->Acquire(RenderTexture::Width, RenderTexture::Height, DXGI_FORMAT_D32_FLOAT);
+	auto renderTexture = std::make_shared<RenderTexture>(*texture, rtvHandle, dsvHandle);
 	renderTexture->Initialize(m_device.Get());
 	return renderTexture;
 }
 
 std::shared_ptr<Primitive> Renderer::CreateModel(const wchar_t* path, std::string name)
 {
-	return m_cbvSrvUavHeap->CreateModel(m_device.Get(), m_pipelineState.Get(), m_rootSignature.Get(), path, name);
+	return m_cbvSrvUavHeap->CreateModel(m_device.Get(), m_pipelineState.Get(), m_bindlessPipelineState.Get(), m_rootSignature.Get(), path, name);
 }
 
 std::shared_ptr<ConstantBufferView> Renderer::CreateConstantBuffer()
 {
-	return m_cbvSrvUavHeap->CreateConstantBufferView(m_device.Get());
+	return m_cbvSrvUavHeap->CreateConstantBufferView(m_constantArena.get());
+}
+
+void Renderer::UnloadResource(DescriptorHandle cbvSrvUavDescriptorHandle)
+{
+	// The descriptor may still be copied from by frames being recorded, so only reuse it after the next signal completes
+	m_cbvSrvUavHeap->FreeStaged(cbvSrvUavDescriptorHandle, m_commandQueue->GetNextFenceValue());
 }
 
-void Renderer::UnloadResource(D3D12_CPU_DESCRIPTOR_HANDLE cbvSrvUavCpuDescriptorHandle, D3D12_GPU_DESCRIPTOR_HANDLE cbvSrvUavGpuDescriptorHandle)
+void Renderer::UnloadResource(DescriptorHandle cbvSrvUavDescriptorHandle, D3D12_CPU_DESCRIPTOR_HANDLE rtvCpuDescriptorHandle, D3D12_CPU_DESCRIPTOR_HANDLE dsvCpuDescriptorHandle)
 {
-	m_cbvSrvUavHeap->Free(cbvSrvUavCpuDescriptorHandle, cbvSrvUavGpuDescriptorHandle);
+	auto fenceValue = m_commandQueue->GetNextFenceValue();
+	m_cbvSrvUavHeap->FreeStaged(cbvSrvUavDescriptorHandle, fenceValue);
+	m_rtvHeap->Free(rtvCpuDescriptorHandle, fenceValue);
+	m_depthStencilPool->Release(dsvCpuDescriptorHandle, fenceValue);
 }
 
-void Renderer::UnloadResource(D3D12_CPU_DESCRIPTOR_HANDLE cbvSrvUavCpuDescriptorHandle, D3D12_GPU_DESCRIPTOR_HANDLE cbvSrvUavGpuDescriptorHandle, D3D12_CPU_DESCRIPTOR_HANDLE rtvCpuDescriptorHandle)
+void Renderer::ReleaseWhenComplete(std::shared_ptr<void> resource)
 {
-	m_cbvSrvUavHeap->Free(cbvSrvUavCpuDescriptorHandle, cbvSrvUavGpuDescriptorHandle);
-	m_rtvHeap->Free(rtvCpuDescriptorHandle);
-	// TODO : Free DSV handle
+	if (!resource)
+	{
+		return;
+	}
+	// Up to the frame latency's worth of frames are in flight, and any of them may have recorded draws with the resource
+	m_commandQueue->OnFenceComplete(m_commandQueue->GetNextFenceValue(), [resource = std::move(resource)]() mutable
+	{
+		resource.reset();
+	});
 }
 
 
@@ -285,8 +440,18 @@ void Renderer::InitializePipeline(HWND hWnd, const UINT width, const UINT height
 	m_device = CreateDevice(hardwareAdapter);
 	//CreateDevice();
 
+	// the thread running fence callbacks, shared by every queue
+	m_fenceCallbacks = std::make_unique<FenceCallbackDispatcher>();
 	// create the direct command queue
-	m_commandQueue = std::make_unique<CommandQueue>(m_device, D3D12_COMMAND_LIST_TYPE_DIRECT);
+	m_commandQueue = std::make_unique<CommandQueue>(m_device, D3D12_COMMAND_LIST_TYPE_DIRECT, *m_fenceCallbacks);
+	// and the copy queue for uploads
+	m_copyQueue = std::make_unique<CommandQueue>(m_device, D3D12_COMMAND_LIST_TYPE_COPY, *m_fenceCallbacks);
+	// and the compute queue for compute passes, which can overlap graphics work
+	m_computeQueue = std::make_unique<CommandQueue>(m_device, D3D12_COMMAND_LIST_TYPE_COMPUTE, *m_fenceCallbacks);
+
+	// Passes are timed on the direct queue, with room for 64 markers in each frame that can be in flight, and the last 240 timings of each kept
+	m_timestampBackend = std::make_unique<D3D12TimestampBackend>(m_device.Get(), m_commandQueue->GetD3D12CommandQueue(), m_frameCount * 64 * 2);
+	m_gpuProfiler = std::make_unique<GpuProfiler>(*m_timestampBackend, m_frameCount, 240);
 
 	m_swapChain = CreateSwapChain(hWnd, m_commandQueue->GetD3D12CommandQueue(), width, height, m_frameCount);
 
@@ -302,15 +467,16 @@ void Renderer::InitializePipeline(HWND hWnd, const UINT width, const UINT height
 			m_dsvHeap->SetName(L"m_dsvHeap");
 		}
 
-		// Describe and create sampler descriptor heap
-		{
-			D3D12_DESCRIPTOR_HEAP_DESC samplerHeapDesc = {};
-			samplerHeapDesc.NumDescriptors = 1;
-			samplerHeapDesc.Type = D3D12_DESCRIPTOR_HEAP_TYPE_SAMPLER;  // Sampler type
-			samplerHeapDesc.Flags = D3D12_DESCRIPTOR_HEAP_FLAG_SHADER_VISIBLE;  // Let the samplers be accessed by shaders
-			ThrowIfFailed(m_device->CreateDescriptorHeap(&samplerHeapDesc, IID_PPV_ARGS(&m_samplerHeap)));
-			m_samplerHeap->SetName(L"m_samplerHeap");
-		}
+		// Room for 4096 draws' constants in every frame that can be in flight, though a busy frame can take more than its share
+		m_frameConstants = std::make_unique<FrameConstantAllocator>(m_device.Get(), UINT64(m_frameCount) * 4096 * D3D12_CONSTANT_BUFFER_DATA_PLACEMENT_ALIGNMENT);
+		// Slots are added 1024 at a time as the scene grows, and the world matrices are copied once a frame for every pass to share
+		m_constantArena = std::make_unique<ConstantBufferArena>(m_frameConstants.get(), 1024);
+
+		// Create the pool of render texture depth buffers
+		m_depthStencilPool = std::make_unique<DepthStencilPool>(m_device.Get(), 64);
+
+		// Create the sampler heap, with room for a handful of distinct samplers before it has to grow
+		m_samplerCache = std::make_unique<SamplerCache>(m_device.Get(), 16);
 
 
 	}
@@ -326,6 +492,7 @@ void Renderer::InitializePipeline(HWND hWnd, const UINT width, const UINT height
 		rtvHeapDesc.Type = D3D12_DESCRIPTOR_HEAP_TYPE_RTV;  //RTV type
 		rtvHeapDesc.Flags = D3D12_DESCRIPTOR_HEAP_FLAG_NONE;    // This heap needs no binding to pipeline
 		m_rtvHeap = std::make_unique<DescriptorHeap>(m_device.Get(), rtvHeapDesc);
+		m_rtvHeap->SetName("RTV");
 	}
 
 	// Create the swapChain
@@ -649,6 +816,7 @@ void Renderer::InitializeAssets(const UINT width, const UINT height)
 
 	// Create empty root signature
 	m_rootSignature = CreateRootSignature();
+	m_computeRootSignature = CreateComputeRootSignature();
 
 	// Load compiled shaders
 	// Load vertex shader from precompiled shader files
@@ -657,9 +825,16 @@ void Renderer::InitializeAssets(const UINT width, const UINT height)
 	// Load pixel shader from precompiled shader files
 	ComPtr<ID3DBlob> pixelShaderBlob;
 	ThrowIfFailed(D3DReadFileToBlob(L"PixelShader.cso", &pixelShaderBlob), "Failed to load pixel shader.\n");
+	// Shaders which index the bindless arrays
+	ComPtr<ID3DBlob> bindlessVertexShaderBlob;
+	ThrowIfFailed(D3DReadFileToBlob(L"BindlessVertexShader.cso", &bindlessVertexShaderBlob), "Failed to load bindless vertex shader.\n");
+	ComPtr<ID3DBlob> bindlessPixelShaderBlob;
+	ThrowIfFailed(D3DReadFileToBlob(L"BindlessPixelShader.cso", &bindlessPixelShaderBlob), "Failed to load bindless pixel shader.\n");
 
 	// Create pipeline state object
 	m_pipelineState = CreatePipelineStateObject(vertexShaderBlob.Get(), pixelShaderBlob.Get());
+	m_bindlessPipelineState = CreatePipelineStateObject(bindlessVertexShaderBlob.Get(), bindlessPixelShaderBlob.Get());
+	m_bindlessPipelineState->SetName(L"m_bindlessPipelineState");
 
 	// Create CBV SRV UAV joint heap
 	{
@@ -669,11 +844,21 @@ void Renderer::InitializeAssets(const UINT width, const UINT height)
 		// This means the descriptor heap needn't be changed in the command list, which is slow and rarely used.
 		// https://learn.microsoft.com/en-us/windows/win32/direct3d12/resource-binding-flow-of-control
 		D3D12_DESCRIPTOR_HEAP_DESC cbvSrvUavHeapDesc = {};
-		cbvSrvUavHeapDesc.NumDescriptors = 1024;
+		cbvSrvUavHeapDesc.NumDescriptors = 2048;
 		cbvSrvUavHeapDesc.Type = D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV;  // SRV type
 		cbvSrvUavHeapDesc.Flags = D3D12_DESCRIPTOR_HEAP_FLAG_SHADER_VISIBLE;  // Allow this heap to be bound to the pipeline
-
-		m_cbvSrvUavHeap = std::make_unique<CbvSrvUavHeap>(m_device.Get(), cbvSrvUavHeapDesc, m_pipelineState.Get());
+		// The second half of the heap holds per-draw descriptors, which only live as long as the frame that draws them
+		UINT transientDescriptors = 1024;
+		// Before that, most of the rest is kept for contiguous tables, i.e. a material's textures and constants bound in one call
+		UINT tableDescriptors = 768;
+		// The bindless region, which shaders index directly, is carved from the table region
+		UINT bindlessDescriptors = 512;
+		// Every SRV and CBV lives in a CPU only staging heap, only those drawn each frame are copied into this one, so the scene can hold far more.
+		// The staging heap starts at this size and doubles whenever it fills
+		UINT stagingDescriptors = 1024;
+
+		m_cbvSrvUavHeap = std::make_unique<CbvSrvUavHeap>(m_device.Get(), cbvSrvUavHeapDesc, transientDescriptors, tableDescriptors, stagingDescriptors, bindlessDescriptors, m_copyQueue.get(), m_commandQueue.get());
+		m_cbvSrvUavHeap->SetName("CBV/SRV/UAV");
 	}
 
 	CreateSampler();
@@ -698,22 +883,16 @@ Microsoft::WRL::ComPtr<ID3D12RootSignature> Renderer::CreateRootSignature()
 
 	// Describe descriptor tables to root signature
 	// Describe range of descriptor heap encompassed by descriptor table
+	// The CBV is a root descriptor, so its range is left empty
 	CD3DX12_DESCRIPTOR_RANGE1 ranges[3] = {};
-	// CBV range
-	ranges[DescriptorHeap::RootParameterIndices::CBV].Init(
-		D3D12_DESCRIPTOR_RANGE_TYPE_CBV,    // type of resources within the range
-		1,  // number of descriptors in the range
-		0,  // base shader register in the range
-		0,  // register space, typically 0
-		D3D12_DESCRIPTOR_RANGE_FLAG_DATA_STATIC // Descriptors and data are static and will not change (as they're loaded textures)
-	);
 	// SRV range
 	ranges[DescriptorHeap::RootParameterIndices::SRV].Init(
 		D3D12_DESCRIPTOR_RANGE_TYPE_SRV,    // type of resources within the range
 		1,  // number of descriptors in the range
 		0,  // base shader register in the range
-		0  // register space, typically 0
+		0,  // register space, typically 0
 		//D3D12_DESCRIPTOR_RANGE_FLAG_DATA_STATIC // Descriptors and data are static and will not change (as they're loaded textures)
+		D3D12_DESCRIPTOR_RANGE_FLAG_DESCRIPTORS_VOLATILE // Copied in from the staging heap after the table is set
 	);
 	// Sampler range
 	ranges[DescriptorHeap::RootParameterIndices::Sampler].Init(
@@ -721,15 +900,26 @@ Microsoft::WRL::ComPtr<ID3D12RootSignature> Renderer::CreateRootSignature()
 		1,  // Just one of them
 		0   // Bound to the base register
 	);
+	// Bindless ranges cover the whole bindless region, in their own register space so they don't overlap the single descriptor tables.
+	// Unbounded arrays need resource binding tier 2, and are indexed uniformly per draw so shader model 5.1 suffices
+	CD3DX12_DESCRIPTOR_RANGE1 bindlessSrvRange;
+	bindlessSrvRange.Init(
+		D3D12_DESCRIPTOR_RANGE_TYPE_SRV,
+		UINT_MAX,   // Unbounded
+		0,  // t0
+		1,  // space1
+		D3D12_DESCRIPTOR_RANGE_FLAG_DESCRIPTORS_VOLATILE    // Copied in from the staging heap as they first become resident
+	);
 
 
 	// Describe layout of descriptor tables to the root signature based on ranges
-	CD3DX12_ROOT_PARAMETER1 rootParameters[3] = {};
-	// CBV root parameters
-	rootParameters[DescriptorHeap::RootParameterIndices::CBV].InitAsDescriptorTable(
-		1,  // number of ranges in this table
-		&ranges[DescriptorHeap::RootParameterIndices::CBV], // Descriptor range specified already 
-		D3D12_SHADER_VISIBILITY_VERTEX   // Specify that the vertex shader can access these textures
+	CD3DX12_ROOT_PARAMETER1 rootParameters[6] = {};
+	// The pass's view constants, bound straight from the frame constants by GPU virtual address so they need no descriptor
+	rootParameters[DescriptorHeap::RootParameterIndices::CBV].InitAsConstantBufferView(
+		0,  // b0
+		0,  // space0
+		D3D12_ROOT_DESCRIPTOR_FLAG_DATA_STATIC_WHILE_SET_AT_EXECUTE,   // Constants are written before the draw is recorded, and never again
+		D3D12_SHADER_VISIBILITY_VERTEX   // Specify that the vertex shader can access these constants
 	);
 	// SRV root parameters
 	rootParameters[DescriptorHeap::RootParameterIndices::SRV].InitAsDescriptorTable(
@@ -743,6 +933,27 @@ Microsoft::WRL::ComPtr<ID3D12RootSignature> Renderer::CreateRootSignature()
 		&ranges[DescriptorHeap::RootParameterIndices::Sampler], // Said descriptor ranges
 		D3D12_SHADER_VISIBILITY_PIXEL   // Only pixel shader need access sampler
 	);
+	// A draw's bindless texture index and object index, set by its bundle or per draw
+	rootParameters[DescriptorHeap::RootParameterIndices::DrawConstants].InitAsConstants(
+		2,  // Texture index, object index
+		1,  // b1
+		0,  // space0
+		D3D12_SHADER_VISIBILITY_ALL // Both shaders read one of them
+	);
+	// The bindless table starts at the bindless region, and is set once per command list
+	rootParameters[DescriptorHeap::RootParameterIndices::BindlessSRV].InitAsDescriptorTable(
+		1,
+		&bindlessSrvRange,
+		D3D12_SHADER_VISIBILITY_PIXEL
+	);
+	// Every object's world matrix as a structured buffer, bound by GPU virtual address like the view constants.
+	// In a register space of its own, so it doesn't overlap either texture range
+	rootParameters[DescriptorHeap::RootParameterIndices::ObjectConstants].InitAsShaderResourceView(
+		0,  // t0
+		2,  // space2
+		D3D12_ROOT_DESCRIPTOR_FLAG_DATA_STATIC_WHILE_SET_AT_EXECUTE,   // Written once a frame before any pass is recorded
+		D3D12_SHADER_VISIBILITY_VERTEX
+	);
 
 
 	// Create root signature descriptor 
@@ -780,6 +991,63 @@ Microsoft::WRL::ComPtr<ID3D12RootSignature> Renderer::CreateRootSignature()
 	return rootSignature;
 }
 
+Microsoft::WRL::ComPtr<ID3D12RootSignature> Renderer::CreateComputeRootSignature()
+{
+	Microsoft::WRL::ComPtr<ID3D12RootSignature> rootSignature;
+
+	D3D12_FEATURE_DATA_ROOT_SIGNATURE featureData = {};
+	featureData.HighestVersion = D3D_ROOT_SIGNATURE_VERSION_1_1;
+	if (FAILED(m_device->CheckFeatureSupport(D3D12_FEATURE_ROOT_SIGNATURE, &featureData, sizeof(featureData))))
+	{
+		featureData.HighestVersion = D3D_ROOT_SIGNATURE_VERSION_1_0;
+	}
+
+	// The same bindless SRV array draws index, so a pass can read any resident texture
+	CD3DX12_DESCRIPTOR_RANGE1 bindlessSrvRange;
+	bindlessSrvRange.Init(
+		D3D12_DESCRIPTOR_RANGE_TYPE_SRV,
+		UINT_MAX,   // Unbounded
+		0,  // t0
+		1,  // space1
+		D3D12_DESCRIPTOR_RANGE_FLAG_DESCRIPTORS_VOLATILE
+	);
+	// The pass's output, a descriptor staged by the pass itself
+	CD3DX12_DESCRIPTOR_RANGE1 uavRange;
+	uavRange.Init(
+		D3D12_DESCRIPTOR_RANGE_TYPE_UAV,
+		1,  // A single output
+		0,  // u0
+		0,  // space0
+		// Copied in from the staging heap after the table is set, and written by the pass
+		D3D12_DESCRIPTOR_RANGE_FLAG_DESCRIPTORS_VOLATILE | D3D12_DESCRIPTOR_RANGE_FLAG_DATA_VOLATILE
+	);
+
+	// Compute root parameters have no shader visibility, the compute shader is the only stage
+	CD3DX12_ROOT_PARAMETER1 rootParameters[3] = {};
+	rootParameters[DescriptorHeap::ComputeRootParameterIndices::ComputeConstants].InitAsConstants(
+		4,  // Enough for a few bindless indices and sizes
+		0,  // b0
+		0   // space0
+	);
+	rootParameters[DescriptorHeap::ComputeRootParameterIndices::ComputeBindlessSRV].InitAsDescriptorTable(1, &bindlessSrvRange);
+	rootParameters[DescriptorHeap::ComputeRootParameterIndices::ComputeUAV].InitAsDescriptorTable(1, &uavRange);
+
+	CD3DX12_VERSIONED_ROOT_SIGNATURE_DESC rootSignatureDesc;
+	rootSignatureDesc.Init_1_1(
+		_countof(rootParameters), rootParameters,
+		0, nullptr, // No samplers, passes load texels directly
+		D3D12_ROOT_SIGNATURE_FLAG_NONE  // No input assembler
+	);
+
+	ComPtr<ID3DBlob> signature;
+	ComPtr<ID3DBlob> error;
+	ThrowIfFailed(D3DX12SerializeVersionedRootSignature(&rootSignatureDesc, featureData.HighestVersion, &signature, &error), "Couldn't serialize compute root signature.\n");
+	ThrowIfFailed(m_device->CreateRootSignature(0, signature->GetBufferPointer(), signature->GetBufferSize(), IID_PPV_ARGS(&rootSignature)), "Failed to create compute root signature.\n");
+	rootSignature->SetName(L"m_computeRootSignature");
+
+	return rootSignature;
+}
+
 void Renderer::CreateSyncObjects()
 {
 	//// Create synchronization objects
@@ -859,7 +1127,45 @@ void Renderer::CreateSampler()
 	samplerDesc.MipLODBias = 0.0f;
 	samplerDesc.MaxAnisotropy = 1;
 	samplerDesc.ComparisonFunc = D3D12_COMPARISON_FUNC_ALWAYS;
-	m_device->CreateSampler(&samplerDesc, m_samplerHeap->GetCPUDescriptorHandleForHeapStart());
+	m_defaultSampler = m_samplerCache->GetSampler(samplerDesc);
+}
+
+UINT Renderer::GetSampler(const D3D12_SAMPLER_DESC& desc)
+{
+	return m_samplerCache->GetSampler(desc);
+}
+
+void Renderer::SetSampler(ID3D12GraphicsCommandList* commandList, UINT sampler)
+{
+	commandList->SetGraphicsRootDescriptorTable(DescriptorHeap::RootParameterIndices::Sampler, m_samplerCache->GetGpuHandle(sampler));
+}
+
+void Renderer::AddComputePass(const std::wstring& name, std::function<void(ID3D12GraphicsCommandList*)> record)
+{
+	m_computePasses.push_back(ComputePass{ name, std::move(record) });
+}
+
+Microsoft::WRL::ComPtr<ID3D12PipelineState> Renderer::CreateComputePipelineState(ID3DBlob* pComputeShaderBlob)
+{
+	Microsoft::WRL::ComPtr<ID3D12PipelineState> pipelineState;
+
+	// A compute pipeline is just the root signature and the shader
+	struct ComputePipelineStateStream
+	{
+		CD3DX12_PIPELINE_STATE_STREAM_ROOT_SIGNATURE pRootSignature;
+		CD3DX12_PIPELINE_STATE_STREAM_CS CS;
+	} pss;
+	pss.pRootSignature = m_computeRootSignature.Get();
+	pss.CS = CD3DX12_SHADER_BYTECODE(pComputeShaderBlob);
+
+	D3D12_PIPELINE_STATE_STREAM_DESC pssDesc = {};
+	pssDesc.SizeInBytes = sizeof(pss);
+	pssDesc.pPipelineStateSubobjectStream = &pss;
+
+	ThrowIfFailed(m_device->CreatePipelineState(&pssDesc, IID_PPV_ARGS(&pipelineState)), "Failed to create compute pipeline state object.\n");
+	pipelineState->SetName(L"Compute pipeline state");
+
+	return pipelineState;
 }
 
 Microsoft::WRL::ComPtr<ID3D12PipelineState> Renderer::CreatePipelineStateObject(ID3DBlob* pVertexShaderBlob, ID3DBlob* pPixelShaderBlob)
@@ -962,12 +1268,15 @@ void Renderer::InitializeGUI(HWND hWnd)
 
 	// Setup Platform/Renderer backends
 	ImGui_ImplWin32_Init(hWnd);
-	auto srv = m_cbvSrvUavHeap->ReserveShaderResourceView("GUI");
+	// ImGui binds its font texture itself, so unlike scene SRVs it takes a permanent descriptor in the shader visible heap
+	D3D12_CPU_DESCRIPTOR_HANDLE fontCpuDescriptorHandle;
+	D3D12_GPU_DESCRIPTOR_HANDLE fontGpuDescriptorHandle;
+	m_cbvSrvUavHeap->GetFreeHandle(fontCpuDescriptorHandle, fontGpuDescriptorHandle);
 	ImGui_ImplDX12_Init(m_device.Get(), m_frameCount, DXGI_FORMAT_R8G8B8A8_UNORM,
 		m_cbvSrvUavHeap->GetDescriptorHeap(),
 		// You'll need to designate a descriptor from your descriptor heap for Dear ImGui to use internally for its font texture's SRV
-		srv->cpuDescriptorHandle,
-		srv->gpuDescriptorHandle
+		fontCpuDescriptorHandle,
+		fontGpuDescriptorHandle
 	);
 #endif
 }
@@ -984,6 +1293,12 @@ void Renderer::UpdateGUI(std::set<std::shared_ptr<SceneObject>>& objects, std::s
 	// Scene Graph
 	ShowSceneGraph(objects, selectedObject);
 
+	// Descriptor heap telemetry
+	ShowDescriptorHeaps();
+
+	ShowFramePacing();
+	ShowGpuTimings();
+
 	// Create properties editor
 	ShowProperties(selectedObject);
 
@@ -1056,6 +1371,151 @@ void Renderer::ShowSceneGraph(std::set<std::shared_ptr<SceneObject>>& objects, s
 	ImGui::End();
 }
 
+void Renderer::ShowDescriptorHeaps()
+{
+	bool open = true;
+	ImGui::SetNextWindowSize(ImVec2(400, 300), ImGuiCond_::ImGuiCond_Once);
+	if (!ImGui::Begin("Descriptor Heaps", &open))
+	{
+		ImGui::End();
+		return;
+	}
+
+	auto snapshots = GetDescriptorHeapSnapshots();
+	for (auto& snapshot : snapshots)
+	{
+		if (ImGui::CollapsingHeader(snapshot.name.c_str(), ImGuiTreeNodeFlags_DefaultOpen))
+		{
+			// Warn as the heap nears exhaustion, as that's when "Descriptor heap is full." is about to be thrown
+			float occupancy = snapshot.capacity ? float(snapshot.occupied) / float(snapshot.capacity) : 0.0f;
+			std::string overlay = std::to_string(snapshot.occupied) + " / " + std::to_string(snapshot.capacity);
+			ImGui::ProgressBar(occupancy, ImVec2(-FLT_MIN, 0), overlay.c_str());
+
+			ImGui::Text("High-water: %u", snapshot.highWater);
+			ImGui::Text("Free list: %u, pending GPU: %u", snapshot.freeListLength, snapshot.pendingFrees);
+			ImGui::Text("Fragmentation: %.2f", snapshot.fragmentation);
+			ImGui::Text("Last frame: %u allocs, %u frees", snapshot.allocationsLastFrame, snapshot.freesLastFrame);
+			ImGui::Text("Total: %llu allocs, %llu frees", snapshot.totalAllocations, snapshot.totalFrees);
+
+			// Buckets double in width, from 1ns up to 2^15ns and beyond
+			float histogram[DescriptorHeapSnapshot::LatencyBuckets];
+			for (size_t i = 0; i < DescriptorHeapSnapshot::LatencyBuckets; i++)
+			{
+				histogram[i] = float(snapshot.latencyHistogram[i]);
+			}
+			std::string label = "##Latency " + snapshot.name;
+			ImGui::PlotHistogram(label.c_str(), histogram, int(DescriptorHeapSnapshot::LatencyBuckets), 0, "alloc latency (log2 ns)", 0.0f, FLT_MAX, ImVec2(-FLT_MIN, 60));
+		}
+	}
+
+	if (ImGui::CollapsingHeader("Binding", ImGuiTreeNodeFlags_DefaultOpen))
+	{
+		// Compare the cost of binding each draw's descriptor tables against passing bindless indices
+		bool bindless = m_cbvSrvUavHeap->IsBindless();
+		if (ImGui::Checkbox("Bindless", &bindless))
+		{
+			m_cbvSrvUavHeap->SetBindless(bindless);
+		}
+		const auto& bindingStats = m_cbvSrvUavHeap->GetBindingStats();
+		ImGui::Text("Last frame: %u draws", bindingStats.draws);
+		ImGui::Text("Descriptor table sets: %u, root constant sets: %u", bindingStats.descriptorTables, bindingStats.rootConstants);
+		const auto& bundleStats = m_cbvSrvUavHeap->GetBundleCache().GetStats();
+		ImGui::Text("Bundled draws: %u, bundles live: %u", bindingStats.bundles, m_cbvSrvUavHeap->GetBundleCache().GetLiveCount());
+		ImGui::Text("Bundles recorded: %llu, reused: %llu, evicted: %llu", bundleStats.recorded, bundleStats.hits, bundleStats.evicted);
+		ImGui::Text("Descriptors copied: %u", m_cbvSrvUavHeap->GetDescriptorsCopied());
+	}
+
+	if (ImGui::Button("Dump to JSON"))
+	{
+		DumpDescriptorHeapStats("DescriptorHeaps.json");
+	}
+
+	ImGui::End();
+}
+
+void Renderer::ShowFramePacing()
+{
+	bool open = true;
+	ImGui::SetNextWindowSize(ImVec2(300, 120), ImGuiCond_::ImGuiCond_Once);
+	if (!ImGui::Begin("Frame Pacing", &open))
+	{
+		ImGui::End();
+		return;
+	}
+
+	// Changing N is safe between any two frames, as there's a copy of the per-frame resources for as many frames as can ever be in flight
+	int framesInFlight = int(m_framePacer.GetFramesInFlight());
+	if (ImGui::SliderInt("Frames in flight", &framesInFlight, 1, int(m_framePacer.GetMaxFramesInFlight())))
+	{
+		m_framePacer.SetFramesInFlight(UINT(framesInFlight));
+	}
+	ImGui::Text("Waited for GPU: %.2f ms", m_frameWaitMilliseconds);
+	ImGui::Text("Recording: %.2f ms on %u threads", m_recordMilliseconds, m_workerPool.GetThreadCount());
+	ImGui::Text("Matrix rebuilds: world %u, view %u, projection %u, view-projection %u", TransformStats::GetLastFrame(TransformStats::World),
+		TransformStats::GetLastFrame(TransformStats::View), TransformStats::GetLastFrame(TransformStats::Projection), TransformStats::GetLastFrame(TransformStats::ViewProjection));
+	ImGui::Text("Frame constants: %llu bytes, %llu / %llu in flight", m_frameConstants->GetFrameUsed(), m_frameConstants->GetUsed(), m_frameConstants->GetCapacity());
+	auto constantWrites = m_constantArena->GetLastFrameStats();
+	ImGui::Text("Constants written: %llu bytes, %u objects, %u views", constantWrites.bytes, constantWrites.objects, constantWrites.views);
+	ImGui::Text("Submissions: %u, command lists: %u", m_commandQueue->GetSubmissionsLastFrame(), m_commandQueue->GetCommandListsLastFrame());
+	ImGui::Text("Upload submissions: %u", m_copyQueue->GetSubmissionsLastFrame());
+	ImGui::Text("Compute submissions: %u, command lists: %u", m_computeQueue->GetSubmissionsLastFrame(), m_computeQueue->GetCommandListsLastFrame());
+	ImGui::Text("Scheduled submissions: %u, cross-queue waits: %u", m_scheduledSubmissions, m_scheduledWaits);
+	auto allocatorStats = m_commandQueue->GetAllocatorStats();
+	ImGui::Text("Command allocators: %u live", m_commandQueue->GetLiveAllocatorCount());
+	ImGui::Text("  created %llu, reused %llu, waited %llu, trimmed %llu", allocatorStats.created, allocatorStats.reused, allocatorStats.waited, allocatorStats.trimmed);
+
+	ImGui::End();
+}
+
+std::vector<DescriptorHeapSnapshot> Renderer::GetDescriptorHeapSnapshots()
+{
+	std::vector<DescriptorHeapSnapshot> snapshots;
+	m_cbvSrvUavHeap->GetSnapshots(snapshots);
+	m_rtvHeap->GetSnapshots(snapshots);
+	snapshots.push_back(m_samplerCache->GetSnapshot("Sampler"));
+	m_depthStencilPool->GetSnapshots(snapshots);
+	return snapshots;
+}
+
+void Renderer::DumpDescriptorHeapStats(const std::string& path)
+{
+	std::ofstream file(path);
+	file << DescriptorHeapStats::ToJson(GetDescriptorHeapSnapshots());
+}
+
+void Renderer::ShowGpuTimings()
+{
+	bool open = true;
+	ImGui::SetNextWindowSize(ImVec2(300, 300), ImGuiCond_::ImGuiCond_Once);
+	if (!ImGui::Begin("GPU Timings", &open))
+	{
+		ImGui::End();
+		return;
+	}
+
+	for (auto& history : m_gpuProfiler->GetHistories())
+	{
+		ImGui::Text("%s: %.3f ms (avg %.3f, max %.3f)", history.name.c_str(), history.GetLatest(), history.GetAverage(), history.GetMax());
+		// The ring is plotted oldest first, which starts at head once it's full
+		int offset = history.count < history.milliseconds.size() ? 0 : int(history.head);
+		std::string label = "##" + history.name;
+		ImGui::PlotLines(label.c_str(), history.milliseconds.data(), int(history.count), offset, nullptr, 0.0f, FLT_MAX, ImVec2(-FLT_MIN, 40));
+	}
+
+	if (ImGui::Button("Dump to JSON"))
+	{
+		DumpGpuTimings("GpuTimings.json");
+	}
+
+	ImGui::End();
+}
+
+void Renderer::DumpGpuTimings(const std::string& path)
+{
+	std::ofstream file(path);
+	file << m_gpuProfiler->ToJson();
+}
+
 void Renderer::ShowProperties(std::shared_ptr<SceneObject>& selectedObject)
 {
 	bool open = true;
@@ -1157,8 +1617,11 @@ void Renderer::ShowProperties(std::shared_ptr<SceneObject>& selectedObject)
 				for (auto model : g_scene->m_models)
 				{
 					const bool is_selected = (selectedObject->GetModel() == model);
-					if (ImGui::Selectable(model->GetName().c_str(), is_selected))
+					if (ImGui::Selectable(model->GetName().c_str(), is_selected) && !is_selected)
+					{
+						ReleaseWhenComplete(selectedObject->GetModel());
 						selectedObject->SetModel(model);
+					}
 
 					// Set the initial focus when opening the combo (scrolling + keyboard navigation focus)
 					if (is_selected)
@@ -1167,8 +1630,11 @@ void Renderer::ShowProperties(std::shared_ptr<SceneObject>& selectedObject)
 				// Add additional "None" option
 				{
 					const bool is_selected = (selectedObject->GetModel() == nullptr);
-					if (ImGui::Selectable("None", is_selected))
+					if (ImGui::Selectable("None", is_selected) && !is_selected)
+					{
+						ReleaseWhenComplete(selectedObject->GetModel());
 						selectedObject->SetModel(nullptr);
+					}
 
 					if (is_selected)
 						ImGui::SetItemDefaultFocus();
@@ -1213,6 +1679,7 @@ void Renderer::ShowProperties(std::shared_ptr<SceneObject>& selectedObject)
 							// If the model was loaded correctly, set it
 							if (model)
 							{
+								ReleaseWhenComplete(selectedObject->GetModel());
 								selectedObject->SetModel(model);
 								pathHint = validPathHint;
 
@@ -1275,8 +1742,11 @@ void Renderer::ShowProperties(std::shared_ptr<SceneObject>& selectedObject)
 					for (auto texture : g_scene->m_textures)
 					{
 						const bool is_selected = (selectedObject->GetTexture() == texture);
-						if (ImGui::Selectable(texture->name.c_str(), is_selected))
+						if (ImGui::Selectable(texture->name.c_str(), is_selected) && !is_selected)
+						{
+							ReleaseWhenComplete(selectedObject->GetTexture());
 							selectedObject->SetTexture(texture);
+						}
 
 						if (is_selected)
 							ImGui::SetItemDefaultFocus();
@@ -1284,8 +1754,11 @@ void Renderer::ShowProperties(std::shared_ptr<SceneObject>& selectedObject)
 					// Add additional "None" option
 					{
 						const bool is_selected = (selectedObject->GetTexture() == nullptr);
-						if (ImGui::Selectable("None", is_selected))
+						if (ImGui::Selectable("None", is_selected) && !is_selected)
+						{
+							ReleaseWhenComplete(selectedObject->GetTexture());
 							selectedObject->SetTexture(nullptr);
+						}
 
 						if (is_selected)
 							ImGui::SetItemDefaultFocus();
@@ -1324,6 +1797,9 @@ void Renderer::ShowProperties(std::shared_ptr<SceneObject>& selectedObject)
 								// If the model was loaded correctly, set it
 								if (texture)
 								{
+									// Kept by the scene, which frees its descriptor when it's unloaded
+									g_scene->m_textures.push_back(texture);
+									ReleaseWhenComplete(selectedObject->GetTexture());
 									selectedObject->SetTexture(texture);
 									pathHint = validPathHint;
 
@@ -1365,11 +1841,8 @@ void Renderer::DestroyGUI()
 void Renderer::RenderGUI(ID3D12GraphicsCommandList* commandList)
 {
 #if defined (_GUI)
-	// render Dear ImGui
-
-	// Rendering
-	// (Your code clears your framebuffer, renders your other stuff etc.)
-	ImGui::Render();
+	// render Dear ImGui, whose draw data Render() already finalised on the main thread
+	GpuProfiler::Scope profile(*m_gpuProfiler, commandList, "GUI");
 	ImGui_ImplDX12_RenderDrawData(ImGui::GetDrawData(), commandList);
 	// (Your code calls ExecuteCommandLists, swapchain's Present(), etc.)
 
@@ -1382,13 +1855,37 @@ void Renderer::PrepareCommandList(ID3D12GraphicsCommandList* commandList)
 	// Set necessary state.
 	commandList->SetGraphicsRootSignature(m_rootSignature.Get());
 	// Set command list shader resource view and constant buffer view
-	ID3D12DescriptorHeap* ppHeaps[] = { m_cbvSrvUavHeap->GetDescriptorHeap(), m_samplerHeap.Get() };
+	ID3D12DescriptorHeap* ppHeaps[] = { m_cbvSrvUavHeap->GetDescriptorHeap(), m_samplerCache->GetDescriptorHeap() };
 	commandList->SetDescriptorHeaps(_countof(ppHeaps), ppHeaps);
 
 	// Describe how samplers are laid out to GPU
-	commandList->SetGraphicsRootDescriptorTable(DescriptorHeap::RootParameterIndices::Sampler, m_samplerHeap->GetGPUDescriptorHandleForHeapStart());
+	SetSampler(commandList, m_defaultSampler);
+	// The bindless array never moves, so whichever binding method draws use, it's set once here
+	commandList->SetGraphicsRootDescriptorTable(DescriptorHeap::RootParameterIndices::BindlessSRV, m_cbvSrvUavHeap->GetBindlessTable());
 
 	commandList->RSSetViewports(1, &m_viewport);
 	commandList->RSSetScissorRects(1, &m_scissorRect);
 }
 
+void Renderer::PrepareComputeCommandList(ID3D12GraphicsCommandList* commandList)
+{
+	commandList->SetComputeRootSignature(m_computeRootSignature.Get());
+	// Compute passes load rather than sample, so only the CBV/SRV/UAV heap is set
+	ID3D12DescriptorHeap* ppHeaps[] = { m_cbvSrvUavHeap->GetDescriptorHeap() };
+	commandList->SetDescriptorHeaps(_countof(ppHeaps), ppHeaps);
+	commandList->SetComputeRootDescriptorTable(DescriptorHeap::ComputeRootParameterIndices::ComputeBindlessSRV, m_cbvSrvUavHeap->GetBindlessTable());
+}
+
+CommandQueue* Renderer::GetCommandQueue(PassScheduler::Queue queue)
+{
+	switch (queue)
+	{
+	case PassScheduler::Queue::Compute:
+		return m_computeQueue.get();
+	case PassScheduler::Queue::Copy:
+		return m_copyQueue.get();
+	default:
+		return m_commandQueue.get();
+	}
+}
+
@@ -1,11 +1,21 @@
 #pragma once
 #include "stdafx.h"
 #include <array>
+#include <functional>
 #include <set>
 
 #include "CommandQueue.h"
 #include "DescriptorHeap.h"
 #include "CbvSrvUavHeap.h"
+#include "SamplerCache.h"
+#include "DepthStencilPool.h"
+#include "FramePacer.h"
+#include "FrameConstantAllocator.h"
+#include "ConstantBufferArena.h"
+#include "WorkerPool.h"
+#include "PassScheduler.h"
+#include "GpuProfiler.h"
+#include "D3D12TimestampBackend.h"
 
 
 class Camera;
@@ -42,13 +52,67 @@ public:
 	std::shared_ptr<RenderTexture> CreateRenderTexture(std::string name);
 	std::shared_ptr<Primitive> CreateModel(const wchar_t* path, std::string name);
 	std::shared_ptr<ConstantBufferView> CreateConstantBuffer();
+	/**
+	* Find or create a sampler, i.e. for a material wanting point, clamp or anisotropic sampling.
+	* Cheap enough to call per draw once the sampler exists.
+	* @param desc The sampler's description
+	* @returns The sampler's index, for SetSampler()
+	*/
+	UINT GetSampler(const D3D12_SAMPLER_DESC& desc);
+	/**
+	* Bind a sampler from GetSampler() to s0, in place of the default.
+	*/
+	void SetSampler(ID3D12GraphicsCommandList* commandList, UINT sampler);
+	/**
+	* Add a pass recorded for the compute queue every frame, i.e. culling or post-processing.
+	* It runs alongside the portal passes on the graphics queue, and the main pass waits for it GPU-side.
+	* @param name The pass's command list's debug name
+	* @param record Records the pass's dispatches, into a list which already has the compute root signature, descriptor heap and bindless table set.
+	* Called from a worker thread
+	*/
+	void AddComputePass(const std::wstring& name, std::function<void(ID3D12GraphicsCommandList*)> record);
+	/**
+	* Create a pipeline state for a compute pass, using the compute root signature.
+	* @param pComputeShaderBlob pointer to memory block containing compute shader
+	* @returns ComPtr to the created PSO
+	*/
+	Microsoft::WRL::ComPtr<ID3D12PipelineState> CreateComputePipelineState(ID3DBlob* pComputeShaderBlob);
 
-	void UnloadResource(D3D12_CPU_DESCRIPTOR_HANDLE cbvSrvUavCpuDescriptorHandle, D3D12_GPU_DESCRIPTOR_HANDLE cbvSrvUavGpuDescriptorHandle);
-	void UnloadResource(D3D12_CPU_DESCRIPTOR_HANDLE cbvSrvUavCpuDescriptorHandle, D3D12_GPU_DESCRIPTOR_HANDLE cbvSrvUavGpuDescriptorHandle, D3D12_CPU_DESCRIPTOR_HANDLE rtvCpuDescriptorHandle);
+	void UnloadResource(DescriptorHandle cbvSrvUavDescriptorHandle);
+	void UnloadResource(DescriptorHandle cbvSrvUavDescriptorHandle, D3D12_CPU_DESCRIPTOR_HANDLE rtvCpuDescriptorHandle, D3D12_CPU_DESCRIPTOR_HANDLE dsvCpuDescriptorHandle);
+	/**
+	* Keep a model or texture alive until every frame recorded so far has completed, as those frames may still draw with it.
+	* Call with whatever is about to be replaced, in case that drops its last reference
+	* @param resource The model or texture, which may be null
+	*/
+	void ReleaseWhenComplete(std::shared_ptr<void> resource);
+
+	/**
+	* @returns Live statistics of every descriptor heap and region
+	*/
+	std::vector<DescriptorHeapSnapshot> GetDescriptorHeapSnapshots();
+	/**
+	* Write the statistics of every descriptor heap to a JSON file.
+	* @param path The file to write to
+	*/
+	void DumpDescriptorHeapStats(const std::string& path);
+	/**
+	* @returns The recent GPU timings of every pass, i.e. each portal, the main pass and the GUI
+	*/
+	const std::vector<GpuProfiler::MarkerHistory>& GetGpuTimings() const
+	{
+		return m_gpuProfiler->GetHistories();
+	}
+	/**
+	* Write the recent GPU timings of every pass to a JSON file.
+	* @param path The file to write to
+	*/
+	void DumpGpuTimings(const std::string& path);
 
 
 private:
-	static const UINT m_frameCount = 2;
+	/** Back buffers in the swap chain, also the most frames that can be in flight so a back buffer is never reused while still queued */
+	static const UINT m_frameCount = 3;
 
 #pragma region Pipeline
 
@@ -64,9 +128,18 @@ private:
 	Microsoft::WRL::ComPtr<ID3D12Resource> m_dsv;
 	Microsoft::WRL::ComPtr<ID3D12RootSignature> m_rootSignature;
 	Microsoft::WRL::ComPtr<ID3D12PipelineState> m_pipelineState;
+	/** Same state as m_pipelineState, with shaders that index the bindless arrays */
+	Microsoft::WRL::ComPtr<ID3D12PipelineState> m_bindlessPipelineState;
+	/** Shared by every compute pass, laid out by DescriptorHeap::ComputeRootParameterIndices */
+	Microsoft::WRL::ComPtr<ID3D12RootSignature> m_computeRootSignature;
 
 	Microsoft::WRL::ComPtr<ID3D12DescriptorHeap> m_dsvHeap;
-	Microsoft::WRL::ComPtr<ID3D12DescriptorHeap> m_samplerHeap;
+	/** Depth buffers for render textures, so they don't share the back buffer's */
+	std::unique_ptr<DepthStencilPool> m_depthStencilPool;
+	/** Every distinct sampler, deduplicated by description */
+	std::unique_ptr<SamplerCache> m_samplerCache;
+	/** The sampler bound by PrepareCommandList() */
+	UINT m_defaultSampler;
 
 
 	bool m_useWarpDevice = false;
@@ -84,6 +157,39 @@ private:
 #pragma region Sync
 
 	std::unique_ptr<CommandQueue> m_commandQueue;
+	/** Textures and models are uploaded on their own queue, which the direct queue only waits on GPU-side for frames that draw them */
+	std::unique_ptr<CommandQueue> m_copyQueue;
+	/** Compute passes run on their own queue, so they can overlap graphics work */
+	std::unique_ptr<CommandQueue> m_computeQueue;
+	/** Runs every queue's fence callbacks on one thread. Declared after the queues so it's destroyed before them, once Destroy() has flushed them */
+	std::unique_ptr<FenceCallbackDispatcher> m_fenceCallbacks;
+	/** How many frames can be queued on the GPU, and which copy of the per-frame resources to use */
+	FramePacer m_framePacer;
+	/** Every frame's constants, in a ring shared by the frames in flight */
+	std::unique_ptr<FrameConstantAllocator> m_frameConstants;
+	/** Every object's world matrix, which each pass turns into a block of constants for its view */
+	std::unique_ptr<ConstantBufferArena> m_constantArena;
+	/** How long the CPU blocked on the GPU before recording the last frame */
+	double m_frameWaitMilliseconds;
+	/** Records each pass of a frame on its own thread, into its own command list */
+	WorkerPool m_workerPool;
+	/** How long recording every pass of the last frame took */
+	double m_recordMilliseconds;
+
+	struct ComputePass
+	{
+		std::wstring name;
+		std::function<void(ID3D12GraphicsCommandList*)> record;
+	};
+	std::vector<ComputePass> m_computePasses;
+	/** Works out which queue each pass is submitted to, and the waits between queues */
+	PassScheduler m_passScheduler;
+	/** Timestamps around each pass on the direct queue, and the timings read back from them */
+	std::unique_ptr<D3D12TimestampBackend> m_timestampBackend;
+	std::unique_ptr<GpuProfiler> m_gpuProfiler;
+	/** Submissions and cross-queue waits made by the last frame */
+	uint32_t m_scheduledSubmissions;
+	uint32_t m_scheduledWaits;
 
 #pragma endregion
 
@@ -148,6 +254,10 @@ private:
 	void InitializeAssets(const UINT width, const UINT height);
 
 	Microsoft::WRL::ComPtr<ID3D12RootSignature> CreateRootSignature();
+	/**
+	* Root signature of compute passes: root constants, the bindless SRV array, and a single UAV table
+	*/
+	Microsoft::WRL::ComPtr<ID3D12RootSignature> CreateComputeRootSignature();
 
 	void CreateSyncObjects();
 
@@ -170,7 +280,22 @@ private:
 	void UpdateGUI(std::set<std::shared_ptr<SceneObject>>& objects, std::shared_ptr<SceneObject>& selectedObject);
 	void ShowSceneGraph(std::set<std::shared_ptr<SceneObject>>& objects, std::shared_ptr<SceneObject>& selectedObject);
 	void ShowProperties(std::shared_ptr<SceneObject>& selectedObject);
+	/**
+	* Show occupancy, churn, fragmentation, and allocation latency of every descriptor heap
+	*/
+	void ShowDescriptorHeaps();
+	/**
+	* Show and change how many frames are queued on the GPU, how long the CPU waited for one to complete, and how the frame was submitted
+	*/
+	void ShowFramePacing();
+	/**
+	* Show each pass's GPU time, and a graph of its recent history
+	*/
+	void ShowGpuTimings();
 	void DestroyGUI();
+	/**
+	* Record the GUI's draw data, which ImGui::Render() must have finalised on the main thread first. Safe to call from a worker
+	*/
 	void RenderGUI(ID3D12GraphicsCommandList* commandList);
 
 
@@ -179,6 +304,26 @@ private:
 #pragma region Rendering
 
 	void PrepareCommandList(ID3D12GraphicsCommandList* commandList);
+	void PrepareComputeCommandList(ID3D12GraphicsCommandList* commandList);
+	/**
+	* @returns The command queue a scheduled pass runs on
+	*/
+	CommandQueue* GetCommandQueue(PassScheduler::Queue queue);
+	/**
+	* Record a compute pass into a command list from the compute queue. Called on worker threads alongside the graphics passes.
+	* @param commandList Out, the command list recorded to
+	*/
+	void RecordComputePass(const ComputePass& pass, Microsoft::WRL::ComPtr<ID3D12GraphicsCommandList>& commandList);
+	/**
+	* Record a portal's pass into a command list of its own. Called on worker threads, one pass each.
+	* @param commandList Out, the command list recorded to
+	*/
+	void RecordPortalPass(Portal& portal, Microsoft::WRL::ComPtr<ID3D12GraphicsCommandList>& commandList);
+	/**
+	* Record the pass drawing the scene and GUI to the back buffer. Called on a worker thread alongside the portal passes.
+	* @param commandList Out, the command list recorded to
+	*/
+	void RecordMainPass(Microsoft::WRL::ComPtr<ID3D12GraphicsCommandList>& commandList);
 	
 #pragma endregion
 };
@@ -1,3 +1,13 @@
 #include "Resource.h"
+#include "CbvSrvUavHeap.h"
 
+void Resource::Set(ID3D12GraphicsCommandList* commandList)
+{
+	// Staged descriptors have no GPU handle of their own, they're given a slot in the shader visible heap for this frame
+	commandList->SetGraphicsRootDescriptorTable(rootParameterIndex, heap->StageDescriptor(descriptorHandle));
+}
 
+void Resource::WriteView(const std::function<void(D3D12_CPU_DESCRIPTOR_HANDLE)>& writeView) const
+{
+	heap->WriteStagingView(descriptorHandle, writeView);
+}
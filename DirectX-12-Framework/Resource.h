@@ -1,25 +1,37 @@
 #pragma once
 #include "stdafx.h"
+#include "DescriptorHandleTable.h"
+#include <functional>
 #include <string>
 
+class CbvSrvUavHeap;
+
 struct Resource
 {
-	const D3D12_CPU_DESCRIPTOR_HANDLE cpuDescriptorHandle;
-	const D3D12_GPU_DESCRIPTOR_HANDLE gpuDescriptorHandle;
+	/** The resource's view in its heap's staging heap, which is copied into the shader visible heap whenever it's set */
+	const DescriptorHandle descriptorHandle;
 	const UINT rootParameterIndex;
 	Microsoft::WRL::ComPtr<ID3D12Resource> resource;
 	std::string name;
+	CbvSrvUavHeap* heap;
+	/** Copy queue fence value the resource's contents are uploaded by, 0 if it's never uploaded */
+	uint64_t uploadFenceValue;
 
-	Resource(const D3D12_CPU_DESCRIPTOR_HANDLE cpuDescriptorHandle, const D3D12_GPU_DESCRIPTOR_HANDLE gpuDescriptorHandle, const UINT rootParameterIndex)
-		: cpuDescriptorHandle(cpuDescriptorHandle)
-		, gpuDescriptorHandle(gpuDescriptorHandle)
+	Resource(const DescriptorHandle descriptorHandle, const UINT rootParameterIndex, CbvSrvUavHeap* heap)
+		: descriptorHandle(descriptorHandle)
 		, rootParameterIndex(rootParameterIndex)
 		, name()
+		, heap(heap)
+		, uploadFenceValue(0)
 	{}
+	virtual ~Resource() = default;
+
+	virtual void Set(ID3D12GraphicsCommandList* commandList);
 
-	void Set(ID3D12GraphicsCommandList* commandList)
-	{
-		commandList->SetGraphicsRootDescriptorTable(rootParameterIndex, gpuDescriptorHandle);
-	}
+	/**
+	* Create the resource's view in the staging heap, which can't grow and move it while it's written.
+	* @param writeView Creates the view at the CPU handle it's passed, which is only valid during the call
+	*/
+	void WriteView(const std::function<void(D3D12_CPU_DESCRIPTOR_HANDLE)>& writeView) const;
 };
 
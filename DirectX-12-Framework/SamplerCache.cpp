@@ -0,0 +1,172 @@
+#include "SamplerCache.h"
+#include "DescriptorHeap.h"
+#include <chrono>
+#include <cstring>
+
+SamplerCache::SamplerCache(ID3D12Device* device, UINT initialCapacity) :
+    m_device(device),
+    m_descriptorSize(device->GetDescriptorHandleIncrementSize(D3D12_DESCRIPTOR_HEAP_TYPE_SAMPLER)),
+    m_state(nullptr),
+    m_table(std::make_unique<std::atomic<uint64_t>[]>(TableSize)),
+    m_descs(std::make_unique<D3D12_SAMPLER_DESC[]>(D3D12_MAX_SHADER_VISIBLE_SAMPLER_HEAP_SIZE)),
+    m_count(0)
+{
+    ThrowIfFalse(initialCapacity > 0 && initialCapacity <= D3D12_MAX_SHADER_VISIBLE_SAMPLER_HEAP_SIZE, "Sampler heap size out of range.\n");
+    for (UINT i = 0; i < TableSize; i++)
+    {
+        m_table[i].store(0, std::memory_order_relaxed);
+    }
+    m_heap = CreateHeap(initialCapacity);
+    m_state.store(m_heap.get(), std::memory_order_release);
+}
+
+UINT SamplerCache::GetSampler(const D3D12_SAMPLER_DESC& desc)
+{
+    uint32_t hash = Hash(desc);
+    UINT index = Find(desc, hash);
+    if (index != InvalidIndex)
+    {
+        return index;
+    }
+
+    auto start = std::chrono::high_resolution_clock::now();
+    std::lock_guard<std::mutex> lock(m_mutex);
+    // Another thread may have created it while this one waited for the lock
+    index = Find(desc, hash);
+    if (index != InvalidIndex)
+    {
+        return index;
+    }
+
+    index = m_count.load(std::memory_order_relaxed);
+    if (index == m_heap->capacity)
+    {
+        Grow();
+    }
+
+    m_descs[index] = desc;
+    m_device->CreateSampler(&desc, CD3DX12_CPU_DESCRIPTOR_HANDLE(m_heap->cpuStart, index, m_descriptorSize));
+
+    // Publishing the entry last means a lookup that finds it also sees the description and the descriptor
+    UINT entry = hash & (TableSize - 1);
+    while (m_table[entry].load(std::memory_order_relaxed) != 0)
+    {
+        entry = (entry + 1) & (TableSize - 1);
+    }
+    m_table[entry].store((uint64_t(hash) << 32) | (index + 1), std::memory_order_release);
+    m_count.store(index + 1, std::memory_order_release);
+
+    m_stats.RecordAllocation(index + 1,
+        std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::high_resolution_clock::now() - start).count());
+    return index;
+}
+
+D3D12_GPU_DESCRIPTOR_HANDLE SamplerCache::GetGpuHandle(UINT index) const
+{
+    return CD3DX12_GPU_DESCRIPTOR_HANDLE(m_state.load(std::memory_order_acquire)->gpuStart, index, m_descriptorSize);
+}
+
+void SamplerCache::EndFrame(uint64_t fenceValue)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    for (auto& retired : m_retiredHeaps)
+    {
+        if (retired.fenceValue == PendingFence)
+        {
+            retired.fenceValue = fenceValue;
+        }
+    }
+    m_stats.EndFrame();
+}
+
+void SamplerCache::Retire(uint64_t completedFenceValue)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    // Heaps are replaced in order, so stop at the first one still in use
+    while (!m_retiredHeaps.empty() && m_retiredHeaps.front().fenceValue <= completedFenceValue)
+    {
+        m_retiredHeaps.pop_front();
+    }
+}
+
+DescriptorHeapSnapshot SamplerCache::GetSnapshot(const std::string& name)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    DescriptorHeapSnapshot snapshot;
+    snapshot.name = name;
+    m_stats.Fill(snapshot);
+    snapshot.capacity = m_heap->capacity;
+    snapshot.occupied = m_count.load(std::memory_order_relaxed);
+    snapshot.freeListLength = snapshot.capacity - snapshot.occupied;
+    // Samplers are never freed, and fill the heap from the start
+    return snapshot;
+}
+
+uint32_t SamplerCache::Hash(const D3D12_SAMPLER_DESC& desc)
+{
+    // FNV-1a over the description, which is all 4 byte fields so has no padding to hash
+    const unsigned char* bytes = reinterpret_cast<const unsigned char*>(&desc);
+    uint32_t hash = 2166136261u;
+    for (size_t i = 0; i < sizeof(desc); i++)
+    {
+        hash = (hash ^ bytes[i]) * 16777619u;
+    }
+    return hash;
+}
+
+UINT SamplerCache::Find(const D3D12_SAMPLER_DESC& desc, uint32_t hash) const
+{
+    // The table is never more than half full, so the probe always reaches an empty entry
+    for (UINT entry = hash & (TableSize - 1); ; entry = (entry + 1) & (TableSize - 1))
+    {
+        uint64_t value = m_table[entry].load(std::memory_order_acquire);
+        if (value == 0)
+        {
+            return InvalidIndex;
+        }
+        // Different descriptions can share a hash, so compare the description itself before trusting it
+        if (uint32_t(value >> 32) == hash)
+        {
+            UINT index = UINT(value & UINT32_MAX) - 1;
+            if (std::memcmp(&m_descs[index], &desc, sizeof(desc)) == 0)
+            {
+                return index;
+            }
+        }
+    }
+}
+
+std::unique_ptr<SamplerCache::HeapState> SamplerCache::CreateHeap(UINT capacity)
+{
+    auto state = std::make_unique<HeapState>();
+    D3D12_DESCRIPTOR_HEAP_DESC desc = {};
+    desc.NumDescriptors = capacity;
+    desc.Type = D3D12_DESCRIPTOR_HEAP_TYPE_SAMPLER;
+    desc.Flags = D3D12_DESCRIPTOR_HEAP_FLAG_SHADER_VISIBLE;  // Let the samplers be accessed by shaders
+    ThrowIfFailed(m_device->CreateDescriptorHeap(&desc, IID_PPV_ARGS(&state->heap)), "Couldn't create sampler heap.\n");
+    std::string name = DescriptorHeap::GetDefaultName(desc) + " (sampler cache)";
+    state->heap->SetName(std::wstring(name.begin(), name.end()).c_str());
+    state->cpuStart = state->heap->GetCPUDescriptorHandleForHeapStart();
+    state->gpuStart = state->heap->GetGPUDescriptorHandleForHeapStart();
+    state->capacity = capacity;
+    return state;
+}
+
+void SamplerCache::Grow()
+{
+    ThrowIfFalse(m_heap->capacity < D3D12_MAX_SHADER_VISIBLE_SAMPLER_HEAP_SIZE, "Sampler heap is full.\n");
+    UINT capacity = m_heap->capacity * 2;
+    auto heap = CreateHeap(capacity < D3D12_MAX_SHADER_VISIBLE_SAMPLER_HEAP_SIZE ? capacity : D3D12_MAX_SHADER_VISIBLE_SAMPLER_HEAP_SIZE);
+
+    // Shader visible heaps can't be copied from, so recreate the samplers from their descriptions instead, keeping their indices
+    UINT count = m_count.load(std::memory_order_relaxed);
+    for (UINT i = 0; i < count; i++)
+    {
+        m_device->CreateSampler(&m_descs[i], CD3DX12_CPU_DESCRIPTOR_HANDLE(heap->cpuStart, i, m_descriptorSize));
+    }
+
+    m_state.store(heap.get(), std::memory_order_release);
+    // Command lists already recorded may still have the old heap set
+    m_retiredHeaps.push_back(RetiredHeap{ PendingFence, std::move(m_heap) });
+    m_heap = std::move(heap);
+}
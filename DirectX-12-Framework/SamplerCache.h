@@ -0,0 +1,126 @@
+#pragma once
+#include "stdafx.h"
+#include "DescriptorHeapStats.h"
+#include <atomic>
+#include <deque>
+#include <mutex>
+
+/**
+* Shader visible sampler heap which hands out one descriptor per distinct D3D12_SAMPLER_DESC.
+* Requesting a sampler that already exists returns the existing descriptor's index, found without taking a lock,
+* so materials can ask for the sampler they want on the render path rather than holding on to descriptors themselves.
+* The heap grows when full, up to the most samplers a shader visible heap can hold. The old heap is kept alive until the GPU is done with it.
+*/
+class SamplerCache
+{
+public:
+    static const UINT InvalidIndex = UINT_MAX;
+
+    /**
+    * @param device The ID3D12Device
+    * @param initialCapacity The number of samplers the heap holds before it first grows
+    */
+    SamplerCache(ID3D12Device* device, UINT initialCapacity);
+
+    /**
+    * Find the sampler matching a description, creating it if this is the first request for it.
+    * Lock free if the sampler exists, otherwise takes a lock to create it. Safe to call from any thread.
+    * If this grows the heap, command lists must set the new heap before using the returned index.
+    * @param desc The sampler's description
+    * @returns The sampler's index in the heap, which stays the same when the heap grows
+    */
+    UINT GetSampler(const D3D12_SAMPLER_DESC& desc);
+
+    /**
+    * @returns The current heap, to set on command lists
+    */
+    ID3D12DescriptorHeap* GetDescriptorHeap() const
+    {
+        return m_state.load(std::memory_order_acquire)->heap.Get();
+    }
+    /**
+    * @param index Index from GetSampler()
+    * @returns GPU handle to the sampler in the current heap, to set as a sampler table
+    */
+    D3D12_GPU_DESCRIPTOR_HANDLE GetGpuHandle(UINT index) const;
+
+    /**
+    * Tag heaps replaced since the last call with the fence value of the frame that last could have used them.
+    * @param fenceValue The fence value signalled after the frame's command lists
+    */
+    void EndFrame(uint64_t fenceValue);
+    /**
+    * Release replaced heaps the GPU has finished with.
+    * @param completedFenceValue The value the fence has currently reached
+    */
+    void Retire(uint64_t completedFenceValue);
+
+    /**
+    * @returns The number of distinct samplers created
+    */
+    UINT GetCount() const
+    {
+        return m_count.load(std::memory_order_acquire);
+    }
+    /**
+    * @param name The name to report the heap's statistics under
+    * @returns The heap's current statistics
+    */
+    DescriptorHeapSnapshot GetSnapshot(const std::string& name);
+
+private:
+    /**
+    * A shader visible heap and where it starts, replaced as a whole when the cache grows.
+    */
+    struct HeapState
+    {
+        Microsoft::WRL::ComPtr<ID3D12DescriptorHeap> heap;
+        D3D12_CPU_DESCRIPTOR_HANDLE cpuStart;
+        D3D12_GPU_DESCRIPTOR_HANDLE gpuStart;
+        UINT capacity;
+    };
+    /**
+    * A replaced heap, and the fence value after which it's no longer referenced.
+    */
+    struct RetiredHeap
+    {
+        uint64_t fenceValue;
+        std::unique_ptr<HeapState> state;
+    };
+
+    /** Entries in the lookup table, twice the most samplers there can be so probes stay short and always find an empty entry */
+    static const UINT TableSize = 2 * D3D12_MAX_SHADER_VISIBLE_SAMPLER_HEAP_SIZE;
+    /** Tags replaced heaps that haven't been closed by EndFrame() yet */
+    static const uint64_t PendingFence = UINT64_MAX;
+
+    static uint32_t Hash(const D3D12_SAMPLER_DESC& desc);
+    /**
+    * Probe the lookup table for a sampler. Lock free.
+    * @returns The sampler's index, or InvalidIndex if it hasn't been created
+    */
+    UINT Find(const D3D12_SAMPLER_DESC& desc, uint32_t hash) const;
+    std::unique_ptr<HeapState> CreateHeap(UINT capacity);
+    /**
+    * Replace the heap with one twice the size, recreating every sampler in it. Requires m_mutex.
+    */
+    void Grow();
+
+    ID3D12Device* m_device;
+    UINT m_descriptorSize;
+
+    /** Heap used by the samplers currently handed out, owned by m_heap */
+    std::atomic<HeapState*> m_state;
+    std::unique_ptr<HeapState> m_heap;
+    std::deque<RetiredHeap> m_retiredHeaps;
+
+    /** Open addressed table of hash in the upper 32 bits and index + 1 in the lower, 0 when empty. Entries are only ever added */
+    std::unique_ptr<std::atomic<uint64_t>[]> m_table;
+    /** The description of each sampler, by index, written before its table entry is published */
+    std::unique_ptr<D3D12_SAMPLER_DESC[]> m_descs;
+    std::atomic<UINT> m_count;
+
+    DescriptorHeapStats m_stats;
+
+    /** Serialises creating samplers, growing, and retiring heaps. Never taken by lookups */
+    std::mutex m_mutex;
+};
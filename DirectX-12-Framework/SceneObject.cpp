@@ -3,6 +3,7 @@
 #include "Resource.h"
 #include "Primitive.h"
 #include "ConstantBufferView.h"
+#include "CbvSrvUavHeap.h"
 
 using namespace DirectX;
 using namespace Microsoft::WRL;
@@ -13,37 +14,57 @@ SceneObject::SceneObject(std::shared_ptr<Primitive> model, std::shared_ptr<Resou
     , m_texture(texture)
     , m_constantBuffer(constantBuffer)
     , m_name(name)
-    , m_position(0.0f, 0.0f, 0.0f)
-    , m_rotation(0.0f, 0.0f, 0.0f)
-    , m_scale(1.0f, 1.0f, 1.0f)
+    , m_transform(XMFLOAT3(0.0f, 0.0f, 0.0f), XMFLOAT3(0.0f, 0.0f, 0.0f), XMFLOAT3(1.0f, 1.0f, 1.0f))
     , m_forward(0.0f, 0.0f, -1.0f)	// Used in determining camera direction
-
 {
+    const XMFLOAT3& position = m_transform.GetPosition();
+    const XMFLOAT3& rotation = m_transform.GetRotation();
+    const XMFLOAT3& scale = m_transform.GetScale();
     XMFLOAT4 orientation;
-    XMStoreFloat4(&orientation, XMQuaternionRotationRollPitchYaw(m_rotation.x, m_rotation.y, m_rotation.z));
-    m_boundingBox = BoundingOrientedBox(m_position, XMFLOAT3(m_scale.x / 2.0f, m_scale.y / 2.0f, m_scale.z / 2.0f), orientation);
+    XMStoreFloat4(&orientation, XMQuaternionRotationRollPitchYaw(rotation.x, rotation.y, rotation.z));
+    m_boundingBox = BoundingOrientedBox(position, XMFLOAT3(scale.x / 2.0f, scale.y / 2.0f, scale.z / 2.0f), orientation);
 
 }
-void SceneObject::UpdateConstantBuffer(const DirectX::XMMATRIX view, const DirectX::XMMATRIX projection)
+
+void SceneObject::UpdateConstantBuffer()
 {
-    // Update constant buffer
-    XMMATRIX model = GetWorld();
-    m_constantBuffer->Update(model, view, projection);
+    // Objects that haven't moved keep what their slot already holds
+    if (m_transform.Update() && m_constantBuffer)
+    {
+        m_constantBuffer->SetWorld(m_transform.GetWorld());
+    }
 }
 
-void SceneObject::Draw(ID3D12GraphicsCommandList* commandList)
+void SceneObject::Draw(ID3D12GraphicsCommandList* commandList, const ConstantBufferArena::Block& block)
 {
-    if (m_texture)
-        m_texture->Set(commandList);
-    if (m_constantBuffer)
-        m_constantBuffer->Set(commandList);
+    // An object created since the block was written has no constants in it, and the shader would read another slot's world matrix, so it's drawn from the next frame
+    if (!m_constantBuffer || !m_constantBuffer->IsIn(block))
+    {
+        return;
+    }
+    UINT objectIndex = m_constantBuffer->GetSlot();
+
+    // Every view of an object lives in the same heap, which decides how they are bound
+    CbvSrvUavHeap* heap = m_constantBuffer->heap;
+    if (heap && heap->IsBindless() && m_model)
+    {
+        // Everything but the pass's constants is recorded in a bundle, so the draw is a single call
+        heap->DrawBundled(commandList, m_model, m_texture.get(), objectIndex);
+        return;
+    }
+    if (heap)
+    {
+        heap->SetDrawResources(commandList, m_texture.get(), objectIndex);
+        if (m_model)
+            heap->RequireUpload(m_model->GetUploadFenceValue());
+    }
     if (m_model)
-        m_model->Draw(commandList);
+        m_model->Draw(commandList, heap && heap->IsBindless());
 }
 
 void SceneObject::SetRotation(const DirectX::XMFLOAT3& rotation)
 {
-    m_rotation = rotation;
+    m_transform.SetRotation(rotation);
     XMVECTOR qRotationV = XMQuaternionRotationRollPitchYaw(rotation.x, rotation.y, rotation.z);
     XMStoreFloat4(&m_boundingBox.Orientation, qRotationV);
     // Get the portal's forward, i.e. where its facing 
@@ -53,11 +74,3 @@ void SceneObject::SetRotation(const DirectX::XMFLOAT3& rotation)
     newForward = XMVector3Normalize(newForward);
     XMStoreFloat3(&m_forward, newForward);
 }
-
-const DirectX::XMMATRIX SceneObject::GetWorld() const
-{
-    XMMATRIX translation = DirectX::XMMatrixTranslation(m_position.x, m_position.y, m_position.z);
-    XMMATRIX rotation = DirectX::XMMatrixRotationRollPitchYaw(m_rotation.x, m_rotation.y, m_rotation.z);
-    XMMATRIX scale = XMMatrixScaling(m_scale.x, m_scale.y, m_scale.z);
-    return scale * rotation * translation;
-}
@@ -2,6 +2,8 @@
 #include "stdafx.h"
 #include <DirectXCollision.h>
 #include <string>
+#include "ConstantBufferArena.h"
+#include "Transform.h"
 
 class Primitive;
 struct Resource;
@@ -12,24 +14,32 @@ class SceneObject
 public:
 	SceneObject(std::shared_ptr<Primitive> model, std::shared_ptr<Resource> texture, std::shared_ptr<ConstantBufferView> constantBuffer, std::string name);
 	virtual void Initialize() {};
-	virtual void Draw(ID3D12GraphicsCommandList* commandList);
+	/**
+	* Draw with the object's world matrix from the pass's constants, which the pass has set.
+	* Passes recorded in parallel each draw the same objects from their own view this way.
+	* @param constants The pass's block, from ConstantBufferArena::UpdateView()
+	*/
+	virtual void Draw(ID3D12GraphicsCommandList* commandList, const ConstantBufferArena::Block& constants);
 	virtual void Update(const double deltaTime) {};
-	void UpdateConstantBuffer(const DirectX::XMMATRIX view, const DirectX::XMMATRIX projection);
+	/**
+	* Give the object's slot in the constant buffer arena its current world matrix, for ConstantBufferArena::UpdateWorlds() to copy.
+	*/
+	void UpdateConstantBuffer();
 
 	const DirectX::XMFLOAT3& GetPosition() const
 	{
-		return m_position;
+		return m_transform.GetPosition();
 	}
 
 	virtual void SetPosition(const DirectX::XMFLOAT3& position)
 	{
-		m_position = position;
+		m_transform.SetPosition(position);
 		m_boundingBox.Center = position;
 	}
 
 	const DirectX::XMFLOAT3& GetRotation() const
 	{
-		return m_rotation;
+		return m_transform.GetRotation();
 	}
 
 	virtual void SetRotation(const DirectX::XMFLOAT3& rotation);
@@ -37,19 +47,25 @@ public:
 
 	const DirectX::XMFLOAT3& GetScale() const
 	{
-		return m_scale;
+		return m_transform.GetScale();
 	}
 
 	virtual void SetScale(const DirectX::XMFLOAT3& scale)
 	{
-		m_scale = scale;
+		m_transform.SetScale(scale);
 		m_boundingBox.Extents.x = scale.x / 2.0f;
 		m_boundingBox.Extents.y = scale.y / 2.0f;
 		m_boundingBox.Extents.z = scale.z / 2.0f;
 	}
 	
 
-	const DirectX::XMMATRIX GetWorld() const;
+	/**
+	* @returns The world matrix, cached by UpdateConstantBuffer(). Only reads the object, so passes recorded in parallel can call it at once
+	*/
+	const DirectX::XMMATRIX GetWorld() const
+	{
+		return m_transform.GetWorld();
+	}
 	
 
 	std::shared_ptr<Primitive> GetModel()
@@ -57,6 +73,9 @@ public:
 		return m_model;
 	}
 
+	/**
+	* A new model or texture gives the object a new bundle, the old one is released once it's gone unused for a while.
+	*/
 	void SetModel(std::shared_ptr<Primitive> model)
 	{
 		m_model = model;
@@ -92,9 +111,8 @@ public:
 		return m_forward;
 	}
 protected:
-	DirectX::XMFLOAT3 m_position;
-	DirectX::XMFLOAT3 m_rotation;
-	DirectX::XMFLOAT3 m_scale;
+	/** Position, rotation and scale, and the world matrix only UpdateConstantBuffer() rebuilds, as passes recorded in parallel read it */
+	Transform m_transform;
 	DirectX::XMFLOAT3 m_forward;
 
 	std::string m_name;
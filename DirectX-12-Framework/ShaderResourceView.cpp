@@ -33,10 +33,12 @@ bool ShaderResourceView::Load(ID3D12Device* device, ID3D12GraphicsCommandList* c
     UpdateSubresources(commandList, resource.Get(), uploadResource.Get(),
         0, 0, static_cast<UINT>(subresources.size()), subresources.data());
 
-    auto barrier = CD3DX12_RESOURCE_BARRIER::Transition(resource.Get(),
-        D3D12_RESOURCE_STATE_COPY_DEST, D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
-    commandList->ResourceBarrier(1, &barrier);
+    // The command list is a copy list, which can't transition to PIXEL_SHADER_RESOURCE.
+    // Textures used on a copy queue decay to COMMON once it's finished with them, and are promoted to a read state when the direct queue first samples them
 
-    DirectX::CreateShaderResourceView(device, resource.Get(), cpuDescriptorHandle);
+    WriteView([&](D3D12_CPU_DESCRIPTOR_HANDLE cpuHandle)
+        {
+            DirectX::CreateShaderResourceView(device, resource.Get(), cpuHandle);
+        });
     return true;
 }
@@ -0,0 +1,134 @@
+#include "SimulatedTimeline.h"
+#include "WakeEvent.h"
+
+SimulatedTimeline::SimulatedTimeline(std::chrono::microseconds submitLatency)
+    : m_submitLatency(submitLatency)
+    , m_completedValue(0)
+    , m_stats()
+    , m_stopping(false)
+{
+    // Started last, once everything it reads is initialised
+    m_gpu = std::thread(&SimulatedTimeline::Execute, this);
+}
+
+SimulatedTimeline::~SimulatedTimeline()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stopping = true;
+    }
+    m_submitted.notify_one();
+    m_gpu.join();
+}
+
+void SimulatedTimeline::Submit(std::chrono::microseconds duration)
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_commands.push_back(Command{ std::chrono::steady_clock::now() + m_submitLatency, duration, 0 });
+    }
+    m_submitted.notify_one();
+}
+
+uint64_t SimulatedTimeline::Signal()
+{
+    uint64_t value;
+    {
+        // Taken under the lock, so threads signalling at once queue their values in order
+        std::lock_guard<std::mutex> lock(m_mutex);
+        value = m_signalledValue.load(std::memory_order_relaxed) + 1;
+        m_signalledValue.store(value, std::memory_order_release);
+        m_commands.push_back(Command{ std::chrono::steady_clock::now() + m_submitLatency, std::chrono::microseconds(0), value });
+    }
+    m_submitted.notify_one();
+    return value;
+}
+
+uint64_t SimulatedTimeline::GetCompletedValue()
+{
+    return m_completedValue.load(std::memory_order_acquire);
+}
+
+void SimulatedTimeline::WaitForValue(uint64_t value)
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_stats.waits++;
+    if (m_completedValue.load(std::memory_order_acquire) >= value)
+    {
+        return;
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    m_completed.wait(lock, [&] { return m_completedValue.load(std::memory_order_acquire) >= value; });
+    m_stats.stalls++;
+    m_stats.stalledMilliseconds += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+void SimulatedTimeline::SetEventOnCompletion(uint64_t value, WakeEvent& event)
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (m_completedValue.load(std::memory_order_acquire) < value)
+        {
+            m_events.emplace_back(value, &event);
+            return;
+        }
+    }
+    event.Set();
+}
+
+SimulatedTimeline::Stats SimulatedTimeline::GetStats()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_stats;
+}
+
+void SimulatedTimeline::Execute()
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+    for (;;)
+    {
+        // Out of work, the GPU sits idle until something is submitted
+        auto idleStart = std::chrono::steady_clock::now();
+        m_submitted.wait(lock, [this] { return m_stopping || !m_commands.empty(); });
+        if (m_stopping)
+        {
+            return;
+        }
+        Command command = m_commands.front();
+        m_commands.pop_front();
+        lock.unlock();
+
+        // The GPU can't start on it until the submission has made its way to the queue
+        std::this_thread::sleep_until(command.readyTime);
+        auto start = std::chrono::steady_clock::now();
+        if (command.duration.count() > 0)
+        {
+            std::this_thread::sleep_for(command.duration);
+        }
+        auto end = std::chrono::steady_clock::now();
+
+        lock.lock();
+        m_stats.idleMilliseconds += std::chrono::duration<double, std::milli>(start - idleStart).count();
+        m_stats.busyMilliseconds += std::chrono::duration<double, std::milli>(end - start).count();
+        if (command.signalValue)
+        {
+            // Commands execute in order, so everything before the signal has finished
+            m_completedValue.store(command.signalValue, std::memory_order_release);
+            m_completed.notify_all();
+            for (size_t i = 0; i < m_events.size();)
+            {
+                if (m_events[i].first <= command.signalValue)
+                {
+                    m_events[i].second->Set();
+                    m_events[i] = m_events.back();
+                    m_events.pop_back();
+                }
+                else
+                {
+                    i++;
+                }
+            }
+        }
+    }
+}
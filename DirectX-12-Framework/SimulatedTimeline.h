@@ -0,0 +1,79 @@
+#pragma once
+#include "Timeline.h"
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/**
+* Timeline of a simulated GPU queue, a thread that works through submissions in order, taking as long as each says it does.
+* Lets frame pacing, allocator reuse and CPU/GPU overlap be measured on machines without a GPU.
+*/
+class SimulatedTimeline : public Timeline
+{
+public:
+	/**
+	* Where the simulated GPU's time went, and how long the CPU spent blocked on it.
+	*/
+	struct Stats
+	{
+		/** Calls to WaitForValue(), and how many of those had to block */
+		uint64_t waits = 0;
+		uint64_t stalls = 0;
+		double stalledMilliseconds = 0.0;
+		/** Time the GPU spent executing submissions, and waiting for something to execute */
+		double busyMilliseconds = 0.0;
+		double idleMilliseconds = 0.0;
+	};
+
+	/**
+	* @param submitLatency How long after being submitted the GPU can start on a submission, i.e. driver and scheduling overhead
+	*/
+	SimulatedTimeline(std::chrono::microseconds submitLatency = std::chrono::microseconds(0));
+	~SimulatedTimeline();
+
+	/**
+	* Queue work behind everything submitted so far.
+	* @param duration How long the GPU takes to execute it
+	*/
+	void Submit(std::chrono::microseconds duration);
+
+	uint64_t Signal() override;
+	uint64_t GetCompletedValue() override;
+	void WaitForValue(uint64_t value) override;
+	void SetEventOnCompletion(uint64_t value, WakeEvent& event) override;
+
+	/**
+	* @returns The stats so far. The GPU times only cover submissions it has finished
+	*/
+	Stats GetStats();
+
+private:
+	/** The simulated GPU */
+	void Execute();
+
+	/** A submission, or a signal if it has a value */
+	struct Command
+	{
+		std::chrono::steady_clock::time_point readyTime;
+		std::chrono::microseconds duration;
+		uint64_t signalValue;
+	};
+
+	const std::chrono::microseconds m_submitLatency;
+
+	std::mutex m_mutex;
+	std::condition_variable m_submitted;
+	std::condition_variable m_completed;
+	std::deque<Command> m_commands;
+	/** Events waiting for a value, set by the GPU thread once it's reached */
+	std::vector<std::pair<uint64_t, WakeEvent*>> m_events;
+	std::atomic<uint64_t> m_completedValue;
+	Stats m_stats;
+	bool m_stopping;
+
+	std::thread m_gpu;
+};
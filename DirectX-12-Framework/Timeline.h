@@ -0,0 +1,66 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+
+class WakeEvent;
+
+/**
+* A GPU queue's progress as a counter that only goes up, which is all frame pacing and resource reuse need to know about it.
+* Signal() queues the next value behind everything submitted so far, and it's reached once the GPU has finished all of that work.
+* D3D12Timeline implements it with an ID3D12Fence, SimulatedTimeline with an in-process simulated GPU, so the logic built on it runs without a device.
+*/
+class Timeline
+{
+public:
+	virtual ~Timeline() {}
+
+	/**
+	* Queue a signal behind all work submitted so far.
+	* @returns The value that will be reached once that work has finished
+	*/
+	virtual uint64_t Signal() = 0;
+	/**
+	* Query how far the GPU has progressed, without blocking.
+	* @returns The last value reached
+	*/
+	virtual uint64_t GetCompletedValue() = 0;
+	/**
+	* Block the calling thread until a value has been reached. Safe to call from several threads at once.
+	* @param value The value to wait for, returns immediately if already reached
+	*/
+	virtual void WaitForValue(uint64_t value) = 0;
+	/**
+	* Set an event once a value has been reached, without blocking, so one thread can wait on several timelines and other wake-ups at once.
+	* Safe to call from several threads at once.
+	* @param value The value to wait for, the event is set straight away if it's already been reached
+	* @param event The event to set, which must outlive the wait
+	*/
+	virtual void SetEventOnCompletion(uint64_t value, WakeEvent& event) = 0;
+
+	/**
+	* @returns true if the value has been reached
+	*/
+	bool IsComplete(uint64_t value)
+	{
+		return GetCompletedValue() >= value;
+	}
+	/**
+	* Safe to call while another thread signals, in which case it's the value either before or after that signal.
+	* @returns The value the next Signal() will use, so anything submitted or recorded but not yet signalled is covered by it
+	*/
+	uint64_t GetNextValue() const
+	{
+		return m_signalledValue.load(std::memory_order_acquire) + 1;
+	}
+	/**
+	* Block until everything submitted so far has finished.
+	*/
+	void Flush()
+	{
+		WaitForValue(Signal());
+	}
+
+protected:
+	/** The last value Signal() returned. Atomic, as threads recording uploads or freeing resources read it while the frame thread signals */
+	std::atomic<uint64_t> m_signalledValue{ 0 };
+};
@@ -0,0 +1,39 @@
+#pragma once
+#include <cstdint>
+
+struct ID3D12GraphicsCommandList;
+
+/**
+* Numbered slots the GPU writes its clock into, and a way for the CPU to read them back once the GPU has passed them.
+* D3D12TimestampBackend implements it with a timestamp query heap and a readback buffer, NullTimestampBackend with synthetic timestamps,
+* so the profiler's resolve and aggregation run without a device.
+*/
+class TimestampBackend
+{
+public:
+	virtual ~TimestampBackend() {}
+
+	/**
+	* Record writing the GPU's clock into a slot, once the GPU reaches this point in the list.
+	* @param commandList The list to record into
+	* @param query The slot to write, in [0, GetQueryCount())
+	*/
+	virtual void WriteTimestamp(ID3D12GraphicsCommandList* commandList, uint32_t query) = 0;
+	/**
+	* Record copying a range of slots to where Read() can find them, after every timestamp in the range has been written.
+	*/
+	virtual void Resolve(ID3D12GraphicsCommandList* commandList, uint32_t firstQuery, uint32_t count) = 0;
+	/**
+	* Read back a resolved range, once the GPU has finished the list resolving it.
+	* @param timestamps Out, count timestamps in ticks of GetFrequency()
+	*/
+	virtual void Read(uint32_t firstQuery, uint32_t count, uint64_t* timestamps) = 0;
+	/**
+	* @returns Timestamp ticks per second
+	*/
+	virtual uint64_t GetFrequency() const = 0;
+	/**
+	* @returns The number of slots
+	*/
+	virtual uint32_t GetQueryCount() const = 0;
+};
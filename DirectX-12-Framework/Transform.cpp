@@ -0,0 +1,43 @@
+#include "Transform.h"
+#include "TransformStats.h"
+
+using namespace DirectX;
+
+Transform::Transform(const XMFLOAT3& position, const XMFLOAT3& rotation, const XMFLOAT3& scale)
+    : m_position(position)
+    , m_rotation(rotation)
+    , m_scale(scale)
+    , m_world()
+    , m_dirty(true)
+{
+}
+
+XMMATRIX Transform::GetWorld() const
+{
+    // Building it here rather than caching it keeps this read-only, so recording threads never write to the object
+    if (m_dirty)
+    {
+        return BuildWorld();
+    }
+    return XMLoadFloat4x4(&m_world);
+}
+
+bool Transform::Update()
+{
+    if (!m_dirty)
+    {
+        return false;
+    }
+    XMStoreFloat4x4(&m_world, BuildWorld());
+    m_dirty = false;
+    return true;
+}
+
+XMMATRIX Transform::BuildWorld() const
+{
+    XMMATRIX translation = XMMatrixTranslation(m_position.x, m_position.y, m_position.z);
+    XMMATRIX rotation = XMMatrixRotationRollPitchYaw(m_rotation.x, m_rotation.y, m_rotation.z);
+    XMMATRIX scale = XMMatrixScaling(m_scale.x, m_scale.y, m_scale.z);
+    TransformStats::CountRebuild(TransformStats::World);
+    return scale * rotation * translation;
+}
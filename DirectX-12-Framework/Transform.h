@@ -0,0 +1,65 @@
+#pragma once
+#include "stdafx.h"
+
+/**
+* A scene object's position, rotation and scale, and the world matrix built from them.
+* The matrix is cached, and only rebuilt by Update() once one of them has been set, so objects that don't move cost nothing a frame.
+* Update() is the only thing that writes the cache, and is called on the frame thread before any pass is recorded.
+* GetWorld() never writes it, so passes recorded in parallel can read it at once, even if the object has moved since Update().
+*/
+class Transform
+{
+public:
+	Transform(const DirectX::XMFLOAT3& position, const DirectX::XMFLOAT3& rotation, const DirectX::XMFLOAT3& scale);
+
+	const DirectX::XMFLOAT3& GetPosition() const
+	{
+		return m_position;
+	}
+	void SetPosition(const DirectX::XMFLOAT3& position)
+	{
+		m_position = position;
+		m_dirty = true;
+	}
+	const DirectX::XMFLOAT3& GetRotation() const
+	{
+		return m_rotation;
+	}
+	void SetRotation(const DirectX::XMFLOAT3& rotation)
+	{
+		m_rotation = rotation;
+		m_dirty = true;
+	}
+	const DirectX::XMFLOAT3& GetScale() const
+	{
+		return m_scale;
+	}
+	void SetScale(const DirectX::XMFLOAT3& scale)
+	{
+		m_scale = scale;
+		m_dirty = true;
+	}
+
+	/**
+	* Safe to call from several threads at once, as long as none is setting the transform or calling Update().
+	* @returns The cached world matrix, or if the transform has been set since the last Update(), one built afresh without caching it
+	*/
+	DirectX::XMMATRIX GetWorld() const;
+	/**
+	* Rebuild the cached world matrix if the transform has been set since it was last built.
+	* @returns Whether it was rebuilt, i.e. whether copies of the old one, such as the object's constants, are out of date
+	*/
+	bool Update();
+
+private:
+	DirectX::XMMATRIX BuildWorld() const;
+
+	DirectX::XMFLOAT3 m_position;
+	DirectX::XMFLOAT3 m_rotation;
+	DirectX::XMFLOAT3 m_scale;
+
+	/** The world matrix as last built by Update() */
+	DirectX::XMFLOAT4X4 m_world;
+	/** Whether the position, rotation or scale has been set since m_world was built */
+	bool m_dirty;
+};
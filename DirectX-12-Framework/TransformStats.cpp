@@ -0,0 +1,12 @@
+#include "TransformStats.h"
+
+std::atomic<uint32_t> TransformStats::s_rebuilds[TransformStats::MatrixCount] = {};
+uint32_t TransformStats::s_lastFrame[TransformStats::MatrixCount] = {};
+
+void TransformStats::EndFrame()
+{
+    for (int matrix = 0; matrix < MatrixCount; matrix++)
+    {
+        s_lastFrame[matrix] = s_rebuilds[matrix].exchange(0, std::memory_order_relaxed);
+    }
+}
@@ -0,0 +1,41 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+
+/**
+* Counts how many cached matrices are rebuilt each frame, i.e. how many had something they're computed from changed since they were last read.
+* A scene where nothing moves rebuilds none. Matrices can be read from any recording thread, so counting is atomic.
+*/
+class TransformStats
+{
+public:
+	enum Matrix
+	{
+		World,
+		View,
+		Projection,
+		ViewProjection,
+		MatrixCount
+	};
+
+	static void CountRebuild(Matrix matrix)
+	{
+		s_rebuilds[matrix].fetch_add(1, std::memory_order_relaxed);
+	}
+
+	/**
+	* Close the frame, keeping its counts for GetLastFrame() and starting the next frame's from zero.
+	*/
+	static void EndFrame();
+	/**
+	* @returns Rebuilds of the given kind of matrix during the last frame to have ended
+	*/
+	static uint32_t GetLastFrame(Matrix matrix)
+	{
+		return s_lastFrame[matrix];
+	}
+
+private:
+	static std::atomic<uint32_t> s_rebuilds[MatrixCount];
+	static uint32_t s_lastFrame[MatrixCount];
+};
@@ -0,0 +1,112 @@
+#include "TransientStager.h"
+#include <chrono>
+
+// Defined here as well as declared, as callers compare against it by reference, e.g. through std::map::count()
+const uint32_t TransientStager::InvalidIndex;
+
+TransientStager::TransientStager(uint32_t start, uint32_t capacity, uint32_t blockSize, std::function<void(uint64_t)> waitForFence)
+    : m_start(start)
+    , m_blockSize(blockSize)
+    , m_waitForFence(std::move(waitForFence))
+    , m_ringMutex()
+    , m_ring(capacity)
+    , m_stats()
+    , m_threads()
+{
+}
+
+uint32_t TransientStager::Stage(uint32_t source)
+{
+    ThreadStaging& thread = m_threads.Get();
+    // Already staged by this thread this frame, so it's already being copied
+    auto staged = thread.staged.find(source);
+    if (staged != thread.staged.end())
+    {
+        return staged->second;
+    }
+
+    if (thread.next == thread.end && !ClaimBlock(thread))
+    {
+        return InvalidIndex;
+    }
+    uint32_t index = m_start + thread.next++;
+    thread.staged.emplace(source, index);
+    thread.copies.push_back(Copy{ source, index });
+    return index;
+}
+
+void TransientStager::AddCopy(uint32_t source, uint32_t destination)
+{
+    m_threads.Get().copies.push_back(Copy{ source, destination });
+}
+
+void TransientStager::TakeCopies(std::vector<Copy>& copies)
+{
+    m_threads.ForEach([&copies](ThreadStaging& thread)
+        {
+            copies.insert(copies.end(), thread.copies.begin(), thread.copies.end());
+            thread.copies.clear();
+        });
+}
+
+void TransientStager::EndFrame(uint64_t fenceValue)
+{
+    // Blocks belong to the frame that claimed them, and are retired with it
+    m_threads.ForEach([](ThreadStaging& thread)
+        {
+            thread.next = 0;
+            thread.end = 0;
+            thread.staged.clear();
+        });
+
+    std::lock_guard<std::mutex> lock(m_ringMutex);
+    m_ring.EndFrame(fenceValue);
+    m_stats.EndFrame(fenceValue);
+}
+
+uint32_t TransientStager::Retire(uint64_t completedFenceValue)
+{
+    std::lock_guard<std::mutex> lock(m_ringMutex);
+    uint32_t released = m_ring.Retire(completedFenceValue);
+    m_stats.RecordFree(released);
+    return released;
+}
+
+bool TransientStager::ClaimBlock(ThreadStaging& thread)
+{
+    // Latency includes waiting for the lock, which is what contention between recording threads costs
+    auto start = std::chrono::high_resolution_clock::now();
+    std::lock_guard<std::mutex> lock(m_ringMutex);
+    uint32_t offset;
+    uint32_t count;
+    for (;;)
+    {
+        offset = m_ring.Allocate(m_blockSize);
+        count = m_blockSize;
+        if (offset == DescriptorRing::InvalidIndex)
+        {
+            // Not a whole block left, so hand out what's left a slot at a time rather than failing while the ring still has room
+            offset = m_ring.Allocate(1);
+            count = 1;
+        }
+        if (offset != DescriptorRing::InvalidIndex)
+        {
+            break;
+        }
+
+        // Waiting only helps if frames in flight hold slots, the frame being recorded can't free its own
+        if (!m_waitForFence || m_ring.GetUsed() == m_ring.GetFrameUsed())
+        {
+            return false;
+        }
+        // Wait for the oldest and take its slots. The lock is held, as any other thread claiming a block would have to wait too
+        uint64_t oldestFenceValue = m_ring.GetOldestFenceValue();
+        m_waitForFence(oldestFenceValue);
+        m_stats.RecordFree(m_ring.Retire(oldestFenceValue));
+    }
+    thread.next = offset;
+    thread.end = offset + count;
+    m_stats.RecordAllocation(m_ring.GetUsed(),
+        std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::high_resolution_clock::now() - start).count());
+    return true;
+}
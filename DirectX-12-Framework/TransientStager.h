@@ -0,0 +1,111 @@
+#pragma once
+#include "DescriptorRing.h"
+#include "DescriptorHeapStats.h"
+#include "PerThread.h"
+#include <functional>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+/**
+* Gives the descriptors draws bind slots in a transient ring for the frame being recorded, from several recording threads at once.
+* Each thread claims a block of the ring at a time and stages into it on its own, so the ring's lock is only taken once a block.
+* The copies each thread queues are merged by TakeCopies() at submit time, to be made with one CopyDescriptors.
+* The ring's region of the heap is fixed, so when it's full of frames in flight a thread waits for the oldest to complete rather than failing.
+* Owns no D3D12 objects, descriptors are plain keys and slots are plain heap indices.
+*/
+class TransientStager
+{
+public:
+	static const uint32_t InvalidIndex = UINT32_MAX;
+
+	/**
+	* A descriptor to copy into the shader visible heap before the frame executes.
+	*/
+	struct Copy
+	{
+		/** Identifies the source descriptor, i.e. its DescriptorHandle's value */
+		uint32_t source;
+		/** Heap index to copy it to */
+		uint32_t destination;
+	};
+
+	/**
+	* @param start Heap index of the ring's first slot
+	* @param capacity Number of slots in the ring
+	* @param blockSize Number of slots a thread claims at a time
+	* @param waitForFence Blocks until the frame fence reaches the value it's passed, called when the ring is full. Without it Stage() fails instead
+	*/
+	TransientStager(uint32_t start, uint32_t capacity, uint32_t blockSize, std::function<void(uint64_t)> waitForFence = nullptr);
+
+	/**
+	* Give a descriptor a slot for the frame being recorded, and queue its copy. A descriptor staged twice by one thread in a frame shares one slot.
+	* Safe to call from several threads at once.
+	* @param source Identifies the descriptor
+	* @returns The slot's heap index, or InvalidIndex if the frame being recorded has filled the ring on its own, or it's full of frames in flight and there's no fence to wait for
+	*/
+	uint32_t Stage(uint32_t source);
+	/**
+	* Queue a copy to somewhere other than the ring, e.g. the bindless region, alongside the calling thread's staged copies.
+	* Safe to call from several threads at once.
+	*/
+	void AddCopy(uint32_t source, uint32_t destination);
+	/**
+	* Move every copy queued since the last call onto the end of copies, each thread's in the order it queued them.
+	* Must only be called while no thread is staging, i.e. once recording has finished.
+	*/
+	void TakeCopies(std::vector<Copy>& copies);
+
+	/**
+	* Close the frame being recorded, each thread starts the next frame with a fresh block.
+	* @param fenceValue The fence value signalled after the frame's command lists
+	*/
+	void EndFrame(uint64_t fenceValue);
+	/**
+	* @returns The number of slots released
+	*/
+	uint32_t Retire(uint64_t completedFenceValue);
+
+	/**
+	* The ring, including the unused ends of blocks, which are held until their frame retires like the rest.
+	*/
+	const DescriptorRing& GetRing() const
+	{
+		return m_ring;
+	}
+	/**
+	* Counts blocks rather than descriptors, as claiming a block is the only time staging waits on other threads.
+	*/
+	DescriptorHeapStats& GetStats()
+	{
+		return m_stats;
+	}
+
+private:
+	struct ThreadStaging
+	{
+		/** Unused slots of the thread's current block, as ring offsets */
+		uint32_t next = 0;
+		uint32_t end = 0;
+		/** Slot each descriptor the thread has staged this frame was given */
+		std::unordered_map<uint32_t, uint32_t> staged;
+		std::vector<Copy> copies;
+	};
+
+	/**
+	* Claim the calling thread a new block, waiting for frames in flight to complete if the ring is full of them.
+	* @returns false if the ring hasn't a single slot free and waiting wouldn't free one
+	*/
+	bool ClaimBlock(ThreadStaging& thread);
+
+	const uint32_t m_start;
+	const uint32_t m_blockSize;
+	const std::function<void(uint64_t)> m_waitForFence;
+
+	/** Guards the ring, which threads only touch to claim a block */
+	std::mutex m_ringMutex;
+	DescriptorRing m_ring;
+	DescriptorHeapStats m_stats;
+
+	PerThread<ThreadStaging> m_threads;
+};
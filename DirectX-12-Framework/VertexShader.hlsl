@@ -1,9 +1,19 @@
-cbuffer SceneConstantBuffer : register(b0)
+// The pass's view, written once per pass
+cbuffer ViewConstants : register(b0)
 {
-    float4x4 mvp;
-    float4 padding[12];
+    float4x4 viewProjection;
 };
 
+// Which world matrix is the draw's, set per draw. The texture index is only read by the bindless shaders
+cbuffer DrawConstants : register(b1)
+{
+    uint textureIndex;
+    uint objectIndex;
+};
+
+// Every object's world matrix, written once per frame and shared by every pass
+StructuredBuffer<float4x4> g_worlds : register(t0, space2);
+
 struct VSInput
 {
     float3 position : POSITION;
@@ -20,8 +30,8 @@ PSInput main(VSInput input)
 {
     PSInput result;
 
-    result.position = mul(float4(input.position, 1.0f), mvp);
-    //result.position = mul(position, transpose(mvp));
+    float4 worldPosition = mul(float4(input.position, 1.0f), g_worlds[objectIndex]);
+    result.position = mul(worldPosition, viewProjection);
     result.uv = input.uv;
     
     return result;
@@ -0,0 +1,53 @@
+#include "WakeEvent.h"
+
+#if defined (_WIN32)
+
+WakeEvent::WakeEvent()
+    : m_event(::CreateEvent(nullptr, FALSE, FALSE, nullptr))
+{
+    ThrowIfFalse(m_event != nullptr, "Couldn't create event.\n");
+}
+
+WakeEvent::~WakeEvent()
+{
+    ::CloseHandle(m_event);
+}
+
+void WakeEvent::Set()
+{
+    ::SetEvent(m_event);
+}
+
+void WakeEvent::Wait()
+{
+    ::WaitForSingleObject(m_event, INFINITE);
+}
+
+#else
+
+WakeEvent::WakeEvent()
+    : m_set(false)
+{
+}
+
+WakeEvent::~WakeEvent()
+{
+}
+
+void WakeEvent::Set()
+{
+    // Notified under the lock, as the waiter may destroy the event as soon as it sees it set.
+    // Auto-reset, so like a Win32 event it releases a single waiter
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_set = true;
+    m_condition.notify_one();
+}
+
+void WakeEvent::Wait()
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_condition.wait(lock, [this]() { return m_set; });
+    m_set = false;
+}
+
+#endif
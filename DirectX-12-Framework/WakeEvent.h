@@ -0,0 +1,50 @@
+#pragma once
+#if defined (_WIN32)
+#include "Helpers.h"
+#else
+#include <condition_variable>
+#include <mutex>
+#endif
+
+/**
+* An auto-reset event, which a thread can block on until any of several sources sets it, e.g. fences completing and other threads.
+* Setting it while nothing is waiting isn't lost, the next Wait() returns straight away.
+* A Win32 event on Windows, so fences can set it directly. Elsewhere a mutex and condition variable, so the simulated GPU and everything built on it build on any platform.
+*/
+class WakeEvent
+{
+public:
+	WakeEvent();
+	~WakeEvent();
+
+	WakeEvent(const WakeEvent&) = delete;
+	WakeEvent& operator=(const WakeEvent&) = delete;
+
+	/**
+	* Wake the waiting thread. Safe to call from any thread.
+	*/
+	void Set();
+	/**
+	* Block until the event is set, and reset it.
+	*/
+	void Wait();
+
+#if defined (_WIN32)
+	/**
+	* @returns The event, to hand to ID3D12Fence::SetEventOnCompletion()
+	*/
+	HANDLE GetHandle() const
+	{
+		return m_event;
+	}
+#endif
+
+private:
+#if defined (_WIN32)
+	HANDLE m_event;
+#else
+	std::mutex m_mutex;
+	std::condition_variable m_condition;
+	bool m_set;
+#endif
+};
\ No newline at end of file
@@ -0,0 +1,119 @@
+#include "WorkerPool.h"
+#include <utility>
+
+WorkerPool::WorkerPool(uint32_t threadCount)
+    : m_job(nullptr)
+    , m_jobCount(0)
+    , m_nextJob(0)
+    , m_jobsRemaining(0)
+    , m_batch(0)
+    , m_activeWorkers(0)
+    , m_exception()
+    , m_stopping(false)
+{
+    m_threads.reserve(threadCount);
+    for (uint32_t i = 0; i < threadCount; i++)
+    {
+        m_threads.emplace_back(&WorkerPool::WorkerLoop, this);
+    }
+}
+
+WorkerPool::~WorkerPool()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stopping = true;
+    }
+    m_workAvailable.notify_all();
+    for (auto& thread : m_threads)
+    {
+        thread.join();
+    }
+}
+
+void WorkerPool::Run(uint32_t count, const std::function<void(uint32_t)>& job)
+{
+    if (count == 0)
+    {
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_job = &job;
+        m_jobCount = count;
+        m_jobsRemaining = count;
+        m_exception = nullptr;
+        m_nextJob.store(0);
+        m_batch++;
+    }
+    m_workAvailable.notify_all();
+
+    // Rather than sit idle, the calling thread takes jobs too
+    RunJobs();
+
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_workDone.wait(lock, [this] { return m_jobsRemaining == 0 && m_activeWorkers == 0; });
+    m_job = nullptr;
+    if (m_exception)
+    {
+        std::rethrow_exception(std::exchange(m_exception, nullptr));
+    }
+}
+
+void WorkerPool::WorkerLoop()
+{
+    uint64_t batch = 0;
+    for (;;)
+    {
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_workAvailable.wait(lock, [&] { return m_stopping || m_batch != batch; });
+            if (m_stopping)
+            {
+                return;
+            }
+            batch = m_batch;
+            m_activeWorkers++;
+        }
+        RunJobs();
+
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (--m_activeWorkers == 0)
+        {
+            m_workDone.notify_one();
+        }
+    }
+}
+
+void WorkerPool::RunJobs()
+{
+    for (;;)
+    {
+        uint32_t index = m_nextJob.fetch_add(1);
+        if (index >= m_jobCount)
+        {
+            return;
+        }
+
+        try
+        {
+            (*m_job)(index);
+        }
+        catch (...)
+        {
+            // An exception can't cross threads by itself, so keep it for Run() to rethrow
+            std::lock_guard<std::mutex> lock(m_mutex);
+            if (!m_exception)
+            {
+                m_exception = std::current_exception();
+            }
+        }
+
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (--m_jobsRemaining == 0)
+        {
+            m_workDone.notify_one();
+        }
+    }
+}
@@ -0,0 +1,64 @@
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/**
+* A fixed set of worker threads that run a batch of independent jobs in parallel, with the calling thread joining in, e.g. recording one command list per job.
+* Jobs are handed out one at a time from a shared counter, so uneven jobs still balance across threads.
+* Owns no D3D12 objects.
+*/
+class WorkerPool
+{
+public:
+	/**
+	* @param threadCount Number of worker threads besides the thread calling Run(), 0 runs every job on the calling thread
+	*/
+	WorkerPool(uint32_t threadCount);
+	~WorkerPool();
+
+	/**
+	* Run job(i) for every i in [0, count), and return once they've all finished.
+	* If any job throws, the first exception is rethrown here once the rest have finished.
+	* Jobs must not call Run() themselves.
+	*/
+	void Run(uint32_t count, const std::function<void(uint32_t)>& job);
+
+	/**
+	* @returns The number of threads jobs run on, including the calling thread
+	*/
+	uint32_t GetThreadCount() const
+	{
+		return static_cast<uint32_t>(m_threads.size()) + 1;
+	}
+
+private:
+	void WorkerLoop();
+	/** Claim and run jobs from the current batch until there are none left */
+	void RunJobs();
+
+	std::vector<std::thread> m_threads;
+
+	std::mutex m_mutex;
+	std::condition_variable m_workAvailable;
+	std::condition_variable m_workDone;
+
+	/** The batch being run, only valid during Run() */
+	const std::function<void(uint32_t)>* m_job;
+	uint32_t m_jobCount;
+	/** Next job of the batch to be claimed */
+	std::atomic<uint32_t> m_nextJob;
+	/** Jobs of the batch that haven't finished, guarded by m_mutex */
+	uint32_t m_jobsRemaining;
+	/** Bumped each Run(), so a worker can tell a new batch from a spurious wake up */
+	uint64_t m_batch;
+	/** Workers still inside the batch, Run() waits for them so none reads the next batch's state mid-way, guarded by m_mutex */
+	uint32_t m_activeWorkers;
+	std::exception_ptr m_exception;
+	bool m_stopping;
+};
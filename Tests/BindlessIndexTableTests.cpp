@@ -0,0 +1,176 @@
+#include "Test.h"
+#include "BindlessIndexTable.h"
+#include "DescriptorRing.h"
+#include <random>
+#include <unordered_set>
+
+namespace
+{
+    /**
+    * Counts of the calls a frame's draws make, standing in for a command list.
+    */
+    struct CallCounts
+    {
+        uint32_t descriptorTables = 0;
+        uint32_t rootConstants = 0;
+        uint32_t descriptorsCopied = 0;
+
+        uint32_t GetBindingCalls() const
+        {
+            return descriptorTables + rootConstants;
+        }
+    };
+}
+
+TEST(BindlessIndexTableKeepsIndicesAcrossFrames)
+{
+    // Index 0 is reserved for the null descriptor
+    BindlessIndexTable table(3, 1);
+    bool inserted;
+    CHECK(table.Acquire(10, inserted) == 1 && inserted);
+    CHECK(table.Acquire(11, inserted) == 2 && inserted);
+    CHECK(table.Acquire(10, inserted) == 1 && !inserted);
+    table.EndFrame(1);
+
+    // Already resident, so the next frame doesn't copy it again
+    CHECK(table.Acquire(11, inserted) == 2 && !inserted);
+    CHECK(table.GetResidentCount() == 2);
+    CHECK(table.GetEvictionCount() == 0);
+}
+
+TEST(BindlessIndexTableEvictsOnlyCompletedFrames)
+{
+    BindlessIndexTable table(3, 1);
+    bool inserted;
+    table.Acquire(10, inserted);
+    table.Acquire(11, inserted);
+    // Full, and both residents are used by the frame being recorded
+    CHECK(table.Acquire(12, inserted) == BindlessIndexTable::InvalidIndex);
+
+    table.EndFrame(5);
+    table.Retire(4);
+    CHECK(table.Acquire(12, inserted) == BindlessIndexTable::InvalidIndex);
+
+    // Once frame 5 completes, the least recently used resident makes way
+    table.Retire(5);
+    CHECK(table.Acquire(12, inserted) == 1 && inserted);
+    CHECK(table.GetEvictionCount() == 1);
+    CHECK(table.Acquire(10, inserted) == 2 && inserted);
+    CHECK(table.Acquire(13, inserted) == BindlessIndexTable::InvalidIndex);
+}
+
+TEST(BindlessIndexTableNeverEvictsADescriptorTheGpuMayRead)
+{
+    const uint32_t capacity = 64;
+    const uint64_t framesInFlight = 2;
+    BindlessIndexTable table(capacity, 1);
+    std::mt19937 random(1);
+
+    // The frame which last used each index, and the key resident in it
+    std::vector<uint64_t> usedBy(capacity, 0);
+    std::vector<uint32_t> heldKey(capacity, UINT32_MAX);
+    uint32_t full = 0;
+
+    for (uint64_t frame = 1; frame <= 5000; frame++)
+    {
+        uint64_t completed = frame > framesInFlight ? frame - framesInFlight : 0;
+        table.Retire(completed);
+
+        // 30 draws a frame out of 100 textures, more than the region holds
+        for (uint32_t draw = 0; draw < 30; draw++)
+        {
+            uint32_t key = random() % 100;
+            bool inserted;
+            uint32_t index = table.Acquire(key, inserted);
+            if (index == BindlessIndexTable::InvalidIndex)
+            {
+                full++;
+                continue;
+            }
+            CHECK(index != 0 && index < capacity);
+            if (inserted)
+            {
+                // Overwriting the index is only safe once no frame still in flight reads it
+                CHECK(usedBy[index] <= completed);
+                heldKey[index] = key;
+            }
+            CHECK(heldKey[index] == key);
+            usedBy[index] = frame;
+        }
+        table.EndFrame(frame);
+    }
+
+    CHECK(full == 0);
+    CHECK(table.GetEvictionCount() > 0);
+}
+
+TEST(BindlessIndexTableApiCallBenchmark)
+{
+    // A scene of 1000 objects sharing 64 textures, every object drawn every frame, two frames in flight
+    const uint32_t objects = 1000;
+    const uint32_t textures = 64;
+    const uint32_t frames = 100;
+    const uint64_t framesInFlight = 2;
+
+    std::vector<uint32_t> objectTextures(objects);
+    std::mt19937 random(1);
+    for (auto& texture : objectTextures)
+    {
+        texture = random() % textures;
+    }
+
+    // Descriptor tables: each draw sets its texture's table and its constant buffer's, and both are copied from staging each frame
+    CallCounts tables;
+    {
+        DescriptorRing ring(4096);
+        for (uint64_t frame = 1; frame <= frames; frame++)
+        {
+            ring.Retire(frame > framesInFlight ? frame - framesInFlight : 0);
+            std::unordered_set<uint32_t> stagedThisFrame;
+            for (uint32_t object = 0; object < objects; object++)
+            {
+                // A texture drawn twice in a frame shares its copy, a constant buffer is only drawn once
+                if (stagedThisFrame.insert(objectTextures[object]).second)
+                {
+                    CHECK(ring.Allocate() != DescriptorRing::InvalidIndex);
+                    tables.descriptorsCopied++;
+                }
+                CHECK(ring.Allocate() != DescriptorRing::InvalidIndex);
+                tables.descriptorsCopied++;
+                tables.descriptorTables += 2;
+            }
+            ring.EndFrame(frame);
+        }
+    }
+
+    // Bindless: the arrays are set once a list, and each draw passes its indices as one root constants write.
+    // Constants are indexed by object, and a texture is only copied in when it becomes resident
+    CallCounts bindless;
+    {
+        BindlessIndexTable table(512, 1);
+        for (uint64_t frame = 1; frame <= frames; frame++)
+        {
+            table.Retire(frame > framesInFlight ? frame - framesInFlight : 0);
+            bindless.descriptorTables++;
+            for (uint32_t object = 0; object < objects; object++)
+            {
+                bool inserted;
+                CHECK(table.Acquire(objectTextures[object], inserted) != BindlessIndexTable::InvalidIndex);
+                bindless.descriptorsCopied += inserted ? 1 : 0;
+                bindless.rootConstants++;
+            }
+            table.EndFrame(frame);
+        }
+    }
+
+    printf("  %u draws a frame over %u frames, per frame:\n", objects, frames);
+    printf("                descriptor tables  root constants  binding calls  descriptors copied\n");
+    printf("  tables        %17u  %14u  %13u  %18.2f\n",
+        tables.descriptorTables / frames, tables.rootConstants / frames, tables.GetBindingCalls() / frames, double(tables.descriptorsCopied) / frames);
+    printf("  bindless      %17u  %14u  %13u  %18.2f\n",
+        bindless.descriptorTables / frames, bindless.rootConstants / frames, bindless.GetBindingCalls() / frames, double(bindless.descriptorsCopied) / frames);
+
+    CHECK(tables.GetBindingCalls() == 2 * objects * frames);
+    CHECK(bindless.GetBindingCalls() == (objects + 1) * frames);
+    CHECK(bindless.descriptorsCopied == textures);
+}
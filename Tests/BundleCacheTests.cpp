@@ -0,0 +1,173 @@
+#include "Test.h"
+#include "TestDevice.h"
+#include "BundleCache.h"
+#include "Primitive.h"
+
+namespace
+{
+    /**
+    * The cache as CbvSrvUavHeap drives it, recording on one thread and with the GPU keeping up, so every frame completes once the next is recorded.
+    */
+    struct Frames
+    {
+        BundleCache cache;
+        BundleCache::ThreadBundles thread;
+        uint64_t fenceValue = 0;
+
+        Frames(uint32_t maxIdleFrames) :
+            cache(GetTestDevice(), maxIdleFrames)
+        {
+        }
+
+        ID3D12GraphicsCommandList* Draw(const std::shared_ptr<Primitive>& model, UINT textureIndex, UINT objectIndex)
+        {
+            return cache.GetBundle(thread, model, textureIndex, objectIndex);
+        }
+
+        void End(uint64_t completedFenceValue)
+        {
+            cache.Merge(thread);
+            cache.EndFrame(++fenceValue);
+            cache.Retire(completedFenceValue);
+        }
+        void End()
+        {
+            End(fenceValue + 1);
+        }
+    };
+}
+
+TEST(BundleCacheHitsOnlyWhenTheWholeKeyMatches)
+{
+    auto rootSignature = CreateTestRootSignature();
+    auto otherRootSignature = CreateTestRootSignature(1);
+    auto pipelineState = CreateTestPipelineState(rootSignature.Get());
+    auto otherPipelineState = CreateTestPipelineState(rootSignature.Get());
+    auto model = CreateTestModel(pipelineState.Get(), rootSignature.Get());
+    // The same cube, drawn with another pipeline state or root signature
+    auto withOtherPipelineState = CreateTestModel(otherPipelineState.Get(), rootSignature.Get());
+    auto withOtherRootSignature = CreateTestModel(CreateTestPipelineState(otherRootSignature.Get()).Get(), otherRootSignature.Get());
+
+    Frames frames(120);
+    ID3D12GraphicsCommandList* bundle = frames.Draw(model, 1, 0);
+    CHECK(bundle != nullptr);
+    // Found among the thread's own before it's merged, and in the cache after
+    CHECK(frames.Draw(model, 1, 0) == bundle);
+    frames.End();
+    CHECK(frames.Draw(model, 1, 0) == bundle);
+    CHECK(frames.cache.GetLiveCount() == 1);
+
+    // Changing any part of the key records a bundle of its own
+    ID3D12GraphicsCommandList* misses[] = {
+        frames.Draw(model, 1, 1),
+        frames.Draw(model, 2, 0),
+        frames.Draw(withOtherPipelineState, 1, 0),
+        frames.Draw(withOtherRootSignature, 1, 0),
+    };
+    for (UINT i = 0; i < _countof(misses); i++)
+    {
+        CHECK(misses[i] != bundle);
+        for (UINT j = 0; j < i; j++)
+        {
+            CHECK(misses[i] != misses[j]);
+        }
+    }
+    frames.End();
+    CHECK(frames.cache.GetLiveCount() == 5);
+    CHECK(frames.cache.GetStats().recorded == 5);
+    CHECK(frames.cache.GetStats().hits == 2);
+}
+
+TEST(BundleCacheRecordsANewBundleForANewModelOrTexture)
+{
+    // What SceneObject::SetModel() and SetTexture() do to the object's next draw: the model, or the texture's bindless index, changes its key
+    auto rootSignature = CreateTestRootSignature();
+    auto pipelineState = CreateTestPipelineState(rootSignature.Get());
+    auto model = CreateTestModel(pipelineState.Get(), rootSignature.Get());
+    auto newModel = CreateTestModel(pipelineState.Get(), rootSignature.Get());
+
+    Frames frames(120);
+    ID3D12GraphicsCommandList* bundle = frames.Draw(model, 1, 7);
+    frames.End();
+    ID3D12GraphicsCommandList* newModelBundle = frames.Draw(newModel, 1, 7);
+    frames.End();
+    ID3D12GraphicsCommandList* newTextureBundle = frames.Draw(newModel, 3, 7);
+    frames.End();
+    CHECK(newModelBundle != bundle);
+    CHECK(newTextureBundle != bundle && newTextureBundle != newModelBundle);
+    CHECK(frames.cache.GetStats().recorded == 3);
+
+    // Setting the old ones back finds their bundles, as long as they haven't been evicted
+    CHECK(frames.Draw(model, 1, 7) == bundle);
+    frames.End();
+    CHECK(frames.cache.GetStats().recorded == 3);
+
+    // The cache keeps the model alive while a bundle draws it, even once the object has let it go
+    std::weak_ptr<Primitive> oldModel = newModel;
+    newModel.reset();
+    CHECK(!oldModel.expired());
+}
+
+TEST(BundleCacheEvictsBundlesAfter120IdleFrames)
+{
+    auto rootSignature = CreateTestRootSignature();
+    auto pipelineState = CreateTestPipelineState(rootSignature.Get());
+    auto model = CreateTestModel(pipelineState.Get(), rootSignature.Get());
+    auto otherModel = CreateTestModel(pipelineState.Get(), rootSignature.Get());
+    std::weak_ptr<Primitive> idleModel = otherModel;
+
+    Frames frames(120);
+    // Frames 1 and 2 draw both, after which only one keeps drawing. Idle bundles are looked for after frames 1, 121, 241 and so on,
+    // so the other has been idle for 119 frames at the second look, and 239 at the third
+    const uint64_t lastUsedFrame = 2;
+    for (uint64_t frame = 1; frame <= lastUsedFrame; frame++)
+    {
+        frames.Draw(model, 0, 0);
+        frames.Draw(otherModel, 0, 0);
+        frames.End();
+    }
+    otherModel.reset();
+
+    uint64_t evictedFrame = 0;
+    for (uint64_t frame = lastUsedFrame + 1; frame <= 400 && evictedFrame == 0; frame++)
+    {
+        frames.Draw(model, 0, 0);
+        frames.End();
+        if (frames.cache.GetLiveCount() == 1)
+        {
+            evictedFrame = frame;
+        }
+    }
+    // Only released once it's gone 120 frames unused, and within another 120 as idle bundles are only looked for every 120 frames
+    CHECK(evictedFrame - lastUsedFrame >= 120);
+    CHECK(evictedFrame - lastUsedFrame <= 2 * 120);
+    CHECK(frames.cache.GetStats().evicted == 1);
+    // The bundle held the last reference to its model
+    CHECK(idleModel.expired());
+    CHECK(frames.Draw(model, 0, 0) != nullptr);
+    CHECK(frames.cache.GetStats().recorded == 2);
+}
+
+TEST(BundleCacheKeepsIdleBundlesUntilTheirFramesComplete)
+{
+    auto rootSignature = CreateTestRootSignature();
+    auto pipelineState = CreateTestPipelineState(rootSignature.Get());
+    auto model = CreateTestModel(pipelineState.Get(), rootSignature.Get());
+
+    Frames frames(120);
+    frames.Draw(model, 0, 0);
+    // The GPU stalls on frame 1, so however long the bundle goes unused it may still be executing
+    for (uint64_t frame = 1; frame <= 300; frame++)
+    {
+        frames.End(0);
+    }
+    CHECK(frames.cache.GetLiveCount() == 1);
+
+    // Once it catches up the bundle is evicted at the next sweep
+    for (uint64_t frame = 301; frame <= 300 + 120; frame++)
+    {
+        frames.End(frames.fenceValue);
+    }
+    CHECK(frames.cache.GetLiveCount() == 0);
+    CHECK(frames.cache.GetStats().evicted == 1);
+}
@@ -0,0 +1,178 @@
+#include "Test.h"
+#include "CommandAllocatorPool.h"
+#include <algorithm>
+#include <random>
+
+TEST(CommandAllocatorPoolReusesCompletedAllocators)
+{
+    // One list a frame, with the fake fence two submissions behind
+    CommandAllocatorPool pool(4, 3);
+    uint64_t fence = 0;
+    uint64_t completed = 0;
+    bool create;
+    uint64_t wait;
+    std::vector<uint32_t> trimmed;
+
+    for (uint32_t frame = 0; frame < 100; frame++)
+    {
+        uint32_t index = pool.Acquire(completed, create, wait);
+        CHECK(wait == 0);
+        pool.Release(index, ++fence);
+        completed = fence >= 2 ? fence - 2 : 0;
+        pool.EndFrame(completed, trimmed);
+    }
+
+    // Three allocators cover the two in flight and the one recording, the rest of the frames reuse them
+    CHECK(pool.GetStats().created == 3);
+    CHECK(pool.GetStats().reused == 97);
+    CHECK(pool.GetStats().waited == 0);
+    CHECK(pool.GetLiveCount() == 3);
+    CHECK(trimmed.empty());
+}
+
+TEST(CommandAllocatorPoolWaitsAtTheCap)
+{
+    CommandAllocatorPool pool(4, 3);
+    bool create;
+    uint64_t wait;
+    uint64_t fence = 0;
+
+    // Four lists submitted with nothing completed fill the pool
+    uint32_t indices[4];
+    for (auto& index : indices)
+    {
+        index = pool.Acquire(0, create, wait);
+        CHECK(create && wait == 0);
+    }
+    for (auto index : indices)
+    {
+        pool.Release(index, ++fence);
+    }
+
+    // A fifth waits for the oldest submission rather than creating another allocator
+    uint32_t index = pool.Acquire(0, create, wait);
+    CHECK(index == indices[0]);
+    CHECK(!create && wait == 1);
+    CHECK(pool.GetStats().waited == 1);
+    CHECK(pool.GetLiveCount() == 4);
+}
+
+TEST(CommandAllocatorPoolGrowsWhenEveryAllocatorIsRecording)
+{
+    CommandAllocatorPool pool(2, 4);
+    bool create;
+    uint64_t wait;
+
+    // More threads recording at once than the cap, none of which could complete, so waiting would never return
+    for (uint32_t i = 0; i < 5; i++)
+    {
+        CHECK(pool.Acquire(0, create, wait) == i);
+        CHECK(create && wait == 0);
+    }
+    CHECK(pool.GetCapacity() == 5);
+    CHECK(pool.GetLiveCount() == 5);
+    CHECK(pool.GetStats().created == 5);
+
+    // Once they're submitted the cap applies again, waiting rather than growing further
+    for (uint32_t i = 0; i < 5; i++)
+    {
+        pool.Release(i, i + 1);
+    }
+    pool.Acquire(0, create, wait);
+    CHECK(!create && wait == 1);
+    CHECK(pool.GetCapacity() == 5);
+}
+
+TEST(CommandAllocatorPoolTrimsIdleAllocators)
+{
+    CommandAllocatorPool pool(4, 3);
+    bool create;
+    uint64_t wait;
+    uint64_t fence = 0;
+    std::vector<uint32_t> trimmed;
+
+    // A burst of four lists in one frame
+    uint32_t indices[4];
+    for (auto& index : indices)
+    {
+        index = pool.Acquire(fence, create, wait);
+    }
+    for (auto index : indices)
+    {
+        pool.Release(index, ++fence);
+    }
+    pool.EndFrame(fence, trimmed);
+
+    // Then quiet, one list a frame with the GPU keeping up, so the other three go idle and are released
+    for (uint32_t frame = 0; frame < 10; frame++)
+    {
+        uint32_t index = pool.Acquire(fence, create, wait);
+        CHECK(!create && wait == 0);
+        pool.Release(index, ++fence);
+        pool.EndFrame(fence, trimmed);
+    }
+    CHECK(pool.GetLiveCount() == 1);
+    CHECK(pool.GetStats().trimmed == 3);
+    CHECK(trimmed.size() == 3);
+}
+
+TEST(CommandAllocatorPoolLongSession)
+{
+    const uint32_t capacity = 8;
+    const uint32_t maxIdleFrames = 120;
+    CommandAllocatorPool pool(capacity, maxIdleFrames);
+    std::mt19937 random(1);
+
+    // The fence value each allocator was last submitted with, to check none is reset while the GPU may be executing it
+    std::vector<uint64_t> allocatorFences;
+    std::vector<uint32_t> trimmed;
+    uint64_t fence = 0;
+    uint64_t completed = 0;
+    uint32_t earlyResets = 0;
+    uint32_t peakLive = 0;
+
+    for (uint32_t frame = 0; frame < 100000; frame++)
+    {
+        // Usually 2 lists a frame, with an occasional burst of up to the cap, and a fake fence a few submissions behind
+        uint32_t lists = (random() % 500 == 0) ? 2 + random() % (capacity - 1) : 2;
+        std::vector<uint32_t> recording;
+        for (uint32_t list = 0; list < lists; list++)
+        {
+            bool create;
+            uint64_t wait;
+            uint32_t index = pool.Acquire(completed, create, wait);
+            if (index >= allocatorFences.size())
+            {
+                allocatorFences.resize(index + 1, 0);
+            }
+            if (wait)
+            {
+                // The caller waits on the fence, as CommandQueue does
+                completed = std::max(completed, wait);
+            }
+            if (!create && allocatorFences[index] > completed)
+            {
+                earlyResets++;
+            }
+            recording.push_back(index);
+        }
+        for (auto index : recording)
+        {
+            allocatorFences[index] = ++fence;
+            pool.Release(index, fence);
+        }
+        completed = std::max(completed, fence - std::min<uint64_t>(fence, random() % 6));
+        pool.EndFrame(completed, trimmed);
+        peakLive = std::max(peakLive, pool.GetLiveCount());
+    }
+
+    auto& stats = pool.GetStats();
+    printf("  100000 frames: created %llu, reused %llu, waited %llu, trimmed %llu, peak live %u, live %u\n",
+        static_cast<unsigned long long>(stats.created), static_cast<unsigned long long>(stats.reused),
+        static_cast<unsigned long long>(stats.waited), static_cast<unsigned long long>(stats.trimmed), peakLive, pool.GetLiveCount());
+    CHECK(earlyResets == 0);
+    // However many bursts there have been, the pool holds no more than the cap, and only as many as recent frames needed
+    CHECK(peakLive <= capacity);
+    CHECK(pool.GetCapacity() == capacity);
+    CHECK(stats.created - stats.trimmed == pool.GetLiveCount());
+}
@@ -0,0 +1,244 @@
+#include "Test.h"
+#include "ConstantBufferArena.h"
+#include "FrameConstantAllocator.h"
+#include <memory>
+
+using namespace DirectX;
+
+namespace
+{
+    const D3D12_GPU_VIRTUAL_ADDRESS GpuStart = 0x10000;
+
+    /**
+    * Frame constants over ordinary memory, standing in for the mapped upload buffer.
+    */
+    struct CpuFrameConstants
+    {
+        std::vector<UINT8> memory;
+        FrameConstantAllocator allocator;
+
+        CpuFrameConstants(UINT64 capacity) :
+            memory(capacity),
+            allocator(memory.data(), GpuStart, capacity)
+        {
+        }
+
+        /**
+        * @returns Where the CPU wrote what the GPU reads at an address
+        */
+        const XMFLOAT4X4* Read(D3D12_GPU_VIRTUAL_ADDRESS address) const
+        {
+            return reinterpret_cast<const XMFLOAT4X4*>(memory.data() + (address - GpuStart));
+        }
+    };
+
+    bool IsEqual(const XMFLOAT4X4& a, const XMMATRIX& b)
+    {
+        XMFLOAT4X4 stored;
+        XMStoreFloat4x4(&stored, b);
+        return memcmp(&a, &stored, sizeof(stored)) == 0;
+    }
+
+    /**
+    * An object with its own constant buffer, as before the arena: each pass multiplies its world matrix by the view and writes the result to its own mapping.
+    */
+    struct PerObjectConstants
+    {
+        XMFLOAT4X4 world;
+        std::unique_ptr<UINT8[]> constants = std::make_unique<UINT8[]>(D3D12_CONSTANT_BUFFER_DATA_PLACEMENT_ALIGNMENT);
+
+        void Update(const XMMATRIX& viewProjection)
+        {
+            XMStoreFloat4x4(reinterpret_cast<XMFLOAT4X4*>(constants.get()), XMMatrixTranspose(XMLoadFloat4x4(&world) * viewProjection));
+        }
+    };
+}
+
+TEST(ConstantBufferArenaHandsOutLowestSlotsFirst)
+{
+    CpuFrameConstants frameConstants(64 * 1024);
+    ConstantBufferArena arena(&frameConstants.allocator, 4);
+    CHECK(arena.GetSlotCount() == 0);
+
+    UINT slots[4];
+    for (UINT i = 0; i < 4; i++)
+    {
+        slots[i] = arena.Allocate();
+        CHECK(slots[i] == i);
+    }
+    CHECK(arena.GetSlotCount() == 4);
+    CHECK(arena.GetCapacity() == 4);
+
+    arena.Free(slots[1]);
+    CHECK(arena.Allocate() == 1);
+}
+
+TEST(ConstantBufferArenaAddsPagesForMoreObjectsThanItStartedWith)
+{
+    // Ten objects in an arena with room for four, as a scene of more objects than the renderer sized its first page for
+    CpuFrameConstants frameConstants(64 * 1024);
+    ConstantBufferArena arena(&frameConstants.allocator, 4);
+    std::vector<UINT> slots;
+    for (UINT i = 0; i < 10; i++)
+    {
+        slots.push_back(arena.Allocate());
+        CHECK(slots.back() == i);
+        arena.SetWorld(slots.back(), XMMatrixTranslation(float(i), 0.0f, 0.0f));
+    }
+    CHECK(arena.GetCapacity() == 12);
+    CHECK(arena.GetSlotCount() == 10);
+
+    // Every object's world matrix is in the one copy the passes share, including those in later pages
+    arena.UpdateWorlds();
+    auto block = arena.UpdateView(XMMatrixIdentity());
+    CHECK(block.count == 10 && block.Contains(9));
+    const XMFLOAT4X4* worlds = frameConstants.Read(block.objectConstants);
+    for (UINT i = 0; i < 10; i++)
+    {
+        CHECK(IsEqual(worlds[i], XMMatrixTranspose(XMMatrixTranslation(float(i), 0.0f, 0.0f))));
+    }
+
+    // Freed slots in earlier pages are reused before the last page's, and before another page is added
+    arena.Free(slots[1]);
+    arena.Free(slots[9]);
+    CHECK(arena.Allocate() == 1);
+    CHECK(arena.Allocate() == 9);
+    CHECK(arena.Allocate() == 10);
+    CHECK(arena.Allocate() == 11);
+    CHECK(arena.GetCapacity() == 12);
+    CHECK(arena.Allocate() == 12);
+    CHECK(arena.GetCapacity() == 16);
+}
+
+TEST(ConstantBufferArenaWritesNothingWithoutSlots)
+{
+    CpuFrameConstants frameConstants(64 * 1024);
+    ConstantBufferArena arena(&frameConstants.allocator, 4);
+    arena.UpdateWorlds();
+    auto block = arena.UpdateView(XMMatrixIdentity());
+    CHECK(block.IsEmpty());
+    CHECK(!block.Contains(0));
+    // Nothing is bound, so no command list is needed
+    block.Set(nullptr);
+
+    arena.EndFrame();
+    CHECK(arena.GetLastFrameStats().views == 0);
+    CHECK(arena.GetLastFrameStats().bytes == 0);
+    CHECK(frameConstants.allocator.GetFrameUsed() == 0);
+}
+
+TEST(ConstantBufferArenaSharesOneCopyOfTheWorldsBetweenPasses)
+{
+    CpuFrameConstants frameConstants(64 * 1024);
+    ConstantBufferArena arena(&frameConstants.allocator, 8);
+    for (UINT i = 0; i < 3; i++)
+    {
+        arena.SetWorld(arena.Allocate(), XMMatrixTranslation(float(i), 0.0f, 0.0f));
+    }
+    // A freed slot below the highest is still copied, as the identity
+    arena.Free(1);
+
+    XMMATRIX view = XMMatrixTranslation(0.0f, 0.0f, 5.0f);
+    XMMATRIX projection = XMMatrixTranslation(0.0f, 2.0f, 0.0f);
+    arena.UpdateWorlds();
+    auto main = arena.UpdateView(view, projection);
+    auto portal = arena.UpdateView(XMMatrixIdentity());
+
+    CHECK(main.count == 3 && main.Contains(2) && !main.Contains(3));
+    CHECK(main.objectConstants == portal.objectConstants);
+    CHECK(main.viewConstants != portal.viewConstants);
+    CHECK(main.viewConstants % D3D12_CONSTANT_BUFFER_DATA_PLACEMENT_ALIGNMENT == 0);
+
+    const XMFLOAT4X4* worlds = frameConstants.Read(main.objectConstants);
+    CHECK(IsEqual(worlds[0], XMMatrixTranspose(XMMatrixTranslation(0.0f, 0.0f, 0.0f))));
+    CHECK(IsEqual(worlds[1], XMMatrixIdentity()));
+    CHECK(IsEqual(worlds[2], XMMatrixTranspose(XMMatrixTranslation(2.0f, 0.0f, 0.0f))));
+    CHECK(IsEqual(*frameConstants.Read(main.viewConstants), XMMatrixTranspose(view * projection)));
+    CHECK(IsEqual(*frameConstants.Read(portal.viewConstants), XMMatrixIdentity()));
+
+    // Reusing the freed slot keeps within the copy, but a new slot past it has no constants in this frame's blocks
+    CHECK(arena.Allocate() == 1);
+    UINT late = arena.Allocate();
+    CHECK(late == 3 && !main.Contains(late));
+
+    arena.EndFrame();
+    auto& stats = arena.GetLastFrameStats();
+    CHECK(stats.views == 2);
+    CHECK(stats.objects == 3);
+    CHECK(stats.bytes == (3 + 2) * sizeof(XMFLOAT4X4));
+
+    // The counts start again each frame
+    arena.EndFrame();
+    CHECK(arena.GetLastFrameStats().objects == 0);
+}
+
+TEST(ConstantBufferArenaBenchmark)
+{
+    // A frame of three passes, the main view and two portals, each drawing every object
+    const uint32_t passes = 3;
+    const uint32_t framesInFlight = 2;
+    XMMATRIX viewProjections[passes];
+    for (uint32_t pass = 0; pass < passes; pass++)
+    {
+        viewProjections[pass] = XMMatrixTranslation(0.0f, float(pass), 10.0f);
+    }
+
+    printf("  objects  per-object  arena  worlds and views only  (ms a frame)\n");
+    for (uint32_t objectCount : { 1000u, 10000u, 100000u })
+    {
+        uint32_t frames = 1000000 / objectCount;
+
+        std::vector<std::unique_ptr<PerObjectConstants>> objects;
+        for (uint32_t i = 0; i < objectCount; i++)
+        {
+            objects.push_back(std::make_unique<PerObjectConstants>());
+            XMStoreFloat4x4(&objects.back()->world, XMMatrixTranslation(float(i), 0.0f, 0.0f));
+        }
+        Stopwatch perObjectStopwatch;
+        for (uint32_t frame = 0; frame < frames; frame++)
+        {
+            for (auto& viewProjection : viewProjections)
+            {
+                for (auto& object : objects)
+                {
+                    object->Update(viewProjection);
+                }
+            }
+        }
+        double perObject = perObjectStopwatch.GetMilliseconds() / frames;
+
+        CpuFrameConstants frameConstants((framesInFlight + 1) * (UINT64(objectCount) * sizeof(XMFLOAT4X4) + passes * 256 + 256));
+        ConstantBufferArena arena(&frameConstants.allocator, objectCount);
+        std::vector<UINT> slots;
+        for (uint32_t i = 0; i < objectCount; i++)
+        {
+            slots.push_back(arena.Allocate());
+        }
+        double worldsAndViews = 0.0;
+        Stopwatch arenaStopwatch;
+        for (uint64_t frame = 1; frame <= frames; frame++)
+        {
+            frameConstants.allocator.Retire(frame > framesInFlight ? frame - framesInFlight : 0);
+            // Every object moved, so every world matrix is set again
+            for (uint32_t i = 0; i < objectCount; i++)
+            {
+                arena.SetWorld(slots[i], XMLoadFloat4x4(&objects[i]->world));
+            }
+
+            Stopwatch updateStopwatch;
+            arena.UpdateWorlds();
+            for (auto& viewProjection : viewProjections)
+            {
+                CHECK(arena.UpdateView(viewProjection).count == objectCount);
+            }
+            worldsAndViews += updateStopwatch.GetMilliseconds();
+
+            arena.EndFrame();
+            frameConstants.allocator.EndFrame(frame);
+        }
+        double arenaTotal = arenaStopwatch.GetMilliseconds() / frames;
+
+        CHECK(arena.GetLastFrameStats().bytes == (UINT64(objectCount) + passes) * sizeof(XMFLOAT4X4));
+        printf("  %7u  %10.3f  %5.3f  %21.3f\n", objectCount, perObject, arenaTotal, worldsAndViews / frames);
+    }
+}
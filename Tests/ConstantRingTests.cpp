@@ -0,0 +1,172 @@
+#include "Test.h"
+#include "ConstantRing.h"
+#include <algorithm>
+#include <mutex>
+#include <random>
+#include <set>
+#include <thread>
+
+namespace
+{
+    // Constant buffers are placed on 256-byte boundaries
+    const uint64_t Alignment = 256;
+}
+
+TEST(ConstantRingAlignsAndRetiresWholeFrames)
+{
+    // Rounded down to a whole number of alignments
+    ConstantRing ring(1000, Alignment);
+    CHECK(ring.GetCapacity() == 768);
+
+    CHECK(ring.Allocate(1) == 0);
+    CHECK(ring.Allocate(256) == 256);
+    CHECK(ring.GetUsed() == 512);
+    ring.EndFrame(1);
+
+    // 512 bytes needed but only 256 left
+    CHECK(ring.Allocate(300) == ConstantRing::InvalidOffset);
+    CHECK(ring.Allocate(10) == 512);
+    CHECK(ring.Allocate(10) == ConstantRing::InvalidOffset);
+    ring.EndFrame(2);
+    CHECK(ring.GetFrameUsed() == 0);
+
+    CHECK(ring.Retire(1) == 512);
+    CHECK(ring.GetUsed() == 256);
+    // The head is back at the start, so nothing is skipped
+    CHECK(ring.Allocate(300) == 0);
+    ring.EndFrame(3);
+    CHECK(ring.Retire(3) == 256 + 512);
+    CHECK(ring.GetUsed() == 0);
+
+    CHECK(ring.Allocate(0) == ConstantRing::InvalidOffset);
+    CHECK(ring.Allocate(769) == ConstantRing::InvalidOffset);
+}
+
+TEST(ConstantRingSkipsTheEndRatherThanSplitting)
+{
+    ConstantRing ring(1024, Alignment);
+    for (uint32_t i = 0; i < 3; i++)
+    {
+        ring.Allocate(256);
+    }
+    ring.EndFrame(1);
+    ring.Retire(1);
+
+    // 512 bytes don't fit in the last 256, which are charged to the frame and released with it
+    CHECK(ring.Allocate(512) == 0);
+    CHECK(ring.GetFrameUsed() == 256 + 512);
+    ring.EndFrame(2);
+    CHECK(ring.Retire(2) == 768);
+}
+
+TEST(ConstantRingNeverOverwritesConstantsTheGpuMayRead)
+{
+    const uint64_t capacity = 64 * 1024;
+    const uint64_t framesInFlight = 3;
+    ConstantRing ring(capacity, Alignment);
+    std::mt19937 random(1);
+
+    // The frame which last wrote each 256-byte block
+    std::vector<uint64_t> writtenBy(capacity / Alignment, 0);
+    uint64_t completed = 0;
+    uint32_t full = 0;
+
+    for (uint64_t frame = 1; frame <= 10000; frame++)
+    {
+        completed = frame > framesInFlight ? frame - framesInFlight : 0;
+        ring.Retire(completed);
+
+        // Draws of 1 to 4 blocks of constants
+        for (uint32_t draw = random() % 64; draw > 0; draw--)
+        {
+            uint64_t size = (1 + random() % 4) * Alignment - random() % Alignment;
+            uint64_t offset = ring.Allocate(size);
+            if (offset == ConstantRing::InvalidOffset)
+            {
+                full++;
+                continue;
+            }
+            CHECK(offset % Alignment == 0);
+            CHECK(offset + size <= ring.GetCapacity());
+            for (uint64_t block = offset / Alignment; block * Alignment < offset + size; block++)
+            {
+                CHECK(writtenBy[block] <= completed);
+                writtenBy[block] = frame;
+            }
+        }
+        ring.EndFrame(frame);
+    }
+
+    // Sized so busy frames overflow, to check it recovers
+    CHECK(full > 0);
+    ring.Retire(UINT64_MAX);
+    CHECK(ring.GetUsed() == 0);
+}
+
+TEST(ConstantRingAllocatesFromEveryThread)
+{
+    ConstantRing ring(Alignment * 4096, Alignment);
+    uint64_t fence = 0;
+    for (uint32_t frame = 0; frame < 50; frame++)
+    {
+        std::mutex mutex;
+        std::set<uint64_t> offsets;
+        uint32_t overlaps = 0;
+        std::vector<std::thread> threads;
+        for (uint32_t t = 0; t < 8; t++)
+        {
+            threads.emplace_back([&]()
+            {
+                for (uint32_t i = 0; i < 100; i++)
+                {
+                    uint64_t offset = ring.Allocate(200);
+                    std::lock_guard<std::mutex> lock(mutex);
+                    overlaps += (offset == ConstantRing::InvalidOffset || !offsets.insert(offset).second) ? 1 : 0;
+                }
+            });
+        }
+        for (auto& thread : threads)
+        {
+            thread.join();
+        }
+        CHECK(overlaps == 0);
+        CHECK(ring.GetFrameUsed() == 800 * Alignment);
+        ring.EndFrame(++fence);
+        ring.Retire(fence > 2 ? fence - 2 : 0);
+    }
+}
+
+TEST(ConstantRingBenchmark)
+{
+    // A 10k-draw frame's constants, each 256 bytes, from one thread and shared between four
+    const uint32_t draws = 10000;
+    const uint32_t frames = 200;
+    printf("  threads  ns per allocation\n");
+    for (uint32_t threadCount : { 1u, 4u })
+    {
+        ConstantRing ring(uint64_t(Alignment) * draws * 3, Alignment);
+        Stopwatch stopwatch;
+        for (uint64_t frame = 1; frame <= frames; frame++)
+        {
+            ring.Retire(frame > 2 ? frame - 2 : 0);
+            std::vector<std::thread> threads;
+            for (uint32_t t = 0; t < threadCount; t++)
+            {
+                threads.emplace_back([&]()
+                {
+                    for (uint32_t draw = 0; draw < draws / threadCount; draw++)
+                    {
+                        ring.Allocate(Alignment);
+                    }
+                });
+            }
+            for (auto& thread : threads)
+            {
+                thread.join();
+            }
+            CHECK(ring.GetFrameUsed() == uint64_t(Alignment) * draws);
+            ring.EndFrame(frame);
+        }
+        printf("  %7u  %17.1f\n", threadCount, stopwatch.GetMilliseconds() * 1e6 / (double(draws) * frames));
+    }
+}
@@ -0,0 +1,135 @@
+#include "Test.h"
+#include "DeferredFreeQueue.h"
+#include "DescriptorAllocator.h"
+#include "DescriptorRangeAllocator.h"
+#include <algorithm>
+#include <random>
+#include <thread>
+
+TEST(DeferredFreeQueueRetiresOnlyCompletedFrees)
+{
+    DeferredFreeQueue queue;
+    queue.Push(3, 1, 1);
+    queue.Push(8, 4, 2);
+    queue.Push(5, 1, 2);
+    queue.Push(1, 1, 4);
+    CHECK(queue.GetPendingCount() == 4);
+
+    std::vector<DeferredFreeQueue::Entry> released;
+    auto release = [&](const DeferredFreeQueue::Entry& entry) { released.push_back(entry); };
+    CHECK(queue.Retire(0, release) == 0);
+    CHECK(queue.Retire(1, release) == 1);
+    CHECK(queue.Retire(3, release) == 2);
+    CHECK(queue.GetPendingCount() == 1);
+
+    // Handed back oldest first, with the range intact
+    CHECK(released.size() == 3);
+    CHECK(released[0].offset == 3 && released[0].count == 1);
+    CHECK(released[1].offset == 8 && released[1].count == 4 && released[1].fenceValue == 2);
+    CHECK(released[2].offset == 5);
+
+    CHECK(queue.Retire(4, release) == 1);
+    CHECK(queue.GetPendingCount() == 0);
+}
+
+TEST(DeferredFreeQueueNeverReleasesADescriptorTheGpuMayRead)
+{
+    const uint32_t capacity = 128;
+    const uint64_t framesInFlight = 3;
+    DescriptorAllocator allocator(capacity);
+    DeferredFreeQueue queue;
+    std::mt19937 random(1);
+
+    // The fence value each slot was last freed with, 0 if never
+    std::vector<uint64_t> freedAt(capacity, 0);
+    std::vector<uint32_t> live;
+    uint64_t completed = 0;
+    uint32_t earlyReleases = 0;
+    uint32_t reuses = 0;
+
+    for (uint64_t frame = 1; frame <= 20000; frame++)
+    {
+        // The simulated fence completes frames in order, framesInFlight or one more behind the frame being recorded
+        if (frame > framesInFlight + 1)
+        {
+            completed = std::max(completed, frame - framesInFlight - random() % 2);
+        }
+        queue.Retire(completed, [&](const DeferredFreeQueue::Entry& entry)
+        {
+            earlyReleases += entry.fenceValue > completed ? 1 : 0;
+            allocator.Free(entry.offset);
+        });
+
+        // Objects created and destroyed by the editor. Anything destroyed was drawn by this frame, so is tagged with its fence value
+        for (uint32_t i = random() % 4; i > 0; i--)
+        {
+            uint32_t index = allocator.Allocate();
+            if (index != DescriptorAllocator::InvalidIndex)
+            {
+                reuses += freedAt[index] != 0 ? 1 : 0;
+                CHECK(freedAt[index] <= completed);
+                live.push_back(index);
+            }
+        }
+        for (uint32_t i = random() % 4; i > 0 && !live.empty(); i--)
+        {
+            size_t pick = random() % live.size();
+            uint32_t index = live[pick];
+            live[pick] = live.back();
+            live.pop_back();
+            freedAt[index] = frame;
+            queue.Push(index, 1, frame);
+        }
+    }
+
+    CHECK(earlyReleases == 0);
+    // The heap is small enough that slots must have been recycled for the test to mean anything
+    CHECK(reuses > 1000);
+    queue.Retire(UINT64_MAX, [&](const DeferredFreeQueue::Entry& entry) { allocator.Free(entry.offset); });
+    CHECK(allocator.GetAllocatedCount() == live.size());
+}
+
+TEST(DeferredFreeQueueReturnsRangesToTheirAllocator)
+{
+    DescriptorRangeAllocator allocator(16);
+    DeferredFreeQueue queue;
+    uint32_t table = allocator.Allocate(16);
+    queue.Push(table, 16, 5);
+
+    // Until the fence passes 5 the table's descriptors can't be handed out again
+    queue.Retire(4, [&](const DeferredFreeQueue::Entry& entry) { allocator.Free(entry.offset, entry.count); });
+    CHECK(allocator.Allocate(1) == DescriptorRangeAllocator::InvalidIndex);
+    queue.Retire(5, [&](const DeferredFreeQueue::Entry& entry) { allocator.Free(entry.offset, entry.count); });
+    CHECK(allocator.GetLargestFreeRange() == 16);
+}
+
+TEST(DeferredFreeQueueAcceptsFreesFromEveryThread)
+{
+    DeferredFreeQueue queue;
+    const uint32_t threadCount = 4;
+    const uint32_t freesPerThread = 10000;
+
+    std::vector<std::thread> threads;
+    for (uint32_t t = 0; t < threadCount; t++)
+    {
+        threads.emplace_back([&, t]()
+        {
+            for (uint32_t i = 0; i < freesPerThread; i++)
+            {
+                queue.Push(t * freesPerThread + i, 1, 1);
+            }
+        });
+    }
+    // Retiring while other threads are still freeing
+    uint32_t retired = 0;
+    while (retired < threadCount * freesPerThread / 2)
+    {
+        retired += queue.Retire(1, [](const DeferredFreeQueue::Entry&) {});
+    }
+    for (auto& thread : threads)
+    {
+        thread.join();
+    }
+    retired += queue.Retire(1, [](const DeferredFreeQueue::Entry&) {});
+    CHECK(retired == threadCount * freesPerThread);
+}
@@ -0,0 +1,208 @@
+#include "Test.h"
+#include "DescriptorAllocator.h"
+#include <memory>
+#include <mutex>
+#include <queue>
+#include <thread>
+
+namespace
+{
+    // Stand-ins for a heap's CPU start and descriptor increment, so slots become handles the way DescriptorHeap makes them
+    const uint64_t FakeHeapStart = 0x100000000;
+    const uint64_t FakeIncrement = 32;
+
+    uint64_t GetFakeHandle(uint32_t index)
+    {
+        return FakeHeapStart + index * FakeIncrement;
+    }
+
+    /**
+    * The allocator DescriptorHeap had before, a bump offset and a queue of freed slots, behind a mutex so threads can share it.
+    * The benchmark's baseline.
+    */
+    class LockedAllocator
+    {
+    public:
+        LockedAllocator(uint32_t capacity) : m_capacity(capacity), m_next(0) {}
+
+        uint32_t Allocate()
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            if (!m_free.empty())
+            {
+                uint32_t index = m_free.front();
+                m_free.pop();
+                return index;
+            }
+            return m_next < m_capacity ? m_next++ : DescriptorAllocator::InvalidIndex;
+        }
+
+        void Free(uint32_t index)
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_free.push(index);
+        }
+
+    private:
+        const uint32_t m_capacity;
+        uint32_t m_next;
+        std::queue<uint32_t> m_free;
+        std::mutex m_mutex;
+    };
+
+    /**
+    * Each thread repeatedly allocates a batch of descriptors, as an editor action creating objects would, then frees them.
+    * @returns Nanoseconds per allocate and free pair, across every thread
+    */
+    template <typename Allocator>
+    double RunChurn(Allocator& allocator, uint32_t threadCount, uint32_t cyclesPerThread)
+    {
+        const uint32_t batch = 16;
+        Stopwatch stopwatch;
+        std::vector<std::thread> threads;
+        for (uint32_t t = 0; t < threadCount; t++)
+        {
+            threads.emplace_back([&]()
+            {
+                uint32_t held[batch];
+                for (uint32_t cycle = 0; cycle < cyclesPerThread / batch; cycle++)
+                {
+                    for (auto& index : held)
+                    {
+                        index = allocator.Allocate();
+                    }
+                    for (auto index : held)
+                    {
+                        allocator.Free(index);
+                    }
+                }
+            });
+        }
+        for (auto& thread : threads)
+        {
+            thread.join();
+        }
+        return stopwatch.GetMilliseconds() * 1e6 / (double(threadCount) * cyclesPerThread);
+    }
+}
+
+TEST(DescriptorAllocatorFillsFromStartAndStopsAtCapacity)
+{
+    // The CBV/SRV/UAV heap's size
+    DescriptorAllocator allocator(1024);
+    for (uint32_t i = 0; i < 1024; i++)
+    {
+        CHECK(allocator.Allocate() == i);
+    }
+    CHECK(allocator.GetAllocatedCount() == 1024);
+    CHECK(allocator.Allocate() == DescriptorAllocator::InvalidIndex);
+
+    allocator.Free(7);
+    CHECK(allocator.Allocate() == 7);
+    CHECK(allocator.Allocate() == DescriptorAllocator::InvalidIndex);
+
+    DescriptorAllocator empty(0);
+    CHECK(empty.Allocate() == DescriptorAllocator::InvalidIndex);
+}
+
+TEST(DescriptorAllocatorHeapsAreIndependent)
+{
+    // Each heap counts from its own start, rather than sharing one offset
+    DescriptorAllocator cbvSrvUav(1024);
+    DescriptorAllocator rtv(8);
+    CHECK(cbvSrvUav.Allocate() == 0);
+    CHECK(cbvSrvUav.Allocate() == 1);
+    CHECK(rtv.Allocate() == 0);
+    for (uint32_t i = 1; i < 8; i++)
+    {
+        rtv.Allocate();
+    }
+    CHECK(rtv.Allocate() == DescriptorAllocator::InvalidIndex);
+    CHECK(cbvSrvUav.Allocate() == 2);
+}
+
+TEST(DescriptorAllocatorNeverHandsOutAHandleTwice)
+{
+    const uint32_t capacity = 256;
+    const uint32_t threadCount = 8;
+    DescriptorAllocator allocator(capacity);
+
+    // Which thread holds each fake handle, 0 if none. A thread claiming a handle another holds is a double allocation
+    auto owners = std::make_unique<std::atomic<uint32_t>[]>(capacity);
+    std::atomic<uint32_t> doubleAllocations = 0;
+    std::atomic<uint32_t> invalidHandles = 0;
+
+    std::vector<std::thread> threads;
+    for (uint32_t t = 0; t < threadCount; t++)
+    {
+        threads.emplace_back([&, owner = t + 1]()
+        {
+            std::vector<uint32_t> held;
+            for (uint32_t i = 0; i < 200000; i++)
+            {
+                // Hold up to 48 at once, so together the threads sometimes exhaust the heap
+                if (held.size() < 48 && (i % 3) != 2)
+                {
+                    uint32_t index = allocator.Allocate();
+                    if (index == DescriptorAllocator::InvalidIndex)
+                    {
+                        continue;
+                    }
+                    uint64_t handle = GetFakeHandle(index);
+                    if (handle < FakeHeapStart || handle >= GetFakeHandle(capacity))
+                    {
+                        invalidHandles++;
+                        continue;
+                    }
+                    uint32_t expected = 0;
+                    if (!owners[index].compare_exchange_strong(expected, owner))
+                    {
+                        doubleAllocations++;
+                    }
+                    held.push_back(index);
+                }
+                else if (!held.empty())
+                {
+                    uint32_t index = held.back();
+                    held.pop_back();
+                    owners[index].store(0);
+                    allocator.Free(index);
+                }
+            }
+            for (auto index : held)
+            {
+                owners[index].store(0);
+                allocator.Free(index);
+            }
+        });
+    }
+    for (auto& thread : threads)
+    {
+        thread.join();
+    }
+
+    CHECK(doubleAllocations == 0);
+    CHECK(invalidHandles == 0);
+    CHECK(allocator.GetAllocatedCount() == 0);
+    // Every slot made it back to the free stack
+    for (uint32_t i = 0; i < capacity; i++)
+    {
+        CHECK(allocator.Allocate() != DescriptorAllocator::InvalidIndex);
+    }
+    CHECK(allocator.Allocate() == DescriptorAllocator::InvalidIndex);
+}
+
+TEST(DescriptorAllocatorBenchmark)
+{
+    const uint32_t cyclesPerThread = 1 << 20;
+    printf("  threads  lock-free ns/op  locked ns/op\n");
+    for (uint32_t threadCount : { 1u, 2u, 4u, 8u })
+    {
+        DescriptorAllocator allocator(1024);
+        LockedAllocator locked(1024);
+        double lockFree = RunChurn(allocator, threadCount, cyclesPerThread);
+        double baseline = RunChurn(locked, threadCount, cyclesPerThread);
+        printf("  %7u  %15.1f  %12.1f\n", threadCount, lockFree, baseline);
+        CHECK(allocator.GetAllocatedCount() == 0);
+    }
+}
@@ -0,0 +1,44 @@
+#include "Test.h"
+#include "DescriptorHeapStats.h"
+
+TEST(DescriptorHeapStatsTagsTheFrameWithItsFence)
+{
+    DescriptorHeapStats stats;
+    stats.RecordAllocation(1, 100);
+    stats.RecordAllocation(2, 100);
+    stats.RecordFree();
+    stats.EndFrame(7);
+
+    DescriptorHeapSnapshot snapshot;
+    stats.Fill(snapshot);
+    CHECK(snapshot.lastFrameFenceValue == 7);
+    CHECK(snapshot.allocationsLastFrame == 2);
+    CHECK(snapshot.freesLastFrame == 1);
+    CHECK(snapshot.highWater == 2);
+
+    // The next frame's counts are tagged with the next fence, whatever it recorded
+    stats.EndFrame(8);
+    stats.Fill(snapshot);
+    CHECK(snapshot.lastFrameFenceValue == 8);
+    CHECK(snapshot.allocationsLastFrame == 0);
+    CHECK(snapshot.totalAllocations == 2);
+}
+
+TEST(DescriptorHeapStatsExportsJson)
+{
+    DescriptorHeapStats stats;
+    stats.EndFrame(3);
+    // Heaps are named after what they hold, which can be anything
+    DescriptorHeapSnapshot named;
+    named.name = "Heap \"A\"\\\n";
+    stats.Fill(named);
+    DescriptorHeapSnapshot plain;
+    plain.name = "B";
+    std::vector<DescriptorHeapSnapshot> snapshots = { named, plain };
+
+    std::string json = DescriptorHeapStats::ToJson(snapshots);
+    CHECK(json.find("\"name\": \"Heap \\\"A\\\"\\\\\\u000a\"") != std::string::npos);
+    CHECK(json.find("\"lastFrameFenceValue\": 3") != std::string::npos);
+    CHECK(json.find("\"name\": \"B\"") != std::string::npos);
+    CHECK(json.front() == '[' && json.find(']', json.rfind('}')) != std::string::npos);
+}
@@ -0,0 +1,121 @@
+#include "Test.h"
+#include "DescriptorRangeAllocator.h"
+#include <algorithm>
+#include <random>
+#include <utility>
+
+TEST(DescriptorRangeAllocatorCoalescesFreedNeighbours)
+{
+    DescriptorRangeAllocator allocator(16);
+    uint32_t a = allocator.Allocate(4);
+    uint32_t b = allocator.Allocate(4);
+    uint32_t c = allocator.Allocate(4);
+    CHECK(a == 0 && b == 4 && c == 8);
+    CHECK(allocator.GetFreeCount() == 4);
+    CHECK(allocator.GetFragmentation() == 0.0f);
+
+    // Freeing a and c leaves two free ranges, a's and c's merged with the tail, with 12 free but no more than 8 in a row
+    allocator.Free(a, 4);
+    allocator.Free(c, 4);
+    CHECK(allocator.GetFreeRangeCount() == 2);
+    CHECK(allocator.GetLargestFreeRange() == 8);
+    CHECK(allocator.GetFragmentation() == 1.0f - 8.0f / 12.0f);
+    CHECK(allocator.Allocate(9) == DescriptorRangeAllocator::InvalidIndex);
+
+    // b joins both neighbours into one range covering the whole heap
+    allocator.Free(b, 4);
+    CHECK(allocator.GetFreeRangeCount() == 1);
+    CHECK(allocator.GetLargestFreeRange() == 16);
+    CHECK(allocator.Allocate(16) == 0);
+    CHECK(allocator.Allocate(1) == DescriptorRangeAllocator::InvalidIndex);
+}
+
+TEST(DescriptorRangeAllocatorPicksTheSmallestRangeThatFits)
+{
+    DescriptorRangeAllocator allocator(32);
+    uint32_t a = allocator.Allocate(8);
+    allocator.Allocate(1);
+    uint32_t b = allocator.Allocate(3);
+    allocator.Allocate(1);
+    allocator.Free(a, 8);
+    allocator.Free(b, 3);
+
+    // The 3-descriptor hole is used before the 8-descriptor one or the tail
+    CHECK(allocator.Allocate(2) == b);
+    CHECK(allocator.Allocate(6) == a);
+}
+
+TEST(DescriptorRangeAllocatorChurnBenchmark)
+{
+    const uint32_t capacity = 4096;
+    const uint32_t cycles = 1000000;
+    DescriptorRangeAllocator allocator(capacity);
+    std::mt19937 random(1);
+
+    // Tables of 1 to 8 descriptors, as a material's textures and constants would be
+    std::vector<std::pair<uint32_t, uint32_t>> live;
+    std::vector<bool> used(capacity, false);
+    uint32_t overlaps = 0;
+    uint32_t failures = 0;
+    double fragmentationSum = 0.0;
+    float fragmentationMax = 0.0f;
+    uint32_t samples = 0;
+
+    Stopwatch stopwatch;
+    for (uint32_t cycle = 0; cycle < cycles; cycle++)
+    {
+        // Hover between a quarter and half full, so allocation and freeing are interleaved throughout
+        bool allocate = live.empty() || (random() % 2 == 0 && allocator.GetFreeCount() > capacity / 2) || allocator.GetFreeCount() > capacity * 3 / 4;
+        if (allocate)
+        {
+            uint32_t count = 1 + random() % 8;
+            uint32_t offset = allocator.Allocate(count);
+            if (offset == DescriptorRangeAllocator::InvalidIndex)
+            {
+                failures++;
+                continue;
+            }
+            for (uint32_t i = offset; i < offset + count; i++)
+            {
+                overlaps += used[i] ? 1 : 0;
+                used[i] = true;
+            }
+            live.emplace_back(offset, count);
+        }
+        else
+        {
+            size_t index = random() % live.size();
+            auto range = live[index];
+            live[index] = live.back();
+            live.pop_back();
+            for (uint32_t i = range.first; i < range.first + range.second; i++)
+            {
+                used[i] = false;
+            }
+            allocator.Free(range.first, range.second);
+        }
+
+        if (cycle % 1000 == 999)
+        {
+            float fragmentation = allocator.GetFragmentation();
+            fragmentationSum += fragmentation;
+            fragmentationMax = std::max(fragmentationMax, fragmentation);
+            samples++;
+        }
+    }
+    double milliseconds = stopwatch.GetMilliseconds();
+
+    printf("  %u cycles in %.1f ms, %.1f ns per cycle\n", cycles, milliseconds, milliseconds * 1e6 / cycles);
+    printf("  fragmentation: final %.3f, mean %.3f, max %.3f\n", allocator.GetFragmentation(), fragmentationSum / samples, fragmentationMax);
+    printf("  final: %u live tables, %u free in %u ranges, largest %u, %u failed allocations\n",
+        static_cast<uint32_t>(live.size()), allocator.GetFreeCount(), allocator.GetFreeRangeCount(), allocator.GetLargestFreeRange(), failures);
+    CHECK(overlaps == 0);
+
+    // Once everything is freed, coalescing leaves the heap as one range again
+    for (auto& range : live)
+    {
+        allocator.Free(range.first, range.second);
+    }
+    CHECK(allocator.GetFreeRangeCount() == 1);
+    CHECK(allocator.GetLargestFreeRange() == capacity);
+}
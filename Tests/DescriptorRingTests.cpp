@@ -0,0 +1,100 @@
+#include "Test.h"
+#include "DescriptorRing.h"
+#include <algorithm>
+#include <random>
+
+TEST(DescriptorRingWrapsOnlyOnceFramesRetire)
+{
+    DescriptorRing ring(10);
+    for (uint32_t i = 0; i < 4; i++)
+    {
+        CHECK(ring.Allocate() == i);
+    }
+    ring.EndFrame(1);
+    CHECK(ring.Allocate(4) == 4);
+    ring.EndFrame(2);
+
+    // Two slots left at the end, too few for a table of three, and wrapping would overwrite frame 1
+    CHECK(ring.Allocate(3) == DescriptorRing::InvalidIndex);
+    CHECK(ring.Retire(0) == 0);
+    CHECK(ring.Retire(1) == 4);
+    // The table can't straddle the end, so the last two slots are skipped and charged to this frame
+    CHECK(ring.Allocate(3) == 0);
+    CHECK(ring.GetFrameUsed() == 5);
+    CHECK(ring.GetUsed() == 4 + 5);
+
+    ring.EndFrame(3);
+    CHECK(ring.Retire(3) == 9);
+    CHECK(ring.GetUsed() == 0);
+    CHECK(ring.Allocate(11) == DescriptorRing::InvalidIndex);
+    CHECK(ring.Allocate(0) == DescriptorRing::InvalidIndex);
+}
+
+TEST(DescriptorRingNeverReusesSlotsTheGpuMayRead)
+{
+    const uint32_t capacity = 256;
+    const uint32_t framesInFlight = 3;
+    DescriptorRing ring(capacity);
+
+    // The fence value of the frame which last wrote each slot. A slot can be reused once the simulated fence has passed it
+    std::vector<uint64_t> writtenBy(capacity, 0);
+    uint64_t completed = 0;
+    uint32_t full = 0;
+    std::mt19937 random(1);
+
+    for (uint64_t frame = 1; frame <= 10000; frame++)
+    {
+        // The simulated GPU lags the CPU by up to framesInFlight frames, and completes frames in order
+        if (frame > framesInFlight)
+        {
+            completed = frame - framesInFlight;
+        }
+        ring.Retire(completed);
+
+        // Draws visible this frame, each with a table of one or two descriptors
+        uint32_t draws = random() % 60;
+        for (uint32_t draw = 0; draw < draws; draw++)
+        {
+            uint32_t count = 1 + random() % 2;
+            uint32_t offset = ring.Allocate(count);
+            if (offset == DescriptorRing::InvalidIndex)
+            {
+                full++;
+                continue;
+            }
+            for (uint32_t slot = offset; slot < offset + count; slot++)
+            {
+                CHECK(writtenBy[slot] <= completed);
+                writtenBy[slot] = frame;
+            }
+        }
+        ring.EndFrame(frame);
+        CHECK(ring.GetUsed() <= capacity);
+    }
+
+    // At most 59 draws of 2 over 4 frames can outgrow the ring, so it should have filled sometimes and recovered
+    CHECK(full > 0);
+    ring.Retire(10000);
+    CHECK(ring.GetUsed() == 0);
+}
+
+TEST(DescriptorRingCostFollowsVisibleDraws)
+{
+    // 10k objects but only 100 drawn, the ring holds 100 descriptors a frame rather than one per object
+    DescriptorRing ring(1024);
+    const uint32_t visible = 100;
+    uint32_t peak = 0;
+    for (uint64_t frame = 1; frame <= 100; frame++)
+    {
+        ring.Retire(frame > 2 ? frame - 2 : 0);
+        for (uint32_t draw = 0; draw < visible; draw++)
+        {
+            CHECK(ring.Allocate() != DescriptorRing::InvalidIndex);
+        }
+        CHECK(ring.GetFrameUsed() == visible);
+        peak = std::max(peak, ring.GetUsed());
+        ring.EndFrame(frame);
+    }
+    printf("  %u visible draws, 2 frames behind: peak %u descriptors\n", visible, peak);
+    CHECK(peak <= 3 * visible);
+}
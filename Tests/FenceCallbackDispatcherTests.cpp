@@ -0,0 +1,212 @@
+#include "Test.h"
+#include "FenceCallbackDispatcher.h"
+#include "SimulatedTimeline.h"
+#include <algorithm>
+#include <memory>
+#include <thread>
+
+using namespace std::chrono;
+
+namespace
+{
+    /**
+    * Wait, up to a timeout, for the dispatcher thread to have run a number of callbacks.
+    * @returns true if it did
+    */
+    bool WaitForDispatched(const FenceCallbackDispatcher& dispatcher, uint64_t count)
+    {
+        auto deadline = steady_clock::now() + seconds(10);
+        while (dispatcher.GetDispatchedCount() < count)
+        {
+            if (steady_clock::now() > deadline)
+            {
+                return false;
+            }
+            std::this_thread::sleep_for(milliseconds(1));
+        }
+        return true;
+    }
+}
+
+TEST(FenceCallbackDispatcherRunsCallbacksOnceReached)
+{
+    SimulatedTimeline timeline;
+    FenceCallbackDispatcher dispatcher;
+    std::atomic<bool> ran = false;
+
+    timeline.Submit(milliseconds(20));
+    uint64_t value = timeline.Signal();
+    dispatcher.OnFenceComplete(timeline, value, [&]() { ran = timeline.IsComplete(value); });
+    std::this_thread::sleep_for(milliseconds(5));
+    CHECK(!ran);
+
+    timeline.WaitForValue(value);
+    CHECK(WaitForDispatched(dispatcher, 1));
+    CHECK(ran);
+
+    // Already reached, so it runs straight away
+    dispatcher.OnFenceComplete(timeline, value, []() {});
+    CHECK(WaitForDispatched(dispatcher, 2));
+}
+
+TEST(FenceCallbackDispatcherKeepsRegistrationOrderForOneValue)
+{
+    SimulatedTimeline timeline;
+    std::vector<uint32_t> order;
+    {
+        FenceCallbackDispatcher dispatcher;
+        timeline.Submit(milliseconds(5));
+        uint64_t value = timeline.Signal();
+        for (uint32_t i = 0; i < 100; i++)
+        {
+            // Only the dispatcher thread touches order
+            dispatcher.OnFenceComplete(timeline, value, [&order, i]() { order.push_back(i); });
+        }
+        timeline.Flush();
+        CHECK(WaitForDispatched(dispatcher, 100));
+    }
+    CHECK(order.size() == 100);
+    for (uint32_t i = 0; i < order.size(); i++)
+    {
+        CHECK(order[i] == i);
+    }
+}
+
+TEST(FenceCallbackDispatcherDropsUnreachedCallbacksOnDestruction)
+{
+    SimulatedTimeline timeline;
+    bool ran = false;
+    {
+        FenceCallbackDispatcher dispatcher;
+        dispatcher.OnFenceComplete(timeline, 1000, [&]() { ran = true; });
+        std::this_thread::sleep_for(milliseconds(5));
+    }
+    CHECK(!ran);
+}
+
+TEST(FenceCallbackDispatcherServesEveryTimeline)
+{
+    // The graphics, copy and a third queue, as Renderer shares one dispatcher between its queues
+    SimulatedTimeline timelines[3];
+    std::atomic<uint32_t> ran = 0;
+    std::atomic<uint32_t> early = 0;
+    {
+        FenceCallbackDispatcher dispatcher;
+        for (uint32_t i = 0; i < 300; i++)
+        {
+            SimulatedTimeline& timeline = timelines[i % 3];
+            timeline.Submit(microseconds(100 * (1 + i % 3)));
+            uint64_t value = timeline.Signal();
+            dispatcher.OnFenceComplete(timeline, value, [&, value, timeline = &timeline]()
+            {
+                early += timeline->IsComplete(value) ? 0 : 1;
+                ran++;
+            });
+        }
+        for (auto& timeline : timelines)
+        {
+            timeline.Flush();
+        }
+        CHECK(WaitForDispatched(dispatcher, 300));
+    }
+    CHECK(ran == 300);
+    CHECK(early == 0);
+}
+
+TEST(FenceCallbackDispatcherStress)
+{
+    const uint32_t threadCount = 8;
+    const uint32_t callbacksPerThread = 5000;
+    const uint32_t total = threadCount * callbacksPerThread;
+    SimulatedTimeline timeline;
+    auto runs = std::make_unique<std::atomic<uint32_t>[]>(total);
+    std::atomic<uint32_t> early = 0;
+    std::atomic<uint32_t> nested = 0;
+
+    {
+        FenceCallbackDispatcher dispatcher;
+
+        // The GPU keeps signalling while every thread registers callbacks for values just past the one reached
+        std::thread gpu([&]()
+        {
+            for (uint32_t i = 0; i < 2000; i++)
+            {
+                timeline.Submit(microseconds(20));
+                timeline.Signal();
+                std::this_thread::sleep_for(microseconds(10));
+            }
+        });
+
+        Stopwatch stopwatch;
+        std::vector<std::thread> threads;
+        for (uint32_t t = 0; t < threadCount; t++)
+        {
+            threads.emplace_back([&, t]()
+            {
+                for (uint32_t i = 0; i < callbacksPerThread; i++)
+                {
+                    uint32_t id = t * callbacksPerThread + i;
+                    uint64_t value = timeline.GetCompletedValue() + i % 7;
+                    dispatcher.OnFenceComplete(timeline, value, [&, id, value]()
+                    {
+                        early += timeline.IsComplete(value) ? 0 : 1;
+                        runs[id]++;
+                        // Callbacks can register callbacks, i.e. a readback starting the next
+                        if (id % 1000 == 0)
+                        {
+                            dispatcher.OnFenceComplete(timeline, value, [&]() { nested++; });
+                        }
+                    });
+                }
+            });
+        }
+        for (auto& thread : threads)
+        {
+            thread.join();
+        }
+        double registering = stopwatch.GetMilliseconds();
+        gpu.join();
+        timeline.Flush();
+
+        uint32_t nestedCount = total / 1000;
+        CHECK(WaitForDispatched(dispatcher, total + nestedCount));
+        CHECK(dispatcher.GetRegisteredCount() == total + nestedCount);
+        printf("  %u callbacks from %u threads, registered in %.1f ms while the GPU signalled\n", total, threadCount, registering);
+    }
+
+    uint32_t wrongRuns = 0;
+    for (uint32_t id = 0; id < total; id++)
+    {
+        wrongRuns += runs[id] != 1 ? 1 : 0;
+    }
+    CHECK(wrongRuns == 0);
+    CHECK(early == 0);
+    CHECK(nested == total / 1000);
+}
+
+TEST(FenceCallbackDispatcherLatencyBenchmark)
+{
+    // How long after a fence completes its callback runs, compared with a thread blocked on the same value waking
+    SimulatedTimeline timeline;
+    FenceCallbackDispatcher dispatcher;
+    std::vector<double> latencies;
+
+    for (uint32_t i = 0; i < 2000; i++)
+    {
+        timeline.Submit(microseconds(100));
+        uint64_t value = timeline.Signal();
+        std::atomic<int64_t> ranAt = 0;
+        dispatcher.OnFenceComplete(timeline, value, [&]() { ranAt = steady_clock::now().time_since_epoch().count(); });
+
+        timeline.WaitForValue(value);
+        int64_t wokeAt = steady_clock::now().time_since_epoch().count();
+        while (ranAt == 0)
+        {
+            std::this_thread::yield();
+        }
+        latencies.push_back(duration<double, std::micro>(steady_clock::duration(ranAt - wokeAt)).count());
+    }
+
+    std::sort(latencies.begin(), latencies.end());
+    printf("  callback after the woken waiter: median %.1f us, p99 %.1f us\n", latencies[latencies.size() / 2], latencies[latencies.size() * 99 / 100]);
+}
@@ -0,0 +1,122 @@
+#include "Test.h"
+#include "TestDevice.h"
+#include "FrameConstantAllocator.h"
+#include <set>
+#include <thread>
+
+namespace
+{
+    const UINT64 Alignment = D3D12_CONSTANT_BUFFER_DATA_PLACEMENT_ALIGNMENT;
+}
+
+TEST(FrameConstantAllocatorFailsCleanlyWhenItCantGrow)
+{
+    // Memory the allocator doesn't own, so it has nothing to grow into
+    std::vector<UINT8> memory(4 * Alignment);
+    FrameConstantAllocator allocator(memory.data(), 0x10000, memory.size());
+    for (UINT i = 0; i < 4; i++)
+    {
+        CHECK(allocator.Allocate(Alignment).gpuAddress == 0x10000 + i * Alignment);
+    }
+
+    bool threw = false;
+    try
+    {
+        allocator.Allocate(1);
+    }
+    catch (const std::exception&)
+    {
+        threw = true;
+    }
+    CHECK(threw);
+    // What the frame had already allocated is untouched
+    CHECK(allocator.GetFrameUsed() == 4 * Alignment);
+    CHECK(allocator.GetCapacity() == 4 * Alignment);
+
+    // Once the frame completes, its memory is used again
+    allocator.EndFrame(1);
+    allocator.Retire(1);
+    CHECK(allocator.GetUsed() == 0);
+    CHECK(allocator.Allocate(Alignment).gpuAddress == 0x10000);
+}
+
+TEST(FrameConstantAllocatorGrowsWhenAFrameOverflowsIt)
+{
+    // Room for four objects' constants, then ten are written in one frame
+    FrameConstantAllocator allocator(GetTestDevice(), 4 * Alignment);
+    std::set<D3D12_GPU_VIRTUAL_ADDRESS> addresses;
+    std::vector<FrameConstantAllocator::Allocation> allocations;
+    for (UINT i = 0; i < 10; i++)
+    {
+        allocations.push_back(allocator.Allocate(Alignment));
+        CHECK(allocations.back().gpuAddress % Alignment == 0);
+        addresses.insert(allocations.back().gpuAddress);
+        memset(allocations.back().cpuAddress, int(i), Alignment);
+    }
+    CHECK(addresses.size() == 10);
+    CHECK(allocator.GetCapacity() == 8 * Alignment);
+    CHECK(allocator.GetBufferCount() == 2);
+    CHECK(allocator.GetFrameUsed() == 10 * Alignment);
+
+    // Growing moved nothing already written, the first buffer is kept for the GPU to read
+    uint32_t overwritten = 0;
+    for (UINT i = 0; i < 10; i++)
+    {
+        overwritten += static_cast<const UINT8*>(allocations[i].cpuAddress)[Alignment - 1] == i ? 0 : 1;
+    }
+    CHECK(overwritten == 0);
+
+    // Bigger than the whole buffer, so it grows past double
+    allocator.Allocate(20 * Alignment);
+    CHECK(allocator.GetCapacity() == 32 * Alignment);
+    CHECK(allocator.GetBufferCount() == 3);
+
+    // The outgrown buffers are released once the frame that wrote to them completes
+    allocator.EndFrame(1);
+    allocator.Allocate(Alignment);
+    allocator.EndFrame(2);
+    allocator.Retire(1);
+    CHECK(allocator.GetBufferCount() == 1);
+    CHECK(allocator.GetUsed() == Alignment);
+    allocator.Retire(2);
+    CHECK(allocator.GetUsed() == 0);
+}
+
+TEST(FrameConstantAllocatorGrowsWhileThreadsAllocate)
+{
+    // Every pass's thread writes its constants at once, and one of them finds the buffer full
+    const uint32_t threadCount = 8;
+    const uint32_t perThread = 200;
+    FrameConstantAllocator allocator(GetTestDevice(), 4 * Alignment);
+    std::vector<std::vector<D3D12_GPU_VIRTUAL_ADDRESS>> addresses(threadCount);
+    std::vector<std::thread> threads;
+    for (uint32_t t = 0; t < threadCount; t++)
+    {
+        threads.emplace_back([&, t]()
+        {
+            for (uint32_t i = 0; i < perThread; i++)
+            {
+                auto allocation = allocator.Allocate(Alignment);
+                memset(allocation.cpuAddress, 0, Alignment);
+                addresses[t].push_back(allocation.gpuAddress);
+            }
+        });
+    }
+    for (auto& thread : threads)
+    {
+        thread.join();
+    }
+
+    std::set<D3D12_GPU_VIRTUAL_ADDRESS> unique;
+    for (auto& threadAddresses : addresses)
+    {
+        unique.insert(threadAddresses.begin(), threadAddresses.end());
+    }
+    CHECK(unique.size() == threadCount * perThread);
+    CHECK(allocator.GetFrameUsed() == threadCount * perThread * Alignment);
+    CHECK(allocator.GetCapacity() >= threadCount * perThread * Alignment / 2);
+
+    allocator.EndFrame(1);
+    allocator.Retire(1);
+    CHECK(allocator.GetBufferCount() == 1);
+}
@@ -0,0 +1,101 @@
+#include "Test.h"
+#include "FramePacer.h"
+#include "SimulatedTimeline.h"
+#include <algorithm>
+#include <random>
+#include <thread>
+
+using namespace std::chrono;
+
+TEST(FramePacerWaitsForTheFrameNFramesAgo)
+{
+    FramePacer pacer(3, 2);
+    // The first N frames have nothing to wait for
+    CHECK(pacer.BeginFrame() == 0);
+    CHECK(pacer.GetFrameIndex() == 0);
+    pacer.EndFrame(10);
+    CHECK(pacer.BeginFrame() == 0);
+    CHECK(pacer.GetFrameIndex() == 1);
+    pacer.EndFrame(11);
+
+    CHECK(pacer.BeginFrame() == 10);
+    CHECK(pacer.GetFrameIndex() == 2);
+    pacer.EndFrame(12);
+    CHECK(pacer.BeginFrame() == 11);
+    CHECK(pacer.GetFrameIndex() == 0);
+    pacer.EndFrame(13);
+
+    // Down to 1, the next frame waits for the one just submitted
+    pacer.SetFramesInFlight(1);
+    CHECK(pacer.BeginFrame() == 13);
+    pacer.EndFrame(14);
+    // Back up to 3, waiting on the frame three ago
+    pacer.SetFramesInFlight(3);
+    CHECK(pacer.BeginFrame() == 12);
+}
+
+TEST(FramePacerNeverReusesACopyTheGpuMayRead)
+{
+    const uint32_t maxFramesInFlight = 3;
+    FramePacer pacer(maxFramesInFlight, 2);
+    std::mt19937 random(1);
+
+    // The fence value of the frame which last used each copy of the per-frame resources
+    std::vector<uint64_t> copyFences(maxFramesInFlight, 0);
+    uint64_t signalled = 0;
+    uint64_t completed = 0;
+
+    for (uint32_t frame = 0; frame < 10000; frame++)
+    {
+        if (frame % 100 == 0)
+        {
+            pacer.SetFramesInFlight(1 + random() % maxFramesInFlight);
+        }
+
+        // The simulated GPU gets through some of what's queued, then the CPU waits as the pacer says
+        completed = std::min(signalled, completed + random() % 3);
+        completed = std::max(completed, pacer.BeginFrame());
+        CHECK(copyFences[pacer.GetFrameIndex()] <= completed);
+        // No more than N frames are queued once the CPU has waited
+        CHECK(signalled - completed < pacer.GetFramesInFlight());
+
+        copyFences[pacer.GetFrameIndex()] = ++signalled;
+        pacer.EndFrame(signalled);
+    }
+}
+
+TEST(FramePacerThroughputBenchmark)
+{
+    // A frame takes as long to record on the CPU as to execute on the GPU
+    const auto cpuTime = microseconds(2000);
+    const auto gpuTime = microseconds(2000);
+    const uint32_t frames = 60;
+
+    printf("  CPU %.1f ms, GPU %.1f ms a frame\n", cpuTime.count() / 1000.0, gpuTime.count() / 1000.0);
+    printf("  frames in flight  ms per frame  GPU idle ms  stalls\n");
+    double frameTimes[3] = {};
+    for (uint32_t framesInFlight = 1; framesInFlight <= 3; framesInFlight++)
+    {
+        SimulatedTimeline gpu(microseconds(100));
+        FramePacer pacer(3, framesInFlight);
+
+        Stopwatch stopwatch;
+        for (uint32_t frame = 0; frame < frames; frame++)
+        {
+            gpu.WaitForValue(pacer.BeginFrame());
+            std::this_thread::sleep_for(cpuTime);
+            gpu.Submit(gpuTime);
+            pacer.EndFrame(gpu.Signal());
+        }
+        gpu.Flush();
+
+        auto stats = gpu.GetStats();
+        frameTimes[framesInFlight - 1] = stopwatch.GetMilliseconds() / frames;
+        printf("  %16u  %12.2f  %11.1f  %6llu\n", framesInFlight, frameTimes[framesInFlight - 1], stats.idleMilliseconds,
+            static_cast<unsigned long long>(stats.stalls));
+    }
+
+    // Waiting on every frame serialises the CPU and GPU, and two in flight overlaps them
+    CHECK(frameTimes[1] < frameTimes[0] * 0.75);
+    CHECK(frameTimes[2] < frameTimes[0] * 0.75);
+}
@@ -0,0 +1,193 @@
+#include "Test.h"
+#include "GpuProfiler.h"
+#include "NullTimestampBackend.h"
+#include "WorkerPool.h"
+#include <cmath>
+#include <string>
+
+namespace
+{
+    bool IsNear(float a, float b)
+    {
+        return std::fabs(a - b) < 1e-4f;
+    }
+}
+
+TEST(GpuProfilerTimesNestedMarkers)
+{
+    // One tick a millisecond, and timestamps don't move the clock on themselves, so durations are exactly what's advanced
+    NullTimestampBackend backend(3 * 4 * 2, 1000, 0);
+    GpuProfiler profiler(backend, 3, 4);
+    CHECK(profiler.GetMarkersPerFrame() == 4);
+
+    CHECK(profiler.BeginFrame(0));
+    {
+        GpuProfiler::Scope portal(profiler, nullptr, "Portal");
+        backend.Advance(3);
+        {
+            GpuProfiler::Scope main(profiler, nullptr, "Main");
+            backend.Advance(2);
+        }
+    }
+    profiler.ResolveFrame(nullptr);
+    profiler.EndFrame(1);
+
+    // Nothing is read back until the frame's fence completes
+    CHECK(profiler.BeginFrame(0));
+    CHECK(profiler.GetHistories().empty());
+    profiler.ResolveFrame(nullptr);
+    profiler.EndFrame(2);
+
+    CHECK(profiler.BeginFrame(1));
+    auto& histories = profiler.GetHistories();
+    CHECK(histories.size() == 2);
+    CHECK(histories[0].name == "Portal" && IsNear(histories[0].GetLatest(), 5.0f));
+    CHECK(histories[1].name == "Main" && IsNear(histories[1].GetLatest(), 2.0f));
+    CHECK(histories[0].lastFrame == 0);
+}
+
+TEST(GpuProfilerSkipsFramesRatherThanStalling)
+{
+    NullTimestampBackend backend(2 * 4 * 2, 1000, 0);
+    GpuProfiler profiler(backend, 2, 4);
+    uint64_t fence = 0;
+
+    // Two frames queued with the GPU yet to finish either fill both regions
+    for (uint32_t frame = 0; frame < 2; frame++)
+    {
+        CHECK(profiler.BeginFrame(0));
+        {
+            GpuProfiler::Scope scope(profiler, nullptr, "Main");
+            backend.Advance(1);
+        }
+        profiler.ResolveFrame(nullptr);
+        profiler.EndFrame(++fence);
+    }
+
+    // So the third goes untimed, and its markers are no-ops
+    CHECK(!profiler.BeginFrame(0));
+    CHECK(profiler.BeginMarker(nullptr, "Main") == GpuProfiler::InvalidIndex);
+    profiler.ResolveFrame(nullptr);
+    profiler.EndFrame(++fence);
+
+    CHECK(profiler.BeginFrame(fence));
+    CHECK(profiler.GetHistories().size() == 1);
+    CHECK(profiler.GetHistories()[0].count == 2);
+}
+
+TEST(GpuProfilerDropsMarkersPastTheFramesSlots)
+{
+    NullTimestampBackend backend(2 * 4 * 2);
+    GpuProfiler profiler(backend, 2, 8);
+    profiler.BeginFrame(0);
+    for (uint32_t i = 0; i < 6; i++)
+    {
+        uint32_t marker = profiler.BeginMarker(nullptr, "Pass");
+        CHECK((marker == GpuProfiler::InvalidIndex) == (i >= 4));
+        profiler.EndMarker(nullptr, marker);
+    }
+    profiler.ResolveFrame(nullptr);
+    profiler.EndFrame(1);
+    profiler.BeginFrame(1);
+    CHECK(profiler.GetHistories().size() == 1);
+    CHECK(profiler.GetHistories()[0].count == 4);
+}
+
+TEST(GpuProfilerKeepsARingOfTimings)
+{
+    NullTimestampBackend backend(2 * 4 * 2, 1000, 0);
+    GpuProfiler profiler(backend, 2, 4);
+    uint64_t fence = 0;
+    for (uint32_t frame = 0; frame < 10; frame++)
+    {
+        profiler.BeginFrame(fence);
+        {
+            GpuProfiler::Scope scope(profiler, nullptr, "Main");
+            backend.Advance(frame);
+        }
+        profiler.ResolveFrame(nullptr);
+        profiler.EndFrame(++fence);
+    }
+    profiler.BeginFrame(fence);
+
+    // Only the last four timings are kept, 6 to 9 ms
+    auto& history = profiler.GetHistories()[0];
+    CHECK(history.count == 4);
+    CHECK(IsNear(history.GetLatest(), 9.0f));
+    CHECK(IsNear(history.GetAverage(), 7.5f));
+    CHECK(IsNear(history.GetMax(), 9.0f));
+    CHECK(history.lastFrame == 9);
+}
+
+TEST(GpuProfilerExportsJson)
+{
+    NullTimestampBackend backend(2 * 4 * 2, 1000, 0);
+    GpuProfiler profiler(backend, 2, 4);
+    profiler.BeginFrame(0);
+    {
+        // Portals are named after scene objects, which can hold anything
+        GpuProfiler::Scope scope(profiler, nullptr, "Portal \"A\"\\");
+        backend.Advance(2);
+    }
+    profiler.ResolveFrame(nullptr);
+    profiler.EndFrame(1);
+    profiler.BeginFrame(1);
+
+    std::string json = profiler.ToJson();
+    CHECK(json.find("\"name\": \"Portal \\\"A\\\"\\\\\"") != std::string::npos);
+    CHECK(json.find("\"milliseconds\": [2]") != std::string::npos);
+    CHECK(json.front() == '[' && json.find(']', json.rfind('}')) != std::string::npos);
+}
+
+TEST(GpuProfilerTakesMarkersFromEveryThread)
+{
+    // Passes recorded in parallel, as Renderer records portal passes on the worker pool
+    WorkerPool pool(4);
+    NullTimestampBackend backend(2 * 64 * 2);
+    GpuProfiler profiler(backend, 2, 8);
+    profiler.BeginFrame(0);
+    pool.Run(64, [&](uint32_t i)
+    {
+        GpuProfiler::Scope scope(profiler, nullptr, "Pass " + std::to_string(i % 8));
+    });
+    profiler.ResolveFrame(nullptr);
+    profiler.EndFrame(1);
+    profiler.BeginFrame(1);
+
+    CHECK(profiler.GetHistories().size() == 8);
+    for (auto& history : profiler.GetHistories())
+    {
+        CHECK(history.count == 8);
+    }
+}
+
+TEST(GpuProfilerResolveBenchmark)
+{
+    // The CPU cost of the profiler itself, with the scene's worth of markers every frame
+    const uint32_t markers = 32;
+    const uint32_t frames = 10000;
+    NullTimestampBackend backend(3 * markers * 2);
+    GpuProfiler profiler(backend, 3, 120);
+    std::vector<std::string> names;
+    for (uint32_t i = 0; i < markers; i++)
+    {
+        names.push_back("Portal " + std::to_string(i));
+    }
+
+    Stopwatch stopwatch;
+    for (uint64_t frame = 0; frame < frames; frame++)
+    {
+        // The GPU two frames behind
+        profiler.BeginFrame(frame > 2 ? frame - 2 : 0);
+        for (auto& name : names)
+        {
+            GpuProfiler::Scope scope(profiler, nullptr, name);
+        }
+        profiler.ResolveFrame(nullptr);
+        profiler.EndFrame(frame + 1);
+    }
+    double milliseconds = stopwatch.GetMilliseconds();
+    printf("  %u markers a frame: %.2f us a frame to begin, end, resolve and aggregate\n", markers, milliseconds * 1000.0 / frames);
+    CHECK(profiler.GetHistories().size() == markers);
+    CHECK(profiler.GetHistories()[0].count == 120);
+}
@@ -0,0 +1,110 @@
+#include "Test.h"
+#include "TestDevice.h"
+#include "GrowableDescriptorHeap.h"
+#include <thread>
+
+using Microsoft::WRL::ComPtr;
+
+namespace
+{
+    /**
+    * A CPU-only CBV/SRV/UAV heap for test descriptors to be copied or created into.
+    */
+    ComPtr<ID3D12DescriptorHeap> CreateScratchHeap(UINT count)
+    {
+        D3D12_DESCRIPTOR_HEAP_DESC desc = {};
+        desc.NumDescriptors = count;
+        desc.Type = D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV;
+        desc.Flags = D3D12_DESCRIPTOR_HEAP_FLAG_NONE;
+        ComPtr<ID3D12DescriptorHeap> heap;
+        ThrowIfFailed(GetTestDevice()->CreateDescriptorHeap(&desc, IID_PPV_ARGS(&heap)), "Couldn't create scratch heap.\n");
+        return heap;
+    }
+
+    /**
+    * Create the view test descriptor i holds, a CBV over the i-th 256 bytes of a buffer, so every descriptor is different.
+    */
+    void CreateTestView(ID3D12Resource* buffer, uint32_t i, D3D12_CPU_DESCRIPTOR_HANDLE cpuHandle)
+    {
+        D3D12_CONSTANT_BUFFER_VIEW_DESC desc = {};
+        desc.BufferLocation = buffer->GetGPUVirtualAddress() + UINT64(i) * D3D12_CONSTANT_BUFFER_DATA_PLACEMENT_ALIGNMENT;
+        desc.SizeInBytes = D3D12_CONSTANT_BUFFER_DATA_PLACEMENT_ALIGNMENT;
+        GetTestDevice()->CreateConstantBufferView(&desc, cpuHandle);
+    }
+}
+
+TEST(GrowableDescriptorHeapGrowsWhileOtherThreadsWriteViews)
+{
+    const uint32_t threadCount = 8;
+    const uint32_t viewsPerThread = 512;
+    const UINT total = threadCount * viewsPerThread;
+    ID3D12Device* device = GetTestDevice();
+    auto buffer = CreateTestBuffer(UINT64(total) * D3D12_CONSTANT_BUFFER_DATA_PLACEMENT_ALIGNMENT);
+
+    // Starting at one descriptor, the heap grows time and again while the other threads are allocating and writing views.
+    // Every thread writes its views as texture loads do, allocating then writing the view through the handle
+    GrowableDescriptorHeap heap(device, D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV, 1);
+    std::vector<DescriptorHandle> handles(total);
+    std::vector<std::thread> threads;
+    for (uint32_t t = 0; t < threadCount; t++)
+    {
+        threads.emplace_back([&, t]()
+        {
+            for (uint32_t i = t * viewsPerThread; i < (t + 1) * viewsPerThread; i++)
+            {
+                handles[i] = heap.Allocate();
+                heap.WriteView(handles[i], [&](D3D12_CPU_DESCRIPTOR_HANDLE cpuHandle)
+                {
+                    CreateTestView(buffer.Get(), i, cpuHandle);
+                });
+            }
+        });
+    }
+    for (auto& thread : threads)
+    {
+        thread.join();
+    }
+    CHECK(heap.GetCapacity() >= total);
+
+    // Copy every view out of the heap, and compare it with the same view created directly.
+    // A view written into a heap already released, or between a grow's copy and the swap, would have been lost
+    UINT descriptorSize = device->GetDescriptorHandleIncrementSize(D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV);
+    auto copied = CreateScratchHeap(total);
+    auto expected = CreateScratchHeap(total);
+    D3D12_CPU_DESCRIPTOR_HANDLE copiedStart = copied->GetCPUDescriptorHandleForHeapStart();
+    heap.CopyDescriptors(1, &copiedStart, &total, handles.data(), total);
+
+    uint32_t wrong = 0;
+    for (uint32_t i = 0; i < total; i++)
+    {
+        CD3DX12_CPU_DESCRIPTOR_HANDLE expectedHandle(expected->GetCPUDescriptorHandleForHeapStart(), i, descriptorSize);
+        CreateTestView(buffer.Get(), i, expectedHandle);
+        CD3DX12_CPU_DESCRIPTOR_HANDLE copiedHandle(copiedStart, i, descriptorSize);
+        wrong += ReadDescriptor(copiedHandle, descriptorSize) != ReadDescriptor(expectedHandle, descriptorSize) ? 1 : 0;
+    }
+    CHECK(wrong == 0);
+}
+
+TEST(GrowableDescriptorHeapRefusesStaleHandles)
+{
+    GrowableDescriptorHeap heap(GetTestDevice(), D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV, 4);
+    DescriptorHandle handle = heap.Allocate();
+    heap.Free(handle, 1);
+
+    // Still resolves until its fence value is reached, as recorded command lists may still copy it
+    bool wrote = false;
+    heap.WriteView(handle, [&](D3D12_CPU_DESCRIPTOR_HANDLE) { wrote = true; });
+    CHECK(wrote);
+
+    heap.Retire(1);
+    bool threw = false;
+    try
+    {
+        heap.WriteView(handle, [](D3D12_CPU_DESCRIPTOR_HANDLE) {});
+    }
+    catch (const std::exception&)
+    {
+        threw = true;
+    }
+    CHECK(threw);
+}
@@ -0,0 +1,277 @@
+#include "Test.h"
+#include "PassScheduler.h"
+#include <algorithm>
+#include <random>
+#include <set>
+
+using Queue = PassScheduler::Queue;
+
+namespace
+{
+    /**
+    * For each submission, every earlier submission certain to have finished before it starts,
+    * through being earlier on the same queue or through a chain of waits.
+    */
+    std::vector<std::set<uint32_t>> GetHappensBefore(const std::vector<PassScheduler::Submission>& submissions)
+    {
+        std::vector<std::set<uint32_t>> before(submissions.size());
+        for (uint32_t s = 0; s < submissions.size(); s++)
+        {
+            for (uint32_t earlier = 0; earlier < s; earlier++)
+            {
+                if (submissions[earlier].queue == submissions[s].queue)
+                {
+                    before[s].insert(earlier);
+                    before[s].insert(before[earlier].begin(), before[earlier].end());
+                }
+            }
+            for (auto& wait : submissions[s].waits)
+            {
+                before[s].insert(wait.submission);
+                before[s].insert(before[wait.submission].begin(), before[wait.submission].end());
+            }
+        }
+        return before;
+    }
+
+    /**
+    * Check a schedule honours every dependency, and that the graphics queue's last submission follows everything else.
+    * @returns The number of waits in the schedule
+    */
+    uint32_t CheckSchedule(const PassScheduler& scheduler, const std::vector<std::vector<uint32_t>>& dependencies)
+    {
+        auto submissions = scheduler.Schedule();
+        auto before = GetHappensBefore(submissions);
+
+        std::vector<uint32_t> submissionOf(scheduler.GetPassCount(), PassScheduler::InvalidIndex);
+        std::vector<uint32_t> positionOf(scheduler.GetPassCount(), 0);
+        uint32_t waits = 0;
+        for (uint32_t s = 0; s < submissions.size(); s++)
+        {
+            for (uint32_t i = 0; i < submissions[s].passes.size(); i++)
+            {
+                uint32_t pass = submissions[s].passes[i];
+                CHECK(submissionOf[pass] == PassScheduler::InvalidIndex);
+                CHECK(scheduler.GetQueue(pass) == submissions[s].queue);
+                submissionOf[pass] = s;
+                positionOf[pass] = i;
+            }
+            for (auto& wait : submissions[s].waits)
+            {
+                CHECK(wait.submission < s);
+                CHECK(submissions[wait.submission].queue == wait.queue);
+                CHECK(wait.queue != submissions[s].queue);
+                waits++;
+            }
+        }
+
+        for (uint32_t pass = 0; pass < scheduler.GetPassCount(); pass++)
+        {
+            CHECK(submissionOf[pass] != PassScheduler::InvalidIndex);
+            for (auto dependency : dependencies[pass])
+            {
+                // Within one submission, lists execute in order
+                bool ordered = submissionOf[dependency] == submissionOf[pass] ? positionOf[dependency] < positionOf[pass]
+                    : before[submissionOf[pass]].count(submissionOf[dependency]) != 0;
+                CHECK(ordered);
+            }
+        }
+
+        if (!submissions.empty())
+        {
+            CHECK(submissions.back().queue == Queue::Graphics);
+            CHECK(before.back().size() == submissions.size() - 1);
+        }
+        return waits;
+    }
+
+    /**
+    * When a frame's GPU work would finish, with each queue running its submissions in order and each submission
+    * starting once its queue is free and every submission it waits for has finished.
+    * @param durations How long each pass takes on the GPU
+    */
+    double GetFrameTime(const std::vector<PassScheduler::Submission>& submissions, const std::vector<double>& durations)
+    {
+        std::vector<double> queueFree(static_cast<size_t>(Queue::Count), 0.0);
+        std::vector<double> finished(submissions.size(), 0.0);
+        double frameTime = 0.0;
+        for (uint32_t s = 0; s < submissions.size(); s++)
+        {
+            double& freeAt = queueFree[static_cast<size_t>(submissions[s].queue)];
+            double start = freeAt;
+            for (auto& wait : submissions[s].waits)
+            {
+                start = std::max(start, finished[wait.submission]);
+            }
+            finished[s] = start;
+            for (auto pass : submissions[s].passes)
+            {
+                finished[s] += durations[pass];
+            }
+            freeAt = finished[s];
+            frameTime = std::max(frameTime, finished[s]);
+        }
+        return frameTime;
+    }
+}
+
+TEST(PassSchedulerBatchesOneQueueIntoOneSubmission)
+{
+    PassScheduler scheduler;
+    scheduler.AddPass(Queue::Graphics);
+    scheduler.AddPass(Queue::Graphics);
+    scheduler.AddPass(Queue::Graphics, { 0, 1 });
+    auto submissions = scheduler.Schedule();
+    CHECK(submissions.size() == 1);
+    CHECK(submissions[0].passes.size() == 3);
+    CHECK(submissions[0].waits.empty());
+}
+
+TEST(PassSchedulerWaitsOnlyAcrossQueues)
+{
+    // Compute results read by the second graphics pass, but not the first
+    PassScheduler scheduler;
+    uint32_t compute = scheduler.AddPass(Queue::Compute);
+    uint32_t graphics = scheduler.AddPass(Queue::Graphics);
+    uint32_t reader = scheduler.AddPass(Queue::Graphics, { compute, graphics });
+    auto submissions = scheduler.Schedule();
+
+    // The first graphics pass doesn't wait, so overlaps the compute pass
+    CHECK(submissions.size() == 3);
+    CHECK(submissions[0].queue == Queue::Compute);
+    CHECK(submissions[1].passes.size() == 1 && submissions[1].passes[0] == graphics);
+    CHECK(submissions[1].waits.empty());
+    CHECK(submissions[2].passes.size() == 1 && submissions[2].passes[0] == reader);
+    CHECK(submissions[2].waits.size() == 1);
+    CHECK(submissions[2].waits[0].queue == Queue::Compute && submissions[2].waits[0].submission == 0);
+}
+
+TEST(PassSchedulerDropsCoveredWaits)
+{
+    // Both graphics passes read compute results, but waiting for the second compute pass covers the first
+    PassScheduler scheduler;
+    uint32_t first = scheduler.AddPass(Queue::Compute);
+    uint32_t second = scheduler.AddPass(Queue::Compute);
+    scheduler.AddPass(Queue::Graphics, { first });
+    scheduler.AddPass(Queue::Graphics, { second });
+    auto submissions = scheduler.Schedule();
+    CHECK(submissions.size() == 2);
+    CHECK(submissions[0].passes.size() == 2);
+    CHECK(submissions[1].passes.size() == 2);
+    CHECK(submissions[1].waits.size() == 1);
+}
+
+TEST(PassSchedulerJoinsEveryQueueIntoGraphics)
+{
+    // Compute work nothing on graphics reads afterwards still has to finish before the frame's fence
+    PassScheduler scheduler;
+    uint32_t graphics = scheduler.AddPass(Queue::Graphics);
+    scheduler.AddPass(Queue::Compute, { graphics });
+    scheduler.AddPass(Queue::Graphics);
+    auto submissions = scheduler.Schedule();
+    CHECK(submissions.size() == 4);
+    CHECK(submissions[1].queue == Queue::Compute);
+    CHECK(submissions[1].waits.size() == 1 && submissions[1].waits[0].queue == Queue::Graphics);
+    CHECK(submissions[3].queue == Queue::Graphics && submissions[3].passes.empty());
+    CHECK(submissions[3].waits.size() == 1);
+    CHECK(submissions[3].waits[0].queue == Queue::Compute && submissions[3].waits[0].submission == 1);
+}
+
+TEST(PassSchedulerChainsCopyComputeGraphics)
+{
+    // An upload read by a compute pass, both read by graphics
+    PassScheduler scheduler;
+    uint32_t upload = scheduler.AddPass(Queue::Copy);
+    uint32_t compute = scheduler.AddPass(Queue::Compute, { upload });
+    scheduler.AddPass(Queue::Graphics, { upload, compute });
+    auto submissions = scheduler.Schedule();
+    CHECK(submissions.size() == 3);
+    CHECK(submissions[1].waits.size() == 1 && submissions[1].waits[0].queue == Queue::Copy);
+    CHECK(submissions[2].waits.size() == 2);
+    CheckSchedule(scheduler, { {}, { upload }, { upload, compute } });
+
+    scheduler.Clear();
+    CHECK(scheduler.GetPassCount() == 0);
+    CHECK(scheduler.Schedule().empty());
+}
+
+TEST(PassSchedulerHonoursRandomDependencies)
+{
+    std::mt19937 random(1);
+    uint32_t crossQueueDependencies = 0;
+    uint32_t waits = 0;
+    for (uint32_t frame = 0; frame < 2000; frame++)
+    {
+        PassScheduler scheduler;
+        std::vector<std::vector<uint32_t>> dependencies;
+        uint32_t passes = 1 + random() % 16;
+        for (uint32_t pass = 0; pass < passes; pass++)
+        {
+            Queue queue = static_cast<Queue>(random() % static_cast<uint32_t>(Queue::Count));
+            std::vector<uint32_t> reads;
+            for (uint32_t earlier = 0; earlier < pass; earlier++)
+            {
+                if (random() % 4 == 0)
+                {
+                    reads.push_back(earlier);
+                    crossQueueDependencies += scheduler.GetQueue(earlier) != queue ? 1 : 0;
+                }
+            }
+            scheduler.AddPass(queue, reads);
+            dependencies.push_back(reads);
+        }
+        waits += CheckSchedule(scheduler, dependencies);
+    }
+    printf("  2000 random frames: %u cross-queue dependencies met with %u waits, including final joins\n", crossQueueDependencies, waits);
+}
+
+TEST(PassSchedulerOverlapsRendererComputePassesWithPortalPasses)
+{
+    // The frame as Renderer::Render adds it: compute passes, the portal passes, the main pass reading the compute results, then the profiler's resolve
+    const uint32_t computeCount = 2;
+    const uint32_t portalCount = 8;
+    PassScheduler scheduler;
+    std::vector<std::vector<uint32_t>> dependencies;
+    std::vector<uint32_t> computePasses;
+    for (uint32_t i = 0; i < computeCount; i++)
+    {
+        computePasses.push_back(scheduler.AddPass(Queue::Compute));
+        dependencies.push_back({});
+    }
+    for (uint32_t i = 0; i < portalCount; i++)
+    {
+        scheduler.AddPass(Queue::Graphics);
+        dependencies.push_back({});
+    }
+    uint32_t mainPass = scheduler.AddPass(Queue::Graphics, computePasses);
+    dependencies.push_back(computePasses);
+    scheduler.AddPass(Queue::Graphics);
+    dependencies.push_back({});
+    CheckSchedule(scheduler, dependencies);
+
+    // The compute passes are one submission, the portal passes go ahead without waiting, and only the main pass waits for compute
+    auto submissions = scheduler.Schedule();
+    CHECK(submissions.size() == 3);
+    CHECK(submissions[0].queue == Queue::Compute && submissions[0].passes.size() == computeCount);
+    CHECK(submissions[1].queue == Queue::Graphics && submissions[1].passes.size() == portalCount);
+    CHECK(submissions[1].waits.empty());
+    CHECK(submissions[2].passes.front() == mainPass);
+    CHECK(submissions[2].waits.size() == 1 && submissions[2].waits[0].queue == Queue::Compute);
+
+    // Culling and post-processing at 1 ms each, portal passes at 0.5 ms and the main pass at 2 ms, against running every pass on the graphics queue
+    std::vector<double> durations(scheduler.GetPassCount(), 0.5);
+    for (auto pass : computePasses)
+    {
+        durations[pass] = 1.0;
+    }
+    durations[mainPass] = 2.0;
+    durations.back() = 0.0;
+    double serial = 0.0;
+    for (auto duration : durations)
+    {
+        serial += duration;
+    }
+    double overlapped = GetFrameTime(submissions, durations);
+    CHECK(overlapped < serial);
+    printf("  %u compute and %u portal passes: %.1f ms on one queue, %.1f ms with compute overlapped\n", computeCount, portalCount, serial, overlapped);
+}
@@ -0,0 +1,183 @@
+#include "Test.h"
+#include "SimulatedTimeline.h"
+#include "CommandAllocatorPool.h"
+#include "FramePacer.h"
+#include "WakeEvent.h"
+#include <algorithm>
+#include <atomic>
+#include <thread>
+
+using namespace std::chrono;
+
+TEST(SimulatedTimelineCompletesSubmissionsInOrder)
+{
+    SimulatedTimeline gpu;
+    CHECK(gpu.GetCompletedValue() == 0);
+    CHECK(gpu.GetNextValue() == 1);
+
+    gpu.Submit(milliseconds(20));
+    uint64_t first = gpu.Signal();
+    gpu.Submit(milliseconds(1));
+    uint64_t second = gpu.Signal();
+    CHECK(first == 1 && second == 2);
+
+    // The second signal can't be reached before the first, however short its work
+    gpu.WaitForValue(second);
+    CHECK(gpu.IsComplete(first));
+    CHECK(gpu.GetCompletedValue() == 2);
+
+    // Waiting on a value already reached doesn't block, and isn't counted as a stall
+    gpu.WaitForValue(first);
+    auto stats = gpu.GetStats();
+    CHECK(stats.waits == 2);
+    CHECK(stats.stalls == 1);
+    CHECK(stats.stalledMilliseconds >= 15.0);
+    CHECK(stats.busyMilliseconds >= 20.0);
+}
+
+TEST(SimulatedTimelineSignalsFromSeveralThreadsInOrder)
+{
+    // Queues signalled from several threads, e.g. passes submitting their own lists, while others read the next value to tag resources with
+    SimulatedTimeline gpu;
+    const uint32_t threadCount = 4;
+    const uint32_t signals = 500;
+    std::atomic<bool> signalling{ true };
+    uint32_t backwards = 0;
+    std::thread reader([&]()
+    {
+        uint64_t last = gpu.GetNextValue();
+        while (signalling.load())
+        {
+            uint64_t next = gpu.GetNextValue();
+            backwards += next < last ? 1 : 0;
+            last = next;
+        }
+    });
+
+    std::vector<std::vector<uint64_t>> values(threadCount);
+    std::vector<std::thread> threads;
+    for (uint32_t t = 0; t < threadCount; t++)
+    {
+        threads.emplace_back([&, t]()
+        {
+            for (uint32_t i = 0; i < signals; i++)
+            {
+                values[t].push_back(gpu.Signal());
+            }
+        });
+    }
+    for (auto& thread : threads)
+    {
+        thread.join();
+    }
+    signalling = false;
+    reader.join();
+    CHECK(backwards == 0);
+
+    // Every value handed out once, and each thread's in the order it signalled
+    std::vector<uint64_t> all;
+    uint32_t unordered = 0;
+    for (auto& threadValues : values)
+    {
+        for (size_t i = 1; i < threadValues.size(); i++)
+        {
+            unordered += threadValues[i] > threadValues[i - 1] ? 0 : 1;
+        }
+        all.insert(all.end(), threadValues.begin(), threadValues.end());
+    }
+    CHECK(unordered == 0);
+    std::sort(all.begin(), all.end());
+    for (size_t i = 0; i < all.size(); i++)
+    {
+        CHECK(all[i] == i + 1);
+    }
+    CHECK(gpu.GetNextValue() == threadCount * signals + 1);
+
+    // The simulated GPU reaches them in order, so the last is reached after all the others
+    gpu.WaitForValue(threadCount * signals);
+    CHECK(gpu.GetCompletedValue() == threadCount * signals);
+}
+
+TEST(SimulatedTimelineAppliesSubmitLatency)
+{
+    SimulatedTimeline gpu(milliseconds(10));
+    Stopwatch stopwatch;
+    gpu.Flush();
+    // Even an empty submission takes the latency to reach the queue
+    CHECK(stopwatch.GetMilliseconds() >= 10.0);
+}
+
+TEST(SimulatedTimelineSetsEventsOnCompletion)
+{
+    SimulatedTimeline gpu;
+    WakeEvent event;
+
+    // Already reached, so set straight away
+    gpu.SetEventOnCompletion(0, event);
+    event.Wait();
+
+    gpu.Submit(milliseconds(5));
+    uint64_t value = gpu.Signal();
+    gpu.SetEventOnCompletion(value, event);
+    event.Wait();
+    CHECK(gpu.IsComplete(value));
+}
+
+TEST(SimulatedTimelineOverlapBenchmark)
+{
+    struct Scene
+    {
+        const char* name;
+        microseconds cpuTime;
+        microseconds gpuTime;
+    };
+    const Scene scenes[] = {
+        { "CPU-bound", microseconds(3000), microseconds(1500) },
+        { "balanced", microseconds(2000), microseconds(2000) },
+        { "GPU-bound", microseconds(1500), microseconds(3000) },
+    };
+    const uint32_t frames = 60;
+
+    printf("  scene      in flight  ms/frame  GPU busy  stalls  stalled ms  allocators\n");
+    for (auto& scene : scenes)
+    {
+        for (uint32_t framesInFlight = 1; framesInFlight <= 3; framesInFlight++)
+        {
+            SimulatedTimeline gpu(microseconds(200));
+            FramePacer pacer(3, framesInFlight);
+            CommandAllocatorPool allocators(16, 120);
+            std::vector<uint32_t> trimmed;
+
+            Stopwatch stopwatch;
+            for (uint32_t frame = 0; frame < frames; frame++)
+            {
+                gpu.WaitForValue(pacer.BeginFrame());
+
+                bool create;
+                uint64_t wait;
+                uint32_t allocator = allocators.Acquire(gpu.GetCompletedValue(), create, wait);
+                if (wait)
+                {
+                    gpu.WaitForValue(wait);
+                }
+                std::this_thread::sleep_for(scene.cpuTime);
+                gpu.Submit(scene.gpuTime);
+                uint64_t fenceValue = gpu.Signal();
+                allocators.Release(allocator, fenceValue);
+                allocators.EndFrame(gpu.GetCompletedValue(), trimmed);
+                pacer.EndFrame(fenceValue);
+            }
+            gpu.Flush();
+            double elapsed = stopwatch.GetMilliseconds();
+
+            auto stats = gpu.GetStats();
+            printf("  %-9s  %9u  %8.2f  %7.0f%%  %6llu  %10.1f  %10llu\n", scene.name, framesInFlight, elapsed / frames,
+                100.0 * stats.busyMilliseconds / elapsed, static_cast<unsigned long long>(stats.stalls), stats.stalledMilliseconds,
+                static_cast<unsigned long long>(allocators.GetStats().created));
+
+            // Every frame the GPU runs is one the CPU recorded, and the pool never needs more allocators than frames can be queued
+            CHECK(gpu.GetCompletedValue() == frames + 1);
+            CHECK(allocators.GetStats().created <= framesInFlight + 1);
+        }
+    }
+}
@@ -0,0 +1,67 @@
+#pragma once
+#include <chrono>
+#include <cstdio>
+#include <vector>
+
+/**
+* Minimal test harness for the framework's device-free classes, so they run headless without a GPU.
+* Classes which need a device only for CPU-side objects are tested on Windows against WARP, see TestDevice.h.
+* TEST(name) registers a function which main() runs in the order the tests were registered,
+* and CHECK(expression) records a failure without stopping the test. Benchmarks are tests which print what they measure.
+*/
+struct Test
+{
+	const char* name;
+	void (*function)();
+};
+
+/**
+* Adds a test to the list main() runs, at static initialisation.
+*/
+struct TestRegistration
+{
+	TestRegistration(const char* name, void (*function)());
+};
+
+/**
+* @returns Every registered test
+*/
+std::vector<Test>& GetTests();
+/**
+* Record a failed check against the test being run.
+*/
+void ReportFailure(const char* file, int line, const char* expression);
+
+#define TEST(name) \
+	static void name(); \
+	static TestRegistration name##Registration(#name, name); \
+	static void name()
+
+#define CHECK(expression) \
+	do \
+	{ \
+		if (!(expression)) \
+		{ \
+			ReportFailure(__FILE__, __LINE__, #expression); \
+		} \
+	} while (false)
+
+/**
+* Wall-clock time since construction, for benchmarks.
+*/
+class Stopwatch
+{
+public:
+	Stopwatch()
+		: m_start(std::chrono::steady_clock::now())
+	{
+	}
+
+	double GetMilliseconds() const
+	{
+		return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - m_start).count();
+	}
+
+private:
+	std::chrono::steady_clock::time_point m_start;
+};
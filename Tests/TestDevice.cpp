@@ -0,0 +1,99 @@
+#include "TestDevice.h"
+#include "DescriptorHeap.h"
+#include "Primitive.h"
+
+using Microsoft::WRL::ComPtr;
+
+ID3D12Device* GetTestDevice()
+{
+    static ComPtr<ID3D12Device> device = []()
+        {
+            ComPtr<IDXGIFactory4> factory;
+            ThrowIfFailed(CreateDXGIFactory1(IID_PPV_ARGS(&factory)), "Couldn't create DXGI factory.\n");
+            ComPtr<IDXGIAdapter> warpAdapter;
+            ThrowIfFailed(factory->EnumWarpAdapter(IID_PPV_ARGS(&warpAdapter)), "Couldn't get WARP adapter.\n");
+            ComPtr<ID3D12Device> warpDevice;
+            ThrowIfFailed(D3D12CreateDevice(warpAdapter.Get(), D3D_FEATURE_LEVEL_11_0, IID_PPV_ARGS(&warpDevice)), "Couldn't create WARP device.\n");
+            return warpDevice;
+        }();
+    return device.Get();
+}
+
+ComPtr<ID3D12Resource> CreateTestBuffer(UINT64 size)
+{
+    ComPtr<ID3D12Resource> buffer;
+    auto heapProps = CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_UPLOAD);
+    auto bufferDesc = CD3DX12_RESOURCE_DESC::Buffer(size);
+    ThrowIfFailed(GetTestDevice()->CreateCommittedResource(
+        &heapProps,
+        D3D12_HEAP_FLAG_NONE,
+        &bufferDesc,
+        D3D12_RESOURCE_STATE_GENERIC_READ,
+        nullptr,
+        IID_PPV_ARGS(&buffer)
+    ), "Couldn't create test buffer.\n");
+    return buffer;
+}
+
+std::vector<UINT8> ReadDescriptor(D3D12_CPU_DESCRIPTOR_HANDLE handle, UINT size)
+{
+    const UINT8* descriptor = reinterpret_cast<const UINT8*>(handle.ptr);
+    return std::vector<UINT8>(descriptor, descriptor + size);
+}
+
+ComPtr<ID3D12RootSignature> CreateTestRootSignature(UINT variant)
+{
+    // The parameters before the draw constants are only placeholders, bundles never set them
+    std::vector<CD3DX12_ROOT_PARAMETER> parameters(DescriptorHeap::RootParameterIndices::DrawConstants + 1 + variant);
+    for (UINT i = 0; i < parameters.size(); i++)
+    {
+        parameters[i].InitAsConstants(i == DescriptorHeap::RootParameterIndices::DrawConstants ? 2 : 1, i);
+    }
+    CD3DX12_ROOT_SIGNATURE_DESC desc(static_cast<UINT>(parameters.size()), parameters.data());
+
+    ComPtr<ID3DBlob> signature;
+    ComPtr<ID3DBlob> error;
+    ThrowIfFailed(D3D12SerializeRootSignature(&desc, D3D_ROOT_SIGNATURE_VERSION_1, &signature, &error), "Couldn't serialize test root signature.\n");
+    ComPtr<ID3D12RootSignature> rootSignature;
+    ThrowIfFailed(GetTestDevice()->CreateRootSignature(0, signature->GetBufferPointer(), signature->GetBufferSize(), IID_PPV_ARGS(&rootSignature)), "Couldn't create test root signature.\n");
+    return rootSignature;
+}
+
+ComPtr<ID3D12PipelineState> CreateTestPipelineState(ID3D12RootSignature* rootSignature)
+{
+    static ComPtr<ID3DBlob> vertexShader = []()
+        {
+            const char source[] = "float4 main(uint id : SV_VertexID) : SV_Position { return float4(0, 0, 0, 1); }";
+            ComPtr<ID3DBlob> shader;
+            ComPtr<ID3DBlob> error;
+            ThrowIfFailed(D3DCompile(source, sizeof(source) - 1, nullptr, nullptr, nullptr, "main", "vs_5_0", 0, 0, &shader, &error), "Couldn't compile test vertex shader.\n");
+            return shader;
+        }();
+
+    // No render targets or pixel shader, so nothing is ever written
+    D3D12_GRAPHICS_PIPELINE_STATE_DESC desc = {};
+    desc.pRootSignature = rootSignature;
+    desc.VS = CD3DX12_SHADER_BYTECODE(vertexShader.Get());
+    desc.RasterizerState = CD3DX12_RASTERIZER_DESC(D3D12_DEFAULT);
+    desc.BlendState = CD3DX12_BLEND_DESC(D3D12_DEFAULT);
+    desc.DepthStencilState.DepthEnable = FALSE;
+    desc.SampleMask = UINT_MAX;
+    desc.PrimitiveTopologyType = D3D12_PRIMITIVE_TOPOLOGY_TYPE_TRIANGLE;
+    desc.SampleDesc.Count = 1;
+    ComPtr<ID3D12PipelineState> pipelineState;
+    ThrowIfFailed(GetTestDevice()->CreateGraphicsPipelineState(&desc, IID_PPV_ARGS(&pipelineState)), "Couldn't create test pipeline state.\n");
+    return pipelineState;
+}
+
+std::shared_ptr<Primitive> CreateTestModel(ID3D12PipelineState* pipelineState, ID3D12RootSignature* rootSignature)
+{
+    ComPtr<ID3D12CommandAllocator> allocator;
+    ThrowIfFailed(GetTestDevice()->CreateCommandAllocator(D3D12_COMMAND_LIST_TYPE_DIRECT, IID_PPV_ARGS(&allocator)), "Couldn't create test command allocator.\n");
+    ComPtr<ID3D12GraphicsCommandList> uploadCommandList;
+    ThrowIfFailed(GetTestDevice()->CreateCommandList(0, D3D12_COMMAND_LIST_TYPE_DIRECT, allocator.Get(), nullptr, IID_PPV_ARGS(&uploadCommandList)), "Couldn't create test command list.\n");
+
+    auto model = std::make_shared<Primitive>("Test Cube");
+    ThrowIfFalse(model->Initialize(GetTestDevice(), uploadCommandList.Get(), pipelineState, pipelineState, rootSignature, L"Cube"), "Couldn't create test model.\n");
+    ThrowIfFailed(uploadCommandList->Close(), "Couldn't close test command list.\n");
+    return model;
+}
@@ -0,0 +1,40 @@
+#pragma once
+#include "stdafx.h"
+#include <memory>
+#include <vector>
+
+class Primitive;
+
+/**
+* Tests of classes which create D3D12 objects, but only ever CPU-side ones such as non-shader-visible descriptor heaps, or bundles which are recorded and never executed,
+* run against the WARP software device.
+* Windows only, CMake leaves them out elsewhere.
+*/
+
+/**
+* @returns A WARP device shared by every test, created the first time it's asked for
+*/
+ID3D12Device* GetTestDevice();
+/**
+* Create an upload buffer, for views to point into.
+* @param size Size of the buffer in bytes
+*/
+Microsoft::WRL::ComPtr<ID3D12Resource> CreateTestBuffer(UINT64 size);
+/**
+* Read a descriptor's contents. CPU handles of non-shader-visible heaps are addresses on WARP, which D3D12 doesn't promise in general,
+* so this is only for comparing a descriptor against one created directly.
+*/
+std::vector<UINT8> ReadDescriptor(D3D12_CPU_DESCRIPTOR_HANDLE handle, UINT size);
+/**
+* Create a root signature with the draw constants where DescriptorHeap::RootParameterIndices puts them, which is all a bundle sets.
+* @param variant Root signatures of different variants differ, as the device hands out the same one for identical descriptions
+*/
+Microsoft::WRL::ComPtr<ID3D12RootSignature> CreateTestRootSignature(UINT variant = 0);
+/**
+* Create a pipeline state which draws nothing but is valid to record with. Every call creates a new one.
+*/
+Microsoft::WRL::ComPtr<ID3D12PipelineState> CreateTestPipelineState(ID3D12RootSignature* rootSignature);
+/**
+* Create a cube model, drawn bindlessly with the pipeline state. Its upload is recorded but never executed, so it can be recorded but not drawn.
+*/
+std::shared_ptr<Primitive> CreateTestModel(ID3D12PipelineState* pipelineState, ID3D12RootSignature* rootSignature);
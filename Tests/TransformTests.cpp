@@ -0,0 +1,113 @@
+#include "Test.h"
+#include "Transform.h"
+#include "TransformStats.h"
+#include <thread>
+
+using namespace DirectX;
+
+namespace
+{
+    bool IsEqual(const XMMATRIX& a, const XMMATRIX& b)
+    {
+        XMFLOAT4X4 storedA;
+        XMFLOAT4X4 storedB;
+        XMStoreFloat4x4(&storedA, a);
+        XMStoreFloat4x4(&storedB, b);
+        return memcmp(&storedA, &storedB, sizeof(storedA)) == 0;
+    }
+
+    XMMATRIX Expected(const XMFLOAT3& position, const XMFLOAT3& rotation, const XMFLOAT3& scale)
+    {
+        return XMMatrixScaling(scale.x, scale.y, scale.z) * XMMatrixRotationRollPitchYaw(rotation.x, rotation.y, rotation.z) * XMMatrixTranslation(position.x, position.y, position.z);
+    }
+}
+
+TEST(TransformRebuildsStaticObjectsOnce)
+{
+    // N objects that never move, rendered for K frames as the renderer does: updated on the frame thread, then read by each of three passes
+    const uint32_t objectCount = 1000;
+    const uint32_t frames = 100;
+    const uint32_t passes = 3;
+    std::vector<Transform> transforms;
+    for (uint32_t i = 0; i < objectCount; i++)
+    {
+        transforms.emplace_back(XMFLOAT3(float(i), 0.0f, 0.0f), XMFLOAT3(0.0f, float(i) * 0.01f, 0.0f), XMFLOAT3(1.0f, 2.0f, 1.0f));
+    }
+
+    // Drop whatever earlier tests counted
+    TransformStats::EndFrame();
+    uint32_t rebuilds = 0;
+    uint32_t updated = 0;
+    for (uint32_t frame = 0; frame < frames; frame++)
+    {
+        for (auto& transform : transforms)
+        {
+            updated += transform.Update() ? 1 : 0;
+        }
+        for (uint32_t pass = 0; pass < passes; pass++)
+        {
+            for (auto& transform : transforms)
+            {
+                transform.GetWorld();
+            }
+        }
+        TransformStats::EndFrame();
+        rebuilds += TransformStats::GetLastFrame(TransformStats::World);
+        if (frame == 0)
+        {
+            CHECK(TransformStats::GetLastFrame(TransformStats::World) == objectCount);
+        }
+    }
+    CHECK(rebuilds == objectCount);
+    CHECK(updated == objectCount);
+    CHECK(IsEqual(transforms[7].GetWorld(), Expected(XMFLOAT3(7.0f, 0.0f, 0.0f), XMFLOAT3(0.0f, 0.07f, 0.0f), XMFLOAT3(1.0f, 2.0f, 1.0f))));
+
+    // Moving one rebuilds just that one, once
+    transforms[3].SetPosition(XMFLOAT3(3.0f, 1.0f, 0.0f));
+    for (auto& transform : transforms)
+    {
+        transform.Update();
+    }
+    for (auto& transform : transforms)
+    {
+        transform.GetWorld();
+    }
+    TransformStats::EndFrame();
+    CHECK(TransformStats::GetLastFrame(TransformStats::World) == 1);
+}
+
+TEST(TransformReadsWithoutWritingFromRecordingThreads)
+{
+    // Moved since it was last updated, so every thread reading it builds the matrix itself, and none caches it under the others
+    Transform transform(XMFLOAT3(0.0f, 0.0f, 0.0f), XMFLOAT3(0.0f, 0.0f, 0.0f), XMFLOAT3(1.0f, 1.0f, 1.0f));
+    transform.Update();
+    transform.SetRotation(XMFLOAT3(0.5f, 0.25f, 0.0f));
+    XMMATRIX expected = Expected(XMFLOAT3(0.0f, 0.0f, 0.0f), XMFLOAT3(0.5f, 0.25f, 0.0f), XMFLOAT3(1.0f, 1.0f, 1.0f));
+
+    const uint32_t threadCount = 8;
+    std::vector<uint32_t> wrong(threadCount, 0);
+    std::vector<std::thread> threads;
+    for (uint32_t t = 0; t < threadCount; t++)
+    {
+        threads.emplace_back([&, t]()
+        {
+            for (uint32_t i = 0; i < 1000; i++)
+            {
+                wrong[t] += IsEqual(transform.GetWorld(), expected) ? 0 : 1;
+            }
+        });
+    }
+    for (auto& thread : threads)
+    {
+        thread.join();
+    }
+    for (uint32_t count : wrong)
+    {
+        CHECK(count == 0);
+    }
+
+    // Still out of date, so the next update rebuilds it and the object's constants are written
+    CHECK(transform.Update());
+    CHECK(!transform.Update());
+    CHECK(IsEqual(transform.GetWorld(), expected));
+}
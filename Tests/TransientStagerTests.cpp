@@ -0,0 +1,304 @@
+#include "Test.h"
+#include "TransientStager.h"
+#include <map>
+#include <set>
+#include <thread>
+
+namespace
+{
+    /**
+    * Run job(t) on threadCount threads at once, and wait for them.
+    */
+    template <typename Job>
+    void RunThreads(uint32_t threadCount, Job job)
+    {
+        std::vector<std::thread> threads;
+        for (uint32_t t = 0; t < threadCount; t++)
+        {
+            threads.emplace_back(job, t);
+        }
+        for (auto& thread : threads)
+        {
+            thread.join();
+        }
+    }
+
+    /**
+    * Staging as it was before each thread had its own blocks: one lock around the ring, the frame's slots and the command list writes,
+    * as CbvSrvUavHeap's recording mutex was held across the whole of a draw.
+    */
+    struct LockedStager
+    {
+        std::mutex mutex;
+        DescriptorRing ring;
+        std::unordered_map<uint32_t, uint32_t> staged;
+        std::vector<TransientStager::Copy> copies;
+
+        LockedStager(uint32_t capacity) :
+            ring(capacity)
+        {
+        }
+    };
+
+    /**
+    * Stands in for the command list calls of a draw, i.e. setting its table and drawing, which write a few dozen bytes to the list.
+    */
+    void RecordDraw(std::vector<uint32_t>& commandList, uint32_t index)
+    {
+        for (uint32_t i = 0; i < 16; i++)
+        {
+            commandList.push_back(index + i);
+        }
+    }
+}
+
+TEST(TransientStagerSharesSlotsWithinAThreadAndFrame)
+{
+    TransientStager stager(100, 64, 8);
+    uint32_t first = stager.Stage(7);
+    CHECK(first == 100);
+    CHECK(stager.Stage(7) == first);
+    CHECK(stager.Stage(8) == 101);
+    // One block claimed for the frame, however few of its slots were used
+    CHECK(stager.GetRing().GetFrameUsed() == 8);
+
+    stager.AddCopy(7, 3);
+    std::vector<TransientStager::Copy> copies;
+    stager.TakeCopies(copies);
+    CHECK(copies.size() == 3);
+    CHECK(copies[0].source == 7 && copies[0].destination == 100);
+    CHECK(copies[1].source == 8 && copies[1].destination == 101);
+    CHECK(copies[2].source == 7 && copies[2].destination == 3);
+    copies.clear();
+    stager.TakeCopies(copies);
+    CHECK(copies.empty());
+
+    // The next frame starts a new block, and copies its descriptors afresh
+    stager.EndFrame(1);
+    CHECK(stager.Stage(7) == 108);
+    CHECK(stager.GetRing().GetUsed() == 16);
+    CHECK(stager.Retire(1) == 8);
+}
+
+TEST(TransientStagerUsesTheLastSlotsOneAtATime)
+{
+    TransientStager stager(0, 10, 4);
+    for (uint32_t i = 0; i < 8; i++)
+    {
+        CHECK(stager.Stage(i) == i);
+    }
+    // Two slots are left, too few for a block, so they're handed out singly before the ring is full
+    CHECK(stager.Stage(8) == 8);
+    CHECK(stager.Stage(9) == 9);
+    CHECK(stager.Stage(10) == TransientStager::InvalidIndex);
+    // Still staged once the ring's full
+    CHECK(stager.Stage(3) == 3);
+
+    stager.EndFrame(1);
+    CHECK(stager.Stage(11) == TransientStager::InvalidIndex);
+    stager.Retire(1);
+    CHECK(stager.Stage(11) == 0);
+}
+
+TEST(TransientStagerWaitsForTheOldestFrameWhenFull)
+{
+    // The fence the test's GPU has reached, which waiting advances to the value asked for
+    uint64_t completedFenceValue = 0;
+    std::vector<uint64_t> waits;
+    TransientStager stager(0, 8, 4, [&](uint64_t fenceValue)
+    {
+        waits.push_back(fenceValue);
+        completedFenceValue = fenceValue;
+    });
+
+    for (uint64_t frame = 1; frame <= 2; frame++)
+    {
+        for (uint32_t i = 0; i < 4; i++)
+        {
+            stager.Stage(uint32_t(frame * 10 + i));
+        }
+        stager.EndFrame(frame);
+    }
+    CHECK(stager.GetRing().GetUsed() == 8);
+
+    // Full of two frames in flight, so the third waits for the first rather than failing, and reuses its slots
+    CHECK(stager.Stage(30) == 0);
+    CHECK(waits.size() == 1 && waits[0] == 1);
+    CHECK(completedFenceValue == 1);
+    CHECK(stager.GetRing().GetUsed() == 8);
+    for (uint32_t i = 1; i < 4; i++)
+    {
+        CHECK(stager.Stage(30 + i) == i);
+    }
+    CHECK(waits.size() == 1);
+
+    // Then for the second, once it needs more
+    CHECK(stager.Stage(34) == 4);
+    CHECK(waits.size() == 2 && waits[1] == 2);
+
+    // A frame that fills the ring on its own can't be helped by waiting, so it fails without waiting
+    for (uint32_t i = 5; i < 8; i++)
+    {
+        CHECK(stager.Stage(30 + i) == i);
+    }
+    CHECK(stager.Stage(38) == TransientStager::InvalidIndex);
+    CHECK(waits.size() == 2);
+}
+
+TEST(TransientStagerWaitsOnceWhenThreadsFillItTogether)
+{
+    const uint32_t threadCount = 8;
+    std::mutex waitMutex;
+    std::vector<uint64_t> waits;
+    TransientStager stager(0, threadCount * 64, 16, [&](uint64_t fenceValue)
+    {
+        std::lock_guard<std::mutex> lock(waitMutex);
+        waits.push_back(fenceValue);
+    });
+
+    // Each frame fills the ring, so every frame after the first waits for the one before
+    for (uint64_t frame = 1; frame <= 10; frame++)
+    {
+        std::vector<uint32_t> invalid(threadCount, 0);
+        RunThreads(threadCount, [&](uint32_t t)
+        {
+            for (uint32_t i = 0; i < 64; i++)
+            {
+                invalid[t] += stager.Stage(t * 64 + i) == TransientStager::InvalidIndex ? 1 : 0;
+            }
+        });
+        for (uint32_t count : invalid)
+        {
+            CHECK(count == 0);
+        }
+        std::vector<TransientStager::Copy> copies;
+        stager.TakeCopies(copies);
+        CHECK(copies.size() == threadCount * 64);
+        stager.EndFrame(frame);
+    }
+    CHECK(waits.size() == 9);
+    for (uint64_t i = 0; i < waits.size(); i++)
+    {
+        CHECK(waits[i] == i + 1);
+    }
+}
+
+TEST(TransientStagerGivesEveryThreadItsOwnSlots)
+{
+    const uint32_t threadCount = 8;
+    const uint32_t draws = 1000;
+    TransientStager stager(0, threadCount * draws * 2, 16);
+
+    for (uint64_t frame = 1; frame <= 20; frame++)
+    {
+        // Every thread draws the same descriptors, so each is staged once by each thread
+        std::vector<std::vector<uint32_t>> indices(threadCount);
+        RunThreads(threadCount, [&](uint32_t t)
+        {
+            for (uint32_t draw = 0; draw < draws; draw++)
+            {
+                indices[t].push_back(stager.Stage(draw % 500));
+            }
+        });
+
+        // The descriptor each slot was given to
+        std::map<uint32_t, uint32_t> slots;
+        for (auto& threadIndices : indices)
+        {
+            CHECK(threadIndices[0] == threadIndices[500]);
+            for (uint32_t draw = 0; draw < draws; draw++)
+            {
+                slots[threadIndices[draw]] = draw % 500;
+            }
+        }
+        CHECK(slots.size() == threadCount * 500);
+        CHECK(slots.count(TransientStager::InvalidIndex) == 0);
+
+        // Each slot is copied into once, from the descriptor staged into it
+        std::vector<TransientStager::Copy> copies;
+        stager.TakeCopies(copies);
+        CHECK(copies.size() == threadCount * 500);
+        std::set<uint32_t> destinations;
+        uint32_t wrongSources = 0;
+        for (auto& copy : copies)
+        {
+            destinations.insert(copy.destination);
+            wrongSources += slots[copy.destination] == copy.source ? 0 : 1;
+        }
+        CHECK(destinations.size() == slots.size());
+        CHECK(wrongSources == 0);
+
+        stager.EndFrame(frame);
+        stager.Retire(frame > 2 ? frame - 2 : 0);
+    }
+}
+
+TEST(TransientStagerBenchmark)
+{
+    // A frame of 8 passes of 2000 draws each, recorded on up to 8 threads. Each draw stages its texture and writes the list
+    const uint32_t passes = 8;
+    const uint32_t draws = 2000;
+    const uint32_t frames = 50;
+    const uint32_t capacity = passes * draws * 3;
+    printf("  threads  one lock (ms a frame)  per-thread blocks (ms a frame)  (%u hardware threads)\n", std::thread::hardware_concurrency());
+    for (uint32_t threadCount : { 1u, 2u, 4u, 8u })
+    {
+        LockedStager locked(capacity);
+        Stopwatch lockedStopwatch;
+        for (uint64_t frame = 1; frame <= frames; frame++)
+        {
+            locked.ring.Retire(frame > 2 ? frame - 2 : 0);
+            RunThreads(threadCount, [&](uint32_t t)
+            {
+                std::vector<uint32_t> commandList;
+                for (uint32_t pass = t; pass < passes; pass += threadCount)
+                {
+                    for (uint32_t draw = 0; draw < draws; draw++)
+                    {
+                        std::lock_guard<std::mutex> lock(locked.mutex);
+                        uint32_t key = pass * draws + draw;
+                        auto staged = locked.staged.find(key);
+                        uint32_t index = staged != locked.staged.end() ? staged->second : locked.ring.Allocate();
+                        if (staged == locked.staged.end())
+                        {
+                            locked.staged.emplace(key, index);
+                            locked.copies.push_back(TransientStager::Copy{ key, index });
+                        }
+                        RecordDraw(commandList, index);
+                    }
+                }
+            });
+            CHECK(locked.copies.size() == passes * draws);
+            locked.copies.clear();
+            locked.staged.clear();
+            locked.ring.EndFrame(frame);
+        }
+        double lockedMilliseconds = lockedStopwatch.GetMilliseconds() / frames;
+
+        TransientStager stager(0, capacity, 16);
+        std::vector<TransientStager::Copy> copies;
+        Stopwatch stagerStopwatch;
+        for (uint64_t frame = 1; frame <= frames; frame++)
+        {
+            stager.Retire(frame > 2 ? frame - 2 : 0);
+            RunThreads(threadCount, [&](uint32_t t)
+            {
+                std::vector<uint32_t> commandList;
+                for (uint32_t pass = t; pass < passes; pass += threadCount)
+                {
+                    for (uint32_t draw = 0; draw < draws; draw++)
+                    {
+                        RecordDraw(commandList, stager.Stage(pass * draws + draw));
+                    }
+                }
+            });
+            stager.TakeCopies(copies);
+            CHECK(copies.size() == passes * draws);
+            copies.clear();
+            stager.EndFrame(frame);
+        }
+        double stagerMilliseconds = stagerStopwatch.GetMilliseconds() / frames;
+
+        printf("  %7u  %21.3f  %30.3f\n", threadCount, lockedMilliseconds, stagerMilliseconds);
+    }
+}
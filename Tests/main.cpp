@@ -0,0 +1,63 @@
+#include "Test.h"
+#include <cstring>
+#include <exception>
+
+namespace
+{
+    int g_failures = 0;
+}
+
+std::vector<Test>& GetTests()
+{
+    static std::vector<Test> tests;
+    return tests;
+}
+
+TestRegistration::TestRegistration(const char* name, void (*function)())
+{
+    GetTests().push_back(Test{ name, function });
+}
+
+void ReportFailure(const char* file, int line, const char* expression)
+{
+    printf("  %s(%d): CHECK(%s) failed\n", file, line, expression);
+    g_failures++;
+}
+
+/**
+* Runs every test, or only those whose names start with the first argument.
+* @returns The number of tests which failed, so a CI step fails with them
+*/
+int main(int argc, char* argv[])
+{
+    const char* filter = argc > 1 ? argv[1] : "";
+    int failed = 0;
+    int run = 0;
+    for (auto& test : GetTests())
+    {
+        if (strncmp(test.name, filter, strlen(filter)) != 0)
+        {
+            continue;
+        }
+
+        printf("%s\n", test.name);
+        int failuresBefore = g_failures;
+        try
+        {
+            test.function();
+        }
+        catch (const std::exception& e)
+        {
+            printf("  threw: %s\n", e.what());
+            g_failures++;
+        }
+        run++;
+        if (g_failures != failuresBefore)
+        {
+            failed++;
+        }
+    }
+
+    printf("%d of %d tests passed\n", run - failed, run);
+    return failed;
+}